@@ -5,36 +5,91 @@
 #include <stdlib.h>
 
 #include <string>
+#include <thread>
 
 #include "util/mutexlock.h"
 
 namespace rocksdb {
 
-LIRSHandleTable::LIRSHandleTable() : list_(nullptr), length_(0), elems_(0) {
-  Resize();
+std::atomic<size_t>* LIRSReadEpoch::Enter() {
+  Readers* readers = readers_.Access();
+  while (true) {
+    uint64_t epoch = epoch_.load();
+    std::atomic<size_t>* slot = &readers->count[epoch & 1];
+    slot->fetch_add(1);
+    // Counted in the parity of an older epoch this lookup could be missed by
+    // TryAdvance(), start over
+    if (epoch_.load() == epoch) {
+      return slot;
+    }
+    slot->fetch_sub(1, std::memory_order_release);
+  }
+}
+
+uint64_t LIRSReadEpoch::TryAdvance() {
+  uint64_t epoch = epoch_.load();
+  size_t previous = (epoch + 1) & 1;
+  for (size_t i = 0; i < readers_.Size(); ++i) {
+    if (readers_.AccessAtCore(i)->count[previous].load() != 0) {
+      return epoch;
+    }
+  }
+  // Loads the newer epoch on failure
+  epoch_.compare_exchange_strong(epoch, epoch + 1);
+  return epoch_.load();
+}
+
+LIRSHandleTable::Buckets::Buckets(uint32_t _length)
+    : length(_length), list(new std::atomic<LIRSHandle*>[_length]) {
+  for (uint32_t i = 0; i < length; i++) {
+    list[i].store(nullptr, std::memory_order_relaxed);
+  }
 }
 
+LIRSHandleTable::LIRSHandleTable(LIRSReadEpoch* epoch)
+    : epoch_(epoch), buckets_(new Buckets(16)), resize_seq_(0), elems_(0) {}
+
 LIRSHandleTable::~LIRSHandleTable() {
   ApplyToAllCacheEntries([](LIRSHandle* h) {
-    if (h->refs == 1) {
+    h->SetInvalid();
+    if (h->refs.fetch_sub(1, std::memory_order_relaxed) == 1) {
       h->Free();
     }
   });
-  delete[] list_;
+  delete buckets_.load(std::memory_order_relaxed);
+  for (auto& retired : retired_) {
+    delete retired.second;
+  }
 }
 
-LIRSHandle* LIRSHandleTable::Lookup(const Slice& key, uint32_t hash) {
-  return *FindPointer(key, hash);
+LIRSHandle* LIRSHandleTable::Lookup(const Slice& key, uint32_t hash) const {
+  while (true) {
+    uint32_t seq;
+    while ((seq = resize_seq_.load()) & 1) {
+      std::this_thread::yield();
+    }
+    const Buckets* buckets = buckets_.load();
+    LIRSHandle* h = buckets->list[hash & (buckets->length - 1)].load();
+    while (h != nullptr && (h->hash != hash || key != h->key())) {
+      h = h->next_hash.load();
+    }
+    // A concurrent Resize() may have moved the entry out of the way
+    if (h != nullptr || resize_seq_.load() == seq) {
+      return h;
+    }
+  }
 }
 
 LIRSHandle* LIRSHandleTable::Insert(LIRSHandle* h) {
-  LIRSHandle** ptr = FindPointer(h->key(), h->hash);
-  LIRSHandle* old = *ptr;
-  h->next_hash = (old == nullptr ? nullptr : old->next_hash);
-  *ptr = h;
+  std::atomic<LIRSHandle*>* ptr = FindPointer(h->key(), h->hash);
+  LIRSHandle* old = ptr->load(std::memory_order_relaxed);
+  h->next_hash.store(old == nullptr ? nullptr : old->next_hash.load(),
+                     std::memory_order_relaxed);
+  // Publishes the key of `h` to lookups
+  ptr->store(h);
   if (old == nullptr) {
     ++elems_;
-    if (elems_ > length_) {
+    if (elems_ > buckets_.load(std::memory_order_relaxed)->length) {
       Resize();
     }
   }
@@ -42,62 +97,104 @@ LIRSHandle* LIRSHandleTable::Insert(LIRSHandle* h) {
 }
 
 LIRSHandle* LIRSHandleTable::Remove(const Slice& key, uint32_t hash) {
-  LIRSHandle** ptr = FindPointer(key, hash);
-  LIRSHandle* result = *ptr;
+  std::atomic<LIRSHandle*>* ptr = FindPointer(key, hash);
+  LIRSHandle* result = ptr->load(std::memory_order_relaxed);
   if (result != nullptr) {
-    *ptr = result->next_hash;
+    // Lookups standing on `result` still find their way on
+    ptr->store(result->next_hash.load(std::memory_order_relaxed));
     --elems_;
   }
   return result;
 }
 
-LIRSHandle** LIRSHandleTable::FindPointer(const Slice& key, uint32_t hash) {
-  LIRSHandle** ptr = &list_[hash & (length_ - 1)];
-  while (*ptr != nullptr && ((*ptr)->hash != hash || key != (*ptr)->key())) {
-    ptr = &(*ptr)->next_hash;
+void LIRSHandleTable::Reclaim(uint64_t epoch) {
+  while (!retired_.empty() && retired_.front().first < epoch) {
+    delete retired_.front().second;
+    retired_.pop_front();
+  }
+}
+
+std::atomic<LIRSHandle*>* LIRSHandleTable::FindPointer(const Slice& key,
+                                                       uint32_t hash) {
+  Buckets* buckets = buckets_.load(std::memory_order_relaxed);
+  std::atomic<LIRSHandle*>* ptr = &buckets->list[hash & (buckets->length - 1)];
+  LIRSHandle* h;
+  while ((h = ptr->load(std::memory_order_relaxed)) != nullptr &&
+         (h->hash != hash || key != h->key())) {
+    ptr = &h->next_hash;
   }
   return ptr;
 }
 
 void LIRSHandleTable::Resize() {
+  Buckets* old_buckets = buckets_.load(std::memory_order_relaxed);
   uint32_t new_length = 16;
   while (new_length < elems_ * 1.5) {
     new_length *= 2;
   }
-  LIRSHandle** new_list = new LIRSHandle*[new_length];
-  memset(new_list, 0, sizeof(new_list[0]) * new_length);
+  Buckets* new_buckets = new Buckets(new_length);
   uint32_t count = 0;
-  for (uint32_t i = 0; i < length_; i++) {
-    LIRSHandle* h = list_[i];
+  resize_seq_.fetch_add(1);
+  for (uint32_t i = 0; i < old_buckets->length; i++) {
+    LIRSHandle* h = old_buckets->list[i].load(std::memory_order_relaxed);
     while (h != nullptr) {
-      LIRSHandle* next = h->next_hash;
+      LIRSHandle* next = h->next_hash.load(std::memory_order_relaxed);
       uint32_t hash = h->hash;
-      LIRSHandle** ptr = &new_list[hash & (new_length - 1)];
-      h->next_hash = *ptr;
-      *ptr = h;
+      std::atomic<LIRSHandle*>* ptr =
+          &new_buckets->list[hash & (new_length - 1)];
+      h->next_hash.store(ptr->load(std::memory_order_relaxed));
+      ptr->store(h, std::memory_order_relaxed);
       h = next;
       count++;
     }
   }
   assert(elems_ == count);
-  delete[] list_;
-  list_ = new_list;
-  length_ = new_length;
+  buckets_.store(new_buckets);
+  resize_seq_.fetch_add(1);
+  // Lookups may still read the old array
+  retired_.emplace_back(epoch_->current(), old_buckets);
 }
 
 LIRSCacheShard::LIRSCacheShard(size_t capacity, bool strict_capacity_limit,
-                               double irr_ratio)
-    : capacity_(capacity),
+                               double irr_ratio, LIRSReadEpoch* epoch)
+    : capacity_(0),
+      stack_capacity_(0),
       usage_(0),
       stack_usage_(0),
       irr_ratio_(irr_ratio),
-      strict_capacity_limit_(strict_capacity_limit) {
+      own_epoch_(epoch == nullptr ? new LIRSReadEpoch : nullptr),
+      epoch_(epoch == nullptr ? own_epoch_.get() : epoch),
+      table_(epoch_),
+      strict_capacity_limit_(strict_capacity_limit),
+      num_accesses_(0),
+      freed_(nullptr) {
   cache_.next_stack = cache_.prev_stack = cache_.next_queue =
       cache_.prev_queue = &cache_;
+  for (auto& access : accesses_) {
+    access.store(nullptr, std::memory_order_relaxed);
+  }
   SetCapacity(capacity);
 }
 
-LIRSCacheShard::~LIRSCacheShard() {}
+LIRSCacheShard::~LIRSCacheShard() {
+  autovector<LIRSHandle*> last_reference_list;
+  {
+    MutexLock l(&mutex_);
+    ApplyAccesses(&last_reference_list);
+  }
+  // No lookup is left, all memory can go
+  for (auto entry : last_reference_list) {
+    entry->Free();
+  }
+  for (auto h = freed_.load(); h != nullptr;) {
+    auto next = h->next_queue;
+    h->FreeMemory();
+    h = next;
+  }
+  for (auto& retired : retired_) {
+    retired.second->FreeMemory();
+  }
+}
 
 void LIRSCacheShard::PushToQueue(LIRSHandle* h) {
   cache_.next_queue->prev_queue = h;
@@ -122,19 +219,6 @@ void LIRSCacheShard::AdjustToQueueTail(LIRSHandle* h) {
   h->prev_queue = &cache_;
 }
 
-void LIRSCacheShard::ShiftQueueHead() {
-  if (cache_.prev_queue == &cache_) {
-    return;
-  }
-  auto head = cache_.prev_queue;
-  RemoveFromQueue(head);
-  if (head->next_stack != nullptr) {
-    head->SetNHIR();
-  } else {
-    LIRS_Remove(head);
-  }
-}
-
 void LIRSCacheShard::PushToStack(LIRSHandle* h) {
   cache_.next_stack->prev_stack = h;
   h->next_stack = cache_.next_stack;
@@ -158,52 +242,101 @@ void LIRSCacheShard::AdjustToStackTop(LIRSHandle* h) {
   h->prev_stack = &cache_;
 }
 
-void LIRSCacheShard::AdjustStackBottom() {
+bool LIRSCacheShard::DemoteStackBottom() {
   if (cache_.prev_stack == &cache_) {
-    return;
+    return false;
   }
   auto bottom = cache_.prev_stack;
-  if (bottom->LIR()) {
-    bottom->SetHIR();
-    if (bottom->next_queue != nullptr) {
-      RemoveFromQueue(bottom);
-    }
-    PushToQueue(bottom);
-  }
+  assert(bottom->LIR());
+  RemoveFromStack(bottom);
+  bottom->SetHIR();
+  stack_usage_ -= bottom->charge;
+  PushToQueue(bottom);
+  StackPruning();
+  return true;
 }
 
 void LIRSCacheShard::StackPruning() {
+  // HIR entries below the last LIR entry can't be promoted by their next hit,
+  // they stay in the queue
   while (cache_.prev_stack != &cache_ && !cache_.prev_stack->LIR()) {
-    auto bottom = cache_.prev_stack;
-    RemoveFromStack(bottom);
-    PushToQueue(bottom);
+    RemoveFromStack(cache_.prev_stack);
   }
 }
 
 bool LIRSCacheShard::Unref(LIRSHandle* h) {
   assert(h->refs > 0);
-  h->refs--;
-  return h->refs == 0;
+  return h->refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+bool LIRSCacheShard::TryRef(LIRSHandle* h) {
+  uint32_t refs = h->refs.load(std::memory_order_relaxed);
+  do {
+    if (refs == 0) {
+      return false;
+    }
+  } while (!h->refs.compare_exchange_weak(refs, refs + 1,
+                                          std::memory_order_relaxed));
+  return true;
+}
+
+void LIRSCacheShard::ReclaimLocked(autovector<LIRSHandle*>* reclaimed) {
+  mutex_.AssertHeld();
+  // Tagged now, at least as late as their removal from the table
+  uint64_t epoch = epoch_->current();
+  for (auto h = freed_.exchange(nullptr); h != nullptr;) {
+    auto next = h->next_queue;
+    retired_.emplace_back(epoch, h);
+    h = next;
+  }
+  if (retired_.empty() && !table_.HasRetired()) {
+    return;
+  }
+  epoch = epoch_->TryAdvance();
+  // Retired in `epoch - 2` or before, no lookup that saw them is left
+  while (!retired_.empty() && retired_.front().first + 2 <= epoch) {
+    reclaimed->push_back(retired_.front().second);
+    retired_.pop_front();
+  }
+  if (epoch >= 2) {
+    table_.Reclaim(epoch - 1);
+  }
+}
+
+void LIRSCacheShard::Free(const autovector<LIRSHandle*>& last_references,
+                          const autovector<LIRSHandle*>& reclaimed) {
+  for (auto h : last_references) {
+    h->FreeValue();
+    // Lock free push, the stack is only taken as a whole
+    h->next_queue = freed_.load(std::memory_order_relaxed);
+    while (!freed_.compare_exchange_weak(h->next_queue, h,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+    }
+  }
+  for (auto h : reclaimed) {
+    h->FreeMemory();
+  }
 }
 
 void LIRSCacheShard::EraseUnRefEntries() {
-  autovector<LIRSHandle*> last_reference_list;
+  autovector<LIRSHandle*> last_reference_list, reclaimed;
   {
     MutexLock l(&mutex_);
-    while (cache_.prev_queue != &cache_) {
-      LIRSHandle* old = cache_.prev_queue;
-      LIRS_Remove(old);
-      table_.Remove(old->key(), old->hash);
-      old->SetInvalid();
-      Unref(old);
-      usage_ -= old->charge;
-      last_reference_list.push_back(old);
+    ApplyAccesses(&last_reference_list);
+    std::vector<LIRSHandle*> unref_entries;
+    table_.ApplyToAllCacheEntries([&](LIRSHandle* h) {
+      if (h->refs.load(std::memory_order_relaxed) == 1) {
+        unref_entries.push_back(h);
+      }
+    });
+    for (auto h : unref_entries) {
+      EvictEntry(h, &last_reference_list);
     }
+    ReclaimLocked(&reclaimed);
   }
 
-  for (auto entry : last_reference_list) {
-    entry->Free();
-  }
+  Free(last_reference_list, reclaimed);
 }
 
 void LIRSCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
@@ -219,101 +352,173 @@ void LIRSCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
 }
 
 void LIRSCacheShard::LIRS_Remove(LIRSHandle* e) {
-  if (e->next_queue != nullptr) {
+  if (e->InQueue()) {
     RemoveFromQueue(e);
   }
-  if (e->next_stack != nullptr) {
+  if (e->InStack()) {
+    bool bottom = cache_.prev_stack == e;
     RemoveFromStack(e);
+    if (bottom) {
+      StackPruning();
+    }
+  }
+  if (e->LIR()) {
     stack_usage_ -= e->charge;
   }
 }
 
 void LIRSCacheShard::LIRS_Insert(LIRSHandle* e) {
+  PushToStack(e);
   if (stack_usage_ + e->charge <= stack_capacity_) {
-    PushToStack(e);
     e->SetLIR();
     stack_usage_ += e->charge;
   } else {
-    PushToQueue(e);
     e->SetHIR();
+    PushToQueue(e);
   }
 }
 
+void LIRSCacheShard::LIRS_Access(LIRSHandle* h) {
+  if (h->LIR()) {
+    bool bottom = cache_.prev_stack == h;
+    AdjustToStackTop(h);
+    if (bottom) {
+      StackPruning();
+    }
+  } else if (h->InStack()) {
+    // Reused within the LIR working set, swap it with the LIR stack bottom
+    RemoveFromQueue(h);
+    AdjustToStackTop(h);
+    h->SetLIR();
+    stack_usage_ += h->charge;
+    while (stack_usage_ > stack_capacity_ && cache_.prev_stack != h) {
+      DemoteStackBottom();
+    }
+  } else {
+    PushToStack(h);
+    AdjustToQueueTail(h);
+  }
+}
+
+bool LIRSCacheShard::EvictEntry(LIRSHandle* h,
+                                autovector<LIRSHandle*>* deleted) {
+  assert(h->InCache());
+  LIRS_Remove(h);
+  table_.Remove(h->key(), h->hash);
+  h->SetInvalid();
+  // A lookup may have taken a reference since `h` was found unreferenced,
+  // the entry is then freed by its last release
+  if (!Unref(h)) {
+    return false;
+  }
+  usage_ -= h->charge;
+  deleted->push_back(h);
+  return true;
+}
+
 void LIRSCacheShard::EvictFromLIRS(size_t charge,
                                    autovector<LIRSHandle*>* deleted) {
-  while (usage_ - stack_usage_ + charge > capacity_ - stack_capacity_ &&
-         cache_.prev_queue != &cache_) {
-    LIRSHandle* old = cache_.prev_queue;
-    assert(old->refs == 1);
-    LIRS_Remove(old);
-    table_.Remove(old->key(), old->hash);
-    old->SetInvalid();
-    Unref(old);
-    usage_ -= old->charge;
-    deleted->push_back(old);
-  }
-  while (stack_usage_ + charge > stack_capacity_ &&
-         cache_.prev_stack != &cache_) {
-    LIRSHandle* old = cache_.prev_stack;
-    stack_usage_ -= old->charge;
-    RemoveFromStack(old);
-    PushToQueue(old);
+  while (usage_ + charge > capacity_) {
+    // Referenced entries can't be evicted, take the oldest HIR entry which
+    // is not referenced
+    LIRSHandle* victim = nullptr;
+    for (auto h = cache_.prev_queue; h != &cache_; h = h->prev_queue) {
+      if (h->refs.load(std::memory_order_relaxed) == 1) {
+        victim = h;
+        break;
+      }
+    }
+    if (victim != nullptr) {
+      EvictEntry(victim, deleted);
+    } else if (!DemoteStackBottom()) {
+      break;
+    }
   }
 }
 
+void LIRSCacheShard::RecordAccess(LIRSHandle* h) {
+  size_t index = num_accesses_.fetch_add(1, std::memory_order_relaxed);
+  if (index < kAccessBufferSize) {
+    // One reference for the buffer, the caller's keeps `h` alive meanwhile
+    h->refs.fetch_add(1, std::memory_order_relaxed);
+    accesses_[index].store(h, std::memory_order_release);
+    if (index + 1 < kAccessBufferSize) {
+      return;
+    }
+  }
+  // The buffer is full. A hit finding no slot is dropped, and the buffer is
+  // left to the next thread if the mutex is busy.
+  if (!mutex_.TryLock()) {
+    return;
+  }
+  autovector<LIRSHandle*> last_reference_list, reclaimed;
+  ApplyAccesses(&last_reference_list);
+  ReclaimLocked(&reclaimed);
+  mutex_.Unlock();
+  Free(last_reference_list, reclaimed);
+}
+
+void LIRSCacheShard::ApplyAccesses(autovector<LIRSHandle*>* deleted) {
+  mutex_.AssertHeld();
+  // Appends fail over to the mutex until the buffer is emptied
+  size_t n = num_accesses_.exchange(kAccessBufferSize,
+                                    std::memory_order_relaxed);
+  if (n > kAccessBufferSize) {
+    n = kAccessBufferSize;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    LIRSHandle* h;
+    // The slot is reserved, its store may still be on the way
+    while ((h = accesses_[i].load(std::memory_order_acquire)) == nullptr) {
+      std::this_thread::yield();
+    }
+    accesses_[i].store(nullptr, std::memory_order_relaxed);
+    if (h->InCache()) {
+      LIRS_Access(h);
+    }
+    if (Unref(h)) {
+      usage_ -= h->charge;
+      deleted->push_back(h);
+    }
+  }
+  num_accesses_.store(0, std::memory_order_release);
+}
+
 void LIRSCacheShard::SetCapacity(size_t capacity) {
-  MutexLock l(&mutex_);
-  capacity_ = capacity;
-  stack_capacity_ = capacity_ * irr_ratio_;
+  autovector<LIRSHandle*> last_reference_list, reclaimed;
+  {
+    MutexLock l(&mutex_);
+    ApplyAccesses(&last_reference_list);
+    capacity_ = capacity;
+    stack_capacity_ = static_cast<size_t>(capacity * irr_ratio_);
+    while (stack_usage_ > stack_capacity_ && DemoteStackBottom()) {
+    }
+    EvictFromLIRS(0, &last_reference_list);
+    ReclaimLocked(&reclaimed);
+  }
+
+  Free(last_reference_list, reclaimed);
 }
 
 Cache::Handle* LIRSCacheShard::Lookup(const Slice& key, uint32_t hash) {
-  MutexLock l(&mutex_);
+  std::atomic<size_t>* slot = epoch_->Enter();
   LIRSHandle* h = table_.Lookup(key, hash);
+  // An entry whose last reference is gone left the cache, its memory waits
+  // for the lookups that may still see it
+  if (h != nullptr && !TryRef(h)) {
+    h = nullptr;
+  }
+  epoch_->Exit(slot);
   if (h != nullptr) {
-    if (!h->Remote()) {
-      if (h->refs == 1) {
-        LIRS_Remove(h);
-      } else {
-        if (h->LIR()) {
-          AdjustToStackTop(h);
-        } else if (h->HIR()) {
-          if (h->next_stack != nullptr) {
-            h->SetLIR();
-            AdjustToStackTop(h);
-            RemoveFromQueue(h);
-            AdjustStackBottom();
-          } else {
-            PushToStack(h);
-            AdjustToQueueTail(h);
-          }
-        } else {
-          ShiftQueueHead();
-          if (h->next_stack != nullptr) {
-            h->SetLIR();
-            AdjustToStackTop(h);
-            AdjustStackBottom();
-          } else {
-            h->SetHIR();
-            PushToStack(h);
-            PushToQueue(h);
-          }
-        }
-        StackPruning();
-      }
-    }
-    h->refs++;
+    RecordAccess(h);
   }
   return reinterpret_cast<Cache::Handle*>(h);
 }
 
 bool LIRSCacheShard::Ref(Cache::Handle* h) {
   LIRSHandle* handle = reinterpret_cast<LIRSHandle*>(h);
-  MutexLock l(&mutex_);
-  if (handle->InCache() && handle->refs == 1) {
-    LIRS_Remove(handle);
-  }
-  handle->refs++;
+  // The caller holds a reference, the entry can't be evicted meanwhile
+  handle->refs.fetch_add(1, std::memory_order_relaxed);
   return true;
 }
 
@@ -322,31 +527,40 @@ bool LIRSCacheShard::Release(Cache::Handle* handle, bool force_erase) {
     return false;
   }
   LIRSHandle* e = reinterpret_cast<LIRSHandle*>(handle);
+  if (!force_erase && usage_ <= capacity_) {
+    // Nothing to evict, the last reference only remains if the entry already
+    // left the cache
+    if (Unref(e)) {
+      usage_ -= e->charge;
+      autovector<LIRSHandle*> last_reference_list = {e};
+      Free(last_reference_list, {});
+      return true;
+    }
+    return false;
+  }
   bool last_reference = false;
+  autovector<LIRSHandle*> last_reference_list, reclaimed;
   {
     MutexLock l(&mutex_);
-    last_reference = Unref(e);
-    if (last_reference) {
+    // Drop the reference of a pending access to this entry
+    ApplyAccesses(&last_reference_list);
+    if (Unref(e)) {
       usage_ -= e->charge;
-    }
-    if (e->refs == 1 && e->InCache()) {
+      last_reference_list.push_back(e);
+      last_reference = true;
+    } else if (e->refs == 1 && e->InCache()) {
       // The item is still in cache, and nobody else holds a reference to it
       if (usage_ > capacity_ || force_erase) {
         // the cache is full
         // take this opportunity and remove the item
-        table_.Remove(e->key(), e->hash);
-        e->SetInvalid();
-        Unref(e);
-        usage_ -= e->charge;
-        last_reference = true;
+        last_reference = EvictEntry(e, &last_reference_list);
       }
     }
+    ReclaimLocked(&reclaimed);
   }
 
   // free outside of mutex
-  if (last_reference) {
-    e->Free();
-  }
+  Free(last_reference_list, reclaimed);
   return last_reference;
 }
 
@@ -364,13 +578,15 @@ Status LIRSCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
   e->charge = charge;
   e->key_length = key.size();
   e->hash = hash;
-  e->refs = (handle == nullptr ? 1 : 2);
+  e->refs.store(handle == nullptr ? 1 : 2, std::memory_order_relaxed);
   e->next_stack = e->prev_stack = e->next_queue = e->prev_queue = nullptr;
+  e->SetInvalid();
   memcpy(e->key_data, key.data(), key.size());
 
-  autovector<LIRSHandle*> last_reference_list;
+  autovector<LIRSHandle*> last_reference_list, reclaimed;
   {
     MutexLock l(&mutex_);
+    ApplyAccesses(&last_reference_list);
     EvictFromLIRS(charge, &last_reference_list);
     if (usage_ + charge > capacity_ && strict_capacity_limit_) {
       e->refs = 0;
@@ -382,64 +598,62 @@ Status LIRSCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
     } else {
       LIRSHandle* old = table_.Insert(e);
       usage_ += e->charge;
+      LIRS_Insert(e);
       if (old != nullptr) {
+        LIRS_Remove(old);
         old->SetInvalid();
         if (Unref(old)) {
           usage_ -= old->charge;
-          LIRS_Remove(old);
+          last_reference_list.push_back(old);
         }
       }
-      if (handle == nullptr) {
-        LIRS_Insert(e);
-      } else {
-        e->SetRemote();
+      if (handle != nullptr) {
         *handle = reinterpret_cast<Cache::Handle*>(e);
       }
       s = Status::OK();
     }
+    ReclaimLocked(&reclaimed);
   }
 
-  for (auto entry : last_reference_list) {
-    entry->Free();
-  }
+  Free(last_reference_list, reclaimed);
 
   return s;
 }
 
 void LIRSCacheShard::Erase(const Slice& key, uint32_t hash) {
-  LIRSHandle* e;
-  bool last_reference = false;
+  autovector<LIRSHandle*> last_reference_list, reclaimed;
   {
     MutexLock l(&mutex_);
-    e = table_.Remove(key, hash);
+    ApplyAccesses(&last_reference_list);
+    LIRSHandle* e = table_.Remove(key, hash);
     if (e != nullptr) {
-      last_reference = Unref(e);
-      if (last_reference) {
+      LIRS_Remove(e);
+      e->SetInvalid();
+      if (Unref(e)) {
         usage_ -= e->charge;
+        last_reference_list.push_back(e);
       }
-      if (last_reference && e->InCache()) {
-        LIRS_Remove(e);
-      }
-      e->SetInvalid();
     }
+    ReclaimLocked(&reclaimed);
   }
 
   // mutex not held here
-  // last_reference will only be true if e != nullptr
-  if (last_reference) {
-    e->Free();
-  }
+  Free(last_reference_list, reclaimed);
 }
 
-size_t LIRSCacheShard::GetUsage() const {
-  MutexLock l(&mutex_);
-  return usage_;
-}
+size_t LIRSCacheShard::GetUsage() const { return usage_; }
 
 size_t LIRSCacheShard::GetPinnedUsage() const {
+  // Pending accesses hold references, the usage is only approximate
+  size_t unpinned_usage = 0;
   MutexLock l(&mutex_);
-  assert(usage_ >= stack_usage_);
-  return usage_ - stack_usage_;
+  table_.ApplyToAllCacheEntries([&](LIRSHandle* h) {
+    if (h->refs.load(std::memory_order_relaxed) == 1) {
+      unpinned_usage += h->charge;
+    }
+  });
+  size_t usage = usage_;
+  return usage > unpinned_usage ? usage - unpinned_usage : 0;
 }
 
 std::string LIRSCacheShard::GetPrintableOptions() const {
@@ -457,6 +671,25 @@ void LIRSCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
   strict_capacity_limit_ = strict_capacity_limit;
 }
 
+void LIRSCacheShard::TEST_GetLIRSLists(std::vector<std::string>* stack,
+                                       std::vector<std::string>* queue) {
+  autovector<LIRSHandle*> last_reference_list, reclaimed;
+  {
+    MutexLock l(&mutex_);
+    ApplyAccesses(&last_reference_list);
+    stack->clear();
+    for (auto h = cache_.next_stack; h != &cache_; h = h->next_stack) {
+      stack->push_back(h->key().ToString());
+    }
+    queue->clear();
+    for (auto h = cache_.next_queue; h != &cache_; h = h->next_queue) {
+      queue->push_back(h->key().ToString());
+    }
+    ReclaimLocked(&reclaimed);
+  }
+  Free(last_reference_list, reclaimed);
+}
+
 LIRSCache::LIRSCache(size_t capacity, int num_shard_bits,
                      bool strict_capacity_limit, double irr_ratio,
                      std::shared_ptr<MemoryAllocator> memory_allocator)
@@ -467,8 +700,8 @@ LIRSCache::LIRSCache(size_t capacity, int num_shard_bits,
       port::cacheline_aligned_alloc(sizeof(LIRSCacheShard) * num_shards_));
   size_t size_per_shard = (capacity + (num_shards_ - 1)) / num_shards_;
   for (int i = 0; i < num_shards_; i++) {
-    new (&shards_[i])
-        LIRSCacheShard(size_per_shard, strict_capacity_limit, irr_ratio);
+    new (&shards_[i]) LIRSCacheShard(size_per_shard, strict_capacity_limit,
+                                     irr_ratio, &epoch_);
   }
 }
 
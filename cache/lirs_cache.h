@@ -1,69 +1,132 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "cache/sharded_cache.h"
 #include "port/port.h"
 #include "util/autovector.h"
+#include "util/core_local.h"
 
 namespace rocksdb {
 
+// LIRS keeps recently accessed entries in the stack and all HIR entries in
+// the queue. LIR entries are only in the stack, the stack bottom is always a
+// LIR entry, and HIR entries are evicted in queue order. Referenced entries
+// stay in the stack and queue, eviction skips them.
 struct LIRSHandle {
   void* value;
   void (*deleter)(const Slice&, void* value);
-  LIRSHandle* next_hash;
+  // Read by lookups without a lock
+  std::atomic<LIRSHandle*> next_hash;
   LIRSHandle* next_stack;
   LIRSHandle* prev_stack;
   LIRSHandle* next_queue;
   LIRSHandle* prev_queue;
   size_t charge;
   size_t key_length;
-  uint32_t refs;
+  // External references, plus one while the entry is in the cache
+  std::atomic<uint32_t> refs;
   uint32_t hash;  // Hash of key(); used for fast sharding and comparisons
 
-  enum State { kRemote = 0, kLIR, kHIR, kNHIR, kInvalid } state;
+  enum State { kLIR = 0, kHIR, kInvalid } state;
 
   char key_data[1];  // Beginning of key
 
   Slice key() const { return Slice(key_data, key_length); }
 
-  bool Remote() { return state == kRemote; }
   bool LIR() { return state == kLIR; }
   bool HIR() { return state == kHIR; }
-  bool InCache() { return state == kLIR || state == kHIR || state == kNHIR; }
-  bool NHIR() { return state == kNHIR; }
-  bool Valid() { return state != kInvalid; }
+  bool InCache() { return state != kInvalid; }
+  bool InStack() { return next_stack != nullptr; }
+  bool InQueue() { return next_queue != nullptr; }
 
-  void SetRemote() { state = kRemote; }
   void SetLIR() { state = kLIR; }
   void SetHIR() { state = kHIR; }
-  void SetNHIR() { state = kNHIR; }
   void SetInvalid() { state = kInvalid; }
 
-  void Free() {
-    assert((refs == 1 && InCache()) || (refs == 0 && !InCache()));
+  // Run the deleter, lookups may still read the key of a handle that left
+  // the table, so its memory is freed apart
+  void FreeValue() {
+    assert(refs == 0 && !InCache());
     if (deleter) {
       (*deleter)(key(), value);
     }
-    delete[] reinterpret_cast<char*>(this);
   }
+  void FreeMemory() { delete[] reinterpret_cast<char*>(this); }
+
+  void Free() {
+    FreeValue();
+    FreeMemory();
+  }
+};
+
+// Lookups read the hash table without a lock. Handles and bucket arrays taken
+// out of the table are retired with the current epoch and only freed once
+// the epoch is two ahead. A lookup counts itself in a per core slot of the
+// parity of the epoch it runs in, and the epoch only advances when no lookup
+// of the previous parity is left, so no lookup that could see the retired
+// memory is still running by then. Shared by the shards of a cache.
+class LIRSReadEpoch {
+ public:
+  LIRSReadEpoch() : epoch_(0) {}
+
+  // Returns the slot to give to Exit()
+  std::atomic<size_t>* Enter();
+  void Exit(std::atomic<size_t>* slot) {
+    slot->fetch_sub(1, std::memory_order_release);
+  }
+
+  uint64_t current() const { return epoch_.load(); }
+  // Advance the epoch unless a lookup of the previous one is still running,
+  // returns the current epoch
+  uint64_t TryAdvance();
+
+ private:
+  // One cache line per core, alignment attributes may expand to nothing
+  struct ALIGN_AS(CACHE_LINE_SIZE) Readers {
+    Readers() {
+      count[0].store(0, std::memory_order_relaxed);
+      count[1].store(0, std::memory_order_relaxed);
+    }
+    std::atomic<size_t> count[2];
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(std::atomic<size_t>)];
+
+    void* operator new[](size_t s) { return port::cacheline_aligned_alloc(s); }
+    void operator delete[](void* p) { port::cacheline_aligned_free(p); }
+  };
+
+  std::atomic<uint64_t> epoch_;
+  CoreLocalArray<Readers> readers_;
 };
 
+// Lookup() runs concurrently with the other methods, which are serialized by
+// the shard mutex. The caller of Lookup() keeps the handles it walks alive
+// through LIRSReadEpoch.
 class LIRSHandleTable {
  public:
-  LIRSHandleTable();
+  explicit LIRSHandleTable(LIRSReadEpoch* epoch);
   ~LIRSHandleTable();
 
-  LIRSHandle* Lookup(const Slice& key, uint32_t hash);
+  LIRSHandle* Lookup(const Slice& key, uint32_t hash) const;
   LIRSHandle* Insert(LIRSHandle* h);
   LIRSHandle* Remove(const Slice& key, uint32_t hash);
 
+  // Free the bucket arrays retired in an epoch before `epoch`
+  void Reclaim(uint64_t epoch);
+  bool HasRetired() const { return !retired_.empty(); }
+
   template <typename T>
-  void ApplyToAllCacheEntries(T func) {
-    for (uint32_t i = 0; i < length_; i++) {
-      LIRSHandle* h = list_[i];
+  void ApplyToAllCacheEntries(T func) const {
+    const Buckets* buckets = buckets_.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < buckets->length; i++) {
+      LIRSHandle* h = buckets->list[i].load(std::memory_order_relaxed);
       while (h != nullptr) {
-        auto n = h->next_hash;
+        auto n = h->next_hash.load(std::memory_order_relaxed);
         assert(h->InCache());
         func(h);
         h = n;
@@ -72,24 +135,41 @@ class LIRSHandleTable {
   }
 
  private:
+  // The table consists of an array of buckets where each bucket is
+  // a linked list of cache entries that hash into the bucket.
+  struct Buckets {
+    explicit Buckets(uint32_t _length);
+
+    uint32_t length;
+    std::unique_ptr<std::atomic<LIRSHandle*>[]> list;
+  };
+
   // Return a pointer to slot that points to a cache entry that
   // matches key/hash.  If there is no such cache entry, return a
   // pointer to the trailing slot in the corresponding linked list.
-  LIRSHandle** FindPointer(const Slice& key, uint32_t hash);
+  std::atomic<LIRSHandle*>* FindPointer(const Slice& key, uint32_t hash);
 
   void Resize();
 
-  // The table consists of an array of buckets where each bucket is
-  // a linked list of cache entries that hash into the bucket.
-  LIRSHandle** list_;
-  uint32_t length_;
+  LIRSReadEpoch* epoch_;
+  std::atomic<Buckets*> buckets_;
+  // Odd while Resize() relinks the entries, a lookup may then miss
+  std::atomic<uint32_t> resize_seq_;
   uint32_t elems_;
+  // Replaced bucket arrays and the epoch they were retired in
+  std::deque<std::pair<uint64_t, Buckets*>> retired_;
 };
 
+// A hit takes no lock. Moving the entry in the stack and queue is deferred
+// into a per-shard access buffer, which is applied in one batch by the thread
+// filling it if it gets the shard mutex without waiting, or else by whichever
+// thread takes the mutex next (BP-Wrapper). Hits finding the buffer full are
+// not recorded. Release without eviction is lock free.
 class ALIGN_AS(CACHE_LINE_SIZE) LIRSCacheShard : public CacheShard {
  public:
+  // Shards of one cache share `epoch`, a shard without it has its own
   LIRSCacheShard(size_t capacity, bool strict_capacity_limit,
-                 double irr_ratio = 0.9);
+                 double irr_ratio = 0.9, LIRSReadEpoch* epoch = nullptr);
   virtual ~LIRSCacheShard();
 
   virtual void SetCapacity(size_t capacity) override;
@@ -117,29 +197,67 @@ class ALIGN_AS(CACHE_LINE_SIZE) LIRSCacheShard : public CacheShard {
 
   virtual std::string GetPrintableOptions() const override;
 
+  // Accesses buffered before the stack and queue are updated
+  static const size_t kAccessBufferSize = 64;
+
+  // Keys from stack top to bottom and from queue tail to head, for tests
+  void TEST_GetLIRSLists(std::vector<std::string>* stack,
+                         std::vector<std::string>* queue);
+
  private:
   void PushToQueue(LIRSHandle* h);
   void RemoveFromQueue(LIRSHandle* h);
   void AdjustToQueueTail(LIRSHandle* h);
-  void ShiftQueueHead();
   void PushToStack(LIRSHandle* h);
   void RemoveFromStack(LIRSHandle* h);
   void AdjustToStackTop(LIRSHandle* h);
-  void AdjustStackBottom();
+  // Turn the LIR stack bottom into a HIR entry, false if there is no LIR
+  bool DemoteStackBottom();
   void StackPruning();
   void LIRS_Remove(LIRSHandle* h);
   void LIRS_Insert(LIRSHandle* h);
+  // Move an entry in the stack and queue for one hit
+  void LIRS_Access(LIRSHandle* h);
   bool Unref(LIRSHandle* h);
+  // Take a reference unless the last one is already gone
+  static bool TryRef(LIRSHandle* h);
+  // Remove an unreferenced entry from the table, stack and queue, false if
+  // a lookup referenced it meanwhile and will free it
+  bool EvictEntry(LIRSHandle* h, autovector<LIRSHandle*>* deleted);
   void EvictFromLIRS(size_t charge, autovector<LIRSHandle*>* deleted);
 
-  size_t capacity_;
+  // Record a hit of `h`, the caller holds a reference
+  void RecordAccess(LIRSHandle* h);
+  // Apply all buffered hits, mutex_ must be held
+  void ApplyAccesses(autovector<LIRSHandle*>* deleted);
+
+  // Retire the handles freed since the last call and collect in `reclaimed`
+  // those no lookup can see any more, mutex_ must be held
+  void ReclaimLocked(autovector<LIRSHandle*>* reclaimed);
+  // Run the deleters of handles whose last reference is gone and free the
+  // memory of reclaimed ones, mutex_ must not be held
+  void Free(const autovector<LIRSHandle*>& last_references,
+            const autovector<LIRSHandle*>& reclaimed);
+
+  std::atomic<size_t> capacity_;
   size_t stack_capacity_;
-  size_t usage_;
+  std::atomic<size_t> usage_;
   size_t stack_usage_;
   double irr_ratio_;
   LIRSHandle cache_;
+  std::unique_ptr<LIRSReadEpoch> own_epoch_;
+  LIRSReadEpoch* epoch_;
+  // Written under mutex_, read by lookups without it
   LIRSHandleTable table_;
   bool strict_capacity_limit_;
+  std::atomic<size_t> num_accesses_;
+  std::atomic<LIRSHandle*> accesses_[kAccessBufferSize];
+  // Handles whose deleter ran, linked by next_queue, to be retired
+  std::atomic<LIRSHandle*> freed_;
+  // Retired handles and their epoch, oldest first
+  std::deque<std::pair<uint64_t, LIRSHandle*>> retired_;
+  // Guards the table writes, stack, queue, entry states, stack_usage_ and
+  // retired_
   mutable port::Mutex mutex_;
 };
 
@@ -158,6 +276,7 @@ class LIRSCache : public ShardedCache {
   virtual void DisownData() override;
 
  private:
+  LIRSReadEpoch epoch_;
   LIRSCacheShard* shards_ = nullptr;
   int num_shards_ = 0;
 };
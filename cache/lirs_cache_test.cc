@@ -0,0 +1,223 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cache/lirs_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "port/port.h"
+#include "util/random.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class LIRSCacheTest : public testing::Test {
+ public:
+  LIRSCacheTest() {}
+  ~LIRSCacheTest() { DeleteCache(); }
+
+  void DeleteCache() {
+    if (cache_ != nullptr) {
+      cache_->~LIRSCacheShard();
+      port::cacheline_aligned_free(cache_);
+      cache_ = nullptr;
+    }
+  }
+
+  void NewCache(size_t capacity, double irr_ratio) {
+    DeleteCache();
+    cache_ = reinterpret_cast<LIRSCacheShard*>(
+        port::cacheline_aligned_alloc(sizeof(LIRSCacheShard)));
+    new (cache_) LIRSCacheShard(capacity, false /*strict_capcity_limit*/,
+                                irr_ratio);
+  }
+
+  void Insert(const std::string& key) {
+    cache_->Insert(key, 0 /*hash*/, nullptr /*value*/, 1 /*charge*/,
+                   nullptr /*deleter*/, nullptr /*handle*/,
+                   Cache::Priority::LOW);
+  }
+
+  void Insert(char key) { Insert(std::string(1, key)); }
+
+  bool Lookup(const std::string& key) {
+    auto handle = cache_->Lookup(key, 0 /*hash*/);
+    if (handle) {
+      cache_->Release(handle);
+      return true;
+    }
+    return false;
+  }
+
+  bool Lookup(char key) { return Lookup(std::string(1, key)); }
+
+  void ValidateLists(const std::string& stack, const std::string& queue) {
+    std::vector<std::string> stack_keys, queue_keys;
+    cache_->TEST_GetLIRSLists(&stack_keys, &queue_keys);
+    std::string s, q;
+    for (auto& key : stack_keys) {
+      s += key;
+    }
+    for (auto& key : queue_keys) {
+      q += key;
+    }
+    ASSERT_EQ(stack, s);
+    ASSERT_EQ(queue, q);
+  }
+
+ protected:
+  LIRSCacheShard* cache_ = nullptr;
+};
+
+TEST_F(LIRSCacheTest, BasicLIRS) {
+  NewCache(5, 0.6);
+  // 3 LIR entries, HIR entries go to the stack and the queue
+  for (char key = 'a'; key <= 'e'; ++key) {
+    Insert(key);
+  }
+  ValidateLists("edcba", "ed");
+
+  // A hit on a HIR entry in the stack promotes it, the LIR stack bottom
+  // becomes HIR
+  ASSERT_TRUE(Lookup('d'));
+  ValidateLists("decb", "ae");
+
+  // A new entry evicts the queue head
+  Insert('f');
+  ASSERT_FALSE(Lookup('e'));
+  ValidateLists("fdcb", "fa");
+
+  // A hit on a HIR entry out of the stack moves it to the queue tail
+  ASSERT_TRUE(Lookup('a'));
+  ValidateLists("afdcb", "af");
+
+  // A hit on the LIR stack bottom prunes the HIR entries above it
+  ASSERT_TRUE(Lookup('b'));
+  ValidateLists("bafdc", "af");
+}
+
+TEST_F(LIRSCacheTest, ScanResistant) {
+  NewCache(10, 0.5);
+  for (char key = 'a'; key <= 'e'; ++key) {
+    Insert(key);
+    ASSERT_TRUE(Lookup(key));
+  }
+  // A scan of entries used once only churns the HIR entries
+  for (int i = 0; i < 100; ++i) {
+    Insert("scan" + ToString(i));
+  }
+  for (char key = 'a'; key <= 'e'; ++key) {
+    ASSERT_TRUE(Lookup(key));
+  }
+}
+
+TEST_F(LIRSCacheTest, PinnedEntriesStay) {
+  NewCache(2, 0.5);
+  Insert('a');
+  Insert('b');
+  auto handle = cache_->Lookup("b", 0);
+  ASSERT_NE(nullptr, handle);
+  Insert('c');
+  Insert('d');
+  // The referenced HIR entry is skipped by eviction, and a second lookup of
+  // it works
+  auto handle2 = cache_->Lookup("b", 0);
+  ASSERT_EQ(handle, handle2);
+  cache_->Release(handle2);
+  cache_->Release(handle);
+  ASSERT_TRUE(Lookup('b'));
+}
+
+TEST_F(LIRSCacheTest, ConcurrentLookup) {
+  const int kNumKeys = 1000;
+  NewCache(kNumKeys / 2, 0.9);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([this, t] {
+      Random rnd(301 + t);
+      for (int i = 0; i < 20000; ++i) {
+        std::string key = ToString(rnd.Uniform(kNumKeys));
+        if (!Lookup(key)) {
+          Insert(key);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::vector<std::string> stack, queue;
+  // Applies the pending accesses, which hold references
+  cache_->TEST_GetLIRSLists(&stack, &queue);
+  ASSERT_EQ(0, cache_->GetPinnedUsage());
+  cache_->SetCapacity(kNumKeys / 4);
+  ASSERT_LE(cache_->GetUsage(), kNumKeys / 4);
+  // Every entry is in the stack or the queue, HIR entries may be in both
+  cache_->TEST_GetLIRSLists(&stack, &queue);
+  size_t num_entries = stack.size();
+  for (auto& key : queue) {
+    if (std::find(stack.begin(), stack.end(), key) == stack.end()) {
+      ++num_entries;
+    }
+  }
+  ASSERT_EQ(cache_->GetUsage(), num_entries);
+}
+
+TEST_F(LIRSCacheTest, LookupWhileTableChanges) {
+  const int kNumPinned = 100;
+  NewCache(1000000, 0.9);
+  std::vector<Cache::Handle*> pinned;
+  for (int i = 0; i < kNumPinned; ++i) {
+    Cache::Handle* handle = nullptr;
+    ASSERT_OK(cache_->Insert("pinned" + ToString(i), 0 /*hash*/,
+                             nullptr /*value*/, 1 /*charge*/,
+                             nullptr /*deleter*/, &handle,
+                             Cache::Priority::LOW));
+    pinned.push_back(handle);
+  }
+  // Lookups don't lock out the table growing and entries leaving it, they
+  // must still find every entry that stays
+  std::atomic<bool> done(false);
+  std::atomic<int> misses(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&, t] {
+      Random rnd(301 + t);
+      while (!done.load()) {
+        if (!Lookup("pinned" + ToString(rnd.Uniform(kNumPinned)))) {
+          misses.fetch_add(1);
+        }
+        Lookup(ToString(rnd.Uniform(4000)));
+      }
+    });
+  }
+  // Keys of this fixture all hash to 0 and share one chain, which every
+  // resize still relinks
+  for (int i = 0; i < 4000; ++i) {
+    Insert(ToString(i));
+    if (i % 2 == 0) {
+      cache_->Erase(ToString(i / 2), 0 /*hash*/);
+    }
+  }
+  done.store(true);
+  for (auto& thread : readers) {
+    thread.join();
+  }
+  ASSERT_EQ(0, misses.load());
+  for (auto handle : pinned) {
+    cache_->Release(handle);
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -169,11 +169,11 @@ Status BuildTable(
       void* trans_to_separate_callback_args = nullptr;
 
       Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                             const Slice& meta, bool is_merge,
-                             bool is_index) override {
+                             const Slice& meta, bool is_merge, bool is_index,
+                             uint64_t location) override {
         return SeparateHelper::TransToSeparate(
             internal_key, value, value.file_number(), meta, is_merge, is_index,
-            value_meta_extractor.get());
+            value_meta_extractor.get(), location);
       }
 
       Status TransToSeparate(const Slice& internal_key,
@@ -290,7 +290,10 @@ Status BuildTable(
         status = SeparateHelper::TransToSeparate(
             key, value, blob_meta->fd.GetNumber(), Slice(),
             GetInternalKeyType(key) == kTypeMerge, false,
-            separate_helper.value_meta_extractor.get());
+            separate_helper.value_meta_extractor.get(),
+            mutable_cf_options.blob_value_location
+                ? blob_builder->LastEntryLocation()
+                : SeparateHelper::kNoLocation);
       }
       return status;
     };
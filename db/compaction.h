@@ -165,6 +165,12 @@ struct CompactionWorkerContext {
   int level, output_level, number_levels;
   bool skip_filters, bottommost_level, allow_ingest_behind, preserve_deletes;
   std::vector<NameParam> int_tbl_prop_collector_factories;
+  // garbage collection, inputs are the blob SSTs on level -1
+  CompactionType compaction_type = kKeyValueCompaction;
+  // (level, file number) of every SST of the input version, the read-only LSM
+  // view the worker answers the liveness queries of garbage collection from
+  std::vector<std::pair<int, uint64_t>> lsm_files;
+  uint64_t max_sequential_skip_in_iterations = 8;
 };
 
 struct CompactionWorkerResult {
@@ -16,8 +16,14 @@
 #endif
 
 #include <inttypes.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #ifdef WITH_TERARK_ZIP
 #include <terark/num_to_str.hpp>
@@ -27,9 +33,12 @@
 #endif
 
 #include "db/compaction_iterator.h"
+#include "db/compaction_job.h"
+#include "db/compaction_worker_codec.h"
 #include "db/map_builder.h"
 #include "db/merge_helper.h"
 #include "db/range_del_aggregator.h"
+#include "db/version_set.h"
 #include "rocksdb/advanced_options.h"
 #include "rocksdb/compaction_filter.h"
 #include "rocksdb/comparator.h"
@@ -39,11 +48,13 @@
 #include "rocksdb/status.h"
 #include "rocksdb/table.h"
 #include "rocksdb/types.h"
+#include "table/iterator_wrapper.h"
 #include "table/merging_iterator.h"
 #include "table/table_reader.h"
 #include "table/two_level_iterator.h"
 #include "util/c_style_callback.h"
 #include "util/filename.h"
+#include "util/hash.h"
 
 #ifndef WITH_TERARK_ZIP
 #define USE_AJSON 1
@@ -266,11 +277,11 @@ class WorkerSeparateHelper : public SeparateHelper, public LazyBufferState {
 
   using SeparateHelper::TransToSeparate;
   Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                         const Slice& meta, bool is_merge,
-                         bool is_index) override {
+                         const Slice& meta, bool is_merge, bool is_index,
+                         uint64_t location) override {
     return SeparateHelper::TransToSeparate(
         internal_key, value, value.file_number(), meta, is_merge, is_index,
-        value_meta_extractor_.get());
+        value_meta_extractor_.get(), location);
   }
 
   LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
@@ -314,8 +325,8 @@ class WorkerSeparateHelper : public SeparateHelper, public LazyBufferState {
 std::function<CompactionWorkerResult()>
 RemoteCompactionDispatcher::StartCompaction(
     const CompactionWorkerContext& context) {
-  ajson::string_stream stream;
-  ajson::save_to(stream, context);
+  std::string data;
+  EncodeCompactionWorkerContext(context, &data);
   struct Result {
     Result(std::future<std::string>&& _future) : future(_future.share()) {}
 
@@ -324,6 +335,14 @@ RemoteCompactionDispatcher::StartCompaction(
     CompactionWorkerResult operator()() {
       CompactionWorkerResult result;
       std::string encoded_result = future.get();
+      if (IsCompactionWorkerMessage(encoded_result)) {
+        Status s = DecodeCompactionWorkerResult(encoded_result, &result);
+        if (!s.ok()) {
+          result.status = std::move(s);
+        }
+        return result;
+      }
+      // Workers which only speak the legacy encoding
       try {
         ajson::load_from_buff(result, encoded_result);
       } catch (const std::exception& ex) {
@@ -336,7 +355,7 @@ RemoteCompactionDispatcher::StartCompaction(
       return result;
     }
   };
-  std::future<std::string> str_result = DoCompaction(stream.str());
+  std::future<std::string> str_result = DoCompaction(std::move(data));
   return Result(std::move(str_result));
 }
 
@@ -388,17 +407,40 @@ class RemoteCompactionProxy : public CompactionIterator::CompactionProxy {
   bool bottommost_level_, allow_ingest_behind_, preserve_deletes_;
 };
 
-static std::string make_error(Status&& status) {
-  CompactionWorkerResult result;
-  result.status = std::move(status);
+static std::string encode_result(const CompactionWorkerResult& result,
+                                 bool binary) {
+  if (binary) {
+    std::string data;
+    EncodeCompactionWorkerResult(result, &data);
+    return data;
+  }
   ajson::string_stream stream;
   ajson::save_to(stream, result);
   return stream.str();
-};
+}
 
 std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
+  return DoCompaction(data, nullptr);
+}
+
+std::string RemoteCompactionDispatcher::Worker::DoCompaction(
+    Slice data, const FileFinishedCallback& on_file_finished) {
+  // Answer in the encoding the request came in
+  const bool binary = IsCompactionWorkerMessage(data);
+  auto make_error = [binary](Status&& status) {
+    CompactionWorkerResult result;
+    result.status = std::move(status);
+    return encode_result(result, binary);
+  };
   CompactionWorkerContext context;
-  ajson::load_from_buff(context, data);
+  if (binary) {
+    Status s = DecodeCompactionWorkerContext(data, &context);
+    if (!s.ok()) {
+      return make_error(std::move(s));
+    }
+  } else {
+    ajson::load_from_buff(context, data);
+  }
   context.compaction_filter_context.smallest_user_key =
       context.smallest_user_key;
   context.compaction_filter_context.largest_user_key = context.largest_user_key;
@@ -539,7 +581,8 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
     auto find = table_cache.find(file_number);
     if (find == table_cache.end()) {
       assert(contxt_dependence_map.count(file_number) > 0);
-      const FileMetaData* file_metadata = contxt_dependence_map[file_number];
+      const FileMetaData* file_metadata =
+          contxt_dependence_map.find(file_number)->second;
       std::string file_name =
           TableFileName(immutable_cf_options.cf_paths, file_number,
                         file_metadata->fd.GetPathId());
@@ -665,19 +708,26 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   CompactionRangeDelAggregator range_del_agg(icmp, context.existing_snapshots);
 
   Arena arena;
-  auto create_input_iterator = [&]() -> InternalIterator* {
-    MergeIteratorBuilder merge_iter_builder(icmp, &arena);
-    for (auto& pair : inputs) {
-      if (pair.first == 0 || pair.second.size() == 1) {
-        merge_iter_builder.AddIterator(new_iterator(
-            pair.second.front(), contxt_dependence_map, &arena, nullptr));
+  typedef std::unordered_map<int, std::vector<const FileMetaData*>> LevelFiles;
+  // Level 0 and blob files (level -1) overlap, every file is its own source
+  auto create_levels_iterator = [&](const LevelFiles& levels,
+                                    Arena* iter_arena) -> InternalIterator* {
+    MergeIteratorBuilder merge_iter_builder(icmp, iter_arena);
+    for (auto& pair : levels) {
+      if (pair.first <= 0 || pair.second.size() == 1) {
+        for (auto f : pair.second) {
+          merge_iter_builder.AddIterator(
+              new_iterator(f, contxt_dependence_map, iter_arena, nullptr));
+        }
       } else {
         auto map_iter = NewMapElementIterator(
             pair.second.data(), pair.second.size(), icmp,
-            c_style_new_iterator.arg, c_style_new_iterator.callback, &arena);
+            c_style_new_iterator.arg, c_style_new_iterator.callback,
+            iter_arena);
         auto level_iter = NewMapSstIterator(
             nullptr, map_iter, contxt_dependence_map, *icmp,
-            c_style_new_iterator.arg, c_style_new_iterator.callback, &arena);
+            c_style_new_iterator.arg, c_style_new_iterator.callback,
+            iter_arena);
         level_iter->RegisterCleanup(
             [](void* arg1, void* /*arg2*/) {
               static_cast<InternalIterator*>(arg1)->~InternalIterator();
@@ -688,6 +738,134 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
     }
     return merge_iter_builder.Finish();
   };
+  auto create_input_iterator = [&]() -> InternalIterator* {
+    return create_levels_iterator(inputs, &arena);
+  };
+
+  if (context.compaction_type == kGarbageCollection) {
+    // Same as CompactionJob::ProcessGarbageCollection, liveness comes from
+    // the shipped LSM view instead of a Version
+    CompactionWorkerResult result;
+    Status& status = result.status;
+    std::vector<const FileMetaData*> garbage_inputs;
+    for (auto& pair : inputs) {
+      garbage_inputs.insert(garbage_inputs.end(), pair.second.begin(),
+                            pair.second.end());
+    }
+    LevelFiles lsm;
+    for (auto& pair : context.lsm_files) {
+      auto found = contxt_dependence_map.find(pair.second);
+      if (found == contxt_dependence_map.end()) {
+        return make_error(Status::Corruption("LSM view file missing"));
+      }
+      lsm[pair.first].push_back(found->second);
+    }
+    SortedKeyGetter key_getter(
+        *icmp,
+        [&](Arena* iter_arena) {
+          return create_levels_iterator(lsm, iter_arena);
+        },
+        context.max_sequential_skip_in_iterations);
+
+    auto create_gc_iter = [&](Arena* iter_arena) -> InternalIterator* {
+      std::vector<InternalIterator*> list;
+      list.reserve(garbage_inputs.size());
+      for (auto f : garbage_inputs) {
+        list.push_back(
+            new_iterator(f, contxt_dependence_map, iter_arena, nullptr));
+      }
+      return NewMergingIterator(icmp, list.data(),
+                                static_cast<int>(list.size()), iter_arena);
+    };
+    GarbageCollectionConflictMap conflict_map;
+    auto filter_conflict = [&](const Slice& ikey, const LazyBuffer& value) {
+      return conflict_map.IsConflict(ikey, value.file_number());
+    };
+    LazyInternalIteratorWrapper second_pass_iter(
+        c_style_callback(create_gc_iter), &create_gc_iter,
+        c_style_callback(filter_conflict), &filter_conflict,
+        nullptr /* arena */);
+
+    std::string file_name = GenerateOutputFileName(0);
+    std::unique_ptr<WritableFile> blob_file;
+    status = env->NewWritableFile(file_name, &blob_file, env_opt);
+    if (!status.ok()) {
+      return encode_result(result, binary);
+    }
+    std::unique_ptr<WritableFileWriter> writer(
+        new WritableFileWriter(std::move(blob_file), file_name, env_opt,
+                               nullptr, immutable_db_options.listeners));
+    TableBuilderOptions table_builder_options(
+        immutable_cf_options, mutable_cf_options, *icmp,
+        &int_tbl_prop_collector_factories.data, context.compression,
+        context.compression_opts, nullptr /* compression_dict */,
+        true /* skip_filters */, context.cf_name, -1 /* level */,
+        0 /* compaction_load */);
+    std::unique_ptr<TableBuilder> builder(
+        immutable_cf_options.table_factory->NewTableBuilder(
+            table_builder_options, 0, writer.get()));
+    builder->SetSecondPassIterator(&second_pass_iter);
+
+    std::unique_ptr<InternalIterator> input(create_gc_iter(nullptr));
+    FileMetaData meta;
+    GarbageCollectionCounter counter;
+    // only the dependence of the input blobs is shipped, a file number missing
+    // here refers to some other blob
+    status = CopyLiveBlobRecords(
+        input.get(), &key_getter, contxt_dependence_map,
+        false /* dependence_map_complete */, *icmp, nullptr /* should_stop */,
+        builder.get(), &meta, &conflict_map, &counter);
+    input.reset();
+
+    std::vector<uint64_t> inheritance_chain = GarbageCollectionInheritanceChain(
+        garbage_inputs, contxt_dependence_map, nullptr /* raw_chain_length */);
+    if (status.ok()) {
+      meta.prop.num_entries = builder->NumEntries();
+      meta.prop.inheritance_chain = std::move(inheritance_chain);
+      status = builder->Finish(&meta.prop, nullptr);
+    } else {
+      builder->Abandon();
+    }
+    if (status.ok()) {
+      status = writer->Sync(true);
+    }
+    if (status.ok()) {
+      status = writer->Close();
+    }
+    if (status.ok() && meta.prop.num_entries > 0 &&
+        meta.prop.num_entries < counter.input) {
+      CompactionWorkerResult::FileInfo file_info;
+      file_info.file_name = file_name;
+      file_info.smallest = meta.smallest;
+      file_info.largest = meta.largest;
+      file_info.smallest_seqno = meta.fd.smallest_seqno;
+      file_info.largest_seqno = meta.fd.largest_seqno;
+      file_info.file_size = builder->FileSize();
+      file_info.marked_for_compaction = builder->NeedCompact();
+      result.files.emplace_back(file_info);
+      if (on_file_finished) {
+        std::string encoded_file_info;
+        EncodeCompactionWorkerFileInfo(file_info, &encoded_file_info);
+        on_file_finished(encoded_file_info);
+      }
+    } else {
+      // Nothing or everything is garbage, same as the local GC the output is
+      // dropped
+      env->DeleteFile(file_name);
+    }
+    fprintf(stderr,
+            "INFO: GC %zd files, %" PRIu64 " inputs, %" PRIu64
+            " kept, lsm scan: %" PRIu64 " next, %" PRIu64 " seek\n",
+            garbage_inputs.size(), counter.input, meta.prop.num_entries,
+            key_getter.num_next(), key_getter.num_seek());
+    builder.reset();
+    writer.reset();
+    auto duration =
+        duration_cast<microseconds>(system_clock::now() - start_time);
+    result.time_us = duration.count();
+    return encode_result(result, binary);
+  }
+
   ScopedArenaIterator input(create_input_iterator());
 
   auto compaction_filter = immutable_cf_options.compaction_filter;
@@ -967,6 +1145,11 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
       file_info.file_size = meta.fd.file_size;
       file_info.marked_for_compaction = builder->NeedCompact();
       result.files.emplace_back(file_info);
+      if (on_file_finished) {
+        std::string encoded_file_info;
+        EncodeCompactionWorkerFileInfo(file_info, &encoded_file_info);
+        on_file_finished(encoded_file_info);
+      }
     }
     meta = FileMetaData();
     builder.reset();
@@ -1081,9 +1264,103 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   auto finish_time = system_clock::now();
   auto duration = duration_cast<microseconds>(finish_time - start_time);
   result.time_us = duration.count();
-  ajson::string_stream stream;
-  ajson::save_to(stream, result);
-  return stream.str();
+  return encode_result(result, binary);
+}
+
+// Full read / write on the worker transport, false on error or EOF
+static bool ReadFully(int fd, char* buf, size_t n) {
+  while (n > 0) {
+    ssize_t r = ::read(fd, buf, n);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return false;
+    }
+    buf += r;
+    n -= r;
+  }
+  return true;
+}
+
+static bool WriteFully(int fd, const char* buf, size_t n) {
+  while (n > 0) {
+    // MSG_NOSIGNAL, a peer which went away must not raise SIGPIPE
+    ssize_t r = ::send(fd, buf, n, MSG_NOSIGNAL);
+    if (r < 0 && errno == ENOTSOCK) {
+      r = ::write(fd, buf, n);
+    }
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return false;
+    }
+    buf += r;
+    n -= r;
+  }
+  return true;
+}
+
+static Status WriteFrame(int fd, CompactionWorkerFrameType type,
+                         const Slice& payload) {
+  char header[kCompactionWorkerFrameHeaderSize];
+  Status s = EncodeCompactionWorkerFrameHeader(type, payload.size(), header);
+  if (s.ok() && (!WriteFully(fd, header, sizeof header) ||
+                 !WriteFully(fd, payload.data(), payload.size()))) {
+    s = Status::IOError("Compaction worker write", strerror(errno));
+  }
+  return s;
+}
+
+static Status ReadFrame(int fd, CompactionWorkerFrameType* type,
+                        std::string* payload) {
+  char header[kCompactionWorkerFrameHeaderSize];
+  if (!ReadFully(fd, header, sizeof header)) {
+    return Status::IOError("Compaction worker transport closed");
+  }
+  size_t size;
+  Status s = DecodeCompactionWorkerFrameHeader(header, type, &size);
+  if (!s.ok()) {
+    return s;
+  }
+  payload->resize(size);
+  if (!ReadFully(fd, &(*payload)[0], size)) {
+    return Status::IOError("Compaction worker transport truncated");
+  }
+  return Status::OK();
+}
+
+int RemoteCompactionDispatcher::Worker::Serve(int in_fd, int out_fd) {
+  std::string request;
+  for (;;) {
+    CompactionWorkerFrameType type;
+    Status s = ReadFrame(in_fd, &type, &request);
+    if (s.IsIOError() && request.empty()) {
+      return 0;  // dispatcher closed the transport
+    }
+    if (!s.ok() || type != kCompactionWorkerRequest) {
+      fprintf(stderr, "ERROR: CompactionWorker::Serve: bad request: %s\n",
+              s.ok() ? "unexpected frame" : s.ToString().c_str());
+      return 1;
+    }
+    std::string result = DoCompaction(
+        request, [&](const std::string& encoded_file_info) {
+          if (s.ok()) {
+            s = WriteFrame(out_fd, kCompactionWorkerFileFinished,
+                           encoded_file_info);
+          }
+        });
+    if (s.ok()) {
+      s = WriteFrame(out_fd, kCompactionWorkerResult, result);
+    }
+    if (!s.ok()) {
+      fprintf(stderr, "ERROR: CompactionWorker::Serve: %s\n",
+              s.ToString().c_str());
+      return 1;
+    }
+    request.clear();
+  }
 }
 
 void RemoteCompactionDispatcher::Worker::DebugSerializeCheckResult(Slice data) {
@@ -1166,4 +1443,154 @@ std::shared_ptr<CompactionDispatcher> NewCommandLineCompactionDispatcher(
   return std::make_shared<CommandLineCompactionDispatcher>(std::move(cmd));
 }
 
+// Keeps num_workers worker processes started from cmd alive, each serving
+// jobs over its own Unix socket pair through Worker::Serve(). A job takes an
+// idle worker instead of forking, and output files are reported as soon as
+// the worker finishes them.
+class LocalWorkerPoolCompactionDispatcher : public RemoteCompactionDispatcher {
+  struct Process {
+    pid_t pid = -1;
+    int fd = -1;
+  };
+
+  std::string m_cmd;
+  CompactionProgressCallback m_on_progress;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  // Idle workers, pid < 0 is a slot whose worker has to be (re)started
+  std::vector<Process> m_idle;
+
+  Status Spawn(Process* p) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+      return Status::IOError("socketpair", strerror(errno));
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+      int err = errno;
+      close(sv[0]);
+      close(sv[1]);
+      return Status::IOError("fork", strerror(err));
+    }
+    if (pid == 0) {
+      // Worker reads requests from stdin and writes frames to stdout
+      dup2(sv[1], 0);
+      dup2(sv[1], 1);
+      execl("/bin/sh", "sh", "-c", m_cmd.c_str(), (char*)nullptr);
+      _exit(127);
+    }
+    close(sv[1]);
+    p->pid = pid;
+    p->fd = sv[0];
+    return Status::OK();
+  }
+
+  static void Stop(Process* p) {
+    if (p->fd >= 0) {
+      // Worker::Serve() returns on EOF
+      close(p->fd);
+      p->fd = -1;
+    }
+    if (p->pid > 0) {
+      int status;
+      while (waitpid(p->pid, &status, 0) < 0 && errno == EINTR) {
+      }
+      p->pid = -1;
+    }
+  }
+
+  Process Acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return !m_idle.empty(); });
+    Process p = m_idle.back();
+    m_idle.pop_back();
+    return p;
+  }
+
+  void Release(Process p) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.push_back(p);
+    m_cv.notify_one();
+  }
+
+  std::string RunJob(const std::string& data) {
+    Process p = Acquire();
+    Status s;
+    if (p.pid < 0) {
+      s = Spawn(&p);
+    }
+    std::string payload;
+    if (s.ok()) {
+      s = WriteFrame(p.fd, kCompactionWorkerRequest, data);
+    }
+    CompactionWorkerResult partial;
+    while (s.ok()) {
+      CompactionWorkerFrameType type;
+      s = ReadFrame(p.fd, &type, &payload);
+      if (!s.ok() || type == kCompactionWorkerResult) {
+        break;
+      }
+      CompactionWorkerResult::FileInfo file_info;
+      if (type != kCompactionWorkerFileFinished ||
+          !DecodeCompactionWorkerFileInfo(payload, &file_info).ok()) {
+        s = Status::Corruption("Compaction worker sent a bad frame");
+        break;
+      }
+      if (m_on_progress) {
+        partial.files.emplace_back(std::move(file_info));
+        m_on_progress(partial);
+      }
+    }
+    if (!s.ok()) {
+      fprintf(stderr, "ERROR: CompactionWorker(%s, pid=%d) = %s\n",
+              m_cmd.c_str(), int(p.pid), s.ToString().c_str());
+      // Restart the worker for the next job, its state is unknown
+      if (p.pid > 0) {
+        kill(p.pid, SIGKILL);
+      }
+      Stop(&p);
+      CompactionWorkerResult result;
+      result.status = std::move(s);
+      payload.clear();
+      EncodeCompactionWorkerResult(result, &payload);
+    }
+    Release(p);
+    return payload;
+  }
+
+ public:
+  LocalWorkerPoolCompactionDispatcher(std::string&& cmd, size_t num_workers,
+                                      CompactionProgressCallback&& on_progress)
+      : m_cmd(std::move(cmd)), m_on_progress(std::move(on_progress)) {
+    m_idle.resize(std::max<size_t>(num_workers, 1));
+    for (auto& p : m_idle) {
+      Status s = Spawn(&p);
+      if (!s.ok()) {
+        fprintf(stderr, "WARN: CompactionWorker(%s) prefork = %s\n",
+                m_cmd.c_str(), s.ToString().c_str());
+      }
+    }
+  }
+
+  ~LocalWorkerPoolCompactionDispatcher() {
+    // All jobs hold a future, so every worker is idle here
+    for (auto& p : m_idle) {
+      Stop(&p);
+    }
+  }
+
+  std::future<std::string> DoCompaction(std::string data) override {
+    return std::async(std::launch::async,
+                      [this](const std::string& d) { return RunJob(d); },
+                      std::move(data));
+  }
+};
+
+std::shared_ptr<CompactionDispatcher> NewLocalWorkerPoolCompactionDispatcher(
+    std::string cmd, size_t num_workers,
+    CompactionProgressCallback on_progress) {
+  return std::make_shared<LocalWorkerPoolCompactionDispatcher>(
+      std::move(cmd), num_workers, std::move(on_progress));
+}
+
 }  // namespace rocksdb
@@ -0,0 +1,503 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rocksdb/compaction_dispatcher.h"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "db/compaction_worker_codec.h"
+#include "db/db_test_util.h"
+#include "port/stack_trace.h"
+
+namespace rocksdb {
+
+namespace {
+
+// Set by main(), the pool tests start this binary with --serve
+std::string test_binary;
+
+// Writes its output files to dir, so they don't mix with the DB files
+class TestWorker : public RemoteCompactionDispatcher::Worker {
+ public:
+  explicit TestWorker(const std::string& dir)
+      : RemoteCompactionDispatcher::Worker(EnvOptions(), Env::Default()),
+        dir_(dir) {}
+
+  virtual std::string GenerateOutputFileName(size_t file_index) override {
+    static std::atomic<uint64_t> next_id(0);
+    return dir_ + "/worker-" + ToString(getpid()) + "-" +
+           ToString(next_id.fetch_add(1)) + "-" + ToString(file_index) +
+           ".sst";
+  }
+
+ private:
+  std::string dir_;
+};
+
+bool ReadFully(int fd, char* buf, size_t n) {
+  while (n > 0) {
+    ssize_t r = ::read(fd, buf, n);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return false;
+    }
+    buf += r;
+    n -= r;
+  }
+  return true;
+}
+
+bool WriteFully(int fd, const char* buf, size_t n) {
+  while (n > 0) {
+    ssize_t r = ::write(fd, buf, n);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return false;
+    }
+    buf += r;
+    n -= r;
+  }
+  return true;
+}
+
+Status WriteFrame(int fd, CompactionWorkerFrameType type,
+                  const Slice& payload) {
+  char header[kCompactionWorkerFrameHeaderSize];
+  Status s = EncodeCompactionWorkerFrameHeader(type, payload.size(), header);
+  if (s.ok() && (!WriteFully(fd, header, sizeof header) ||
+                 !WriteFully(fd, payload.data(), payload.size()))) {
+    s = Status::IOError("write frame");
+  }
+  return s;
+}
+
+Status ReadFrame(int fd, CompactionWorkerFrameType* type,
+                 std::string* payload) {
+  char header[kCompactionWorkerFrameHeaderSize];
+  if (!ReadFully(fd, header, sizeof header)) {
+    return Status::IOError("read frame header");
+  }
+  size_t size;
+  Status s = DecodeCompactionWorkerFrameHeader(header, type, &size);
+  if (s.ok()) {
+    payload->resize(size);
+    if (!ReadFully(fd, &(*payload)[0], size)) {
+      s = Status::IOError("read frame payload");
+    }
+  }
+  return s;
+}
+
+// Runs every job in process, on a TestWorker serving one end of a socket
+// pair, and keeps the requests and the frames the worker sent
+class SocketPairCompactionDispatcher : public RemoteCompactionDispatcher {
+ public:
+  explicit SocketPairCompactionDispatcher(const std::string& dir)
+      : dir_(dir) {}
+
+  virtual std::future<std::string> DoCompaction(std::string data) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests.push_back(data);
+    }
+    return std::async(std::launch::async,
+                      [this](const std::string& d) { return Serve(d); },
+                      std::move(data));
+  }
+
+  std::mutex mutex_;
+  std::vector<std::string> requests;
+  // Requests and results of the finished jobs, in completion order
+  std::vector<std::pair<CompactionWorkerContext, CompactionWorkerResult>> jobs;
+  std::vector<std::string> streamed_files;
+  std::vector<std::string> result_files;
+  std::vector<int> exit_codes;
+  bool bad_frame = false;
+
+ private:
+  std::string Serve(const std::string& data) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+      return std::string();
+    }
+    TestWorker worker(dir_);
+    int exit_code = -1;
+    std::thread thread([&] { exit_code = worker.Serve(sv[1], sv[1]); });
+
+    std::vector<std::string> streamed;
+    std::string payload;
+    CompactionWorkerFrameType type = kCompactionWorkerRequest;
+    Status s = WriteFrame(sv[0], kCompactionWorkerRequest, data);
+    while (s.ok()) {
+      s = ReadFrame(sv[0], &type, &payload);
+      if (!s.ok() || type != kCompactionWorkerFileFinished) {
+        break;
+      }
+      CompactionWorkerResult::FileInfo file_info;
+      s = DecodeCompactionWorkerFileInfo(payload, &file_info);
+      streamed.push_back(file_info.file_name);
+    }
+    // Serve() returns once the dispatcher closes the transport
+    shutdown(sv[0], SHUT_RDWR);
+    thread.join();
+    close(sv[0]);
+    close(sv[1]);
+
+    CompactionWorkerContext context;
+    CompactionWorkerResult result;
+    bool bad = !s.ok() || type != kCompactionWorkerResult ||
+               !DecodeCompactionWorkerResult(payload, &result).ok() ||
+               !DecodeCompactionWorkerContext(data, &context).ok();
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs.emplace_back(context, result);
+    bad_frame |= bad;
+    exit_codes.push_back(exit_code);
+    streamed_files.insert(streamed_files.end(), streamed.begin(),
+                          streamed.end());
+    for (auto& f : result.files) {
+      result_files.push_back(f.file_name);
+    }
+    return payload;
+  }
+
+  std::string dir_;
+};
+
+CompactionWorkerResult WaitResult(std::future<std::string>* future) {
+  CompactionWorkerResult result;
+  Status s = DecodeCompactionWorkerResult(future->get(), &result);
+  if (!s.ok()) {
+    result.status = s;
+  }
+  return result;
+}
+
+}  // namespace
+
+class CompactionDispatcherTest : public DBTestBase {
+ public:
+  CompactionDispatcherTest() : DBTestBase("/compaction_dispatcher_test") {
+    worker_dir_ = dbname_ + "_worker";
+    DestroyWorkerDir();
+    EXPECT_OK(env_->CreateDirIfMissing(worker_dir_));
+  }
+
+  ~CompactionDispatcherTest() { DestroyWorkerDir(); }
+
+  void DestroyWorkerDir() {
+    std::vector<std::string> children;
+    if (env_->GetChildren(worker_dir_, &children).ok()) {
+      for (auto& child : children) {
+        env_->DeleteFile(worker_dir_ + "/" + child);
+      }
+      env_->DeleteDir(worker_dir_);
+    }
+  }
+
+  Options DispatcherOptions(std::shared_ptr<CompactionDispatcher> dispatcher) {
+    Options options = CurrentOptions();
+    options.compaction_dispatcher = dispatcher;
+    options.disable_auto_compactions = true;
+    options.enable_lazy_compaction = false;
+    options.max_subcompactions = 1;
+    options.blob_size = size_t(-1);
+    options.target_file_size_base = 32 << 10;
+    options.level0_file_num_compaction_trigger = 100;
+    return options;
+  }
+
+  // Writes num_files overlapping L0 files, returns the expected contents
+  std::map<std::string, std::string> FillL0(int num_files, int value_size) {
+    Random rnd(301);
+    std::map<std::string, std::string> expected;
+    for (int i = 0; i < num_files; ++i) {
+      for (int k = i; k < 300; k += num_files) {
+        std::string value = RandomString(&rnd, value_size);
+        EXPECT_OK(Put(Key(k), value));
+        expected[Key(k)] = value;
+      }
+      EXPECT_OK(Flush());
+    }
+    return expected;
+  }
+
+  void VerifyData(const std::map<std::string, std::string>& expected) {
+    for (auto& pair : expected) {
+      ASSERT_EQ(pair.second, Get(pair.first));
+    }
+  }
+
+  // Compacts the L0 of a fresh DB on a SocketPairCompactionDispatcher and
+  // returns the request it got. The input files are kept, so the request
+  // can be run again.
+  std::string CompactionRequest() {
+    auto dispatcher =
+        std::make_shared<SocketPairCompactionDispatcher>(worker_dir_);
+    Options options = DispatcherOptions(dispatcher);
+    DestroyAndReopen(options);
+    FillL0(3, 100);
+    EXPECT_OK(db_->DisableFileDeletions());
+    EXPECT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+    EXPECT_EQ(1U, dispatcher->requests.size());
+    return dispatcher->requests.empty() ? std::string()
+                                        : dispatcher->requests[0];
+  }
+
+  // The pool runs this binary, see main()
+  std::string WorkerCommand() {
+    return "exec " + test_binary + " --serve " + worker_dir_;
+  }
+
+  pid_t WorkerPid() {
+    std::string pid;
+    EXPECT_OK(ReadFileToString(env_, worker_dir_ + "/worker.pid", &pid));
+    return static_cast<pid_t>(std::stol(pid));
+  }
+
+  std::string worker_dir_;
+};
+
+// Test scope:
+// - Worker::Serve streams a kCompactionWorkerFileFinished frame for every
+// output file before the result, and returns 0 on a closed transport
+TEST_F(CompactionDispatcherTest, ServeStreamsFinishedFiles) {
+  auto dispatcher =
+      std::make_shared<SocketPairCompactionDispatcher>(worker_dir_);
+  Options options = DispatcherOptions(dispatcher);
+  DestroyAndReopen(options);
+  auto expected = FillL0(3, 1000);
+  ASSERT_EQ("3", FilesPerLevel());
+
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(1U, dispatcher->requests.size());
+  ASSERT_FALSE(dispatcher->bad_frame);
+  ASSERT_EQ(std::vector<int>{0}, dispatcher->exit_codes);
+  // The outputs are cut at target_file_size_base
+  ASSERT_GT(dispatcher->result_files.size(), 1U);
+  ASSERT_EQ(dispatcher->result_files, dispatcher->streamed_files);
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  ASSERT_EQ(static_cast<int>(dispatcher->result_files.size()),
+            NumTableFilesAtLevel(1));
+  VerifyData(expected);
+
+  Reopen(options);
+  VerifyData(expected);
+}
+
+// Test scope:
+// - A pool worker killed between jobs fails the next job, and the pool
+// starts a new worker for the job after it
+TEST_F(CompactionDispatcherTest, PoolRestartsKilledWorker) {
+  std::string request = CompactionRequest();
+  ASSERT_FALSE(request.empty());
+  auto pool = std::static_pointer_cast<RemoteCompactionDispatcher>(
+      NewLocalWorkerPoolCompactionDispatcher(WorkerCommand(), 1));
+
+  auto future = pool->DoCompaction(request);
+  CompactionWorkerResult result = WaitResult(&future);
+  ASSERT_OK(result.status);
+  ASSERT_FALSE(result.files.empty());
+  pid_t pid = WorkerPid();
+
+  // A killed process runs no more user code once kill() returned
+  ASSERT_EQ(0, kill(pid, SIGKILL));
+  future = pool->DoCompaction(request);
+  result = WaitResult(&future);
+  ASSERT_TRUE(result.status.IsIOError()) << result.status.ToString();
+
+  future = pool->DoCompaction(request);
+  result = WaitResult(&future);
+  ASSERT_OK(result.status);
+  ASSERT_FALSE(result.files.empty());
+  ASSERT_NE(pid, WorkerPid());
+}
+
+// Test scope:
+// - A job holds its worker until its result is read, a job finding every
+// worker busy waits for one to be released
+TEST_F(CompactionDispatcherTest, PoolAcquireBlocksWhenAllWorkersBusy) {
+  std::string request = CompactionRequest();
+  ASSERT_FALSE(request.empty());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool blocked = false;
+  bool release = false;
+  size_t progress_calls = 0;
+  auto on_progress = [&](const CompactionWorkerResult& partial) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_FALSE(partial.files.empty());
+    if (progress_calls++ == 0) {
+      // The first job holds the only worker in here
+      blocked = true;
+      cv.notify_all();
+      cv.wait(lock, [&] { return release; });
+    }
+  };
+  auto pool = std::static_pointer_cast<RemoteCompactionDispatcher>(
+      NewLocalWorkerPoolCompactionDispatcher(WorkerCommand(), 1,
+                                             on_progress));
+
+  auto first = pool->DoCompaction(request);
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return blocked; });
+  }
+  auto second = pool->DoCompaction(request);
+  ASSERT_EQ(std::future_status::timeout,
+            second.wait_for(std::chrono::milliseconds(200)));
+  ASSERT_EQ(std::future_status::timeout,
+            first.wait_for(std::chrono::milliseconds(0)));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+    cv.notify_all();
+  }
+  CompactionWorkerResult first_result = WaitResult(&first);
+  CompactionWorkerResult second_result = WaitResult(&second);
+  ASSERT_OK(first_result.status);
+  ASSERT_OK(second_result.status);
+  ASSERT_EQ(first_result.files.size(), second_result.files.size());
+  // Both jobs streamed their files through on_progress
+  ASSERT_EQ(first_result.files.size() * 2, progress_calls);
+}
+
+// Test scope:
+// - Garbage collection runs on the worker from the LSM view it is shipped,
+// with only the dependence of its inputs. The live records are copied and
+// read back through the inheritance chain of the output, and inputs which
+// are all garbage or all live leave no output
+TEST_F(CompactionDispatcherTest, GarbageCollectionOnWorker) {
+  auto dispatcher =
+      std::make_shared<SocketPairCompactionDispatcher>(worker_dir_);
+  Options options = DispatcherOptions(dispatcher);
+  options.blob_size = 64;
+  options.blob_gc_ratio = 0.1;
+  // No blob sst is small enough to be collected as a fragment
+  options.target_file_size_base = 4 << 10;
+  DestroyAndReopen(options);
+  // The replays below read the ssts the DB is done with
+  ASSERT_OK(db_->DisableFileDeletions());
+
+  Random rnd(301);
+  std::map<std::string, std::string> expected;
+  auto put_and_flush = [&](int begin, int end) {
+    for (int k = begin; k < end; ++k) {
+      std::string value = RandomString(&rnd, 200);
+      ASSERT_OK(Put(Key(k), value));
+      expected[Key(k)] = value;
+    }
+    ASSERT_OK(Flush());
+  };
+  typedef std::pair<CompactionWorkerContext, CompactionWorkerResult> Job;
+  auto jobs = [&](bool garbage_collection) {
+    std::vector<Job> result;
+    std::lock_guard<std::mutex> lock(dispatcher->mutex_);
+    for (auto& job : dispatcher->jobs) {
+      if ((job.first.compaction_type == kGarbageCollection) ==
+          garbage_collection) {
+        result.push_back(job);
+      }
+    }
+    return result;
+  };
+
+  // Half of the first blob sst is overwritten
+  put_and_flush(0, 100);
+  put_and_flush(0, 50);
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(0U, jobs(true).size());
+  ASSERT_OK(dbfull()->SetOptions({{"disable_auto_compactions", "false"}}));
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  auto gc_jobs = jobs(true);
+  ASSERT_EQ(1U, gc_jobs.size());
+  ASSERT_OK(gc_jobs[0].second.status);
+  ASSERT_EQ(1U, gc_jobs[0].first.inputs.size());
+  ASSERT_EQ(1U, gc_jobs[0].second.files.size());
+  VerifyData(expected);
+
+  TestWorker worker(worker_dir_);
+  auto replay = [&](const CompactionWorkerContext& context) {
+    std::string request;
+    EncodeCompactionWorkerContext(context, &request);
+    CompactionWorkerResult result;
+    Status s = DecodeCompactionWorkerResult(worker.DoCompaction(request),
+                                            &result);
+    if (!s.ok()) {
+      result.status = s;
+    }
+    return result;
+  };
+  // Replayed on the LSM view it was shipped, the GC keeps half the records
+  CompactionWorkerContext gc_context = gc_jobs[0].first;
+  CompactionWorkerResult replayed = replay(gc_context);
+  ASSERT_OK(replayed.status);
+  ASSERT_EQ(1U, replayed.files.size());
+  // With the L0 ssts the first compaction read added to the view, every
+  // record of the input is live again and the output is dropped
+  auto compactions = jobs(false);
+  ASSERT_FALSE(compactions.empty());
+  const CompactionWorkerContext& l0_context = compactions[0].first;
+  ASSERT_EQ(2U, l0_context.inputs.size());
+  for (auto& input : l0_context.inputs) {
+    ASSERT_EQ(0, input.first);
+    for (auto& pair : l0_context.file_metadata) {
+      if (pair.first == input.second) {
+        gc_context.file_metadata.push_back(pair);
+      }
+    }
+    gc_context.lsm_files.push_back(input);
+  }
+  replayed = replay(gc_context);
+  ASSERT_OK(replayed.status);
+  ASSERT_EQ(0U, replayed.files.size());
+
+  // The other half is overwritten too, the GC output has nothing left
+  put_and_flush(50, 100);
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  gc_jobs = jobs(true);
+  ASSERT_EQ(2U, gc_jobs.size());
+  ASSERT_OK(gc_jobs[1].second.status);
+  ASSERT_EQ(0U, gc_jobs[1].second.files.size());
+  VerifyData(expected);
+
+  // Reopen drops the collected blob ssts
+  ASSERT_OK(db_->EnableFileDeletions());
+  Reopen(options);
+  VerifyData(expected);
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  if (argc == 3 && std::string(argv[1]) == "--serve") {
+    // Worker of the pool tests, records its pid for the restart test
+    std::string dir = argv[2];
+    rocksdb::Status s = rocksdb::WriteStringToFile(
+        rocksdb::Env::Default(), rocksdb::ToString(getpid()),
+        dir + "/worker.pid", true);
+    if (!s.ok()) {
+      return 1;
+    }
+    rocksdb::TestWorker worker(dir);
+    return worker.Serve(0, 1);
+  }
+  rocksdb::test_binary = argv[0];
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -69,7 +69,7 @@ class CompactionIterator {
       bool report_detailed_time, bool expect_valid_internal_key,
       CompactionRangeDelAggregator* range_del_agg,
       const Compaction* compaction = nullptr,
-      BlobConfig blob_config = BlobConfig{size_t(-1), 0.0},
+      BlobConfig blob_config = BlobConfig{size_t(-1), 0.0, false},
       const CompactionFilter* compaction_filter = nullptr,
       const std::atomic<bool>* shutting_down = nullptr,
       const SequenceNumber preserve_deletes_seqnum = 0);
@@ -171,6 +171,7 @@ class CompactionIterator {
   // current output.
   LazyBuffer value_;
   std::string value_meta_;
+  uint64_t value_location_ = SeparateHelper::kNoLocation;
   // The status is OK unless compaction iterator encounters a merge operand
   // while not having a merge operator defined.
   Status status_;
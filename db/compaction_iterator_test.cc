@@ -258,7 +258,7 @@ class CompactionIteratorTest : public testing::TestWithParam<bool> {
         &snapshots_, earliest_write_conflict_snapshot, snapshot_checker_.get(),
         Env::Default(), false /* report_detailed_time */, false,
         range_del_agg_.get(), std::move(compaction),
-        BlobConfig{size_t(-1), 0.0}, filter, &shutting_down_));
+        BlobConfig{size_t(-1), 0.0, false}, filter, &shutting_down_));
   }
 
   void AddSnapshot(SequenceNumber snapshot,
@@ -39,6 +39,7 @@
 #include <random>
 #include <set>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -153,6 +154,9 @@ struct CompactionJob::SubcompactionState {
   // actual range for this subcompaction
   InternalKey actual_start, actual_end;
 
+  // Blob files handled by this subcompaction, only used by garbage collection
+  std::vector<const FileMetaData*> garbage_inputs;
+
   // The return status of this subcompaction
   Status status;
 
@@ -241,6 +245,7 @@ struct CompactionJob::SubcompactionState {
     end = std::move(o.end);
     actual_start = std::move(o.actual_start);
     actual_end = std::move(o.actual_end);
+    garbage_inputs = std::move(o.garbage_inputs);
     status = std::move(o.status);
     outputs = std::move(o.outputs);
     outfile = std::move(o.outfile);
@@ -504,6 +509,10 @@ int CompactionJob::Prepare(int sub_compaction_slots) {
       }
       compact_->sub_compact_states.emplace_back(c, start, end);
     }
+  } else if (c->compaction_type() == kGarbageCollection) {
+    GenGarbageCollectionGroups(sub_compaction_slots + 1);
+    MeasureTime(stats_, NUM_SUBCOMPACTIONS_SCHEDULED,
+                compact_->sub_compact_states.size());
   } else if (c->ShouldFormSubcompactions()) {
     const uint64_t start_micros = env_->NowMicros();
     GenSubcompactionBoundaries(sub_compaction_slots + 1);
@@ -674,6 +683,49 @@ void CompactionJob::GenSubcompactionBoundaries(int max_usable_threads) {
   }
 }
 
+// Splits the blob files of a garbage collection into disjoint groups with a
+// similar amount of live data, one group per subcompaction. Unlike key-value
+// compaction, GC can't be split by key range: the dependence map resolves an
+// input file number to exactly one output, so all live records of an input
+// file must be rewritten into the same output blob.
+void CompactionJob::GenGarbageCollectionGroups(int max_usable_threads) {
+  auto* c = compact_->compaction;
+  assert(c->num_input_levels() == 1 && c->level() == -1);
+  auto& files = *c->inputs(0);
+  size_t n = std::min({size_t(std::max(1, max_usable_threads)),
+                       size_t(std::max(1u, c->max_subcompactions())),
+                       files.size()});
+
+  // Longest processing time first, files with more live data go first and
+  // each one is assigned to the group with the least live data so far
+  std::vector<std::pair<uint64_t, FileMetaData*>> estimate_files;
+  estimate_files.reserve(files.size());
+  for (auto f : files) {
+    double ratio = std::min(
+        1.0, f->num_antiquation / std::max<double>(1, f->prop.num_entries));
+    estimate_files.emplace_back(
+        static_cast<uint64_t>(f->fd.file_size * (1 - ratio)), f);
+  }
+  std::sort(estimate_files.begin(), estimate_files.end(),
+            [](const std::pair<uint64_t, FileMetaData*>& a,
+               const std::pair<uint64_t, FileMetaData*>& b) {
+              return a.first != b.first
+                         ? a.first > b.first
+                         : a.second->fd.GetNumber() < b.second->fd.GetNumber();
+            });
+  for (size_t i = 0; i < n; ++i) {
+    compact_->sub_compact_states.emplace_back(c, nullptr, nullptr);
+  }
+  for (auto& pair : estimate_files) {
+    auto min_state = std::min_element(compact_->sub_compact_states.begin(),
+                                      compact_->sub_compact_states.end(),
+                                      TERARK_CMP(approx_size, <));
+    min_state->garbage_inputs.push_back(pair.second);
+    min_state->approx_size += pair.first;
+  }
+  TEST_SYNC_POINT_CALLBACK("CompactionJob::GenGarbageCollectionGroups", &n);
+}
+
 static std::shared_ptr<CompactionDispatcher> GetCmdLineDispatcher() {
   const char* cmdline = getenv("TerarkDB_compactionWorkerCommandLine");
   if (cmdline) {
@@ -697,7 +749,8 @@ Status CompactionJob::Run() {
         GetCmdLineDispatcher());
     dispatcher = command_line_dispatcher.get();
   }
-  if (!dispatcher || c->compaction_type() != kKeyValueCompaction) {
+  // Map compactions only rewrite the links of map SSTs, they stay local
+  if (!dispatcher || c->compaction_type() == kMapCompaction) {
     return RunSelf();
   }
   Status s;
@@ -771,15 +824,72 @@ Status CompactionJob::Run() {
   context.earliest_write_conflict_snapshot = earliest_write_conflict_snapshot_;
   context.preserve_deletes_seqnum = preserve_deletes_seqnum_;
   auto& dependence_map = c->input_version()->storage_info()->dependence_map();
-  for (auto& pair : dependence_map) {
-    context.file_metadata.emplace_back(pair.first, *pair.second);
-  }
-  for (auto& files : *c->inputs()) {
-    for (auto& f : files.files) {
-      if (dependence_map.count(f->fd.GetNumber()) == 0) {
-        context.file_metadata.emplace_back(f->fd.GetNumber(), *f);
+  const bool garbage_collection = c->compaction_type() == kGarbageCollection;
+  if (garbage_collection) {
+    // GC keeps the records still referenced by the LSM, the worker answers
+    // that from the files of the input version. Inputs are per subcompaction.
+    // Only ship what that needs: the numbers resolving to the input blobs and
+    // the LSM files with whatever their map ssts depend on.
+    std::unordered_set<uint64_t> shipped;
+    auto ship = [&](uint64_t file_number, const FileMetaData* f) {
+      if (shipped.emplace(file_number).second) {
+        context.file_metadata.emplace_back(file_number, *f);
+      }
+    };
+    std::unordered_set<const FileMetaData*> garbage_inputs;
+    for (auto& files : *c->inputs()) {
+      for (auto f : files.files) {
+        garbage_inputs.emplace(f);
+        ship(f->fd.GetNumber(), f);
+      }
+    }
+    for (auto& pair : dependence_map) {
+      if (garbage_inputs.count(pair.second) > 0) {
+        ship(pair.first, pair.second);
+      }
+    }
+    std::vector<const FileMetaData*> map_ssts;
+    auto vstorage = c->input_version()->storage_info();
+    for (int level = 0; level < vstorage->num_levels(); ++level) {
+      for (auto f : vstorage->LevelFiles(level)) {
+        ship(f->fd.GetNumber(), f);
+        if (f->prop.is_map_sst()) {
+          map_ssts.push_back(f);
+        }
+        context.lsm_files.emplace_back(level, f->fd.GetNumber());
+      }
+    }
+    while (!map_ssts.empty()) {
+      auto f = map_ssts.back();
+      map_ssts.pop_back();
+      for (auto& dependence : f->prop.dependence) {
+        auto find = dependence_map.find(dependence.file_number);
+        if (find == dependence_map.end()) {
+          assert(false);
+          continue;
+        }
+        bool visited = shipped.count(find->second->fd.GetNumber()) > 0;
+        ship(dependence.file_number, find->second);
+        ship(find->second->fd.GetNumber(), find->second);
+        if (!visited && find->second->prop.is_map_sst()) {
+          map_ssts.push_back(find->second);
+        }
+      }
+    }
+    context.compaction_type = kGarbageCollection;
+    context.max_sequential_skip_in_iterations =
+        c->mutable_cf_options()->max_sequential_skip_in_iterations;
+  } else {
+    for (auto& pair : dependence_map) {
+      context.file_metadata.emplace_back(pair.first, *pair.second);
+    }
+    for (auto& files : *c->inputs()) {
+      for (auto& f : files.files) {
+        if (dependence_map.count(f->fd.GetNumber()) == 0) {
+          context.file_metadata.emplace_back(f->fd.GetNumber(), *f);
+        }
+        context.inputs.emplace_back(files.level, f->fd.GetNumber());
       }
-      context.inputs.emplace_back(files.level, f->fd.GetNumber());
     }
   }
   context.cf_name = cfd->GetName();
@@ -826,6 +936,12 @@ Status CompactionJob::Run() {
       context.has_end = false;
       context.end.clear();
     }
+    if (garbage_collection) {
+      context.inputs.clear();
+      for (auto f : state.garbage_inputs) {
+        context.inputs.emplace_back(-1, f->fd.GetNumber());
+      }
+    }
     results_fn.emplace_back(dispatcher->StartCompaction(context));
   }
   Status status = Status::Corruption();
@@ -845,8 +961,10 @@ Status CompactionJob::Run() {
           std::string fname = TableFileName(cfd->ioptions()->cf_paths,
                                             file_number, c->output_path_id());
           env_->RenameFile(file_info.file_name, fname);
-          sub_compact.outputs.emplace_back();
-          auto& output = sub_compact.outputs.back();
+          auto& outputs = garbage_collection ? sub_compact.blob_outputs
+                                             : sub_compact.outputs;
+          outputs.emplace_back();
+          auto& output = outputs.back();
           output.meta.fd = FileDescriptor(
               file_number, c->output_path_id(), file_info.file_size,
               file_info.smallest_seqno, file_info.largest_seqno);
@@ -1279,11 +1397,11 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     void* trans_to_separate_callback_args = nullptr;
 
     Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                           const Slice& meta, bool is_merge,
-                           bool is_index) override {
+                           const Slice& meta, bool is_merge, bool is_index,
+                           uint64_t location) override {
       return SeparateHelper::TransToSeparate(
           internal_key, value, value.file_number(), meta, is_merge, is_index,
-          value_meta_extractor.get());
+          value_meta_extractor.get(), location);
     }
 
     Status TransToSeparate(const Slice& key, LazyBuffer& value) override {
@@ -1330,7 +1448,10 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
       status = SeparateHelper::TransToSeparate(
           key, value, blob_meta->fd.GetNumber(), Slice(),
           GetInternalKeyType(key) == kTypeMerge, false,
-          separate_helper.value_meta_extractor.get());
+          separate_helper.value_meta_extractor.get(),
+          mutable_cf_options->blob_value_location
+              ? blob_builder->LastEntryLocation()
+              : SeparateHelper::kNoLocation);
     }
     return status;
   };
@@ -1700,76 +1821,38 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   sub_compact->status = status;
 }  // namespace rocksdb
 
-void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
-  assert(sub_compact != nullptr);
-  ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
-
-  std::unique_ptr<InternalIterator> input(versions_->MakeInputIterator(
-      sub_compact->compaction, nullptr, env_options_for_read_));
-
-  AutoThreadOperationStageUpdater stage_updater(
-      ThreadStatus::STAGE_COMPACTION_PROCESS_KV);
-
-  // I/O measurement variables
-  PerfLevel prev_perf_level = PerfLevel::kEnableTime;
-  uint64_t prev_write_nanos = 0;
-  uint64_t prev_fsync_nanos = 0;
-  uint64_t prev_range_sync_nanos = 0;
-  uint64_t prev_prepare_write_nanos = 0;
-  if (measure_io_stats_) {
-    prev_perf_level = GetPerfLevel();
-    SetPerfLevel(PerfLevel::kEnableTime);
-    prev_write_nanos = IOSTATS(write_nanos);
-    prev_fsync_nanos = IOSTATS(fsync_nanos);
-    prev_range_sync_nanos = IOSTATS(range_sync_nanos);
-    prev_prepare_write_nanos = IOSTATS(prepare_write_nanos);
-  }
-
-  assert(sub_compact->start == nullptr);
-  assert(sub_compact->end == nullptr);
-
-  input->SeekToFirst();
-
-  Arena arena;
-  std::unordered_map<Slice, uint64_t, SliceHasher> conflict_map;
-  std::mutex conflict_map_mutex;
-
-  auto create_iter = [&](Arena* /* arena */) {
-    return versions_->MakeInputIterator(sub_compact->compaction, nullptr,
-                                        env_options_for_read_);
-  };
-  auto filter_conflict = [&](const Slice& ikey, const LazyBuffer& value) {
-    std::lock_guard<std::mutex> lock(conflict_map_mutex);
-    auto find = conflict_map.find(ikey);
-    return find != conflict_map.end() && find->second != value.file_number();
-  };
-
-  LazyInternalIteratorWrapper second_pass_iter(
-      c_style_callback(create_iter), &create_iter,
-      c_style_callback(filter_conflict), &filter_conflict, nullptr /* arena */,
-      shutting_down_);
+void GarbageCollectionConflictMap::Add(const Slice& ikey,
+                                       uint64_t file_number) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  map_.emplace(ArenaPinSlice(ikey, &arena_), file_number);
+}
 
-  Status status = OpenCompactionOutputBlob(sub_compact);
-  if (!status.ok()) {
-    return;
-  }
-  sub_compact->blob_builder->SetSecondPassIterator(&second_pass_iter);
+bool GarbageCollectionConflictMap::IsConflict(const Slice& ikey,
+                                              uint64_t file_number) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto find = map_.find(ikey);
+  return find != map_.end() && find->second != file_number;
+}
 
-  Version* input_version = sub_compact->compaction->input_version();
-  auto& dependence_map = input_version->storage_info()->dependence_map();
-  auto& comp = cfd->internal_comparator();
+Status CopyLiveBlobRecords(InternalIterator* input,
+                           SortedKeyGetter* key_getter,
+                           const DependenceMap& dependence_map,
+                           bool dependence_map_complete,
+                           const InternalKeyComparator& icmp,
+                           const std::function<bool()>& should_stop,
+                           TableBuilder* builder, FileMetaData* meta,
+                           GarbageCollectionConflictMap* conflict_map,
+                           GarbageCollectionCounter* counter) {
+  Status status;
   std::string last_key;
   uint64_t last_file_number = uint64_t(-1);
   IterKey iter_key;
   ParsedInternalKey ikey;
-  struct {
-    uint64_t input = 0;
-    uint64_t garbage_type = 0;
-    uint64_t get_not_found = 0;
-    uint64_t file_number_mismatch = 0;
-  } counter;
-  while (status.ok() && !cfd->IsDropped() && input->Valid()) {
-    ++counter.input;
+  for (input->SeekToFirst(); status.ok() && input->Valid(); input->Next()) {
+    if (should_stop && should_stop()) {
+      break;
+    }
+    ++counter->input;
     Slice curr_key = input->key();
     uint64_t curr_file_number = uint64_t(-1);
     if (!ParseInternalKey(curr_key, &ikey)) {
@@ -1778,7 +1861,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
     }
     do {
       if (ikey.type != kTypeValue && ikey.type != kTypeMerge) {
-        ++counter.garbage_type;
+        ++counter->garbage_type;
         break;
       }
       iter_key.SetInternalKey(ikey.user_key, ikey.sequence, kValueTypeForSeek);
@@ -1786,17 +1869,17 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
       ValueType type = kTypeDeletion;
       SequenceNumber seq = kMaxSequenceNumber;
       LazyBuffer value;
-      input_version->GetKey(ikey.user_key, iter_key.GetInternalKey(), &s, &type,
-                            &seq, &value);
+      key_getter->GetKey(ikey.user_key, iter_key.GetInternalKey(), &s, &type,
+                         &seq, &value);
       if (s.IsNotFound()) {
-        ++counter.get_not_found;
+        ++counter->get_not_found;
         break;
       } else if (!s.ok()) {
         status = std::move(s);
         break;
       } else if (seq != ikey.sequence ||
                  (type != kTypeValueIndex && type != kTypeMergeIndex)) {
-        ++counter.get_not_found;
+        ++counter->get_not_found;
         break;
       }
       status = value.fetch();
@@ -1805,91 +1888,168 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
       }
       uint64_t file_number = SeparateHelper::DecodeFileNumber(value.slice());
       auto find = dependence_map.find(file_number);
-      if (find == dependence_map.end()) {
+      if (find == dependence_map.end() && dependence_map_complete) {
         status = Status::Corruption("Separate value dependence missing");
         break;
       }
       value = input->value();
-      if (find->second->fd.GetNumber() != value.file_number()) {
-        ++counter.file_number_mismatch;
+      // a partial map only holds the numbers resolving to the GC inputs
+      if (find == dependence_map.end() ||
+          find->second->fd.GetNumber() != value.file_number()) {
+        ++counter->file_number_mismatch;
         break;
       }
       curr_file_number = value.file_number();
-
-      assert(sub_compact->blob_builder != nullptr);
-      assert(sub_compact->current_blob_output() != nullptr);
-      status = sub_compact->blob_builder->Add(curr_key, value);
+      status = builder->Add(curr_key, value);
       if (!status.ok()) {
         break;
       }
-      sub_compact->current_blob_output()->meta.UpdateBoundaries(curr_key,
-                                                                ikey.sequence);
-      sub_compact->num_output_records++;
+      meta->UpdateBoundaries(curr_key, ikey.sequence);
+      ++counter->output;
     } while (false);
 
-    if (counter.input > 1 && comp.Compare(curr_key, last_key) == 0 &&
+    if (counter->input > 1 && icmp.Compare(curr_key, last_key) == 0 &&
         (last_file_number & curr_file_number) != uint64_t(-1)) {
       assert(last_file_number == uint64_t(-1) ||
              curr_file_number == uint64_t(-1));
-      uint64_t valid_file_number = last_file_number & curr_file_number;
-      auto pinned_key = ArenaPinSlice(curr_key, &arena);
-      std::lock_guard<std::mutex> lock(conflict_map_mutex);
-      conflict_map.emplace(pinned_key, valid_file_number);
+      conflict_map->Add(curr_key, last_file_number & curr_file_number);
     }
     last_key.assign(curr_key.data(), curr_key.size());
     last_file_number = curr_file_number;
-
-    input->Next();
-  }
-
-  if (status.ok() &&
-      (shutting_down_->load(std::memory_order_relaxed) || cfd->IsDropped())) {
-    status = Status::ShutdownInProgress(
-        "Database shutdown or Column family drop during compaction");
   }
   if (status.ok()) {
     status = input->status();
   }
+  return status;
+}
+
+std::vector<uint64_t> GarbageCollectionInheritanceChain(
+    const std::vector<const FileMetaData*>& inputs,
+    const DependenceMap& dependence_map, size_t* raw_chain_length) {
   std::vector<uint64_t> inheritance_chain;
-  size_t raw_chain_length = 0;
-  for (auto& level : *sub_compact->compaction->inputs()) {
-    for (auto f : level.files) {
-      raw_chain_length += f->prop.inheritance_chain.size() + 1;
-      inheritance_chain.push_back(f->fd.GetNumber());
-      for (size_t i = 0; i < f->prop.inheritance_chain.size(); ++i) {
-        if (dependence_map.count(f->prop.inheritance_chain[i]) > 0) {
-          inheritance_chain.insert(inheritance_chain.end(),
-                                   f->prop.inheritance_chain.begin() + i,
-                                   f->prop.inheritance_chain.end());
-          break;
-        }
+  size_t raw_length = 0;
+  for (auto f : inputs) {
+    raw_length += f->prop.inheritance_chain.size() + 1;
+    inheritance_chain.push_back(f->fd.GetNumber());
+    for (size_t i = 0; i < f->prop.inheritance_chain.size(); ++i) {
+      if (dependence_map.count(f->prop.inheritance_chain[i]) > 0) {
+        inheritance_chain.insert(inheritance_chain.end(),
+                                 f->prop.inheritance_chain.begin() + i,
+                                 f->prop.inheritance_chain.end());
+        break;
       }
     }
   }
   std::sort(inheritance_chain.begin(), inheritance_chain.end());
   assert(std::unique(inheritance_chain.begin(), inheritance_chain.end()) ==
          inheritance_chain.end());
+  if (raw_chain_length != nullptr) {
+    *raw_chain_length = raw_length;
+  }
+  return inheritance_chain;
+}
+
+void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
+  assert(sub_compact != nullptr);
+  ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
+
+  std::unique_ptr<InternalIterator> input(
+      NewGarbageCollectionInputIterator(sub_compact));
+
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_COMPACTION_PROCESS_KV);
+
+  // I/O measurement variables
+  PerfLevel prev_perf_level = PerfLevel::kEnableTime;
+  uint64_t prev_write_nanos = 0;
+  uint64_t prev_fsync_nanos = 0;
+  uint64_t prev_range_sync_nanos = 0;
+  uint64_t prev_prepare_write_nanos = 0;
+  if (measure_io_stats_) {
+    prev_perf_level = GetPerfLevel();
+    SetPerfLevel(PerfLevel::kEnableTime);
+    prev_write_nanos = IOSTATS(write_nanos);
+    prev_fsync_nanos = IOSTATS(fsync_nanos);
+    prev_range_sync_nanos = IOSTATS(range_sync_nanos);
+    prev_prepare_write_nanos = IOSTATS(prepare_write_nanos);
+  }
+
+  assert(sub_compact->start == nullptr);
+  assert(sub_compact->end == nullptr);
+
+  GarbageCollectionConflictMap conflict_map;
+
+  auto create_iter = [&](Arena* /* arena */) {
+    return NewGarbageCollectionInputIterator(sub_compact);
+  };
+  auto filter_conflict = [&](const Slice& ikey, const LazyBuffer& value) {
+    return conflict_map.IsConflict(ikey, value.file_number());
+  };
+
+  LazyInternalIteratorWrapper second_pass_iter(
+      c_style_callback(create_iter), &create_iter,
+      c_style_callback(filter_conflict), &filter_conflict, nullptr /* arena */,
+      shutting_down_);
+
+  Status status = OpenCompactionOutputBlob(sub_compact);
+  if (!status.ok()) {
+    return;
+  }
+  sub_compact->blob_builder->SetSecondPassIterator(&second_pass_iter);
+
+  Version* input_version = sub_compact->compaction->input_version();
+  auto& dependence_map = input_version->storage_info()->dependence_map();
+  // GC input arrives in internal key order, so the liveness checks share one
+  // forward scan of the LSM instead of a full point lookup per record
+  SortedKeyGetter key_getter(
+      input_version, env_options_for_read_,
+      sub_compact->compaction->mutable_cf_options()
+          ->max_sequential_skip_in_iterations);
+  GarbageCollectionCounter counter;
+  assert(sub_compact->blob_builder != nullptr);
+  assert(sub_compact->current_blob_output() != nullptr);
+  status = CopyLiveBlobRecords(
+      input.get(), &key_getter, dependence_map,
+      true /* dependence_map_complete */, cfd->internal_comparator(),
+      [cfd] { return cfd->IsDropped(); }, sub_compact->blob_builder.get(),
+      &sub_compact->current_blob_output()->meta, &conflict_map, &counter);
+  sub_compact->num_output_records += counter.output;
+
+  if (status.ok() &&
+      (shutting_down_->load(std::memory_order_relaxed) || cfd->IsDropped())) {
+    status = Status::ShutdownInProgress(
+        "Database shutdown or Column family drop during compaction");
+  }
+  // Only the files of this subcompaction are inherited by its output
+  size_t raw_chain_length = 0;
+  uint64_t num_antiquation = 0;
+  for (auto f : sub_compact->garbage_inputs) {
+    num_antiquation += f->num_antiquation;
+  }
+  std::vector<uint64_t> inheritance_chain = GarbageCollectionInheritanceChain(
+      sub_compact->garbage_inputs, dependence_map, &raw_chain_length);
   Status s = FinishCompactionOutputBlob(status, sub_compact, inheritance_chain);
   if (status.ok()) {
     status = s;
   }
   if (status.ok()) {
     auto& meta = sub_compact->blob_outputs.front().meta;
-    auto& inputs = *sub_compact->compaction->inputs();
-    assert(inputs.size() == 1 && inputs.front().level == -1);
     ROCKS_LOG_INFO(
         db_options_.info_log,
         "[%s] [JOB %d] Table #%" PRIu64 " GC: %" PRIu64
         " inputs from %zd files. %" PRIu64
         " clear, %.2f%% estimation: [ %" PRIu64 " garbage type, %" PRIu64
         " get not found, %" PRIu64
-        " file number mismatch ], inheritance chain: %" PRIu64 " -> %" PRIu64,
+        " file number mismatch ], inheritance chain: %" PRIu64 " -> %" PRIu64
+        ", lsm scan: %" PRIu64 " next, %" PRIu64 " seek",
         cfd->GetName().c_str(), job_id_, meta.fd.GetNumber(), counter.input,
-        inputs.front().size(), counter.input - meta.prop.num_entries,
-        sub_compact->compaction->num_antiquation() * 100. / counter.input,
+        sub_compact->garbage_inputs.size(),
+        counter.input - meta.prop.num_entries,
+        num_antiquation * 100. / counter.input,
         counter.garbage_type, counter.get_not_found,
         counter.file_number_mismatch, raw_chain_length,
-        inheritance_chain.size());
+        inheritance_chain.size(), key_getter.num_next(),
+        key_getter.num_seek());
     if (counter.input == meta.prop.num_entries || meta.prop.num_entries == 0) {
       ROCKS_LOG_INFO(db_options_.info_log,
                      "[%s] [JOB %d] Table #%" PRIu64
@@ -1922,6 +2082,33 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   sub_compact->status = status;
 }
 
+InternalIterator* CompactionJob::NewGarbageCollectionInputIterator(
+    const SubcompactionState* sub_compact) {
+  auto* c = sub_compact->compaction;
+  auto* cfd = c->column_family_data();
+  assert(!sub_compact->garbage_inputs.empty());
+  ReadOptions read_options;
+  read_options.verify_checksums = true;
+  read_options.fill_cache = false;
+  read_options.total_order_seek = true;
+
+  auto& dependence_map = c->input_version()->storage_info()->dependence_map();
+  std::vector<InternalIterator*> list;
+  list.reserve(sub_compact->garbage_inputs.size());
+  for (auto f : sub_compact->garbage_inputs) {
+    list.push_back(cfd->table_cache()->NewIterator(
+        read_options, env_options_for_read_, cfd->internal_comparator(), *f,
+        dependence_map, nullptr /* range_del_agg */,
+        c->mutable_cf_options()->prefix_extractor.get(),
+        nullptr /* table_reader_ptr */,
+        nullptr /* no per level latency histogram */,
+        true /* for_compaction */, nullptr /* arena */,
+        false /* skip_filters */, -1 /* level */));
+  }
+  return NewMergingIterator(&cfd->internal_comparator(), list.data(),
+                            static_cast<int>(list.size()));
+}
+
 void CompactionJob::RecordDroppedKeys(
     const CompactionIterationStats& c_iter_stats,
     CompactionJobStats* compaction_job_stats) {
@@ -19,8 +19,10 @@
 #include <deque>
 #include <functional>
 #include <limits>
+#include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -46,8 +48,11 @@
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/transaction_log.h"
 #include "table/scoped_arena_iterator.h"
+#include "util/arena.h"
 #include "util/autovector.h"
+#include "util/dependence_map.h"
 #include "util/event_logger.h"
+#include "util/hash.h"
 #include "util/stop_watch.h"
 #include "util/thread_local.h"
 
@@ -57,11 +62,61 @@ class Arena;
 class ErrorHandler;
 class MemTable;
 class SnapshotChecker;
+class SortedKeyGetter;
+class TableBuilder;
 class TableCache;
 class Version;
 class VersionEdit;
 class VersionSet;
 
+// Keys found in more than one blob sst of a garbage collection, with the file
+// number of the record that was kept. The second pass iterator of the output
+// builder skips the other copies.
+class GarbageCollectionConflictMap {
+ public:
+  void Add(const Slice& ikey, uint64_t file_number);
+
+  // True if ikey was kept from another file than file_number
+  bool IsConflict(const Slice& ikey, uint64_t file_number);
+
+ private:
+  Arena arena_;
+  std::unordered_map<Slice, uint64_t, SliceHasher> map_;
+  std::mutex mutex_;
+};
+
+struct GarbageCollectionCounter {
+  uint64_t input = 0;
+  uint64_t output = 0;
+  uint64_t garbage_type = 0;
+  uint64_t get_not_found = 0;
+  uint64_t file_number_mismatch = 0;
+};
+
+// The first pass of a garbage collection, shared by CompactionJob and the
+// compaction workers. Adds to builder the records of input that the LSM, as
+// seen by key_getter, still refers to, and widens the boundaries of meta.
+// dependence_map resolves the blob file numbers stored in the LSM. If
+// dependence_map_complete is false, a number it misses belongs to a blob sst
+// outside of this GC, otherwise that is corruption. should_stop, if set, is
+// checked before each record.
+extern Status CopyLiveBlobRecords(InternalIterator* input,
+                                  SortedKeyGetter* key_getter,
+                                  const DependenceMap& dependence_map,
+                                  bool dependence_map_complete,
+                                  const InternalKeyComparator& icmp,
+                                  const std::function<bool()>& should_stop,
+                                  TableBuilder* builder, FileMetaData* meta,
+                                  GarbageCollectionConflictMap* conflict_map,
+                                  GarbageCollectionCounter* counter);
+
+// Sorted file numbers the output of a GC over inputs inherits, the inputs and
+// the parts of their chains still reachable through dependence_map.
+// raw_chain_length gets the length before that is pruned.
+extern std::vector<uint64_t> GarbageCollectionInheritanceChain(
+    const std::vector<const FileMetaData*>& inputs,
+    const DependenceMap& dependence_map, size_t* raw_chain_length);
+
 class CompactionJob {
  public:
   CompactionJob(int job_id, Compaction* compaction,
@@ -112,6 +167,7 @@ class CompactionJob {
 
   void AggregateStatistics();
   void GenSubcompactionBoundaries(int max_usable_threads);
+  void GenGarbageCollectionGroups(int max_usable_threads);
 
   // update the thread status for starting a compaction.
   void ReportStartedCompaction(Compaction* compaction);
@@ -121,6 +177,8 @@ class CompactionJob {
   void ProcessCompaction(SubcompactionState* sub_compact);
   void ProcessKeyValueCompaction(SubcompactionState* sub_compact);
   void ProcessGarbageCollection(SubcompactionState* sub_compact);
+  InternalIterator* NewGarbageCollectionInputIterator(
+      const SubcompactionState* sub_compact);
 
   Status FinishCompactionOutputFile(
       const Status& input_status, SubcompactionState* sub_compact,
@@ -23,6 +23,7 @@
 
 #include "db/column_family.h"
 #include "db/map_builder.h"
+#include "monitoring/file_read_sample.h"
 #include "monitoring/statistics.h"
 #include "util/c_style_callback.h"
 #include "util/filename.h"
@@ -79,6 +80,8 @@ struct GarbageFileInfo {
 struct FileUseInfo {
   uint64_t size;
   uint64_t used;
+  // Sampled lookups forwarded to the file
+  uint64_t reads;
 };
 struct PickerCompositeHeapItem {
   Slice k;
@@ -864,7 +867,9 @@ Compaction* CompactionPicker::PickGarbageCollection(
       ioptions_, vstorage, mutable_cf_options, bottommost_level, 1, true);
   params.compression_opts =
       GetCompressionOptions(ioptions_, vstorage, bottommost_level, true);
-  params.max_subcompactions = 1;
+  params.max_subcompactions =
+      std::min<uint32_t>(mutable_cf_options.max_subcompactions,
+                         static_cast<uint32_t>(input.size()));
   params.score = 0;
   params.compaction_type = kGarbageCollection;
   params.compaction_reason = CompactionReason::kGarbageCollection;
@@ -1594,6 +1599,19 @@ void CompactionPicker::UnregisterCompaction(Compaction* c) {
   compactions_in_progress_.erase(c);
 }
 
+double CompactionPicker::MapSstReadCost(const FileMetaData* f,
+                                        uint64_t size) {
+  // Lookups sampled on the map sst scale its read amplification to the read
+  // cost flattening saves per byte rewritten, so hot map ssts go first.
+  double read_amp = f->prop.read_amp;
+  double ratio = read_amp / std::max<uint64_t>(1, size);
+  if (read_amp <= 1) {
+    return -ratio;
+  }
+  return ratio *
+         (1 + sample_file_read_recent(f) / double(kFileReadSampleRate));
+}
+
 /*
  *  PickCompositeCompaction() means to pick compaction from SSTables in the
  *  same level, also called tiny/inner compaction at somewhere. Aiming to
@@ -1645,14 +1663,10 @@ Compaction* CompactionPicker::PickCompositeCompaction(
       f = sr.file;
     }
     // Estimate overall read amplification of selects.
-    double level_read_amp = f->prop.read_amp;
-    double level_read_amp_ratio = 1. * level_read_amp / sr.size;
-    if (level_read_amp <= 1) {
-      level_read_amp_ratio = -level_read_amp_ratio;
-    }
+    double level_read_amp_ratio = MapSstReadCost(f, sr.size);
     if (level_read_amp_ratio >= max_read_amp_ratio) {
       max_read_amp_ratio = level_read_amp_ratio;
-      read_amp = level_read_amp;
+      read_amp = f->prop.read_amp;
       input.level = sr.level;
       input.files = {f};
     }
@@ -1671,8 +1685,15 @@ Compaction* CompactionPicker::PickCompositeCompaction(
   }
   CompactionType compaction_type = kKeyValueCompaction;
   std::vector<SelectedRange> input_range;
+  // The picked map sst and the files linked from it
+  std::vector<FileMetaData*> ranked_files;
 
   auto new_compaction = [&] {
+    // Decay the lookups the pick was ranked on, so a hot map sst doesn't
+    // starve the others once its traffic drops
+    for (auto f : ranked_files) {
+      sample_file_read_decay(f);
+    }
     int level = input.level;
     CompactionParams params(vstorage, ioptions_, mutable_cf_options);
     params.inputs = std::move(inputs);
@@ -1736,6 +1757,8 @@ Compaction* CompactionPicker::PickCompositeCompaction(
   };
 
   std::unordered_map<uint64_t, FileUseInfo> file_used;
+  uint64_t total_size = 0;
+  uint64_t total_reads = 0;
   MapSstElement map_element;
   SelectedRange range;
   auto uc = ioptions_.internal_comparator.user_comparator();
@@ -1748,6 +1771,7 @@ Compaction* CompactionPicker::PickCompositeCompaction(
     range.limit.assign(uend.data(), uend.size());
   };
 
+  ranked_files.push_back(input.files.front());
   for (auto& dependence : input.files.front()->prop.dependence) {
     auto& dependence_map = vstorage->dependence_map();
     FileUseInfo info;
@@ -1760,8 +1784,22 @@ Compaction* CompactionPicker::PickCompositeCompaction(
     info.size = f->fd.GetFileSize();
     info.used = info.size - info.size * f->num_antiquation /
                                 std::max<uint64_t>(1, f->prop.num_entries);
+    info.reads = sample_file_read_recent(f);
+    ranked_files.push_back(f);
+    total_size += info.size;
+    total_reads += info.reads;
     file_used.emplace(dependence.file_number, info);
   }
+  // Average sampled reads per byte of the linked files, elements hotter than
+  // this are flattened first
+  double avg_heat = double(total_reads) / std::max<uint64_t>(1, total_size);
+  auto estimate_size = [](const MapSstElement& element) {
+    uint64_t sum = 0;
+    for (auto& l : element.link) {
+      sum += l.size;
+    }
+    return sum;
+  };
   std::vector<PickerCompositeHeapItem> priority_heap;
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
     if (!ReadMapElement(map_element, iter.get(), log_buffer, cf_name)) {
@@ -1772,6 +1810,7 @@ Compaction* CompactionPicker::PickCompositeCompaction(
     }
     double p = map_element.link.size();
     size_t size = 0, used = 0;
+    double reads = 0;
     for (auto& l : map_element.link) {
       auto find = file_used.find(l.file_number);
       if (find == file_used.end()) {
@@ -1780,13 +1819,24 @@ Compaction* CompactionPicker::PickCompositeCompaction(
       }
       size += find->second.size;
       used += find->second.used;
+      // Every lookup in range probes the links, the busiest one tells how
+      // often the range was read
+      reads = std::max(reads, double(find->second.reads) * l.size /
+                                  std::max<uint64_t>(1, find->second.size));
     }
     p *= (1 + double(size - std::min(used, size)) / size);
     if (p <= 2.0) {
       continue;
     }
+    // Ranges read more than average per byte rewritten are picked first, cold
+    // ranges keep their weight
+    double heat = 1;
+    if (avg_heat > 0) {
+      heat += reads / std::max<uint64_t>(1, estimate_size(map_element)) /
+              avg_heat;
+    }
     PickerCompositeHeapItem item = {
-        ArenaPinSlice(map_element.largest_key, &arena), p};
+        ArenaPinSlice(map_element.largest_key, &arena), p * heat};
     priority_heap.push_back(item);
   }
   std::make_heap(priority_heap.begin(), priority_heap.end(),
@@ -1805,13 +1855,6 @@ Compaction* CompactionPicker::PickCompositeCompaction(
       size_t(MaxFileSizeForLevel(mutable_cf_options, std::max(1, input.level),
                                  ioptions_.compaction_style) *
              2);
-  auto estimate_size = [](const MapSstElement& element) {
-    uint64_t sum = 0;
-    for (auto& l : element.link) {
-      sum += l.size;
-    }
-    return sum;
-  };
   while (!priority_heap.empty()) {
     auto key = priority_heap.front().k;
     auto weight = priority_heap.front().s;
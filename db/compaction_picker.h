@@ -88,6 +88,10 @@ class CompactionPicker {
                             const InternalKeyComparator& icmp, bool sort,
                             bool merge);
 
+  // Read amplification per byte of a map sst, scaled by the lookups sampled
+  // on it. Negative if flattening it doesn't reduce read amplification.
+  static double MapSstReadCost(const FileMetaData* f, uint64_t size);
+
   const EnvOptions& env_options() { return env_options_; }
 
   TableCache* table_cache() { return table_cache_; }
@@ -11,6 +11,7 @@
 #include "db/compaction.h"
 #include "db/compaction_picker_fifo.h"
 #include "db/compaction_picker_universal.h"
+#include "monitoring/file_read_sample.h"
 
 #include "util/logging.h"
 #include "util/string_util.h"
@@ -1458,6 +1459,78 @@ TEST_F(CompactionPickerTest, CacheNextCompactionIndex) {
   ASSERT_EQ(4, vstorage_->NextCompactionIndex(1 /* level */));
 }
 
+TEST_F(CompactionPickerTest, GarbageCollectionSubcompactions) {
+  NewVersionStorage(6, kCompactionStyleLevel);
+  mutable_cf_options_.max_subcompactions = 4;
+  mutable_cf_options_.blob_gc_ratio = 0.05;
+  for (uint32_t i = 1; i <= 6; ++i) {
+    Add(-1, i, "a", "z", 1000U);
+    FileMetaData* f = file_map_[i].first;
+    f->prop.num_entries = 100;
+    f->num_antiquation = 50;
+    f->gc_status = FileMetaData::kGarbageCollectionPermitted;
+  }
+  UpdateVersionStorageInfo();
+
+  std::unique_ptr<Compaction> compaction(
+      level_compaction_picker.PickGarbageCollection(
+          cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(-1, compaction->start_level());
+  ASSERT_EQ(6U, compaction->num_input_files(0));
+  ASSERT_EQ(4U, compaction->max_subcompactions());
+
+  // Never more subcompactions than blob files
+  compaction.reset();
+  NewVersionStorage(6, kCompactionStyleLevel);
+  Add(-1, 1U, "a", "m", 1000U);
+  Add(-1, 2U, "n", "z", 1000U);
+  for (uint32_t i = 1; i <= 2; ++i) {
+    FileMetaData* f = file_map_[i].first;
+    f->prop.num_entries = 100;
+    f->num_antiquation = 50;
+    f->gc_status = FileMetaData::kGarbageCollectionPermitted;
+  }
+  UpdateVersionStorageInfo();
+  compaction.reset(level_compaction_picker.PickGarbageCollection(
+      cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(2U, compaction->num_input_files(0));
+  ASSERT_EQ(2U, compaction->max_subcompactions());
+}
+
+TEST_F(CompactionPickerTest, MapSstReadCostDecay) {
+  FileMetaData hot, cold;
+  hot.prop.read_amp = cold.prop.read_amp = 4;
+  hot.stats.num_reads_sampled = 16 * kFileReadSampleRate;
+  cold.stats.num_reads_sampled = 4 * kFileReadSampleRate;
+  ASSERT_GT(CompactionPicker::MapSstReadCost(&hot, 1000),
+            CompactionPicker::MapSstReadCost(&cold, 1000));
+  // A map sst with little read amplification always ranks last
+  FileMetaData flat;
+  flat.prop.read_amp = 1;
+  flat.stats.num_reads_sampled = 64 * kFileReadSampleRate;
+  ASSERT_LT(CompactionPicker::MapSstReadCost(&flat, 1000), 0);
+
+  // Every pick halves the recent reads, the hot map sst falls behind once
+  // it is no longer read more than the cold one
+  sample_file_read_decay(&hot);
+  ASSERT_EQ(8 * kFileReadSampleRate, sample_file_read_recent(&hot));
+  ASSERT_GT(CompactionPicker::MapSstReadCost(&hot, 1000),
+            CompactionPicker::MapSstReadCost(&cold, 1000));
+  sample_file_read_decay(&hot);
+  sample_file_read_decay(&hot);
+  ASSERT_EQ(2 * kFileReadSampleRate, sample_file_read_recent(&hot));
+  ASSERT_LT(CompactionPicker::MapSstReadCost(&hot, 1000),
+            CompactionPicker::MapSstReadCost(&cold, 1000));
+  // The sampled reads users see in the file metadata don't decay
+  ASSERT_EQ(16 * kFileReadSampleRate, hot.stats.num_reads_sampled.load());
+  // New reads count in full
+  sample_file_read_inc(&hot);
+  ASSERT_EQ(3 * kFileReadSampleRate, sample_file_read_recent(&hot));
+  ASSERT_EQ(17 * kFileReadSampleRate, hot.stats.num_reads_sampled.load());
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
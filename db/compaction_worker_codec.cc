@@ -0,0 +1,538 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/compaction_worker_codec.h"
+
+#include <string.h>
+
+#include "port/port.h"
+#include "util/coding.h"
+#include "util/string_util.h"
+
+namespace rocksdb {
+
+namespace {
+
+void PutString(std::string* dst, const Slice& value) {
+  PutLengthPrefixedSlice(dst, value);
+}
+
+bool GetString(Slice* input, std::string* value) {
+  Slice slice;
+  if (!GetLengthPrefixedSlice(input, &slice)) {
+    return false;
+  }
+  value->assign(slice.data(), slice.size());
+  return true;
+}
+
+// Every element takes at least one byte, so a count beyond the remaining
+// input is corrupt and must not size a container
+bool GetCount(Slice* input, uint64_t* count) {
+  return GetVarint64(input, count) && *count <= input->size();
+}
+
+void PutBool(std::string* dst, bool value) {
+  dst->push_back(value ? 1 : 0);
+}
+
+bool GetBool(Slice* input, bool* value) {
+  if (input->empty()) {
+    return false;
+  }
+  *value = (*input)[0] != 0;
+  input->remove_prefix(1);
+  return true;
+}
+
+void PutByte(std::string* dst, unsigned char value) {
+  dst->push_back(static_cast<char>(value));
+}
+
+bool GetByte(Slice* input, unsigned char* value) {
+  if (input->empty()) {
+    return false;
+  }
+  *value = static_cast<unsigned char>((*input)[0]);
+  input->remove_prefix(1);
+  return true;
+}
+
+// Levels may be -1, keep the two's complement bits
+void PutInt(std::string* dst, int value) {
+  PutVarint32(dst, static_cast<uint32_t>(value));
+}
+
+bool GetInt(Slice* input, int* value) {
+  uint32_t u;
+  if (!GetVarint32(input, &u)) {
+    return false;
+  }
+  *value = static_cast<int>(u);
+  return true;
+}
+
+void PutDouble(std::string* dst, double value) {
+  uint64_t u;
+  memcpy(&u, &value, sizeof(u));
+  PutFixed64(dst, u);
+}
+
+bool GetDouble(Slice* input, double* value) {
+  uint64_t u;
+  if (!GetFixed64(input, &u)) {
+    return false;
+  }
+  memcpy(value, &u, sizeof(u));
+  return true;
+}
+
+void PutFloat(std::string* dst, float value) {
+  uint32_t u;
+  memcpy(&u, &value, sizeof(u));
+  PutFixed32(dst, u);
+}
+
+bool GetFloat(Slice* input, float* value) {
+  uint32_t u;
+  if (!GetFixed32(input, &u)) {
+    return false;
+  }
+  memcpy(value, &u, sizeof(u));
+  return true;
+}
+
+void PutStatus(std::string* dst, const Status& s) {
+  PutByte(dst, s.code());
+  PutByte(dst, s.subcode());
+  PutByte(dst, s.severity());
+  PutString(dst, s.getState() == nullptr ? Slice() : Slice(s.getState()));
+}
+
+bool GetStatus(Slice* input, Status* s) {
+  unsigned char code, subcode, sev;
+  std::string state;
+  if (!GetByte(input, &code) || !GetByte(input, &subcode) ||
+      !GetByte(input, &sev) || !GetString(input, &state)) {
+    return false;
+  }
+  *s = Status(code, subcode, sev, state.empty() ? nullptr : state.c_str());
+  return true;
+}
+
+void PutInternalKey(std::string* dst, const InternalKey& key) {
+  PutString(dst, *key.rep());
+}
+
+bool GetInternalKey(Slice* input, InternalKey* key) {
+  return GetString(input, key->rep());
+}
+
+void PutHeader(std::string* dst) {
+  PutFixed32(dst, kCompactionWorkerMagic);
+  PutVarint32(dst, kCompactionWorkerFormatVersion);
+}
+
+Status GetHeader(Slice* input, uint32_t* version_ptr = nullptr) {
+  uint32_t magic, version;
+  if (!GetFixed32(input, &magic) || magic != kCompactionWorkerMagic) {
+    return Status::Corruption("Compaction worker message: bad magic");
+  }
+  if (!GetVarint32(input, &version)) {
+    return Status::Corruption("Compaction worker message: bad version");
+  }
+  if (version > kCompactionWorkerFormatVersion) {
+    return Status::NotSupported("Compaction worker message: format version",
+                                ToString(version));
+  }
+  if (version_ptr != nullptr) {
+    *version_ptr = version;
+  }
+  return Status::OK();
+}
+
+void PutFileMetaData(std::string* dst, const FileMetaData& f) {
+  PutVarint64(dst, f.fd.packed_number_and_path_id);
+  PutVarint64(dst, f.fd.file_size);
+  PutVarint64(dst, f.fd.smallest_seqno);
+  PutVarint64(dst, f.fd.largest_seqno);
+  PutInternalKey(dst, f.smallest);
+  PutInternalKey(dst, f.largest);
+  const TablePropertyCache& prop = f.prop;
+  PutVarint64(dst, prop.num_entries);
+  PutVarint64(dst, prop.num_deletions);
+  PutVarint64(dst, prop.raw_key_size);
+  PutVarint64(dst, prop.raw_value_size);
+  PutByte(dst, prop.flags);
+  PutByte(dst, prop.purpose);
+  PutVarint32(dst, prop.max_read_amp);
+  PutFloat(dst, prop.read_amp);
+  PutVarint64(dst, prop.dependence.size());
+  for (auto& d : prop.dependence) {
+    PutVarint64Varint64(dst, d.file_number, d.entry_count);
+  }
+  PutVarint64(dst, prop.inheritance_chain.size());
+  for (auto file_number : prop.inheritance_chain) {
+    PutVarint64(dst, file_number);
+  }
+}
+
+bool GetFileMetaData(Slice* input, FileMetaData* f) {
+  TablePropertyCache& prop = f->prop;
+  uint32_t max_read_amp;
+  uint64_t size;
+  if (!GetVarint64(input, &f->fd.packed_number_and_path_id) ||
+      !GetVarint64(input, &f->fd.file_size) ||
+      !GetVarint64(input, &f->fd.smallest_seqno) ||
+      !GetVarint64(input, &f->fd.largest_seqno) ||
+      !GetInternalKey(input, &f->smallest) ||
+      !GetInternalKey(input, &f->largest) ||
+      !GetVarint64(input, &prop.num_entries) ||
+      !GetVarint64(input, &prop.num_deletions) ||
+      !GetVarint64(input, &prop.raw_key_size) ||
+      !GetVarint64(input, &prop.raw_value_size) ||
+      !GetByte(input, &prop.flags) || !GetByte(input, &prop.purpose) ||
+      !GetVarint32(input, &max_read_amp) ||
+      !GetFloat(input, &prop.read_amp) || !GetCount(input, &size)) {
+    return false;
+  }
+  prop.max_read_amp = static_cast<uint16_t>(max_read_amp);
+  prop.dependence.resize(size);
+  for (auto& d : prop.dependence) {
+    if (!GetVarint64(input, &d.file_number) ||
+        !GetVarint64(input, &d.entry_count)) {
+      return false;
+    }
+  }
+  if (!GetCount(input, &size)) {
+    return false;
+  }
+  prop.inheritance_chain.resize(size);
+  for (auto& file_number : prop.inheritance_chain) {
+    if (!GetVarint64(input, &file_number)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GetFileInfo(Slice* input, CompactionWorkerResult::FileInfo* f) {
+  uint64_t file_size;
+  if (!GetInternalKey(input, &f->smallest) ||
+      !GetInternalKey(input, &f->largest) ||
+      !GetString(input, &f->file_name) ||
+      !GetVarint64(input, &f->smallest_seqno) ||
+      !GetVarint64(input, &f->largest_seqno) ||
+      !GetVarint64(input, &file_size) ||
+      !GetBool(input, &f->marked_for_compaction)) {
+    return false;
+  }
+  f->file_size = static_cast<size_t>(file_size);
+  return true;
+}
+
+void PutFileInfo(std::string* dst, const CompactionWorkerResult::FileInfo& f) {
+  PutInternalKey(dst, f.smallest);
+  PutInternalKey(dst, f.largest);
+  PutString(dst, f.file_name);
+  PutVarint64(dst, f.smallest_seqno);
+  PutVarint64(dst, f.largest_seqno);
+  PutVarint64(dst, f.file_size);
+  PutBool(dst, f.marked_for_compaction);
+}
+
+}  // anonymous namespace
+
+bool IsCompactionWorkerMessage(const Slice& data) {
+  return data.size() >= sizeof(uint32_t) &&
+         DecodeFixed32(data.data()) == kCompactionWorkerMagic;
+}
+
+void EncodeCompactionWorkerContext(const CompactionWorkerContext& c,
+                                   std::string* dst) {
+  PutHeader(dst);
+  PutString(dst, c.user_comparator);
+  PutString(dst, c.merge_operator);
+  PutString(dst, c.merge_operator_data);
+  PutString(dst, c.value_meta_extractor_factory);
+  PutString(dst, c.value_meta_extractor_factory_options);
+  PutString(dst, c.compaction_filter);
+  PutString(dst, c.compaction_filter_factory);
+  PutBool(dst, c.compaction_filter_context.is_full_compaction);
+  PutBool(dst, c.compaction_filter_context.is_manual_compaction);
+  PutVarint32(dst, c.compaction_filter_context.column_family_id);
+  PutString(dst, c.compaction_filter_data);
+  PutVarint64(dst, c.blob_config.blob_size);
+  PutDouble(dst, c.blob_config.large_key_ratio);
+  PutBool(dst, c.blob_config.value_location);
+  PutString(dst, c.table_factory);
+  PutString(dst, c.table_factory_options);
+  PutVarint32(dst, c.bloom_locality);
+  PutVarint64(dst, c.cf_paths.size());
+  for (auto& path : c.cf_paths) {
+    PutString(dst, path);
+  }
+  PutString(dst, c.prefix_extractor);
+  PutString(dst, c.prefix_extractor_options);
+  PutBool(dst, c.has_start);
+  PutBool(dst, c.has_end);
+  PutString(dst, c.start);
+  PutString(dst, c.end);
+  PutVarint64(dst, c.last_sequence);
+  PutVarint64(dst, c.earliest_write_conflict_snapshot);
+  PutVarint64(dst, c.preserve_deletes_seqnum);
+  PutVarint64(dst, c.file_metadata.size());
+  for (auto& pair : c.file_metadata) {
+    PutVarint64(dst, pair.first);
+    PutFileMetaData(dst, pair.second);
+  }
+  PutVarint64(dst, c.inputs.size());
+  for (auto& pair : c.inputs) {
+    PutInt(dst, pair.first);
+    PutVarint64(dst, pair.second);
+  }
+  PutString(dst, c.cf_name);
+  PutVarint64(dst, c.target_file_size);
+  PutByte(dst, c.compression);
+  PutInt(dst, c.compression_opts.window_bits);
+  PutInt(dst, c.compression_opts.level);
+  PutInt(dst, c.compression_opts.strategy);
+  PutVarint32(dst, c.compression_opts.max_dict_bytes);
+  PutVarint32(dst, c.compression_opts.zstd_max_train_bytes);
+  PutBool(dst, c.compression_opts.enabled);
+  PutVarint64(dst, c.existing_snapshots.size());
+  for (auto snapshot : c.existing_snapshots) {
+    PutVarint64(dst, snapshot);
+  }
+  PutString(dst, c.smallest_user_key);
+  PutString(dst, c.largest_user_key);
+  PutInt(dst, c.level);
+  PutInt(dst, c.output_level);
+  PutInt(dst, c.number_levels);
+  PutBool(dst, c.skip_filters);
+  PutBool(dst, c.bottommost_level);
+  PutBool(dst, c.allow_ingest_behind);
+  PutBool(dst, c.preserve_deletes);
+  PutVarint64(dst, c.int_tbl_prop_collector_factories.size());
+  for (auto& collector : c.int_tbl_prop_collector_factories) {
+    PutString(dst, collector.name);
+    PutString(dst, collector.param);
+  }
+  PutByte(dst, c.compaction_type);
+  PutVarint64(dst, c.lsm_files.size());
+  for (auto& pair : c.lsm_files) {
+    PutInt(dst, pair.first);
+    PutVarint64(dst, pair.second);
+  }
+  PutVarint64(dst, c.max_sequential_skip_in_iterations);
+}
+
+Status DecodeCompactionWorkerContext(Slice input, CompactionWorkerContext* c) {
+  uint32_t version;
+  Status s = GetHeader(&input, &version);
+  if (!s.ok()) {
+    return s;
+  }
+  auto corruption = [](const char* field) {
+    return Status::Corruption("CompactionWorkerContext: bad", field);
+  };
+  uint64_t blob_size, size;
+  if (!GetString(&input, &c->user_comparator) ||
+      !GetString(&input, &c->merge_operator) ||
+      !GetString(&input, &c->merge_operator_data.data) ||
+      !GetString(&input, &c->value_meta_extractor_factory) ||
+      !GetString(&input, &c->value_meta_extractor_factory_options.data) ||
+      !GetString(&input, &c->compaction_filter) ||
+      !GetString(&input, &c->compaction_filter_factory) ||
+      !GetBool(&input, &c->compaction_filter_context.is_full_compaction) ||
+      !GetBool(&input, &c->compaction_filter_context.is_manual_compaction) ||
+      !GetVarint32(&input, &c->compaction_filter_context.column_family_id) ||
+      !GetString(&input, &c->compaction_filter_data.data)) {
+    return corruption("options");
+  }
+  if (!GetVarint64(&input, &blob_size) ||
+      !GetDouble(&input, &c->blob_config.large_key_ratio) ||
+      !GetBool(&input, &c->blob_config.value_location) ||
+      !GetString(&input, &c->table_factory) ||
+      !GetString(&input, &c->table_factory_options) ||
+      !GetVarint32(&input, &c->bloom_locality) ||
+      !GetCount(&input, &size)) {
+    return corruption("table options");
+  }
+  c->blob_config.blob_size = static_cast<size_t>(blob_size);
+  c->cf_paths.resize(size);
+  for (auto& path : c->cf_paths) {
+    if (!GetString(&input, &path)) {
+      return corruption("cf_paths");
+    }
+  }
+  if (!GetString(&input, &c->prefix_extractor) ||
+      !GetString(&input, &c->prefix_extractor_options) ||
+      !GetBool(&input, &c->has_start) || !GetBool(&input, &c->has_end) ||
+      !GetString(&input, &c->start.data) ||
+      !GetString(&input, &c->end.data) ||
+      !GetVarint64(&input, &c->last_sequence) ||
+      !GetVarint64(&input, &c->earliest_write_conflict_snapshot) ||
+      !GetVarint64(&input, &c->preserve_deletes_seqnum) ||
+      !GetCount(&input, &size)) {
+    return corruption("range");
+  }
+  c->file_metadata.resize(size);
+  for (auto& pair : c->file_metadata) {
+    if (!GetVarint64(&input, &pair.first) ||
+        !GetFileMetaData(&input, &pair.second)) {
+      return corruption("file_metadata");
+    }
+  }
+  if (!GetCount(&input, &size)) {
+    return corruption("inputs");
+  }
+  c->inputs.resize(size);
+  for (auto& pair : c->inputs) {
+    if (!GetInt(&input, &pair.first) || !GetVarint64(&input, &pair.second)) {
+      return corruption("inputs");
+    }
+  }
+  uint64_t target_file_size;
+  unsigned char compression;
+  if (!GetString(&input, &c->cf_name) ||
+      !GetVarint64(&input, &target_file_size) ||
+      !GetByte(&input, &compression) ||
+      !GetInt(&input, &c->compression_opts.window_bits) ||
+      !GetInt(&input, &c->compression_opts.level) ||
+      !GetInt(&input, &c->compression_opts.strategy) ||
+      !GetVarint32(&input, &c->compression_opts.max_dict_bytes) ||
+      !GetVarint32(&input, &c->compression_opts.zstd_max_train_bytes) ||
+      !GetBool(&input, &c->compression_opts.enabled) ||
+      !GetCount(&input, &size)) {
+    return corruption("output options");
+  }
+  c->target_file_size = target_file_size;
+  c->compression = static_cast<CompressionType>(compression);
+  c->existing_snapshots.resize(size);
+  for (auto& snapshot : c->existing_snapshots) {
+    if (!GetVarint64(&input, &snapshot)) {
+      return corruption("existing_snapshots");
+    }
+  }
+  if (!GetString(&input, &c->smallest_user_key.data) ||
+      !GetString(&input, &c->largest_user_key.data) ||
+      !GetInt(&input, &c->level) || !GetInt(&input, &c->output_level) ||
+      !GetInt(&input, &c->number_levels) ||
+      !GetBool(&input, &c->skip_filters) ||
+      !GetBool(&input, &c->bottommost_level) ||
+      !GetBool(&input, &c->allow_ingest_behind) ||
+      !GetBool(&input, &c->preserve_deletes) ||
+      !GetCount(&input, &size)) {
+    return corruption("levels");
+  }
+  c->int_tbl_prop_collector_factories.resize(size);
+  for (auto& collector : c->int_tbl_prop_collector_factories) {
+    if (!GetString(&input, &collector.name) ||
+        !GetString(&input, &collector.param.data)) {
+      return corruption("int_tbl_prop_collector_factories");
+    }
+  }
+  if (version < 2) {
+    return Status::OK();
+  }
+  unsigned char compaction_type;
+  if (!GetByte(&input, &compaction_type) || !GetCount(&input, &size)) {
+    return corruption("compaction_type");
+  }
+  c->compaction_type = static_cast<CompactionType>(compaction_type);
+  c->lsm_files.resize(size);
+  for (auto& pair : c->lsm_files) {
+    if (!GetInt(&input, &pair.first) || !GetVarint64(&input, &pair.second)) {
+      return corruption("lsm_files");
+    }
+  }
+  if (!GetVarint64(&input, &c->max_sequential_skip_in_iterations)) {
+    return corruption("max_sequential_skip_in_iterations");
+  }
+  return Status::OK();
+}
+
+void EncodeCompactionWorkerResult(const CompactionWorkerResult& result,
+                                  std::string* dst) {
+  PutHeader(dst);
+  PutStatus(dst, result.status);
+  PutInternalKey(dst, result.actual_start);
+  PutInternalKey(dst, result.actual_end);
+  PutVarint64(dst, result.files.size());
+  for (auto& f : result.files) {
+    PutFileInfo(dst, f);
+  }
+  PutString(dst, result.stat_all);
+  PutVarint64(dst, result.time_us);
+}
+
+Status DecodeCompactionWorkerResult(Slice input,
+                                    CompactionWorkerResult* result) {
+  Status s = GetHeader(&input);
+  if (!s.ok()) {
+    return s;
+  }
+  uint64_t size, time_us;
+  if (!GetStatus(&input, &result->status) ||
+      !GetInternalKey(&input, &result->actual_start) ||
+      !GetInternalKey(&input, &result->actual_end) ||
+      !GetCount(&input, &size)) {
+    return Status::Corruption("CompactionWorkerResult: bad header");
+  }
+  result->files.resize(size);
+  for (auto& f : result->files) {
+    if (!GetFileInfo(&input, &f)) {
+      return Status::Corruption("CompactionWorkerResult: bad files");
+    }
+  }
+  if (!GetString(&input, &result->stat_all) ||
+      !GetVarint64(&input, &time_us)) {
+    return Status::Corruption("CompactionWorkerResult: bad stat");
+  }
+  result->time_us = static_cast<size_t>(time_us);
+  return Status::OK();
+}
+
+void EncodeCompactionWorkerFileInfo(
+    const CompactionWorkerResult::FileInfo& file_info, std::string* dst) {
+  PutHeader(dst);
+  PutFileInfo(dst, file_info);
+}
+
+Status DecodeCompactionWorkerFileInfo(
+    Slice input, CompactionWorkerResult::FileInfo* file_info) {
+  Status s = GetHeader(&input);
+  if (s.ok() && !GetFileInfo(&input, file_info)) {
+    s = Status::Corruption("CompactionWorkerResult::FileInfo");
+  }
+  return s;
+}
+
+Status EncodeCompactionWorkerFrameHeader(CompactionWorkerFrameType type,
+                                         size_t payload_size, char* buf) {
+  if (payload_size > port::kMaxUint32) {
+    return Status::InvalidArgument("Compaction worker frame: payload too big",
+                                   ToString(payload_size));
+  }
+  buf[0] = static_cast<char>(type);
+  EncodeFixed32(buf + 1, static_cast<uint32_t>(payload_size));
+  return Status::OK();
+}
+
+Status DecodeCompactionWorkerFrameHeader(const char* buf,
+                                         CompactionWorkerFrameType* type,
+                                         size_t* payload_size) {
+  unsigned char t = static_cast<unsigned char>(buf[0]);
+  if (t < kCompactionWorkerRequest || t > kCompactionWorkerResult) {
+    return Status::Corruption("Compaction worker frame: bad type",
+                              ToString(t));
+  }
+  *type = static_cast<CompactionWorkerFrameType>(t);
+  *payload_size = DecodeFixed32(buf + 1);
+  return Status::OK();
+}
+
+}  // namespace rocksdb
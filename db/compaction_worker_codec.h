@@ -0,0 +1,64 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+#pragma once
+
+#include <string>
+
+#include "db/compaction.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// Binary encoding of the messages exchanged between a
+// RemoteCompactionDispatcher and its workers. Every message starts with
+// kCompactionWorkerMagic and a format version, keys and option blobs are
+// stored as raw length prefixed bytes.
+//
+// Messages without the magic are the legacy ajson / DataIO encoding.
+const uint32_t kCompactionWorkerMagic = 0x57434454;  // "TDCW"
+// Version 2 adds garbage collection jobs and the LSM view they need
+const uint32_t kCompactionWorkerFormatVersion = 2;
+
+extern bool IsCompactionWorkerMessage(const Slice& data);
+
+extern void EncodeCompactionWorkerContext(
+    const CompactionWorkerContext& context, std::string* dst);
+extern Status DecodeCompactionWorkerContext(Slice input,
+                                            CompactionWorkerContext* context);
+
+extern void EncodeCompactionWorkerResult(const CompactionWorkerResult& result,
+                                         std::string* dst);
+extern Status DecodeCompactionWorkerResult(Slice input,
+                                           CompactionWorkerResult* result);
+
+// A single output file, streamed back while the worker is still running
+extern void EncodeCompactionWorkerFileInfo(
+    const CompactionWorkerResult::FileInfo& file_info, std::string* dst);
+extern Status DecodeCompactionWorkerFileInfo(
+    Slice input, CompactionWorkerResult::FileInfo* file_info);
+
+// Frames of the persistent worker transport. A frame is a one byte type and a
+// fixed32 payload length followed by the payload.
+enum CompactionWorkerFrameType : unsigned char {
+  // Dispatcher to worker, an encoded CompactionWorkerContext
+  kCompactionWorkerRequest = 1,
+  // Worker to dispatcher, an encoded FileInfo of a finished output file
+  kCompactionWorkerFileFinished = 2,
+  // Worker to dispatcher, the encoded CompactionWorkerResult, ends the job
+  kCompactionWorkerResult = 3,
+};
+
+const size_t kCompactionWorkerFrameHeaderSize = 5;
+
+// Fails if the payload doesn't fit the fixed32 length
+extern Status EncodeCompactionWorkerFrameHeader(CompactionWorkerFrameType type,
+                                                size_t payload_size,
+                                                char* buf);
+extern Status DecodeCompactionWorkerFrameHeader(const char* buf,
+                                                CompactionWorkerFrameType* type,
+                                                size_t* payload_size);
+
+}  // namespace rocksdb
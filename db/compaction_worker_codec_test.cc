@@ -0,0 +1,248 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/compaction_worker_codec.h"
+
+#include "util/coding.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class CompactionWorkerCodecTest : public testing::Test {};
+
+namespace {
+
+std::string BinaryKey(char c) {
+  // Keys the legacy JSON encoding had to hex escape
+  return std::string("\0\xff", 2) + c + std::string(3, '\0');
+}
+
+InternalKey IKey(char c, SequenceNumber seq) {
+  return InternalKey(BinaryKey(c), seq, kTypeValue);
+}
+
+}  // namespace
+
+TEST_F(CompactionWorkerCodecTest, ContextRoundTrip) {
+  CompactionWorkerContext c;
+  c.user_comparator = "leveldb.BytewiseComparator";
+  c.merge_operator = "StringAppendOperator";
+  c.merge_operator_data = std::string("\x01\x00\x02", 3);
+  c.compaction_filter_factory = "Factory";
+  c.compaction_filter_context.is_full_compaction = true;
+  c.compaction_filter_context.is_manual_compaction = false;
+  c.compaction_filter_context.column_family_id = 7;
+  c.blob_config = BlobConfig{4096, 0.25, true};
+  c.table_factory = "BlockBasedTable";
+  c.table_factory_options = "block_size=4096";
+  c.bloom_locality = 1;
+  c.cf_paths = {"/a", "/b"};
+  c.has_start = true;
+  c.has_end = false;
+  c.start = BinaryKey('s');
+  c.last_sequence = 1000;
+  c.earliest_write_conflict_snapshot = 900;
+  c.preserve_deletes_seqnum = 0;
+  FileMetaData f;
+  f.fd = FileDescriptor(12, 1, 4096, 10, 20);
+  f.smallest = IKey('a', 10);
+  f.largest = IKey('z', 20);
+  f.prop.num_entries = 100;
+  f.prop.purpose = kMapSst;
+  f.prop.max_read_amp = 3;
+  f.prop.read_amp = 1.5f;
+  f.prop.dependence = {Dependence{10, 50}, Dependence{11, 50}};
+  f.prop.inheritance_chain = {3, 4};
+  c.file_metadata.emplace_back(12, f);
+  c.inputs = {{0, 12}, {-1, 10}};
+  c.cf_name = "default";
+  c.target_file_size = 64 << 20;
+  c.compression = kZSTD;
+  c.compression_opts.level = -3;
+  c.compression_opts.max_dict_bytes = 1 << 14;
+  c.existing_snapshots = {100, 200};
+  c.smallest_user_key = BinaryKey('a');
+  c.largest_user_key = BinaryKey('z');
+  c.level = 1;
+  c.output_level = 2;
+  c.number_levels = 7;
+  c.bottommost_level = true;
+  c.int_tbl_prop_collector_factories.push_back(
+      CompactionWorkerContext::NameParam{"Collector", {"param"}});
+  c.compaction_type = kGarbageCollection;
+  c.lsm_files = {{0, 12}, {2, 13}};
+  c.max_sequential_skip_in_iterations = 16;
+
+  std::string encoded;
+  EncodeCompactionWorkerContext(c, &encoded);
+  ASSERT_TRUE(IsCompactionWorkerMessage(encoded));
+
+  CompactionWorkerContext d;
+  ASSERT_OK(DecodeCompactionWorkerContext(encoded, &d));
+  ASSERT_EQ(c.user_comparator, d.user_comparator);
+  ASSERT_EQ(c.merge_operator_data.data, d.merge_operator_data.data);
+  ASSERT_EQ(c.compaction_filter_factory, d.compaction_filter_factory);
+  ASSERT_TRUE(d.compaction_filter_context.is_full_compaction);
+  ASSERT_EQ(7, d.compaction_filter_context.column_family_id);
+  ASSERT_EQ(4096, d.blob_config.blob_size);
+  ASSERT_EQ(0.25, d.blob_config.large_key_ratio);
+  ASSERT_TRUE(d.blob_config.value_location);
+  ASSERT_EQ(c.cf_paths, d.cf_paths);
+  ASSERT_TRUE(d.has_start);
+  ASSERT_FALSE(d.has_end);
+  ASSERT_EQ(c.start.data, d.start.data);
+  ASSERT_EQ(1000, d.last_sequence);
+  ASSERT_EQ(1, d.file_metadata.size());
+  const FileMetaData& g = d.file_metadata[0].second;
+  ASSERT_EQ(12, d.file_metadata[0].first);
+  ASSERT_EQ(12, g.fd.GetNumber());
+  ASSERT_EQ(1, g.fd.GetPathId());
+  ASSERT_EQ(20, g.fd.largest_seqno);
+  ASSERT_EQ(*f.smallest.rep(), *g.smallest.rep());
+  ASSERT_EQ(*f.largest.rep(), *g.largest.rep());
+  ASSERT_TRUE(g.prop.is_map_sst());
+  ASSERT_EQ(3, g.prop.max_read_amp);
+  ASSERT_EQ(1.5f, g.prop.read_amp);
+  ASSERT_EQ(2, g.prop.dependence.size());
+  ASSERT_EQ(11, g.prop.dependence[1].file_number);
+  ASSERT_EQ(f.prop.inheritance_chain, g.prop.inheritance_chain);
+  ASSERT_EQ(c.inputs, d.inputs);
+  ASSERT_EQ(kZSTD, d.compression);
+  ASSERT_EQ(-3, d.compression_opts.level);
+  ASSERT_EQ(1 << 14, d.compression_opts.max_dict_bytes);
+  ASSERT_EQ(c.existing_snapshots, d.existing_snapshots);
+  ASSERT_EQ(c.largest_user_key.data, d.largest_user_key.data);
+  ASSERT_EQ(2, d.output_level);
+  ASSERT_TRUE(d.bottommost_level);
+  ASSERT_EQ(1, d.int_tbl_prop_collector_factories.size());
+  ASSERT_EQ("param", d.int_tbl_prop_collector_factories[0].param.data);
+  ASSERT_EQ(kGarbageCollection, d.compaction_type);
+  ASSERT_EQ(c.lsm_files, d.lsm_files);
+  ASSERT_EQ(16, d.max_sequential_skip_in_iterations);
+
+  // Every truncation is detected
+  for (size_t n = 0; n < encoded.size(); ++n) {
+    CompactionWorkerContext t;
+    ASSERT_NOK(DecodeCompactionWorkerContext(Slice(encoded.data(), n), &t));
+  }
+}
+
+TEST_F(CompactionWorkerCodecTest, ResultRoundTrip) {
+  CompactionWorkerResult r;
+  r.status = Status::Corruption("bad", "block");
+  r.actual_start = IKey('a', kMaxSequenceNumber);
+  r.actual_end = IKey('m', kMaxSequenceNumber);
+  for (char c = 'a'; c < 'd'; ++c) {
+    CompactionWorkerResult::FileInfo f;
+    f.smallest = IKey(c, 1);
+    f.largest = IKey(c + 1, 2);
+    f.file_name = std::string("out-") + c;
+    f.smallest_seqno = 1;
+    f.largest_seqno = 2;
+    f.file_size = 1 << 20;
+    f.marked_for_compaction = c == 'b';
+    r.files.push_back(f);
+  }
+  r.stat_all = "stat";
+  r.time_us = 12345;
+
+  std::string encoded;
+  EncodeCompactionWorkerResult(r, &encoded);
+  CompactionWorkerResult d;
+  ASSERT_OK(DecodeCompactionWorkerResult(encoded, &d));
+  ASSERT_TRUE(d.status.IsCorruption());
+  ASSERT_EQ(r.status.ToString(), d.status.ToString());
+  ASSERT_EQ(*r.actual_end.rep(), *d.actual_end.rep());
+  ASSERT_EQ(3, d.files.size());
+  ASSERT_EQ("out-c", d.files[2].file_name);
+  ASSERT_EQ(*r.files[1].largest.rep(), *d.files[1].largest.rep());
+  ASSERT_TRUE(d.files[1].marked_for_compaction);
+  ASSERT_FALSE(d.files[2].marked_for_compaction);
+  ASSERT_EQ(1 << 20, d.files[0].file_size);
+  ASSERT_EQ("stat", d.stat_all);
+  ASSERT_EQ(12345, d.time_us);
+
+  std::string file_info;
+  EncodeCompactionWorkerFileInfo(r.files[0], &file_info);
+  CompactionWorkerResult::FileInfo f;
+  ASSERT_OK(DecodeCompactionWorkerFileInfo(file_info, &f));
+  ASSERT_EQ("out-a", f.file_name);
+
+  // Legacy and future messages
+  ASSERT_FALSE(IsCompactionWorkerMessage("{\"status\":{}}"));
+  ASSERT_TRUE(DecodeCompactionWorkerResult("{\"status\":{}}", &d)
+                  .IsCorruption());
+  std::string future;
+  PutFixed32(&future, kCompactionWorkerMagic);
+  PutVarint32(&future, kCompactionWorkerFormatVersion + 1);
+  ASSERT_TRUE(DecodeCompactionWorkerResult(future, &d).IsNotSupported());
+}
+
+TEST_F(CompactionWorkerCodecTest, FrameHeader) {
+  char buf[kCompactionWorkerFrameHeaderSize];
+  ASSERT_OK(EncodeCompactionWorkerFrameHeader(kCompactionWorkerFileFinished,
+                                              123456, buf));
+  CompactionWorkerFrameType type;
+  size_t size;
+  ASSERT_OK(DecodeCompactionWorkerFrameHeader(buf, &type, &size));
+  ASSERT_EQ(kCompactionWorkerFileFinished, type);
+  ASSERT_EQ(123456, size);
+  buf[0] = 0;
+  ASSERT_TRUE(DecodeCompactionWorkerFrameHeader(buf, &type, &size)
+                  .IsCorruption());
+  // The length is a fixed32, bigger payloads are refused instead of cut
+  if (sizeof(size_t) > sizeof(uint32_t)) {
+    ASSERT_TRUE(EncodeCompactionWorkerFrameHeader(
+                    kCompactionWorkerResult,
+                    static_cast<size_t>(uint64_t{1} << 32), buf)
+                    .IsInvalidArgument());
+  }
+}
+
+TEST_F(CompactionWorkerCodecTest, BadCount) {
+  // A file count far beyond the message is corrupt, not a huge allocation
+  CompactionWorkerResult r;
+  r.actual_start = IKey('a', 1);
+  r.actual_end = IKey('b', 2);
+  std::string encoded;
+  PutFixed32(&encoded, kCompactionWorkerMagic);
+  PutVarint32(&encoded, kCompactionWorkerFormatVersion);
+  encoded.append(3, '\0');  // status code, subcode and severity
+  PutLengthPrefixedSlice(&encoded, Slice());
+  PutLengthPrefixedSlice(&encoded, *r.actual_start.rep());
+  PutLengthPrefixedSlice(&encoded, *r.actual_end.rep());
+  std::string valid = encoded;
+  PutVarint64(&encoded, uint64_t{1} << 60);
+  CompactionWorkerResult d;
+  ASSERT_TRUE(DecodeCompactionWorkerResult(encoded, &d).IsCorruption());
+  ASSERT_TRUE(d.files.empty());
+
+  // The same message with no files decodes
+  PutVarint64(&valid, 0);
+  PutLengthPrefixedSlice(&valid, "stat");
+  PutVarint64(&valid, 1);
+  ASSERT_OK(DecodeCompactionWorkerResult(valid, &d));
+  ASSERT_EQ("stat", d.stat_all);
+
+  // Same for the context
+  CompactionWorkerContext c;
+  c.cf_paths = {"a", "b"};
+  std::string context;
+  EncodeCompactionWorkerContext(c, &context);
+  CompactionWorkerContext dc;
+  ASSERT_OK(DecodeCompactionWorkerContext(context, &dc));
+  ASSERT_EQ(2, dc.cf_paths.size());
+  for (size_t cut = 1; cut < context.size(); ++cut) {
+    ASSERT_FALSE(
+        DecodeCompactionWorkerContext(Slice(context.data(), cut), &dc).ok());
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -796,6 +796,134 @@ TEST_F(DBBasicTest, MultiGetEmpty) {
   } while (ChangeCompactOptions());
 }
 
+TEST_F(DBBasicTest, MultiGetBatched) {
+  Options options = CurrentOptions();
+  options.enable_lazy_compaction = false;
+  options.blob_size = -1;
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  options.statistics = rocksdb::CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  auto key = [](int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return std::string(buf);
+  };
+  const int kNumKeys = 200;
+  // Bottom level
+  for (int i = 0; i < kNumKeys; i += 2) {
+    ASSERT_OK(Put(key(i), "base" + ToString(i)));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(2);
+  // Overlapping L0 files, with merges and deletes
+  for (int i = 0; i < kNumKeys; i += 3) {
+    ASSERT_OK(Merge(key(i), "m" + ToString(i)));
+  }
+  ASSERT_OK(Flush());
+  const Snapshot* snapshot = db_->GetSnapshot();
+  for (int i = 0; i < kNumKeys; i += 5) {
+    ASSERT_OK(Delete(key(i)));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < kNumKeys; i += 7) {
+    ASSERT_OK(Put(key(i), "mem" + ToString(i)));
+  }
+
+  // Unsorted keys, with duplicates and keys beyond the range
+  std::vector<std::string> key_strs;
+  for (int i = kNumKeys + 10; i >= 0; i -= 1) {
+    key_strs.push_back(key(i));
+    if (i % 11 == 0) {
+      key_strs.push_back(key(i));
+    }
+  }
+  std::vector<Slice> keys(key_strs.begin(), key_strs.end());
+  for (auto snap : {static_cast<const Snapshot*>(nullptr), snapshot}) {
+    ReadOptions ro;
+    ro.snapshot = snap;
+    std::vector<std::string> values;
+    std::vector<Status> s = db_->MultiGet(ro, keys, &values);
+    ASSERT_EQ(keys.size(), s.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      std::string value;
+      Status expect = db_->Get(ro, keys[i], &value);
+      ASSERT_EQ(expect.code(), s[i].code()) << keys[i].ToString();
+      if (expect.ok()) {
+        ASSERT_EQ(value, values[i]) << keys[i].ToString();
+      }
+    }
+  }
+  db_->ReleaseSnapshot(snapshot);
+
+  // Keys sharing a data block load it once per batch
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  Reopen(options);
+  keys.clear();
+  for (int i = 0; i < 32; ++i) {
+    keys.push_back(key_strs[kNumKeys / 2 + i]);
+  }
+  std::vector<std::string> values;
+  uint64_t accesses =
+      TestGetTickerCount(options, BLOCK_CACHE_DATA_HIT) +
+      TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS);
+  db_->MultiGet(ReadOptions(), keys, &values);
+  accesses = TestGetTickerCount(options, BLOCK_CACHE_DATA_HIT) +
+             TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS) - accesses;
+  ASSERT_GT(accesses, 0);
+  ASSERT_LT(accesses, keys.size() / 2);
+}
+
+TEST_F(DBBasicTest, MultiGetMultiReadBlocks) {
+  Options options = CurrentOptions();
+  options.enable_lazy_compaction = false;
+  options.blob_size = -1;
+  options.disable_auto_compactions = true;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 256;
+  table_options.block_cache = NewLRUCache(8 << 20);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 2000;
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_OK(Put(Key(i), "value" + ToString(i)));
+  }
+  ASSERT_OK(Flush());
+
+  std::vector<std::string> key_strs;
+  for (int i = 0; i < kNumKeys; i += 50) {
+    key_strs.push_back(Key(i));
+  }
+  std::vector<Slice> keys(key_strs.begin(), key_strs.end());
+
+  size_t multi_reads = 0;
+  size_t multi_read_blocks = 0;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "RandomAccessFileReader::MultiRead", [&](void* arg) {
+        ++multi_reads;
+        multi_read_blocks += *static_cast<size_t*>(arg);
+      });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  for (int round = 0; round < 2; ++round) {
+    std::vector<std::string> values;
+    std::vector<Status> s = db_->MultiGet(ReadOptions(), keys, &values);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      ASSERT_OK(s[i]);
+      ASSERT_EQ("value" + ToString(i * 50), values[i]);
+    }
+    // All blocks of the first round are read by one MultiRead, the second
+    // round finds them in the block cache
+    ASSERT_EQ(1, multi_reads);
+    ASSERT_EQ(keys.size(), multi_read_blocks);
+  }
+
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
 TEST_F(DBBasicTest, ChecksumTest) {
   BlockBasedTableOptions table_options;
   Options options = CurrentOptions();
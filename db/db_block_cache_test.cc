@@ -631,6 +631,56 @@ TEST_F(DBBlockCacheTest, CompressedCache) {
   }
 }
 
+TEST_F(DBBlockCacheTest, CompressedCacheDemotion) {
+  CompressionType type = kNoCompression;
+  for (auto t : {kLZ4Compression, kSnappyCompression, kZSTD,
+                 kZlibCompression}) {
+    if (CompressionTypeSupported(t)) {
+      type = t;
+      break;
+    }
+  }
+  if (type == kNoCompression) {
+    return;
+  }
+  auto table_options = GetTableOptions();
+  // Blocks are evicted as soon as they are released
+  table_options.block_cache = NewLRUCache(0, 0, false);
+  table_options.block_cache_compressed = NewLRUCache(1 << 20, 0, false);
+  table_options.block_cache_demotion_compression = type;
+  auto options = GetOptions(table_options);
+  options.compression = kNoCompression;
+  DestroyAndReopen(options);
+  InitTable(options);
+  ASSERT_OK(Flush());
+  RecordCacheCounters(options);
+
+  std::string value(kValueSize, 'a');
+  // Blocks read from the file are demoted when evicted
+  for (size_t i = 0; i < kNumBlocks; i++) {
+    ASSERT_EQ(value, Get(ToString(i)));
+    CheckCacheCounters(options, 1, 0, 1, 0);
+    CheckCompressedCacheCounters(options, 1, 0, 0, 0);
+  }
+  ASSERT_EQ(kNumBlocks,
+            TestGetTickerCount(options, BLOCK_CACHE_COMPRESSED_DEMOTE));
+  ASSERT_LT(0, TestGetTickerCount(options, BLOCK_CACHE_COMPRESSED_DEMOTE_BYTES));
+  ASSERT_EQ(0, table_options.block_cache->GetUsage());
+  size_t compressed_usage = table_options.block_cache_compressed->GetUsage();
+  ASSERT_LT(0, compressed_usage);
+
+  // Demoted blocks are promoted back, and demoted again
+  for (size_t i = 0; i < kNumBlocks; i++) {
+    ASSERT_EQ(value, Get(ToString(i)));
+    CheckCacheCounters(options, 1, 0, 1, 0);
+    CheckCompressedCacheCounters(options, 0, 1, 0, 0);
+  }
+  ASSERT_EQ(2 * kNumBlocks,
+            TestGetTickerCount(options, BLOCK_CACHE_COMPRESSED_DEMOTE));
+  ASSERT_EQ(compressed_usage,
+            table_options.block_cache_compressed->GetUsage());
+}
+
 #endif  // ROCKSDB_LITE
 
 }  // namespace rocksdb
@@ -4290,6 +4290,61 @@ TEST_P(DBCompactionTestWithParam, FixFileIngestionCompactionDeadlock) {
   Close();
 }
 
+TEST_F(DBCompactionTest, GarbageCollectionSubcompactions) {
+  Options options = CurrentOptions();
+  options.blob_size = 16;
+  options.max_subcompactions = 4;
+  options.max_background_jobs = 8;
+  options.level0_file_num_compaction_trigger = 100;
+  DestroyAndReopen(options);
+
+  std::atomic<size_t> max_groups(0);
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::GenGarbageCollectionGroups", [&](void* arg) {
+        size_t n = *static_cast<size_t*>(arg);
+        if (n > max_groups.load()) {
+          max_groups.store(n);
+        }
+      });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  // Four blob files, half of each one is overwritten later
+  const int kNumFiles = 4;
+  const int kKeysPerFile = 100;
+  Random rnd(301);
+  std::map<std::string, std::string> expect;
+  for (int i = 0; i < kNumFiles; ++i) {
+    for (int j = 0; j < kKeysPerFile; ++j) {
+      std::string key = Key(i * kKeysPerFile + j);
+      expect[key] = RandomString(&rnd, 100);
+      ASSERT_OK(Put(key, expect[key]));
+    }
+    ASSERT_OK(Flush());
+  }
+  for (int i = 0; i < kNumFiles; ++i) {
+    for (int j = 0; j < kKeysPerFile; j += 2) {
+      std::string key = Key(i * kKeysPerFile + j);
+      expect[key] = RandomString(&rnd, 100);
+      ASSERT_OK(Put(key, expect[key]));
+    }
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_GT(max_groups.load(), 1);
+  for (auto& pair : expect) {
+    ASSERT_EQ(pair.second, Get(pair.first));
+  }
+  Reopen(options);
+  for (auto& pair : expect) {
+    ASSERT_EQ(pair.second, Get(pair.first));
+  }
+}
+
 #endif // !defined(ROCKSDB_LITE)
 }  // namespace rocksdb
 
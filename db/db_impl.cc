@@ -1691,44 +1691,37 @@ std::vector<Status> DBImpl::MultiGet(
   // merge_operands will contain the sequence of merges in the latter case.
   size_t num_found = 0;
   size_t counting = num_keys;
-  auto get_one = [&](size_t i) {
-    // Contain a list of merge operations if merge occurs.
-    MergeContext merge_context;
-    Status& s = stat_list[i];
-    std::string* value = &(*values)[i];
-    LazyBuffer lazy_val(value);
-
-    LookupKey lkey(keys[i], snapshot);
+  bool skip_memtable =
+      (read_options.read_tier == kPersistedTier &&
+       has_unpersisted_data_.load(std::memory_order_relaxed));
+  auto get_super_version = [&](size_t i) {
     auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i]);
-    SequenceNumber max_covering_tombstone_seq = 0;
     auto mgd_iter = multiget_cf_data.find(cfh->cfd()->GetID());
     assert(mgd_iter != multiget_cf_data.end());
-    auto mgd = mgd_iter->second;
-    auto super_version = mgd->super_version;
-    bool skip_memtable =
-        (read_options.read_tier == kPersistedTier &&
-         has_unpersisted_data_.load(std::memory_order_relaxed));
-    bool done = false;
-    if (!skip_memtable) {
-      if (super_version->mem->Get(lkey, &lazy_val, &s, &merge_context,
-                                  &max_covering_tombstone_seq, read_options)) {
-        done = true;
-        RecordTick(stats_, MEMTABLE_HIT);
-      } else if (super_version->imm->Get(lkey, &lazy_val, &s, &merge_context,
-                                         &max_covering_tombstone_seq,
-                                         read_options)) {
-        done = true;
-        RecordTick(stats_, MEMTABLE_HIT);
-      }
+    return mgd_iter->second->super_version;
+  };
+  auto get_from_memtable = [&](size_t i, SuperVersion* super_version,
+                               const LookupKey& lkey, LazyBuffer* lazy_val,
+                               MergeContext* merge_context,
+                               SequenceNumber* max_covering_tombstone_seq) {
+    Status& s = stat_list[i];
+    if (skip_memtable) {
+      return false;
     }
-    if (!done) {
-      PERF_TIMER_GUARD(get_from_output_files_time);
-      super_version->current->Get(read_options, keys[i], lkey, &lazy_val, &s,
-                                  &merge_context, &max_covering_tombstone_seq);
-      RecordTick(stats_, MEMTABLE_MISS);
+    if (super_version->mem->Get(lkey, lazy_val, &s, merge_context,
+                                max_covering_tombstone_seq, read_options) ||
+        super_version->imm->Get(lkey, lazy_val, &s, merge_context,
+                                max_covering_tombstone_seq, read_options)) {
+      RecordTick(stats_, MEMTABLE_HIT);
+      return true;
     }
+    return false;
+  };
+  auto finish_one = [&](size_t i, LazyBuffer* lazy_val) {
+    Status& s = stat_list[i];
+    std::string* value = &(*values)[i];
     if (s.ok()) {
-      s = std::move(lazy_val).dump(value);
+      s = std::move(*lazy_val).dump(value);
     }
     if (s.ok()) {
       bytes_read += value->size();
@@ -1736,7 +1729,55 @@ std::vector<Status> DBImpl::MultiGet(
     }
     counting--;
   };
+  // Memtable misses of each column family go to the SSTs in one batch, every
+  // file is looked up once for all keys that may be in it
+  auto get_batched = [&] {
+    std::deque<LazyBuffer> lazy_vals;
+    std::deque<LookupKey> lkeys;
+    std::vector<MergeContext> merge_contexts(num_keys);
+    std::vector<SequenceNumber> max_covering_tombstone_seqs(num_keys, 0);
+    std::unordered_map<SuperVersion*, std::vector<Version::MultiGetKey>>
+        sst_keys;
+    for (size_t i = 0; i < num_keys; ++i) {
+      lazy_vals.emplace_back(&(*values)[i]);
+      lkeys.emplace_back(keys[i], snapshot);
+      auto super_version = get_super_version(i);
+      if (!get_from_memtable(i, super_version, lkeys.back(), &lazy_vals.back(),
+                             &merge_contexts[i],
+                             &max_covering_tombstone_seqs[i])) {
+        sst_keys[super_version].emplace_back(Version::MultiGetKey{
+            keys[i], &lkeys.back(), &lazy_vals.back(), &stat_list[i],
+            &merge_contexts[i], &max_covering_tombstone_seqs[i]});
+        RecordTick(stats_, MEMTABLE_MISS);
+      }
+    }
+    for (auto& pair : sst_keys) {
+      PERF_TIMER_GUARD(get_from_output_files_time);
+      pair.first->current->MultiGet(read_options, pair.second.size(),
+                                    pair.second.data());
+    }
+    for (size_t i = 0; i < num_keys; ++i) {
+      finish_one(i, &lazy_vals[i]);
+    }
+  };
 #ifdef BOOSTLIB
+  auto get_one = [&](size_t i) {
+    // Contain a list of merge operations if merge occurs.
+    MergeContext merge_context;
+    LazyBuffer lazy_val(&(*values)[i]);
+    LookupKey lkey(keys[i], snapshot);
+    SequenceNumber max_covering_tombstone_seq = 0;
+    auto super_version = get_super_version(i);
+    if (!get_from_memtable(i, super_version, lkey, &lazy_val, &merge_context,
+                           &max_covering_tombstone_seq)) {
+      PERF_TIMER_GUARD(get_from_output_files_time);
+      super_version->current->Get(read_options, keys[i], lkey, &lazy_val,
+                                  &stat_list[i], &merge_context,
+                                  &max_covering_tombstone_seq);
+      RecordTick(stats_, MEMTABLE_MISS);
+    }
+    finish_one(i, &lazy_val);
+  };
   if (read_options.aio_concurrency && immutable_db_options_.use_aio_reads) {
 #if 0
     static thread_local terark::RunOnceFiberPool fiber_pool(16);
@@ -1760,9 +1801,7 @@ std::vector<Status> DBImpl::MultiGet(
 #endif
   } else {
 #endif
-    for (size_t i = 0; i < num_keys; ++i) {
-      get_one(i);
-    }
+    get_batched();
 #ifdef BOOSTLIB
   }
 #endif
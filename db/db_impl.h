@@ -1075,6 +1075,15 @@ class DBImpl : public DB {
   // Used by WriteImpl to update bg_error_ in case of memtable insert error.
   void MemTableInsertStatusCheck(const Status& memtable_insert_status);
 
+  // Splits the batches of a parallel memtable write group into ranges if
+  // some batch has more than memtable_insert_split_size keys. Sequence
+  // numbers of the writers must be assigned.
+  void SplitWriteGroup(WriteThread::WriteGroup* write_group);
+
+  // Inserts the ranges of a split write group as a parallel memtable
+  // writer, until all are claimed.
+  void InsertWriteGroupRanges(WriteThread::Writer* w);
+
 #ifndef ROCKSDB_LITE
 
   Status CompactFilesImpl(const CompactionOptions& compact_options,
@@ -3021,7 +3021,10 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
         &event_logger_, c->mutable_cf_options()->paranoid_file_checks,
         c->mutable_cf_options()->report_bg_io_stats, dbname_,
         &garbage_collection_job_stats);
-    garbage_collection_job.Prepare(0 /* sub_compaction_slots */);
+    int sub_compaction_scheduled = garbage_collection_job.Prepare(
+        GetSubCompactionSlots(c->max_subcompactions()));
+    bg_compaction_scheduled_ += sub_compaction_scheduled;
+
     NotifyOnCompactionBegin(c->column_family_data(), c.get(), status,
                             garbage_collection_job_stats, job_context->job_id);
 
@@ -3029,6 +3032,7 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
     garbage_collection_job.Run();
     TEST_SYNC_POINT("DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun");
     mutex_.Lock();
+    bg_compaction_scheduled_ -= sub_compaction_scheduled;
     status = garbage_collection_job.Install(*c->mutable_cf_options());
     if (status.ok()) {
       InstallSuperVersionAndScheduleWork(
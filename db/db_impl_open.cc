@@ -13,12 +13,19 @@
 #endif
 #include <inttypes.h>
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
 #include "db/builder.h"
 #include "db/error_handler.h"
+#include "db/flush_scheduler.h"
 #include "db/map_builder.h"
 #include "options/options_helper.h"
 #include "rocksdb/wal_filter.h"
 #include "table/block_based_table_factory.h"
+#include "util/autovector.h"
 #include "util/c_style_callback.h"
 #include "util/rate_limiter.h"
 #include "util/sst_file_manager_impl.h"
@@ -59,7 +66,8 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
 
   if (!result.write_buffer_manager) {
     result.write_buffer_manager.reset(
-        new WriteBufferManager(result.db_write_buffer_size));
+        new WriteBufferManager(result.db_write_buffer_size, {} /* cache */,
+                               result.memory_arbiter));
   }
   auto bg_job_limits = DBImpl::GetBGJobLimits(
       result.max_background_flushes, result.max_background_compactions,
@@ -109,6 +117,17 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
         std::max(result.prepare_log_writer_num, result.recycle_log_file_num);
   }
 
+  // The compression type record of a recycled log is in the legacy format,
+  // readers could not tell the junk at its end from a corruption.
+  if (result.wal_compression != kNoCompression &&
+      (result.recycle_log_file_num ||
+       !StreamingCompressionTypeSupported(result.wal_compression))) {
+    ROCKS_LOG_WARN(result.info_log,
+                   "WAL compression %s is not supported, disabled",
+                   CompressionTypeToString(result.wal_compression).c_str());
+    result.wal_compression = kNoCompression;
+  }
+
   if (result.wal_dir.empty()) {
     // Use dbname as default
     result.wal_dir = dbname;
@@ -537,6 +556,287 @@ Status DBImpl::Recover(
   return s;
 }
 
+namespace {
+
+// Inserts the recovered WAL batches into the memtables on a few threads.
+// Every column family is owned by one thread, and a batch is queued to the
+// threads owning its column families, so the updates of each column family
+// still reach its memtable in log order. A thread skips the entries of the
+// column families it doesn't own, the sequence numbers advance the same way
+// as in the sequential insert.
+class RecoveryMemTableInserter {
+ public:
+  RecoveryMemTableInserter(DB* db, ColumnFamilySet* column_family_set,
+                           size_t num_threads, bool batch_per_txn);
+
+  // Stops the threads, batches not inserted yet are dropped
+  ~RecoveryMemTableInserter();
+
+  // Queues the batch for insert. Returns false, without queueing it, if the
+  // batch is malformed or carries transaction markers, the caller then
+  // inserts it itself after Wait().
+  // REQUIRES: the sequence number of the batch is set
+  bool Add(const WriteBatch& batch, uint64_t log_number);
+
+  // Returns true if a memtable asked for a flush or an insert failed since
+  // the last Wait()
+  bool NeedsWait();
+
+  // Blocks until the queued batches are inserted, then moves the column
+  // families scheduled for flush to *flush_scheduler. Returns the first
+  // insert error since the last Wait(), the inserts of the other column
+  // families queued after the failed batch may already be applied.
+  Status Wait(FlushScheduler* flush_scheduler);
+
+ private:
+  // Collects the column families of a batch and checks that it can be split
+  // by column family
+  class Inspector : public WriteBatch::Handler {
+   public:
+    autovector<uint32_t> column_families;
+    bool has_markers = false;
+
+    virtual Status PutCF(uint32_t column_family_id, const Slice& /*key*/,
+                         const Slice& /*value*/) override {
+      return Add(column_family_id);
+    }
+    virtual Status DeleteCF(uint32_t column_family_id,
+                            const Slice& /*key*/) override {
+      return Add(column_family_id);
+    }
+    virtual Status SingleDeleteCF(uint32_t column_family_id,
+                                  const Slice& /*key*/) override {
+      return Add(column_family_id);
+    }
+    virtual Status DeleteRangeCF(uint32_t column_family_id,
+                                 const Slice& /*begin_key*/,
+                                 const Slice& /*end_key*/) override {
+      return Add(column_family_id);
+    }
+    virtual Status MergeCF(uint32_t column_family_id, const Slice& /*key*/,
+                           const Slice& /*value*/) override {
+      return Add(column_family_id);
+    }
+    virtual Status MarkBeginPrepare(bool = false) override { return Marker(); }
+    virtual Status MarkEndPrepare(const Slice& /*xid*/) override {
+      return Marker();
+    }
+    virtual Status MarkNoop(bool /*empty_batch*/) override { return Marker(); }
+    virtual Status MarkRollback(const Slice& /*xid*/) override {
+      return Marker();
+    }
+    virtual Status MarkCommit(const Slice& /*xid*/) override {
+      return Marker();
+    }
+
+   private:
+    Status Add(uint32_t column_family_id) {
+      if (std::find(column_families.begin(), column_families.end(),
+                    column_family_id) == column_families.end()) {
+        column_families.push_back(column_family_id);
+      }
+      return Status::OK();
+    }
+    Status Marker() {
+      has_markers = true;
+      return Status::OK();
+    }
+  };
+
+  // The memtables of the column families owned by one thread, Seek() fails
+  // for the others so their entries are skipped
+  class OwnedMemTables : public ColumnFamilyMemTables {
+   public:
+    OwnedMemTables(RecoveryMemTableInserter* inserter,
+                   ColumnFamilySet* column_family_set, size_t index)
+        : inserter_(inserter), impl_(column_family_set), index_(index) {}
+
+    virtual bool Seek(uint32_t column_family_id) override {
+      return inserter_->Owner(column_family_id) == index_ &&
+             impl_.Seek(column_family_id);
+    }
+    virtual uint64_t GetLogNumber() const override {
+      return impl_.GetLogNumber();
+    }
+    virtual MemTable* GetMemTable() const override {
+      return impl_.GetMemTable();
+    }
+    virtual ColumnFamilyHandle* GetColumnFamilyHandle() override {
+      return impl_.GetColumnFamilyHandle();
+    }
+    virtual ColumnFamilyData* current() override { return impl_.current(); }
+
+   private:
+    RecoveryMemTableInserter* inserter_;
+    ColumnFamilyMemTablesImpl impl_;
+    size_t index_;
+  };
+
+  struct Job {
+    std::shared_ptr<WriteBatch> batch;
+    uint64_t log_number;
+  };
+
+  struct Worker {
+    Worker(RecoveryMemTableInserter* inserter,
+           ColumnFamilySet* column_family_set, size_t index)
+        : memtables(inserter, column_family_set, index) {}
+
+    OwnedMemTables memtables;
+    // Only used by the thread of the worker until Wait() drains it
+    FlushScheduler flush_scheduler;
+    std::deque<Job> queue;
+    port::Thread thread;
+  };
+
+  // Bounds the batches queued and not inserted yet
+  static const size_t kMaxQueuedBytes = 64 << 20;
+
+  size_t Owner(uint32_t column_family_id) const {
+    auto iter = owners_.find(column_family_id);
+    return iter == owners_.end() ? 0 : iter->second;
+  }
+
+  void BackgroundInsert(Worker* worker);
+
+  DB* const db_;
+  const bool batch_per_txn_;
+  std::unordered_map<uint32_t, size_t> owners_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  port::Mutex mutex_;
+  port::CondVar cv_;
+  size_t queued_bytes_;
+  size_t pending_jobs_;
+  bool flush_scheduled_;
+  bool stop_;
+  Status status_;
+
+  // No copying allowed
+  RecoveryMemTableInserter(const RecoveryMemTableInserter&);
+  void operator=(const RecoveryMemTableInserter&);
+};
+
+RecoveryMemTableInserter::RecoveryMemTableInserter(
+    DB* db, ColumnFamilySet* column_family_set, size_t num_threads,
+    bool batch_per_txn)
+    : db_(db),
+      batch_per_txn_(batch_per_txn),
+      cv_(&mutex_),
+      queued_bytes_(0),
+      pending_jobs_(0),
+      flush_scheduled_(false),
+      stop_(false) {
+  assert(num_threads > 0);
+  // Hand the column families out round robin, so sparse ids still spread
+  for (auto cfd : *column_family_set) {
+    owners_.emplace(cfd->GetID(), owners_.size() % num_threads);
+  }
+  num_threads = std::max<size_t>(1, std::min(num_threads, owners_.size()));
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(new Worker(this, column_family_set, i));
+  }
+  for (auto& worker : workers_) {
+    Worker* w = worker.get();
+    w->thread = port::Thread([this, w] { BackgroundInsert(w); });
+  }
+}
+
+RecoveryMemTableInserter::~RecoveryMemTableInserter() {
+  {
+    MutexLock l(&mutex_);
+    stop_ = true;
+    cv_.SignalAll();
+  }
+  for (auto& worker : workers_) {
+    worker->thread.join();
+    worker->flush_scheduler.Clear();
+  }
+}
+
+bool RecoveryMemTableInserter::Add(const WriteBatch& batch,
+                                   uint64_t log_number) {
+  Inspector inspector;
+  if (!batch.Iterate(&inspector).ok() || inspector.has_markers) {
+    return false;
+  }
+  auto shared = std::make_shared<WriteBatch>(batch.Data());
+  size_t size = batch.GetDataSize();
+  MutexLock l(&mutex_);
+  while (pending_jobs_ > 0 && queued_bytes_ >= kMaxQueuedBytes) {
+    cv_.Wait();
+  }
+  autovector<size_t> targets;
+  for (auto column_family_id : inspector.column_families) {
+    size_t owner = Owner(column_family_id);
+    if (std::find(targets.begin(), targets.end(), owner) == targets.end()) {
+      targets.push_back(owner);
+      workers_[owner]->queue.push_back(Job{shared, log_number});
+      queued_bytes_ += size;
+      ++pending_jobs_;
+    }
+  }
+  cv_.SignalAll();
+  return true;
+}
+
+bool RecoveryMemTableInserter::NeedsWait() {
+  MutexLock l(&mutex_);
+  return flush_scheduled_ || !status_.ok();
+}
+
+Status RecoveryMemTableInserter::Wait(FlushScheduler* flush_scheduler) {
+  MutexLock l(&mutex_);
+  while (pending_jobs_ > 0) {
+    cv_.Wait();
+  }
+  for (auto& worker : workers_) {
+    ColumnFamilyData* cfd;
+    while ((cfd = worker->flush_scheduler.TakeNextColumnFamily()) != nullptr) {
+      flush_scheduler->ScheduleFlush(cfd);
+      cfd->Unref();
+    }
+  }
+  flush_scheduled_ = false;
+  Status s = status_;
+  status_ = Status::OK();
+  return s;
+}
+
+void RecoveryMemTableInserter::BackgroundInsert(Worker* worker) {
+  MutexLock l(&mutex_);
+  while (true) {
+    while (!stop_ && worker->queue.empty()) {
+      cv_.Wait();
+    }
+    if (stop_) {
+      return;
+    }
+    Job job = std::move(worker->queue.front());
+    worker->queue.pop_front();
+    mutex_.Unlock();
+    Status s = WriteBatchInternal::InsertInto(
+        job.batch.get(), &worker->memtables, &worker->flush_scheduler,
+        true /* ignore_missing_column_families */, job.log_number, db_,
+        false /* concurrent_memtable_writes */, nullptr /* next_seq */,
+        nullptr /* has_valid_writes */, false /* seq_per_batch */,
+        batch_per_txn_);
+    bool flush_scheduled = !worker->flush_scheduler.Empty();
+    size_t size = job.batch->GetDataSize();
+    job.batch.reset();
+    mutex_.Lock();
+    if (!s.ok() && status_.ok()) {
+      status_ = s;
+    }
+    flush_scheduled_ |= flush_scheduled;
+    queued_bytes_ -= size;
+    --pending_jobs_;
+    cv_.SignalAll();
+  }
+}
+
+}  // namespace
+
 // REQUIRES: log_numbers are sorted in ascending order
 Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
                                SequenceNumber* next_sequence, bool read_only) {
@@ -592,6 +892,17 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
   }
 #endif
 
+  // With wal_recovery_insert_threads the batches are inserted on background
+  // threads, one per group of column families. The WAL filter and the
+  // corruption and point in time decisions stay on this thread.
+  std::unique_ptr<RecoveryMemTableInserter> parallel_inserter;
+  if (immutable_db_options_.wal_recovery_insert_threads > 0 &&
+      !seq_per_batch_ && !immutable_db_options_.allow_2pc) {
+    parallel_inserter.reset(new RecoveryMemTableInserter(
+        this, versions_->GetColumnFamilySet(),
+        immutable_db_options_.wal_recovery_insert_threads, batch_per_txn_));
+  }
+
   bool stop_replay_by_wal_filter = false;
   bool stop_replay_for_corruption = false;
   bool flushed = false;
@@ -661,9 +972,21 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     // paranoid_checks==false so that corruptions cause entire commits
     // to be skipped instead of propagating bad information (like overly
     // large sequence numbers).
-    log::Reader reader(immutable_db_options_.info_log, std::move(file_reader),
-                       &reporter, true /*checksum*/, log_number,
-                       false /* retry_after_eof */);
+    // With wal_recovery_readahead_size the records are read on a background
+    // thread, the inserts below stay in log order on this thread.
+    std::unique_ptr<log::Reader> reader;
+    std::unique_ptr<log::ReadAheadReader> readahead_reader;
+    if (immutable_db_options_.wal_recovery_readahead_size > 0) {
+      readahead_reader.reset(new log::ReadAheadReader(
+          immutable_db_options_.info_log, std::move(file_reader), &reporter,
+          true /*checksum*/, log_number,
+          immutable_db_options_.wal_recovery_mode,
+          immutable_db_options_.wal_recovery_readahead_size));
+    } else {
+      reader.reset(new log::Reader(
+          immutable_db_options_.info_log, std::move(file_reader), &reporter,
+          true /*checksum*/, log_number, false /* retry_after_eof */));
+    }
 
     // Determine if we should tolerate incomplete records at the tail end of the
     // Read all the records and add to a memtable
@@ -671,10 +994,39 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     Slice record;
     WriteBatch batch;
 
-    while (!stop_replay_by_wal_filter &&
-           reader.ReadRecord(&record, &scratch,
-                             immutable_db_options_.wal_recovery_mode) &&
-           status.ok()) {
+    // we can do this because this is called before client has access to the
+    // DB and there is only a single thread operating on DB
+    auto flush_scheduled_memtables = [&]() {
+      ColumnFamilyData* cfd;
+      while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
+        cfd->Unref();
+        // If this asserts, it means that InsertInto failed in
+        // filtering updates to already-flushed column families
+        assert(cfd->GetLogNumber() <= log_number);
+        auto iter = version_edits.find(cfd->GetID());
+        assert(iter != version_edits.end());
+        VersionEdit* edit = &iter->second;
+        Status s = WriteLevel0TableForRecovery(job_id, cfd, cfd->mem(), edit);
+        if (!s.ok()) {
+          return s;
+        }
+        flushed = true;
+
+        cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
+                               /* needs_dup_key_check */ false,
+                               *next_sequence);
+      }
+      return Status::OK();
+    };
+
+    auto read_record = [&]() {
+      if (readahead_reader != nullptr) {
+        return readahead_reader->ReadRecord(&record, &scratch);
+      }
+      return reader->ReadRecord(&record, &scratch,
+                                immutable_db_options_.wal_recovery_mode);
+    };
+    while (!stop_replay_by_wal_filter && read_record() && status.ok()) {
       if (record.size() < WriteBatchInternal::kHeader) {
         reporter.Corruption(record.size(),
                             Status::Corruption("log record too small"));
@@ -781,10 +1133,28 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
       // we just ignore the update.
       // That's why we set ignore missing column families to true
       bool has_valid_writes = false;
-      status = WriteBatchInternal::InsertInto(
-          &batch, column_family_memtables_.get(), &flush_scheduler_, true,
-          log_number, this, false /* concurrent_memtable_writes */,
-          next_sequence, &has_valid_writes, seq_per_batch_, batch_per_txn_);
+      bool queued = false;
+      if (parallel_inserter != nullptr) {
+        queued = parallel_inserter->Add(batch, log_number);
+        if (queued) {
+          *next_sequence = sequence + WriteBatchInternal::Count(&batch);
+          if (!parallel_inserter->NeedsWait()) {
+            continue;
+          }
+        }
+        // Flush requests and insert errors of the queued batches are
+        // handled here once they are all inserted, the batches which can't
+        // be split by column family are inserted below after them
+        has_valid_writes = true;
+        status = parallel_inserter->Wait(&flush_scheduler_);
+        MaybeIgnoreError(&status);
+      }
+      if (status.ok() && !queued) {
+        status = WriteBatchInternal::InsertInto(
+            &batch, column_family_memtables_.get(), &flush_scheduler_, true,
+            log_number, this, false /* concurrent_memtable_writes */,
+            next_sequence, &has_valid_writes, seq_per_batch_, batch_per_txn_);
+      }
       MaybeIgnoreError(&status);
       if (!status.ok()) {
         // We are treating this as a failure while reading since we read valid
@@ -794,29 +1164,25 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
       }
 
       if (has_valid_writes && !read_only) {
-        // we can do this because this is called before client has access to the
-        // DB and there is only a single thread operating on DB
-        ColumnFamilyData* cfd;
-
-        while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
-          cfd->Unref();
-          // If this asserts, it means that InsertInto failed in
-          // filtering updates to already-flushed column families
-          assert(cfd->GetLogNumber() <= log_number);
-          auto iter = version_edits.find(cfd->GetID());
-          assert(iter != version_edits.end());
-          VersionEdit* edit = &iter->second;
-          status = WriteLevel0TableForRecovery(job_id, cfd, cfd->mem(), edit);
-          if (!status.ok()) {
-            // Reflect errors immediately so that conditions like full
-            // file-systems cause the DB::Open() to fail.
-            return status;
-          }
-          flushed = true;
+        status = flush_scheduled_memtables();
+        if (!status.ok()) {
+          // Reflect errors immediately so that conditions like full
+          // file-systems cause the DB::Open() to fail.
+          return status;
+        }
+      }
+    }
 
-          cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
-                                 /* needs_dup_key_check */ false,
-                                 *next_sequence);
+    if (parallel_inserter != nullptr) {
+      Status s = parallel_inserter->Wait(&flush_scheduler_);
+      MaybeIgnoreError(&s);
+      if (!s.ok()) {
+        reporter.Corruption(0, s);
+      }
+      if (!read_only) {
+        s = flush_scheduled_memtables();
+        if (!s.ok()) {
+          return s;
         }
       }
     }
@@ -1248,7 +1614,8 @@ Status DBImpl::Open(const DBOptions& db_options, const std::string& dbname,
             new log::Writer(
                 std::move(file_writer), new_log_number,
                 impl->immutable_db_options_.recycle_log_file_num > 0,
-                impl->immutable_db_options_.manual_wal_flush));
+                impl->immutable_db_options_.manual_wal_flush,
+                impl->immutable_db_options_.wal_compression));
       }
 
       // set column family handles
@@ -1278,6 +1645,11 @@ Status DBImpl::Open(const DBOptions& db_options, const std::string& dbname,
         }
       }
     }
+    if (s.ok()) {
+      // Nothing wrote to the new log yet, the type record goes first
+      InstrumentedMutexLock wl(&impl->log_write_mutex_);
+      s = impl->logs_.back().writer->AddCompressionTypeRecord();
+    }
     if (s.ok()) {
       SuperVersionContext sv_context(/* create_superversion */ true);
       for (auto cfd : *impl->versions_->GetColumnFamilySet()) {
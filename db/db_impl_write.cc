@@ -136,7 +136,14 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   if (w.state == WriteThread::STATE_PARALLEL_MEMTABLE_WRITER) {
     // we are a non-leader in a parallel group
 
-    if (w.ShouldWriteToMemtable()) {
+    if (!w.write_group->ranges.empty()) {
+      PERF_TIMER_STOP(write_pre_and_post_process_time);
+      PERF_TIMER_GUARD(write_memtable_time);
+
+      InsertWriteGroupRanges(&w);
+
+      PERF_TIMER_START(write_pre_and_post_process_time);
+    } else if (w.ShouldWriteToMemtable()) {
       PERF_TIMER_STOP(write_pre_and_post_process_time);
       PERF_TIMER_GUARD(write_memtable_time);
 
@@ -344,12 +351,15 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
           }
         }
         write_group.last_sequence = last_sequence;
+        SplitWriteGroup(&write_group);
         write_thread_.LaunchParallelMemTableWriters(&write_group);
         in_parallel_group = true;
 
         // Each parallel follower is doing each own writes. The leader should
         // also do its own.
-        if (w.ShouldWriteToMemtable()) {
+        if (!write_group.ranges.empty()) {
+          InsertWriteGroupRanges(&w);
+        } else if (w.ShouldWriteToMemtable()) {
           ColumnFamilyMemTablesImpl column_family_memtables(
               versions_->GetColumnFamilySet());
           assert(w.sequence == current_sequence);
@@ -514,6 +524,7 @@ Status DBImpl::PipelinedWriteImpl(const WriteOptions& write_options,
     write_thread_.EnterAsMemTableWriter(&w, &memtable_write_group);
     if (memtable_write_group.size > 1 &&
         immutable_db_options_.allow_concurrent_memtable_write) {
+      SplitWriteGroup(&memtable_write_group);
       write_thread_.LaunchParallelMemTableWriters(&memtable_write_group);
     } else {
       memtable_write_group.status = WriteBatchInternal::InsertInto(
@@ -528,12 +539,16 @@ Status DBImpl::PipelinedWriteImpl(const WriteOptions& write_options,
 
   if (w.state == WriteThread::STATE_PARALLEL_MEMTABLE_WRITER) {
     assert(w.ShouldWriteToMemtable());
-    ColumnFamilyMemTablesImpl column_family_memtables(
-        versions_->GetColumnFamilySet());
-    w.status = WriteBatchInternal::InsertInto(
-        &w, w.sequence, &column_family_memtables, &flush_scheduler_,
-        write_options.ignore_missing_column_families, 0 /*log_number*/, this,
-        true /*concurrent_memtable_writes*/);
+    if (!w.write_group->ranges.empty()) {
+      InsertWriteGroupRanges(&w);
+    } else {
+      ColumnFamilyMemTablesImpl column_family_memtables(
+          versions_->GetColumnFamilySet());
+      w.status = WriteBatchInternal::InsertInto(
+          &w, w.sequence, &column_family_memtables, &flush_scheduler_,
+          write_options.ignore_missing_column_families, 0 /*log_number*/, this,
+          true /*concurrent_memtable_writes*/);
+    }
     if (write_thread_.CompleteParallelMemTableWriter(&w)) {
       MemTableInsertStatusCheck(w.status);
       versions_->SetLastSequence(w.write_group->last_sequence);
@@ -707,6 +722,67 @@ void DBImpl::MemTableInsertStatusCheck(const Status& status) {
   }
 }
 
+void DBImpl::SplitWriteGroup(WriteThread::WriteGroup* write_group) {
+  assert(write_group->ranges.empty());
+  const size_t split_size = immutable_db_options_.memtable_insert_split_size;
+  if (split_size == 0 || seq_per_batch_) {
+    return;
+  }
+  bool has_large_batch = false;
+  for (auto* writer : *write_group) {
+    if (!writer->CallbackFailed() && writer->ShouldWriteToMemtable() &&
+        size_t(WriteBatchInternal::Count(writer->batch)) > split_size) {
+      has_large_batch = true;
+      break;
+    }
+  }
+  if (!has_large_batch) {
+    return;
+  }
+  // Every batch of the group becomes one range or more, so that the writers
+  // of small batches help with the large ones once done
+  std::vector<size_t> offsets;
+  for (auto* writer : *write_group) {
+    if (writer->CallbackFailed() || !writer->ShouldWriteToMemtable()) {
+      continue;
+    }
+    WriteBatch* batch = writer->batch;
+    WriteBatchInternal::SetSequence(batch, writer->sequence);
+    offsets.clear();
+    if (size_t(WriteBatchInternal::Count(batch)) > split_size &&
+        WriteBatchInternal::Split(batch, split_size, &offsets)) {
+      for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+        write_group->ranges.push_back({writer, offsets[i], offsets[i + 1],
+                                       writer->sequence + i * split_size,
+                                       Status()});
+      }
+    } else {
+      write_group->ranges.push_back({writer, WriteBatchInternal::kHeader,
+                                     WriteBatchInternal::ByteSize(batch),
+                                     writer->sequence, Status()});
+    }
+  }
+  write_group->next_range.store(0, std::memory_order_relaxed);
+  TEST_SYNC_POINT_CALLBACK("DBImpl::SplitWriteGroup:Ranges", write_group);
+}
+
+void DBImpl::InsertWriteGroupRanges(WriteThread::Writer* w) {
+  auto* write_group = w->write_group;
+  assert(!write_group->ranges.empty());
+  ColumnFamilyMemTablesImpl column_family_memtables(
+      versions_->GetColumnFamilySet());
+  for (size_t i = write_group->next_range.fetch_add(1);
+       i < write_group->ranges.size();
+       i = write_group->next_range.fetch_add(1)) {
+    auto& range = write_group->ranges[i];
+    range.status = WriteBatchInternal::InsertInto(
+        range.writer, range.begin, range.end, range.sequence,
+        &column_family_memtables, &flush_scheduler_, this);
+    TEST_SYNC_POINT_CALLBACK("DBImpl::InsertWriteGroupRanges:Status",
+                             &range);
+  }
+}
+
 Status DBImpl::PreprocessWrite(const WriteOptions& write_options,
                                bool* need_log_sync,
                                WriteContext* write_context) {
@@ -1434,7 +1510,14 @@ Status DBImpl::NewLogWriter(std::unique_ptr<log::Writer>* new_log,
         immutable_db_options_.listeners));
     new_log->reset(new log::Writer(
         std::move(file_writer), new_log_number,
-        immutable_db_options_.recycle_log_file_num > 0, manual_wal_flush_));
+        immutable_db_options_.recycle_log_file_num > 0, manual_wal_flush_,
+        immutable_db_options_.wal_compression));
+    // Prepared writers of log_writer_pool_ have their compression context
+    // and record ready as well
+    s = (*new_log)->AddCompressionTypeRecord();
+    if (!s.ok()) {
+      new_log->reset();
+    }
   }
   return s;
 }
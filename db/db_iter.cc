@@ -23,6 +23,7 @@
 #include "rocksdb/iterator.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/options.h"
+#include "rocksdb/value_extractor.h"
 #include "table/internal_iterator.h"
 #include "util/arena.h"
 #include "util/filename.h"
@@ -138,8 +139,17 @@ class DBIter final : public Iterator {
         read_callback_(read_callback),
         db_impl_(db_impl),
         cfd_(cfd),
-        start_seqnum_(read_options.iter_start_seqnum) {
+        start_seqnum_(read_options.iter_start_seqnum),
+        read_options_(read_options) {
     RecordTick(statistics_, NO_ITERATOR_CREATED);
+    ResetSequentialHelper();
+    if (read_options.value_meta_only &&
+        cf_options.value_meta_extractor_factory != nullptr) {
+      ValueExtractorContext context = {cfd == nullptr ? 0 : cfd->GetID()};
+      value_meta_extractor_ =
+          cf_options.value_meta_extractor_factory->CreateValueExtractor(
+              context);
+    }
     prefix_extractor_ = mutable_cf_options.prefix_extractor.get();
     max_skip_ = max_sequential_skip_in_iterations;
     max_skippable_internal_keys_ = read_options.max_skippable_internal_keys;
@@ -149,6 +159,8 @@ class DBIter final : public Iterator {
     RecordTick(statistics_, NO_ITERATOR_DELETED);
     ResetValueAndCounter();
     merge_context_.Clear();
+    value_source_.reset();
+    sequential_helper_.reset();
     local_stats_.BumpGlobalStatistics(statistics_);
     if (!arena_mode_) {
       delete iter_;
@@ -165,8 +177,10 @@ class DBIter final : public Iterator {
                    old_sv->current == self->separate_helper_);
             (void)old_sv;
             self->PinLazyBuffer();
+            self->value_source_.pin(LazyBufferPinLevel::DB);
             self->separate_helper_ =
                 new_sv == nullptr ? nullptr : new_sv->current;
+            self->ResetSequentialHelper();
           },
           this);
     }
@@ -177,6 +191,7 @@ class DBIter final : public Iterator {
     assert(iter_ == nullptr);
     iter_ = iter;
     separate_helper_ = separate_helper;
+    ResetSequentialHelper();
     SetSVDestructCallback(sv_destruct_callback);
   }
   virtual ReadRangeDelAggregator* GetRangeDelAggregator() {
@@ -222,6 +237,25 @@ class DBIter final : public Iterator {
     } else if (prop_name == "rocksdb.iterator.internal-key") {
       *prop = saved_key_.GetUserKey().ToString();
       return Status::OK();
+    } else if (prop_name == "rocksdb.iterator.value" &&
+               read_options_.value_meta_only) {
+      if (!valid_) {
+        return Status::InvalidArgument("Iterator is not valid.");
+      }
+      LazyBuffer value;
+      if (current_entry_is_merged_) {
+        value.reset(this->value());
+      } else if (value_source_type_ == kTypeValueIndex) {
+        value = separate_helper_->TransToCombined(
+            saved_key_.GetUserKey(), value_source_seq_, value_source_);
+      } else {
+        value.reset(value_source_.slice());
+      }
+      auto s = value.fetch();
+      if (s.ok()) {
+        prop->assign(value.data(), value.size());
+      }
+      return s;
     }
     return Status::InvalidArgument("Unidentified property.");
   }
@@ -254,11 +288,51 @@ class DBIter final : public Iterator {
   LazyBuffer GetValue(const ParsedInternalKey& ikey, ValueType index_type) {
     if (separate_helper_ == nullptr || ikey.type != index_type) {
       return iter_->value();
+    } else if (sequential_helper_ != nullptr) {
+      return sequential_helper_->TransToCombined(
+          saved_key_.GetUserKey(), ikey.sequence, iter_->value());
     } else {
       return separate_helper_->TransToCombined(saved_key_.GetUserKey(),
                                                ikey.sequence, iter_->value());
     }
   }
+  // Value of a visible kTypeValue / kTypeValueIndex entry, the value meta if
+  // read_options_.value_meta_only
+  LazyBuffer GetOutputValue(const ParsedInternalKey& ikey) {
+    if (!read_options_.value_meta_only) {
+      return GetValue(ikey, kTypeValueIndex);
+    }
+    // Keep the source for property "rocksdb.iterator.value"
+    value_source_ = iter_->value();
+    value_source_.pin(LazyBufferPinLevel::Internal);
+    value_source_type_ = ikey.type;
+    value_source_seq_ = ikey.sequence;
+    auto s = value_source_.fetch();
+    if (!s.ok()) {
+      return LazyBuffer(std::move(s));
+    }
+    if (ikey.type == kTypeValueIndex) {
+      return LazyBuffer(SeparateHelper::DecodeValueMeta(value_source_.slice()),
+                        true);
+    }
+    std::string meta;
+    if (value_meta_extractor_ != nullptr) {
+      s = value_meta_extractor_->Extract(ikey.user_key, value_source_.slice(),
+                                         &meta);
+      if (!s.ok()) {
+        return LazyBuffer(std::move(s));
+      }
+    }
+    return LazyBuffer(meta, true);
+  }
+  // Values combined by the old sequential helper must be pinned before
+  // calling this
+  void ResetSequentialHelper() {
+    sequential_helper_.reset();
+    if (separate_helper_ != nullptr && read_options_.blob_readahead_files > 0) {
+      sequential_helper_ = separate_helper_->NewSequentialHelper(read_options_);
+    }
+  }
 
   void PrevInternal();
   bool TooManyInternalKeysSkipped(bool increment = true);
@@ -330,6 +404,14 @@ class DBIter final : public Iterator {
   // for diff snapshots we want the lower bound on the seqnum;
   // if this value > 0 iterator will return internal keys
   SequenceNumber start_seqnum_;
+  const ReadOptions read_options_;
+  // Reads separated values when read_options_.blob_readahead_files is set
+  std::unique_ptr<SeparateHelper> sequential_helper_;
+  // For read_options_.value_meta_only, the stored value of the current entry
+  LazyBuffer value_source_;
+  ValueType value_source_type_ = kTypeValue;
+  SequenceNumber value_source_seq_ = 0;
+  std::unique_ptr<ValueExtractor> value_meta_extractor_;
 
   // No copying allowed
   DBIter(const DBIter&);
@@ -486,7 +568,7 @@ bool DBIter::FindNextUserEntryInternal(bool skipping, bool prefix_check) {
             if (start_seqnum_ > 0) {
               if (ikey_.sequence >= start_seqnum_) {
                 saved_key_.SetInternalKey(ikey_);
-                value_ = GetValue(ikey_, kTypeValueIndex);
+                value_ = GetOutputValue(ikey_);
                 valid_ = true;
                 return true;
               } else {
@@ -505,7 +587,7 @@ bool DBIter::FindNextUserEntryInternal(bool skipping, bool prefix_check) {
                 num_skipped = 0;
                 PERF_COUNTER_ADD(internal_delete_skipped_count, 1);
               } else {
-                value_ = GetValue(ikey_, kTypeValueIndex);
+                value_ = GetOutputValue(ikey_);
                 valid_ = true;
                 return true;
               }
@@ -875,7 +957,7 @@ bool DBIter::FindValueForCurrentKey() {
           last_key_entry_type = kTypeRangeDeletion;
           PERF_COUNTER_ADD(internal_delete_skipped_count, 1);
         } else {
-          value_ = GetValue(ikey, kTypeValueIndex);
+          value_ = GetOutputValue(ikey);
           value_.pin(LazyBufferPinLevel::Internal);
         }
         merge_context_.Clear();
@@ -1007,7 +1089,7 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
     return true;
   }
   if (ikey.type == kTypeValue || ikey.type == kTypeValueIndex) {
-    value_ = GetValue(ikey, kTypeValueIndex);
+    value_ = GetOutputValue(ikey);
     value_.pin(LazyBufferPinLevel::Internal);
     valid_ = true;
     return true;
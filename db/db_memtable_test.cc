@@ -312,6 +312,69 @@ TEST(PatriciaMemTableTest, Normal) {
 
   delete mem;
 }
+
+TEST(PatriciaMemTableTest, ApproximateStatsAndReverse) {
+  Options options;
+  InternalKeyComparator cmp(BytewiseComparator());
+  // Small tries, so the keys spread over several of them
+  options.memtable_factory = std::make_shared<PatriciaTrieRepFactory>(
+      options.memtable_factory, terark_memtable_details::ConcurrentType::Native,
+      terark_memtable_details::PatriciaKeyType::UserKey, 16 << 10);
+  ImmutableCFOptions ioptions(options);
+  WriteBufferManager wb(options.db_write_buffer_size);
+  MemTable* mem = new MemTable(cmp, ioptions, MutableCFOptions(options), true,
+                               &wb, kMaxSequenceNumber, 0);
+  int new_tries = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "PatriciaTrieRep::InsertKeyValue:NewTrie",
+      [&](void* /*arg*/) { ++new_tries; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  // Strided, so every trie spans the whole key range
+  for (int i = 0; i < 1000; ++i) {
+    char key[16];
+    snprintf(key, sizeof key, "key%06d", i * 7 % 1000);
+    ASSERT_TRUE(mem->Add(i + 1, kTypeValue, key, std::string(100, 'v')));
+  }
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_GT(new_tries, 1);
+  auto count = [&](const char* start, const char* end) {
+    InternalKey start_ikey(start, kMaxSequenceNumber, kValueTypeForSeek);
+    InternalKey end_ikey(end, kMaxSequenceNumber, kValueTypeForSeek);
+    return mem->ApproximateStats(start_ikey.Encode(), end_ikey.Encode()).count;
+  };
+  // Small ranges are counted exactly
+  ASSERT_EQ(10, count("key000100", "key000110"));
+  ASSERT_EQ(0, count("key000110", "key000100"));
+  // Large ranges are interpolated
+  uint64_t half = count("key000000", "key000500");
+  ASSERT_GT(half, 250);
+  ASSERT_LT(half, 750);
+
+  mem->MarkImmutable();
+  Arena arena;
+  ScopedArenaIterator iter(mem->NewIterator(ReadOptions(), &arena));
+  iter->Seek(InternalKey("key000500", kMaxSequenceNumber, kValueTypeForSeek)
+                 .Encode());
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ("key000500", ExtractUserKey(iter->key()).ToString());
+  iter->Prev();
+  ASSERT_EQ("key000499", ExtractUserKey(iter->key()).ToString());
+  iter->Next();
+  ASSERT_EQ("key000500", ExtractUserKey(iter->key()).ToString());
+  iter->Next();
+  ASSERT_EQ("key000501", ExtractUserKey(iter->key()).ToString());
+
+  int num_keys = 0;
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+    char key[16];
+    snprintf(key, sizeof key, "key%06d", 999 - num_keys++);
+    ASSERT_EQ(key, ExtractUserKey(iter->key()).ToString());
+  }
+  ASSERT_EQ(1000, num_keys);
+  iter.set(nullptr);
+  delete mem;
+}
 #endif
 
 }  // namespace rocksdb
@@ -16,6 +16,7 @@
 #include "port/stack_trace.h"
 #include "rocksdb/persistent_cache.h"
 #include "rocksdb/wal_filter.h"
+#include "table/merging_iterator.h"
 
 namespace rocksdb {
 
@@ -3089,6 +3090,377 @@ TEST_F(DBTest2, TestCompactFiles) {
 }
 #endif  // ROCKSDB_LITE
 
+TEST_F(DBTest2, SortedKeyGetter) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(Key(i), "v1_" + Key(i)));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(2);
+  for (int i = 0; i < 100; i += 3) {
+    ASSERT_OK(Put(Key(i), "v2_" + Key(i)));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(1);
+  for (int i = 0; i < 100; i += 5) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  ASSERT_OK(Flush());
+
+  auto* cfd =
+      reinterpret_cast<ColumnFamilyHandleImpl*>(db_->DefaultColumnFamily())
+          ->cfd();
+  dbfull()->TEST_LockMutex();
+  Version* v = cfd->current();
+  v->Ref();
+  dbfull()->TEST_UnlockMutex();
+
+  EnvOptions env_options;
+  SortedKeyGetter getter(v, env_options, 2 /* max_sequential_skip */);
+  // Same scan over an iterator supplied by the caller, as compaction workers
+  // build it from their own LSM view
+  int num_create_iter = 0;
+  SortedKeyGetter view_getter(
+      cfd->internal_comparator(),
+      [&](Arena* arena) {
+        ++num_create_iter;
+        ReadOptions read_options;
+        read_options.total_order_seek = true;
+        MergeIteratorBuilder builder(&cfd->internal_comparator(), arena);
+        for (int level = 0; level < v->storage_info()->num_non_empty_levels();
+             ++level) {
+          v->AddIteratorsForLevel(read_options, env_options, &builder, level,
+                                  nullptr /* range_del_agg */);
+        }
+        return builder.Finish();
+      },
+      2 /* max_sequential_skip */);
+  // Ascending keys with gaps, then a step back
+  std::vector<int> order;
+  for (int i = 0; i < 110; i += (i % 7 == 0 ? 4 : 1)) {
+    order.push_back(i);
+  }
+  order.push_back(50);
+  order.push_back(51);
+  for (int i : order) {
+    std::string user_key = Key(i);
+    InternalKey ikey(user_key, kMaxSequenceNumber, kValueTypeForSeek);
+
+    Status expect_s, s;
+    ValueType expect_type = kTypeDeletion, type = kTypeDeletion;
+    SequenceNumber expect_seq = 0, seq = 0;
+    LazyBuffer expect_value, value;
+    v->GetKey(user_key, ikey.Encode(), &expect_s, &expect_type, &expect_seq,
+              &expect_value);
+    getter.GetKey(user_key, ikey.Encode(), &s, &type, &seq, &value);
+    ASSERT_EQ(expect_s.code(), s.code()) << user_key;
+    if (expect_s.ok()) {
+      ASSERT_EQ(expect_type, type);
+      ASSERT_EQ(expect_seq, seq);
+      ASSERT_OK(expect_value.fetch());
+      ASSERT_OK(value.fetch());
+      ASSERT_EQ(expect_value.slice(), value.slice());
+    }
+    LazyBuffer view_value;
+    view_getter.GetKey(user_key, ikey.Encode(), &s, &type, &seq, &view_value);
+    ASSERT_EQ(expect_s.code(), s.code()) << user_key;
+    if (expect_s.ok()) {
+      ASSERT_EQ(expect_seq, seq);
+      ASSERT_OK(view_value.fetch());
+      ASSERT_EQ(expect_value.slice(), view_value.slice());
+    }
+  }
+  ASSERT_GT(getter.num_next(), 0);
+  ASSERT_GT(getter.num_seek(), 1);
+  ASSERT_EQ(1, num_create_iter);
+  ASSERT_EQ(getter.num_next(), view_getter.num_next());
+
+  dbfull()->TEST_LockMutex();
+  v->Unref();
+  dbfull()->TEST_UnlockMutex();
+}
+
+TEST_F(DBTest2, SeparatedValueLocation) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.blob_value_location = true;
+  DestroyAndReopen(options);
+
+  std::atomic<int> num_get_by_location(0);
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "BlockBasedTable::GetByLocation",
+      [&](void* /*arg*/) { ++num_get_by_location; });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  auto value_of = [](int i, int round) {
+    return std::string(100 + i % 37, char('a' + (i + round) % 26));
+  };
+  auto verify = [&](int round) {
+    for (int i = 0; i < 200; ++i) {
+      ASSERT_EQ(value_of(i, round), Get(Key(i)));
+    }
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ASSERT_EQ(value_of(count, round), iter->value().ToString());
+      ++count;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(200, count);
+  };
+
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_OK(Put(Key(i), value_of(i, 0)));
+  }
+  ASSERT_OK(Flush());
+  verify(0);
+  ASSERT_GT(num_get_by_location.load(), 0);
+
+  // Compaction keeps locations of values it doesn't move
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  num_get_by_location = 0;
+  verify(0);
+  ASSERT_GT(num_get_by_location.load(), 0);
+
+  // Newly separated values get locations too, old ones remain readable after
+  // the option is turned off
+  for (int i = 0; i < 200; i += 2) {
+    ASSERT_OK(Put(Key(i), value_of(i, 1)));
+  }
+  for (int i = 1; i < 200; i += 2) {
+    ASSERT_OK(Put(Key(i), value_of(i, 1)));
+  }
+  ASSERT_OK(Flush());
+  options.blob_value_location = false;
+  Reopen(options);
+  verify(1);
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  verify(1);
+
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(DBTest2, BlobReadaheadIterator) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  DestroyAndReopen(options);
+
+  // Values spread over a few blob SSTs, with some short ones left inline
+  Random rnd(301);
+  std::map<std::string, std::string> expect;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = round; i < 300; i += 2) {
+      std::string value = RandomString(&rnd, i % 10 == 0 ? 8 : 100 + i % 57);
+      ASSERT_OK(Put(Key(i), value));
+      expect[Key(i)] = value;
+    }
+    ASSERT_OK(Flush());
+  }
+
+  for (size_t files : {1, 2, 8}) {
+    ReadOptions read_options;
+    read_options.blob_readahead_files = files;
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+    auto it = expect.begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+      ASSERT_TRUE(it != expect.end());
+      ASSERT_EQ(it->first, iter->key().ToString());
+      ASSERT_EQ(it->second, iter->value().ToString());
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_TRUE(it == expect.end());
+
+    auto rit = expect.rbegin();
+    for (iter->SeekToLast(); iter->Valid(); iter->Prev(), ++rit) {
+      ASSERT_TRUE(rit != expect.rend());
+      ASSERT_EQ(rit->second, iter->value().ToString());
+    }
+    ASSERT_OK(iter->status());
+
+    // Jumping around costs a Seek in the blob SST scans
+    for (int i : {250, 10, 11, 120, 121, 122, 5}) {
+      iter->Seek(Key(i));
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(expect.lower_bound(Key(i))->second, iter->value().ToString());
+    }
+  }
+}
+
+namespace {
+class PrefixValueExtractor : public ValueExtractor {
+ public:
+  Status Extract(const Slice& /*key*/, const Slice& value,
+                 std::string* output) const override {
+    output->assign(value.data(), std::min<size_t>(value.size(), 4));
+    return Status::OK();
+  }
+};
+
+class PrefixValueExtractorFactory : public ValueExtractorFactory {
+ public:
+  std::unique_ptr<ValueExtractor> CreateValueExtractor(
+      const Context& /*context*/) const override {
+    return std::unique_ptr<ValueExtractor>(new PrefixValueExtractor);
+  }
+  const char* Name() const override { return "PrefixValueExtractorFactory"; }
+};
+}  // namespace
+
+TEST_F(DBTest2, ValueMetaOnlyIterator) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 16;
+  options.blob_large_key_ratio = 1;
+  options.value_meta_extractor_factory =
+      std::make_shared<PrefixValueExtractorFactory>();
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  std::map<std::string, std::string> expect;
+  for (int i = 0; i < 100; ++i) {
+    // Every third value is short enough to stay inline
+    std::string value = RandomString(&rnd, i % 3 == 0 ? 8 : 200);
+    ASSERT_OK(Put(Key(i), value));
+    expect[Key(i)] = value;
+  }
+  ASSERT_OK(Flush());
+
+  options.statistics = CreateDBStatistics();
+  Reopen(options);
+  ReadOptions read_options;
+  read_options.value_meta_only = true;
+  std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+  auto it = expect.begin();
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+    ASSERT_EQ(it->first, iter->key().ToString());
+    ASSERT_EQ(it->second.substr(0, 4), iter->value().ToString());
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_TRUE(it == expect.end());
+  auto rit = expect.rbegin();
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev(), ++rit) {
+    ASSERT_EQ(rit->second.substr(0, 4), iter->value().ToString());
+  }
+  ASSERT_OK(iter->status());
+
+  // Blocks of the key SST are cached now, a normal scan misses the cache on
+  // blob blocks only, which the meta only scan didn't touch
+  uint64_t misses = TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS);
+  std::unique_ptr<Iterator> normal_iter(db_->NewIterator(ReadOptions()));
+  it = expect.begin();
+  for (normal_iter->SeekToFirst(); normal_iter->Valid();
+       normal_iter->Next(), ++it) {
+    ASSERT_EQ(it->second, normal_iter->value().ToString());
+  }
+  ASSERT_OK(normal_iter->status());
+  ASSERT_GT(TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS), misses);
+
+  std::string value;
+  for (int i : {0, 1, 50, 99}) {
+    iter->Seek(Key(i));
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_OK(iter->GetProperty("rocksdb.iterator.value", &value));
+    ASSERT_EQ(expect[Key(i)], value);
+  }
+
+  // Property is not supported for normal iterators
+  normal_iter->SeekToFirst();
+  ASSERT_TRUE(normal_iter->GetProperty("rocksdb.iterator.value", &value)
+                  .IsInvalidArgument());
+}
+
+TEST_F(DBTest2, MapSstElementIndexGet) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.enable_lazy_compaction = true;
+  DestroyAndReopen(options);
+
+  std::atomic<int> num_index_build(0);
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "TableReader::GetMapSstElementIndex:Build",
+      [&](void* /*arg*/) { ++num_index_build; });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  std::map<std::string, std::string> expect;
+  for (int round = 0; round < 4; ++round) {
+    for (int i = round; i < 200; i += 2 + round) {
+      std::string value = Key(i) + "_" + ToString(round);
+      ASSERT_OK(Put(Key(i), value));
+      expect[Key(i)] = value;
+    }
+    ASSERT_OK(Delete(Key(round * 10)));
+    expect.erase(Key(round * 10));
+    ASSERT_OK(Flush());
+  }
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+
+  auto verify = [&] {
+    for (int i = 0; i < 210; ++i) {
+      auto find = expect.find(Key(i));
+      ASSERT_EQ(find == expect.end() ? "NOT_FOUND" : find->second,
+                Get(Key(i)));
+    }
+  };
+  uint64_t readers_mem_before = 0;
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kEstimateTableReadersMem,
+                                  &readers_mem_before));
+  verify();
+  // Lazy compaction left map ssts, each decoded once
+  int num_build = num_index_build.load();
+  ASSERT_GT(num_build, 0);
+  verify();
+  ASSERT_EQ(num_build, num_index_build.load());
+  // The decoded elements are charged to their table readers
+  uint64_t readers_mem_after = 0;
+  ASSERT_TRUE(db_->GetIntProperty(DB::Properties::kEstimateTableReadersMem,
+                                  &readers_mem_after));
+  ASSERT_GT(readers_mem_after, readers_mem_before);
+
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+TEST_F(DBTest2, MapSstSampleForwardedReads) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.enable_lazy_compaction = true;
+  DestroyAndReopen(options);
+
+  for (int round = 0; round < 4; ++round) {
+    for (int i = round; i < 200; i += 2 + round) {
+      ASSERT_OK(Put(Key(i), Key(i) + "_" + ToString(round)));
+    }
+    ASSERT_OK(Flush());
+  }
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+
+  auto sampled_reads = [&] {
+    std::vector<LiveFileMetaData> metadata;
+    db_->GetLiveFilesMetaData(&metadata);
+    uint64_t reads = 0;
+    for (auto& f : metadata) {
+      if (f.level == -1) {
+        reads += f.num_reads_sampled;
+      }
+    }
+    return reads;
+  };
+  ASSERT_EQ(0, sampled_reads());
+  // Files under map ssts are sampled too, about one in 1024 lookups
+  for (int n = 0; n < 50000; ++n) {
+    Get(Key(n % 200));
+  }
+  ASSERT_GT(sampled_reads(), 0);
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
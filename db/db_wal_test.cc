@@ -11,6 +11,7 @@
 #include "options/options_helper.h"
 #include "port/port.h"
 #include "port/stack_trace.h"
+#include "util/compression.h"
 #include "util/fault_injection_test_env.h"
 #include "util/sync_point.h"
 
@@ -598,6 +599,41 @@ TEST_F(DBWALTest, RecoverWithLargeLog) {
   } while (ChangeWalOptions());
 }
 
+TEST_F(DBWALTest, WALCompression) {
+  CompressionType type = kZSTD;
+  if (!StreamingCompressionTypeSupported(type)) {
+    type = kZlibCompression;
+  }
+  if (!StreamingCompressionTypeSupported(type)) {
+    return;
+  }
+  Options options = CurrentOptions();
+  options.avoid_flush_during_recovery = true;
+  DestroyAndReopen(options);
+  std::string value(10000, 'v');
+  ASSERT_OK(Put("key", value));
+
+  // Recover an uncompressed log, then write a compressed one
+  options.wal_compression = type;
+  Reopen(options);
+  ASSERT_EQ(value, Get("key"));
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put("key" + ToString(i), value));
+  }
+  VectorLogPtr log_files;
+  ASSERT_OK(dbfull()->GetSortedWalFiles(log_files));
+  ASSERT_EQ(2, log_files.size());
+  ASSERT_LT(log_files.back()->SizeFileBytes(), 100 * value.size() / 10);
+
+  // Both logs are recovered without compression
+  options.wal_compression = kNoCompression;
+  Reopen(options);
+  ASSERT_EQ(value, Get("key"));
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(value, Get("key" + ToString(i)));
+  }
+}
+
 // In https://reviews.facebook.net/D20661 we change
 // recovery behavior: previously for each log file each column family
 // memtable was flushed, even it was empty. Now it's changed:
@@ -1108,6 +1144,189 @@ TEST_F(DBWALTest, kSkipAnyCorruptedRecords) {
   }
 }
 
+// Test scope:
+// - A drop in a compressed WAL loses the data the following records of the
+// file refer to, they are skipped instead of recovered with wrong values
+TEST_F(DBWALTest, kSkipAnyCorruptedRecordsWithCompression) {
+  CompressionType type = kZSTD;
+  if (!StreamingCompressionTypeSupported(type)) {
+    type = kZlibCompression;
+  }
+  if (!StreamingCompressionTypeSupported(type)) {
+    return;
+  }
+  const int kNumKeys = 80;
+  const int kNumValues = 40;
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < kNumValues; ++i) {
+    values.push_back(RandomString(&rnd, 2000));
+  }
+  for (int i = 0; i < 3; i++) { /* Corruption offset */
+    Options options = CurrentOptions();
+    options.wal_compression = type;
+    options.avoid_flush_during_recovery = true;
+    DestroyAndReopen(options);
+    // The second half repeats the first, its records refer to earlier data
+    for (int k = 0; k < kNumKeys; ++k) {
+      ASSERT_OK(Put(Key(k), values[k % kNumValues]));
+    }
+    VectorLogPtr log_files;
+    ASSERT_OK(dbfull()->GetSortedWalFiles(log_files));
+    ASSERT_EQ(1, log_files.size());
+    std::string fname = dbname_ + log_files.back()->PathName();
+    Close();
+
+    uint64_t size;
+    ASSERT_OK(env_->GetFileSize(fname, &size));
+    ASSERT_GT(size, 2 * log::kBlockSize);
+    RecoveryTestHelper::InduceCorruption(
+        fname, static_cast<size_t>(size * (i + 1) * .2), 16);
+
+    options.wal_recovery_mode = WALRecoveryMode::kSkipAnyCorruptedRecords;
+    options.create_if_missing = false;
+    ASSERT_OK(TryReopen(options));
+    bool dropped = false;
+    for (int k = 0; k < kNumKeys; ++k) {
+      std::string value = Get(Key(k));
+      if (value == "NOT_FOUND") {
+        dropped = true;
+      } else {
+        ASSERT_FALSE(dropped);
+        ASSERT_EQ(values[k % kNumValues], value);
+      }
+    }
+    ASSERT_TRUE(dropped);
+    ASSERT_EQ(values[0], Get(Key(0)));
+  }
+}
+
+// Test scope:
+// - We expect reading the WAL records ahead to recover the same data in all
+// modes, with corruptions at any position
+TEST_F(DBWALTest, RecoveryReadAhead) {
+  const int j = RecoveryTestHelper::kWALFileOffset +
+                RecoveryTestHelper::kWALFilesCount / 2;
+
+  for (auto mode : {WALRecoveryMode::kTolerateCorruptedTailRecords,
+                    WALRecoveryMode::kPointInTimeRecovery,
+                    WALRecoveryMode::kSkipAnyCorruptedRecords}) {
+    for (auto trunc : {true, false}) { /* Corruption style */
+      for (int i = 0; i < 4; i++) {    /* Corruption offset */
+        bool opened[2];
+        size_t recovered_row_count[2] = {0, 0};
+        for (size_t readahead_size : {0, 1}) {
+          Options options = CurrentOptions();
+          RecoveryTestHelper::FillData(this, &options);
+          RecoveryTestHelper::CorruptWAL(this, options, /*off=*/i * .3,
+                                         /*len%=*/.1, j, trunc);
+          options.wal_recovery_mode = mode;
+          options.wal_recovery_readahead_size = readahead_size;
+          options.create_if_missing = false;
+          opened[readahead_size] = TryReopen(options).ok();
+          if (opened[readahead_size]) {
+            recovered_row_count[readahead_size] =
+                RecoveryTestHelper::GetData(this);
+          }
+        }
+        ASSERT_EQ(opened[0], opened[1]);
+        ASSERT_EQ(recovered_row_count[0], recovered_row_count[1]);
+      }
+    }
+  }
+}
+
+// Test scope:
+// - We expect inserting the WAL batches on background threads to recover the
+// same data in all modes, with corruptions at any position
+TEST_F(DBWALTest, RecoveryInsertThreads) {
+  const int j = RecoveryTestHelper::kWALFileOffset +
+                RecoveryTestHelper::kWALFilesCount / 2;
+
+  for (auto mode : {WALRecoveryMode::kTolerateCorruptedTailRecords,
+                    WALRecoveryMode::kPointInTimeRecovery,
+                    WALRecoveryMode::kSkipAnyCorruptedRecords}) {
+    for (auto trunc : {true, false}) { /* Corruption style */
+      for (int i = 0; i < 4; i++) {    /* Corruption offset */
+        bool opened[2];
+        size_t recovered_row_count[2] = {0, 0};
+        for (size_t insert_threads : {0, 1}) {
+          Options options = CurrentOptions();
+          RecoveryTestHelper::FillData(this, &options);
+          RecoveryTestHelper::CorruptWAL(this, options, /*off=*/i * .3,
+                                         /*len%=*/.1, j, trunc);
+          options.wal_recovery_mode = mode;
+          options.wal_recovery_insert_threads = insert_threads;
+          options.create_if_missing = false;
+          opened[insert_threads] = TryReopen(options).ok();
+          if (opened[insert_threads]) {
+            recovered_row_count[insert_threads] =
+                RecoveryTestHelper::GetData(this);
+          }
+        }
+        ASSERT_EQ(opened[0], opened[1]);
+        ASSERT_EQ(recovered_row_count[0], recovered_row_count[1]);
+      }
+    }
+  }
+}
+
+// Test scope:
+// - Batches spanning several column families, overwrites and deletes are
+// recovered by the insert threads in log order, also when the memtables
+// fill up and are flushed during recovery
+TEST_F(DBWALTest, RecoveryInsertThreadsMultipleColumnFamilies) {
+  const int kNumKeys = 2000;
+  for (size_t insert_threads : {1, 2, 8}) {
+    Options options = CurrentOptions();
+    options.create_if_missing = true;
+    options.write_buffer_size = 64 << 10;
+    options.avoid_flush_during_recovery = false;
+    DestroyAndReopen(options);
+    CreateAndReopenWithCF({"one", "two", "three"}, options);
+
+    Random rnd(301);
+    std::vector<std::map<std::string, std::string>> expected(4);
+    for (int i = 0; i < kNumKeys; i++) {
+      WriteBatch batch;
+      for (int cf = 0; cf < 4; cf++) {
+        if (rnd.OneIn(2)) {
+          continue;
+        }
+        std::string key = Key(static_cast<int>(rnd.Uniform(kNumKeys / 4)));
+        if (rnd.OneIn(8)) {
+          ASSERT_OK(batch.Delete(handles_[cf], key));
+          expected[cf].erase(key);
+        } else {
+          std::string value = RandomString(&rnd, 100);
+          ASSERT_OK(batch.Put(handles_[cf], key, value));
+          expected[cf][key] = value;
+        }
+      }
+      ASSERT_OK(dbfull()->Write(WriteOptions(), &batch));
+    }
+    SequenceNumber last_sequence = dbfull()->GetLatestSequenceNumber();
+
+    options.create_if_missing = false;
+    options.wal_recovery_insert_threads = insert_threads;
+    ReopenWithColumnFamilies({"default", "one", "two", "three"}, options);
+    ASSERT_EQ(last_sequence, dbfull()->GetLatestSequenceNumber());
+    for (int cf = 0; cf < 4; cf++) {
+      std::unique_ptr<Iterator> iter(
+          db_->NewIterator(ReadOptions(), handles_[cf]));
+      auto expected_iter = expected[cf].begin();
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        ASSERT_TRUE(expected_iter != expected[cf].end());
+        ASSERT_EQ(expected_iter->first, iter->key().ToString());
+        ASSERT_EQ(expected_iter->second, iter->value().ToString());
+        ++expected_iter;
+      }
+      ASSERT_OK(iter->status());
+      ASSERT_TRUE(expected_iter == expected[cf].end());
+    }
+  }
+}
+
 TEST_F(DBWALTest, AvoidFlushDuringRecovery) {
   Options options = CurrentOptions();
   options.disable_auto_compactions = true;
@@ -159,6 +159,127 @@ TEST_P(DBWriteTest, LockWalInEffect) {
   ASSERT_OK(dbfull()->UnlockWAL());
 }
 
+TEST_P(DBWriteTest, SplitLargeBatchInParallelGroup) {
+  constexpr int kNumThreads = 4;
+  constexpr int kLargeBatchKeys = 1000;
+  Options options = GetOptions();
+  options.memtable_insert_split_size = 100;
+  Reopen(options);
+  std::atomic<int> ready_count{0};
+  std::atomic<size_t> num_ranges{0};
+  // Make all writers join the same batch group
+  SyncPoint::GetInstance()->SetCallBack(
+      "WriteThread::JoinBatchGroup:Wait", [&](void* arg) {
+        ready_count++;
+        auto* w = reinterpret_cast<WriteThread::Writer*>(arg);
+        if (w->state == WriteThread::STATE_GROUP_LEADER) {
+          while (ready_count < kNumThreads) {
+            // busy waiting
+          }
+        }
+      });
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::SplitWriteGroup:Ranges", [&](void* arg) {
+        auto* write_group = reinterpret_cast<WriteThread::WriteGroup*>(arg);
+        num_ranges = write_group->ranges.size();
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  std::vector<port::Thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.push_back(port::Thread(
+        [&](int index) {
+          WriteBatch batch;
+          if (index == 0) {
+            // Every key is written twice, in different ranges
+            for (int j = 0; j < kLargeBatchKeys; j++) {
+              ASSERT_OK(batch.Put("large" + ToString(j % (kLargeBatchKeys / 2)),
+                                  ToString(j)));
+            }
+          } else {
+            ASSERT_OK(batch.Put("small" + ToString(index), "value"));
+          }
+          ASSERT_OK(dbfull()->Write(WriteOptions(), &batch));
+        },
+        i));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_EQ(kLargeBatchKeys / 100 + kNumThreads - 1, num_ranges);
+  ASSERT_EQ(kLargeBatchKeys + kNumThreads - 1,
+            dbfull()->GetLatestSequenceNumber());
+  for (int j = 0; j < kLargeBatchKeys / 2; j++) {
+    ASSERT_EQ(ToString(j + kLargeBatchKeys / 2), Get("large" + ToString(j)));
+  }
+  for (int i = 1; i < kNumThreads; i++) {
+    ASSERT_EQ("value", Get("small" + ToString(i)));
+  }
+}
+
+TEST_P(DBWriteTest, SplitLargeBatchInsertError) {
+  constexpr int kNumThreads = 4;
+  constexpr int kLargeBatchKeys = 1000;
+  Options options = GetOptions();
+  options.memtable_insert_split_size = 100;
+  Reopen(options);
+  std::atomic<int> ready_count{0};
+  std::atomic<WriteThread::Writer*> large_writer{nullptr};
+  SyncPoint::GetInstance()->SetCallBack(
+      "WriteThread::JoinBatchGroup:Wait", [&](void* arg) {
+        ready_count++;
+        auto* w = reinterpret_cast<WriteThread::Writer*>(arg);
+        if (WriteBatchInternal::Count(w->batch) == kLargeBatchKeys) {
+          large_writer = w;
+        }
+        if (w->state == WriteThread::STATE_GROUP_LEADER) {
+          while (ready_count < kNumThreads) {
+            // busy waiting
+          }
+        }
+      });
+  // Fail a range of the large batch, whichever writer inserts it
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::InsertWriteGroupRanges:Status", [&](void* arg) {
+        auto* range = reinterpret_cast<WriteThread::WriteGroup::BatchRange*>(arg);
+        if (range->writer == large_writer &&
+            range->begin == WriteBatchInternal::kHeader) {
+          range->status = Status::Corruption("injected");
+        }
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  std::vector<Status> statuses(kNumThreads);
+  std::vector<port::Thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.push_back(port::Thread(
+        [&](int index) {
+          WriteBatch batch;
+          if (index == 0) {
+            for (int j = 0; j < kLargeBatchKeys; j++) {
+              ASSERT_OK(batch.Put("large" + ToString(j), ToString(j)));
+            }
+          } else {
+            ASSERT_OK(batch.Put("small" + ToString(index), "value"));
+          }
+          statuses[index] = dbfull()->Write(WriteOptions(), &batch);
+        },
+        i));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  // The owner of the failed range sees the error
+  ASSERT_TRUE(statuses[0].IsCorruption());
+  Close();
+}
+
 INSTANTIATE_TEST_CASE_P(DBWriteTestInstance, DBWriteTest,
                         testing::Values(DBTestBase::kDefault,
                                         DBTestBase::kConcurrentWALWrites,
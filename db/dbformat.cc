@@ -197,17 +197,23 @@ void IterKey::EnlargeBuffer(size_t key_size) {
   buf_size_ = key_size;
 }
 
+constexpr uint64_t SeparateHelper::kNoLocation;
+constexpr uint64_t SeparateHelper::kLocationFlag;
+constexpr size_t SeparateHelper::kMaxValueIndexPrefix;
+
 Status SeparateHelper::TransToSeparate(
     const Slice& internal_key, LazyBuffer& value, uint64_t file_number,
     const Slice& meta, bool is_merge, bool is_index,
-    const ValueExtractor* value_meta_extractor) {
+    const ValueExtractor* value_meta_extractor, uint64_t location) {
   assert(file_number != uint64_t(-1));
+  char buf[kMaxValueIndexPrefix];
+  Slice prefix = EncodeValueIndexPrefix(file_number, location, buf);
   if (value_meta_extractor == nullptr || is_merge) {
-    value.reset(EncodeFileNumber(file_number), true, file_number);
+    value.reset(prefix, true, file_number);
     return Status::OK();
   }
   if (is_index) {
-    Slice parts[] = {EncodeFileNumber(file_number), meta};
+    Slice parts[] = {prefix, meta};
     value.reset(SliceParts(parts, 2), file_number);
     return Status::OK();
   } else {
@@ -219,7 +225,7 @@ Status SeparateHelper::TransToSeparate(
     s = value_meta_extractor->Extract(ExtractUserKey(internal_key),
                                       value.slice(), &value_meta);
     if (s.ok()) {
-      Slice parts[] = {EncodeFileNumber(file_number), value_meta};
+      Slice parts[] = {prefix, value_meta};
       value.reset(SliceParts(parts, 2), file_number);
     }
     return s;
@@ -781,16 +781,37 @@ struct ParsedInternalKeyComparator {
   const InternalKeyComparator* cmp;
 };
 
+// Value index layout:
+//   fixed64 file_number [ varint64 location ] [ value_meta ]
+// The location is present iff kLocationFlag is set in file_number, it is what
+// TableBuilder::LastEntryLocation() returned right after the value was added
+// to the blob sst, and lets the reader skip the index search of that sst.
 class SeparateHelper {
  public:
   virtual ~SeparateHelper() = default;
 
+  static constexpr uint64_t kNoLocation = uint64_t(-1);
+  static constexpr uint64_t kLocationFlag = 1ull << 63;
+  static constexpr size_t kMaxValueIndexPrefix = sizeof(uint64_t) + 10;
+
   static Slice EncodeFileNumber(uint64_t& file_number) {
     if (!port::kLittleEndian) {
       file_number = EndianTransform(file_number, sizeof file_number);
     }
     return Slice(reinterpret_cast<char*>(&file_number), sizeof file_number);
   }
+  // buf must have at least kMaxValueIndexPrefix bytes
+  static Slice EncodeValueIndexPrefix(uint64_t file_number, uint64_t location,
+                                      char* buf) {
+    assert((file_number & kLocationFlag) == 0);
+    if (location == kNoLocation) {
+      EncodeFixed64(buf, file_number);
+      return Slice(buf, sizeof(uint64_t));
+    }
+    EncodeFixed64(buf, file_number | kLocationFlag);
+    char* end = EncodeVarint64(buf + sizeof(uint64_t), location);
+    return Slice(buf, end - buf);
+  }
   static uint64_t DecodeFileNumber(const Slice& slice) {
     assert(slice.size() >= sizeof(uint64_t));
     uint64_t file_number;
@@ -798,25 +819,48 @@ class SeparateHelper {
     if (!port::kLittleEndian) {
       file_number = EndianTransform(file_number, sizeof file_number);
     }
-    return file_number;
+    return file_number & ~kLocationFlag;
+  }
+  static uint64_t DecodeLocation(const Slice& slice) {
+    assert(slice.size() >= sizeof(uint64_t));
+    if ((DecodeFixed64(slice.data()) & kLocationFlag) == 0) {
+      return kNoLocation;
+    }
+    Slice input(slice.data() + sizeof(uint64_t),
+                slice.size() - sizeof(uint64_t));
+    uint64_t location;
+    if (!GetVarint64(&input, &location)) {
+      return kNoLocation;
+    }
+    return location;
   }
   static Slice DecodeValueMeta(const Slice& slice) {
     assert(slice.size() >= sizeof(uint64_t));
-    return Slice(slice.data() + sizeof(uint64_t),
-                 slice.size() - sizeof(uint64_t));
+    Slice meta(slice.data() + sizeof(uint64_t),
+               slice.size() - sizeof(uint64_t));
+    if ((DecodeFixed64(slice.data()) & kLocationFlag) != 0) {
+      uint64_t location;
+      if (!GetVarint64(&meta, &location)) {
+        return Slice();
+      }
+    }
+    return meta;
   }
 
   static Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
                                 uint64_t file_number, const Slice& meta,
                                 bool is_merge, bool is_index,
-                                const ValueExtractor* value_meta_extractor);
+                                const ValueExtractor* value_meta_extractor,
+                                uint64_t location = kNoLocation);
 
+  // location is kNoLocation or the one carried by the value index which
+  // produced value, it is only valid while value.file_number() is unchanged
   virtual Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
                                  const Slice& meta, bool is_merge,
-                                 bool is_index) {
+                                 bool is_index, uint64_t location) {
     assert(value.file_number() != uint64_t(-1));
     return TransToSeparate(internal_key, value, value.file_number(), meta,
-                           is_merge, is_index, nullptr);
+                           is_merge, is_index, nullptr, location);
   }
 
   virtual Status TransToSeparate(const Slice& /*internal_key*/,
@@ -826,6 +870,15 @@ class SeparateHelper {
 
   virtual LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                                      const LazyBuffer& value) const = 0;
+
+  // Returns a helper for readers which visit separated values in ascending
+  // key order, it may fetch them by forward scans over the blob ssts instead
+  // of point lookups. Values it combines must be fetched or pinned before it
+  // is destroyed. nullptr if not supported.
+  virtual std::unique_ptr<SeparateHelper> NewSequentialHelper(
+      const ReadOptions& /*read_options*/) const {
+    return nullptr;
+  }
 };
 
 extern Slice ArenaPinSlice(const Slice& slice, Arena* arena);
@@ -199,6 +199,34 @@ TEST_F(FormatTest, RangeTombstoneSerializeEndKey) {
   ASSERT_LT(cmp.Compare(t.SerializeEndKey(), k), 0);
 }
 
+TEST_F(FormatTest, SeparateHelperValueIndex) {
+  char buf[SeparateHelper::kMaxValueIndexPrefix];
+  Slice prefix = SeparateHelper::EncodeValueIndexPrefix(
+      123, SeparateHelper::kNoLocation, buf);
+  ASSERT_EQ(sizeof(uint64_t), prefix.size());
+  std::string index = prefix.ToString() + "meta";
+  ASSERT_EQ(123, SeparateHelper::DecodeFileNumber(index));
+  ASSERT_EQ(SeparateHelper::kNoLocation,
+            SeparateHelper::DecodeLocation(index));
+  ASSERT_EQ("meta", SeparateHelper::DecodeValueMeta(index).ToString());
+
+  // Old format written by EncodeFileNumber
+  uint64_t file_number = 123;
+  ASSERT_EQ(prefix, SeparateHelper::EncodeFileNumber(file_number));
+
+  for (uint64_t location : {0ull, 1ull, 300ull, 1ull << 40}) {
+    prefix = SeparateHelper::EncodeValueIndexPrefix(456, location, buf);
+    ASSERT_GT(prefix.size(), sizeof(uint64_t));
+    index = prefix.ToString() + "meta";
+    ASSERT_EQ(456, SeparateHelper::DecodeFileNumber(index));
+    ASSERT_EQ(location, SeparateHelper::DecodeLocation(index));
+    ASSERT_EQ("meta", SeparateHelper::DecodeValueMeta(index).ToString());
+    index = prefix.ToString();
+    ASSERT_EQ(location, SeparateHelper::DecodeLocation(index));
+    ASSERT_TRUE(SeparateHelper::DecodeValueMeta(index).empty());
+  }
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
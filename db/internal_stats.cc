@@ -253,6 +253,8 @@ static const std::string block_cache_capacity = "block-cache-capacity";
 static const std::string block_cache_usage = "block-cache-usage";
 static const std::string block_cache_pinned_usage = "block-cache-pinned-usage";
 static const std::string options_statistics = "options-statistics";
+static const std::string memory_arbiter_stats = "memory-arbiter-stats";
+static const std::string memory_arbiter_usage = "memory-arbiter-usage";
 
 const std::string DB::Properties::kNumFilesAtLevelPrefix =
     rocksdb_prefix + num_files_at_level_prefix;
@@ -340,6 +342,10 @@ const std::string DB::Properties::kBlockCachePinnedUsage =
     rocksdb_prefix + block_cache_pinned_usage;
 const std::string DB::Properties::kOptionsStatistics =
     rocksdb_prefix + options_statistics;
+const std::string DB::Properties::kMemoryArbiterStats =
+    rocksdb_prefix + memory_arbiter_stats;
+const std::string DB::Properties::kMemoryArbiterUsage =
+    rocksdb_prefix + memory_arbiter_usage;
 
 const std::unordered_map<std::string, DBPropertyInfo>
     InternalStats::ppt_name_to_info = {
@@ -476,6 +482,12 @@ const std::unordered_map<std::string, DBPropertyInfo>
         {DB::Properties::kOptionsStatistics,
          {false, nullptr, nullptr, nullptr,
           &DBImpl::GetPropertyHandleOptionsStatistics}},
+        {DB::Properties::kMemoryArbiterStats,
+         {false, &InternalStats::HandleMemoryArbiterStats, nullptr,
+          &InternalStats::HandleMemoryArbiterMapStats, nullptr}},
+        {DB::Properties::kMemoryArbiterUsage,
+         {false, nullptr, &InternalStats::HandleMemoryArbiterUsage, nullptr,
+          nullptr}},
 };
 
 const DBPropertyInfo* GetPropertyInfo(const Slice& property) {
@@ -942,6 +954,50 @@ bool InternalStats::HandleBlockCachePinnedUsage(uint64_t* value, DBImpl* /*db*/,
   return true;
 }
 
+bool InternalStats::HandleMemoryArbiterStats(std::string* value,
+                                             Slice /*suffix*/) {
+  MemoryArbiter* arbiter = cfd_->ioptions()->memory_arbiter;
+  if (arbiter == nullptr) {
+    return false;
+  }
+  *value = arbiter->ToString();
+  return true;
+}
+
+bool InternalStats::HandleMemoryArbiterMapStats(
+    std::map<std::string, std::string>* values) {
+  MemoryArbiter* arbiter = cfd_->ioptions()->memory_arbiter;
+  if (arbiter == nullptr) {
+    return false;
+  }
+  MemoryArbiter::Stats stats;
+  arbiter->GetStats(&stats);
+  for (int i = 0; i < MemoryArbiter::kNumConsumers; ++i) {
+    (*values)[std::string(MemoryArbiter::ConsumerName(
+                  static_cast<MemoryArbiter::Consumer>(i))) +
+              ".usage"] = ToString(stats.usage[i]);
+  }
+  (*values)["limit"] = ToString(stats.limit);
+  (*values)["peak-usage"] = ToString(stats.peak_usage);
+  (*values)["num-waiting"] = ToString(stats.num_waiting);
+  (*values)["waiting-bytes"] = ToString(stats.waiting_bytes);
+  (*values)["num-reservations"] = ToString(stats.num_reservations);
+  (*values)["num-waits"] = ToString(stats.num_waits);
+  (*values)["wait-micros"] = ToString(stats.wait_micros);
+  (*values)["num-timeouts"] = ToString(stats.num_timeouts);
+  return true;
+}
+
+bool InternalStats::HandleMemoryArbiterUsage(uint64_t* value, DBImpl* /*db*/,
+                                             Version* /*version*/) {
+  MemoryArbiter* arbiter = cfd_->ioptions()->memory_arbiter;
+  if (arbiter == nullptr) {
+    return false;
+  }
+  *value = static_cast<uint64_t>(arbiter->usage());
+  return true;
+}
+
 void InternalStats::DumpDBStats(std::string* value) {
   char buf[1000];
   // DB-level stats, only available from default column family
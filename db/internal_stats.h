@@ -544,6 +544,9 @@ class InternalStats {
                                    Version* version);
   bool HandleBlockCacheCapacity(uint64_t* value, DBImpl* db, Version* version);
   bool HandleBlockCacheUsage(uint64_t* value, DBImpl* db, Version* version);
+  bool HandleMemoryArbiterStats(std::string* value, Slice suffix);
+  bool HandleMemoryArbiterMapStats(std::map<std::string, std::string>* values);
+  bool HandleMemoryArbiterUsage(uint64_t* value, DBImpl* db, Version* version);
   bool HandleBlockCachePinnedUsage(uint64_t* value, DBImpl* db,
                                    Version* version);
   // Total number of background errors encountered. Every time a flush task
@@ -12,8 +12,10 @@
 #include <stdio.h>
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
+#include "util/mutexlock.h"
 #include "util/util.h"
 
 namespace rocksdb {
@@ -39,7 +41,9 @@ Reader::Reader(std::shared_ptr<Logger> info_log,
       end_of_buffer_offset_(0),
       log_number_(log_num),
       recycled_(false),
-      retry_after_eof_(retry_after_eof) {}
+      retry_after_eof_(retry_after_eof),
+      compression_type_(kNoCompression),
+      uncompress_broken_(false) {}
 
 Reader::~Reader() {
   delete[] backing_store_;
@@ -79,6 +83,9 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
         prospective_record_offset = physical_record_offset;
         scratch->clear();
         *record = fragment;
+        if (compression_type_ != kNoCompression && !UncompressRecord(record)) {
+          break;
+        }
         last_record_offset_ = prospective_record_offset;
         return true;
 
@@ -114,11 +121,27 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
         } else {
           scratch->append(fragment.data(), fragment.size());
           *record = Slice(*scratch);
+          if (compression_type_ != kNoCompression &&
+              !UncompressRecord(record)) {
+            in_fragmented_record = false;
+            scratch->clear();
+            break;
+          }
           last_record_offset_ = prospective_record_offset;
           return true;
         }
         break;
 
+      case kSetCompressionType:
+        if (compression_type_ != kNoCompression || in_fragmented_record ||
+            physical_record_offset != 0 || fragment.size() != 1) {
+          ReportCorruption(fragment.size(), "misplaced compression type");
+          break;
+        }
+        compression_type_ = static_cast<CompressionType>(fragment[0]);
+        uncompress_.reset(StreamingUncompress::Create(compression_type_));
+        break;
+
       case kBadHeader:
         if (wal_recovery_mode == WALRecoveryMode::kAbsoluteConsistency) {
           // in clean shutdown we don't expect any error in the log files
@@ -199,6 +222,24 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
   return false;
 }
 
+bool Reader::UncompressRecord(Slice* record) {
+  uncompressed_record_.clear();
+  if (uncompress_broken_) {
+    ReportCorruption(record->size(), "record after a drop in compressed log");
+    return false;
+  }
+  if (uncompress_ == nullptr) {
+    ReportCorruption(record->size(), "unsupported compression type");
+    return false;
+  }
+  if (!uncompress_->Uncompress(*record, &uncompressed_record_)) {
+    ReportCorruption(record->size(), "failed to uncompress record");
+    return false;
+  }
+  *record = Slice(uncompressed_record_);
+  return true;
+}
+
 uint64_t Reader::LastRecordOffset() {
   return last_record_offset_;
 }
@@ -267,11 +308,100 @@ void Reader::UnmarkEOF() {
   }
 }
 
+ReadAheadReader::ReadAheadReader(std::shared_ptr<Logger> info_log,
+                                 std::unique_ptr<SequentialFileReader>&& file,
+                                 Reader::Reporter* reporter, bool checksum,
+                                 uint64_t log_num,
+                                 WALRecoveryMode wal_recovery_mode,
+                                 size_t readahead_size)
+    : reporter_(reporter),
+      wal_recovery_mode_(wal_recovery_mode),
+      readahead_size_(readahead_size),
+      reader_(info_log, std::move(file), &collector_, checksum, log_num,
+              false /* retry_after_eof */),
+      eof_(false),
+      cv_(&mutex_),
+      queued_bytes_(0),
+      stop_(false) {
+  thread_ = port::Thread(&ReadAheadReader::BackgroundRead, this);
+}
+
+ReadAheadReader::~ReadAheadReader() {
+  {
+    MutexLock l(&mutex_);
+    stop_ = true;
+    cv_.SignalAll();
+  }
+  thread_.join();
+}
+
+bool ReadAheadReader::ReadRecord(Slice* record, std::string* scratch) {
+  scratch->clear();
+  record->clear();
+  if (eof_) {
+    return false;
+  }
+  Item item;
+  {
+    MutexLock l(&mutex_);
+    while (queue_.empty()) {
+      cv_.Wait();
+    }
+    item = std::move(queue_.front());
+    queue_.pop_front();
+    queued_bytes_ -= item.record.size();
+    cv_.SignalAll();
+  }
+  if (reporter_ != nullptr) {
+    for (auto& corruption : item.corruptions) {
+      reporter_->Corruption(corruption.first, corruption.second);
+    }
+  }
+  if (item.eof) {
+    eof_ = true;
+    return false;
+  }
+  scratch->swap(item.record);
+  *record = Slice(*scratch);
+  return true;
+}
+
+void ReadAheadReader::BackgroundRead() {
+  std::string scratch;
+  Slice record;
+  while (true) {
+    Item item;
+    item.eof = !reader_.ReadRecord(&record, &scratch, wal_recovery_mode_);
+    if (!item.eof) {
+      item.record.assign(record.data(), record.size());
+    }
+    item.corruptions.swap(collector_.corruptions);
+
+    MutexLock l(&mutex_);
+    while (!stop_ && !queue_.empty() && queued_bytes_ >= readahead_size_) {
+      cv_.Wait();
+    }
+    if (stop_) {
+      return;
+    }
+    queued_bytes_ += item.record.size();
+    bool eof = item.eof;
+    queue_.emplace_back(std::move(item));
+    cv_.SignalAll();
+    if (eof) {
+      return;
+    }
+  }
+}
+
 void Reader::ReportCorruption(size_t bytes, const char* reason) {
   ReportDrop(bytes, Status::Corruption(reason));
 }
 
 void Reader::ReportDrop(size_t bytes, const Status& reason) {
+  if (compression_type_ != kNoCompression) {
+    uncompress_broken_ = true;
+  }
   if (reporter_ != nullptr) {
     reporter_->Corruption(bytes, reason);
   }
@@ -8,10 +8,15 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #pragma once
+#include <deque>
 #include <memory>
 #include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "db/log_format.h"
+#include "port/port.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 #include "rocksdb/options.h"
@@ -19,6 +24,7 @@
 namespace rocksdb {
 
 class SequentialFileReader;
+class StreamingUncompress;
 class Logger;
 using std::unique_ptr;
 
@@ -115,6 +121,14 @@ class Reader {
   // etc.
   const bool retry_after_eof_;
 
+  // Compression type set by the kSetCompressionType record
+  CompressionType compression_type_;
+  std::unique_ptr<StreamingUncompress> uncompress_;
+  std::string uncompressed_record_;
+  // Set by any drop in a compressed log. The records after it may refer to
+  // the dropped data, so they are dropped too.
+  bool uncompress_broken_;
+
   // Extend record types with the following special values
   enum {
     kEof = kMaxRecordType + 1,
@@ -139,6 +153,9 @@ class Reader {
   // Read some more
   bool ReadMore(size_t* drop_size, int *error);
 
+  // Replace the compressed *record by its data, false if it is corrupted
+  bool UncompressRecord(Slice* record);
+
   // Reports dropped bytes to the reporter.
   // buffer_ must be updated to remove the dropped bytes prior to invocation.
   void ReportCorruption(size_t bytes, const char* reason);
@@ -149,5 +166,63 @@ class Reader {
   void operator=(const Reader&);
 };
 
+/**
+ * ReadAheadReader reads the records of a log on a background thread, up to
+ * `readahead_size` bytes of them ahead of the caller, so the I/O, checksums
+ * and decompression overlap with the processing of the records before them.
+ * Corruptions are reported on the thread calling ReadRecord(), in the same
+ * order relative to the records as a Reader does.
+ */
+class ReadAheadReader {
+ public:
+  ReadAheadReader(std::shared_ptr<Logger> info_log,
+                  std::unique_ptr<SequentialFileReader>&& file,
+                  Reader::Reporter* reporter, bool checksum, uint64_t log_num,
+                  WALRecoveryMode wal_recovery_mode, size_t readahead_size);
+
+  // Stops the background thread, records read ahead are dropped
+  ~ReadAheadReader();
+
+  // Same as Reader::ReadRecord()
+  bool ReadRecord(Slice* record, std::string* scratch);
+
+ private:
+  struct Item {
+    std::string record;
+    std::vector<std::pair<size_t, Status>> corruptions;
+    bool eof = false;
+  };
+
+  // Keeps the corruptions of the record being read
+  class Collector : public Reader::Reporter {
+   public:
+    std::vector<std::pair<size_t, Status>> corruptions;
+
+    virtual void Corruption(size_t bytes, const Status& status) override {
+      corruptions.emplace_back(bytes, status);
+    }
+  };
+
+  void BackgroundRead();
+
+  Reader::Reporter* const reporter_;
+  const WALRecoveryMode wal_recovery_mode_;
+  const size_t readahead_size_;
+  Collector collector_;
+  Reader reader_;
+  bool eof_;
+
+  port::Mutex mutex_;
+  port::CondVar cv_;
+  std::deque<Item> queue_;
+  size_t queued_bytes_;
+  bool stop_;
+  port::Thread thread_;
+
+  // No copying allowed
+  ReadAheadReader(const ReadAheadReader&);
+  void operator=(const ReadAheadReader&);
+};
+
 }  // namespace log
 }  // namespace rocksdb
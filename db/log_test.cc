@@ -11,6 +11,7 @@
 #include "db/log_writer.h"
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 #include "util/random.h"
@@ -651,6 +652,81 @@ TEST_P(LogTest, Recycle) {
   ASSERT_EQ("EOF", Read());
 }
 
+TEST_P(LogTest, Compression) {
+  CompressionType type = kZSTD;
+  if (!StreamingCompressionTypeSupported(type)) {
+    type = kZlibCompression;
+  }
+  if (GetParam() || !StreamingCompressionTypeSupported(type)) {
+    return;  // test is only valid for compressed logs, which are not recycled
+  }
+  std::unique_ptr<WritableFileWriter> dest_holder(test::GetWritableFileWriter(
+      new test::StringSink(get_reader_contents()), "" /* don't care */));
+  Writer compressed_writer(std::move(dest_holder), 123, false,
+                           false /* manual_flush */, type);
+  ASSERT_OK(compressed_writer.AddCompressionTypeRecord());
+  ASSERT_EQ(type, compressed_writer.compression_type());
+
+  // Random data is fragmented across blocks, a record repeating an earlier
+  // one is compressed against it
+  Random rnd(301);
+  std::string large, small;
+  test::RandomString(&rnd, 3 * kBlockSize, &large);
+  test::RandomString(&rnd, 8000, &small);
+  ASSERT_OK(compressed_writer.AddRecord(Slice("foo")));
+  ASSERT_OK(compressed_writer.AddRecord(Slice(large)));
+  ASSERT_OK(compressed_writer.AddRecord(Slice(small)));
+  ASSERT_OK(compressed_writer.AddRecord(Slice()));
+  ASSERT_OK(compressed_writer.AddRecord(Slice(small)));
+  ASSERT_LT(get_reader_contents()->size(), large.size() + small.size() + 1000);
+
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ(large, Read());
+  ASSERT_EQ(small, Read());
+  ASSERT_EQ("", Read());
+  ASSERT_EQ(small, Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0U, DroppedBytes());
+}
+
+TEST_P(LogTest, CompressionCorruption) {
+  CompressionType type = kZSTD;
+  if (!StreamingCompressionTypeSupported(type)) {
+    type = kZlibCompression;
+  }
+  if (GetParam() || !StreamingCompressionTypeSupported(type)) {
+    return;  // test is only valid for compressed logs, which are not recycled
+  }
+  std::unique_ptr<WritableFileWriter> dest_holder(test::GetWritableFileWriter(
+      new test::StringSink(get_reader_contents()), "" /* don't care */));
+  Writer compressed_writer(std::move(dest_holder), 123, false,
+                           false /* manual_flush */, type);
+  ASSERT_OK(compressed_writer.AddCompressionTypeRecord());
+  auto dest =
+      dynamic_cast<test::StringSink*>(compressed_writer.file()->writable_file());
+  ASSERT_TRUE(dest != nullptr);
+
+  Random rnd(301);
+  std::string large, small;
+  test::RandomString(&rnd, 3 * kBlockSize, &large);
+  test::RandomString(&rnd, 8000, &small);
+  ASSERT_OK(compressed_writer.AddRecord(Slice("foo")));
+  size_t corrupt_offset = dest->contents_.size() + kHeaderSize;
+  ASSERT_OK(compressed_writer.AddRecord(Slice(small)));
+  // The checksum mismatch drops the rest of the block, the records in the
+  // next blocks are readable but the context lost the data they refer to
+  ASSERT_OK(compressed_writer.AddRecord(Slice(large)));
+  ASSERT_OK(compressed_writer.AddRecord(Slice(small)));
+  ASSERT_OK(compressed_writer.AddRecord(Slice("bar")));
+  dest->contents_[corrupt_offset] ^= 1;
+
+  ASSERT_EQ("foo", Read(WALRecoveryMode::kSkipAnyCorruptedRecords));
+  ASSERT_EQ("EOF", Read(WALRecoveryMode::kSkipAnyCorruptedRecords));
+  ASSERT_EQ("OK", MatchError("checksum mismatch"));
+  ASSERT_EQ("OK", MatchError("record after a drop in compressed log"));
+  ASSERT_GT(DroppedBytes(), large.size());
+}
+
 INSTANTIATE_TEST_CASE_P(bool, LogTest, ::testing::Values(0, 2));
 
 class RetriableLogTest : public ::testing::TestWithParam<int> {
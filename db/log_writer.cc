@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 
@@ -19,12 +20,14 @@ namespace rocksdb {
 namespace log {
 
 Writer::Writer(std::unique_ptr<WritableFileWriter>&& dest, uint64_t log_number,
-               bool recycle_log_files, bool manual_flush)
+               bool recycle_log_files, bool manual_flush,
+               CompressionType compression_type)
     : dest_(std::move(dest)),
       block_offset_(0),
       log_number_(log_number),
       recycle_log_files_(recycle_log_files),
-      manual_flush_(manual_flush) {
+      manual_flush_(manual_flush),
+      compression_type_(compression_type) {
   for (int i = 0; i <= kMaxRecordType; i++) {
     char t = static_cast<char>(i);
     type_crc_[i] = crc32c::Value(&t, 1);
@@ -35,9 +38,36 @@ Writer::~Writer() { WriteBuffer(); }
 
 Status Writer::WriteBuffer() { return dest_->Flush(); }
 
+Status Writer::AddCompressionTypeRecord() {
+  assert(block_offset_ == 0);
+  if (compression_type_ == kNoCompression) {
+    return Status::OK();
+  }
+  compress_.reset(StreamingCompress::Create(compression_type_));
+  if (compress_ == nullptr) {
+    compression_type_ = kNoCompression;
+    return Status::OK();
+  }
+  char type = static_cast<char>(compression_type_);
+  Status s = EmitPhysicalRecord(kSetCompressionType, &type, 1);
+  if (!s.ok()) {
+    compress_.reset();
+    compression_type_ = kNoCompression;
+  }
+  return s;
+}
+
 Status Writer::AddRecord(const Slice& slice) {
   const char* ptr = slice.data();
   size_t left = slice.size();
+  if (compress_ != nullptr) {
+    compressed_buffer_.clear();
+    if (!compress_->Compress(slice, &compressed_buffer_)) {
+      return Status::Corruption("failed to compress log record");
+    }
+    ptr = compressed_buffer_.data();
+    left = compressed_buffer_.size();
+  }
 
   // Header size varies depending on whether we are recycling or not.
   const int header_size =
@@ -106,7 +136,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
   buf[6] = static_cast<char>(t);
 
   uint32_t crc = type_crc_[t];
-  if (t < kRecyclableFullType) {
+  if (t < kRecyclableFullType || t == kSetCompressionType) {
     // Legacy record format
     assert(block_offset_ + kHeaderSize + n <= kBlockSize);
     header_size = kHeaderSize;
@@ -11,13 +11,16 @@
 #include <stdint.h>
 
 #include <memory>
+#include <string>
 
 #include "db/log_format.h"
+#include "rocksdb/options.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 
 namespace rocksdb {
 
+class StreamingCompress;
 class WritableFileWriter;
 
 using std::unique_ptr;
@@ -66,6 +69,11 @@ namespace log {
  * Same as above, with the addition of
  * Log number = 32bit log file number, so that we can distinguish between
  * records written by the most recent log writer vs a previous one.
+ *
+ * Compressed logs start with a kSetCompressionType record, whose payload is
+ * the compression type (1B). The payload of every record after it is the
+ * record compressed by one streaming context, so the records can only be
+ * decoded in order.
  */
 class Writer {
  public:
@@ -73,11 +81,19 @@ class Writer {
   // "*dest" must be initially empty.
   // "*dest" must remain live while this Writer is in use.
   explicit Writer(std::unique_ptr<WritableFileWriter>&& dest, uint64_t log_number,
-                  bool recycle_log_files, bool manual_flush = false);
+                  bool recycle_log_files, bool manual_flush = false,
+                  CompressionType compression_type = kNoCompression);
   ~Writer();
 
+  // Writes the kSetCompressionType record, must be called before the first
+  // AddRecord(). Turns compression off if the type is not supported as a
+  // stream.
+  Status AddCompressionTypeRecord();
+
   Status AddRecord(const Slice& slice);
 
+  CompressionType compression_type() const { return compression_type_; }
+
   WritableFileWriter* file() { return dest_.get(); }
   const WritableFileWriter* file() const { return dest_.get(); }
 
@@ -104,6 +120,10 @@ class Writer {
   // layer to manually does the flush by calling ::WriteBuffer()
   bool manual_flush_;
 
+  CompressionType compression_type_;
+  std::unique_ptr<StreamingCompress> compress_;
+  std::string compressed_buffer_;
+
   // No copying allowed
   Writer(const Writer&);
   void operator=(const Writer&);
@@ -12,11 +12,13 @@
 #include "db/dbformat.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "db/version_edit.h"
+#include "monitoring/file_read_sample.h"
 #include "monitoring/perf_context_imp.h"
 #include "rocksdb/statistics.h"
 #include "table/get_context.h"
 #include "table/internal_iterator.h"
 #include "table/iterator_wrapper.h"
+#include "table/map_sst_element_index.h"
 #include "table/table_builder.h"
 #include "table/table_reader.h"
 #include "table/two_level_iterator.h"
@@ -458,27 +460,14 @@ Status TableCache::Get(const ReadOptions& options,
       ReadOptions forward_options = options;
       forward_options.ignore_range_deletions |=
           file_meta.prop.map_handle_range_deletions();
-      auto get_from_map = [&](const Slice& largest_key,
-                              LazyBuffer&& map_value) {
-        s = map_value.fetch();
-        if (!s.ok()) {
-          return false;
-        }
-        // Manual inline MapSstElement::Decode
-        const char* err_msg = "Map sst invalid link_value";
-        Slice map_input = map_value.slice();
-        Slice smallest_key;
-        uint64_t link_count;
-        uint64_t flags;
+      auto& icomp = internal_comparator;
+      const MapSstElementIndex* map_index = nullptr;
+      auto get_from_map = [&](const MapSstElementIndex::Element& element) {
+        const Slice& smallest_key = element.smallest_key;
+        const Slice& largest_key = element.largest_key;
+        uint64_t flags = element.flags;
         Slice find_k = k;
-        auto& icomp = internal_comparator;
 
-        if (!GetVarint64(&map_input, &flags) ||
-            !GetVarint64(&map_input, &link_count) ||
-            !GetLengthPrefixedSlice(&map_input, &smallest_key)) {
-          s = Status::Corruption(err_msg);
-          return false;
-        }
         // don't care kNoRecords, Get call need load
         // max_covering_tombstone_seq
         int include_smallest = (flags & MapSstElement::kIncludeSmallest) != 0;
@@ -530,18 +519,19 @@ Status TableCache::Get(const ReadOptions& options,
               std::max(min_seq_type_backup, seq_type + !include_largest));
         }
 
-        uint64_t file_number;
-        for (uint64_t i = 0; i < link_count; ++i) {
-          if (!GetVarint64(&map_input, &file_number)) {
-            s = Status::Corruption(err_msg);
-            return false;
-          }
+        const uint64_t* links = map_index->links(element);
+        for (uint32_t i = 0; i < element.link_count; ++i) {
+          uint64_t file_number = links[i];
           auto find = dependence_map.find(file_number);
           if (find == dependence_map.end()) {
             s = Status::Corruption("Map sst dependence missing");
             return false;
           }
           assert(find->second->fd.GetNumber() == file_number);
+          if (get_context->sample()) {
+            // Feeds read cost ranking of map sst flattening
+            sample_file_read_inc(find->second);
+          }
           s = Get(forward_options, internal_comparator, *find->second,
                   dependence_map, find_k, get_context, prefix_extractor,
                   file_read_hist, skip_filters, level);
@@ -555,8 +545,13 @@ Status TableCache::Get(const ReadOptions& options,
         get_context->SetMinSequenceAndType(min_seq_type_backup);
         return is_largest_user_key;
       };
-      t->RangeScan(&k, prefix_extractor, &get_from_map,
-                   c_style_callback(get_from_map));
+      s = t->GetMapSstElementIndex(&map_index);
+      if (s.ok()) {
+        for (size_t i = map_index->LowerBound(icomp, k);
+             i < map_index->size() && get_from_map(map_index->element(i));
+             ++i) {
+        }
+      }
     }
   } else if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
     // Couldn't find Table in cache but treat as kFound if no_io set
@@ -569,6 +564,96 @@ Status TableCache::Get(const ReadOptions& options,
   return s;
 }
 
+void TableCache::MultiGet(const ReadOptions& options,
+                          const InternalKeyComparator& internal_comparator,
+                          const FileMetaData& file_meta,
+                          const DependenceMap& dependence_map, size_t num_keys,
+                          const Slice* keys, GetContext** get_contexts,
+                          Status* statuses,
+                          const SliceTransform* prefix_extractor,
+                          HistogramImpl* file_read_hist, bool skip_filters,
+                          int level) {
+  if (file_meta.prop.is_map_sst()) {
+    // Keys go to different link targets, forward one by one
+    for (size_t i = 0; i < num_keys; ++i) {
+      statuses[i] = Get(options, internal_comparator, file_meta,
+                        dependence_map, keys[i], get_contexts[i],
+                        prefix_extractor, file_read_hist, skip_filters, level);
+    }
+    return;
+  }
+  auto& fd = file_meta.fd;
+  Status s;
+  TableReader* t = fd.table_reader;
+  Cache::Handle* handle = nullptr;
+  if (t == nullptr) {
+    s = FindTable(env_options_, internal_comparator, fd, &handle,
+                  prefix_extractor,
+                  options.read_tier == kBlockCacheTier /* no_io */,
+                  true /* record_read_stats */, file_read_hist, skip_filters,
+                  level, true /* prefetch_index_and_filter_in_cache */);
+    if (s.ok()) {
+      t = GetTableReaderFromHandle(handle);
+    }
+  }
+  if (s.ok()) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      t->UpdateMaxCoveringTombstoneSeq(
+          options, ExtractUserKey(keys[i]),
+          get_contexts[i]->max_covering_tombstone_seq());
+    }
+    t->MultiGet(options, num_keys, keys, get_contexts, statuses,
+                prefix_extractor, skip_filters);
+  } else {
+    if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
+      // Couldn't find Table in cache but treat as kFound if no_io set
+      for (size_t i = 0; i < num_keys; ++i) {
+        get_contexts[i]->MarkKeyMayExist();
+      }
+      s = Status::OK();
+    }
+    for (size_t i = 0; i < num_keys; ++i) {
+      statuses[i] = s;
+    }
+  }
+  if (handle != nullptr) {
+    ReleaseHandle(handle);
+  }
+}
+
+Status TableCache::GetByLocation(
+    const ReadOptions& options,
+    const InternalKeyComparator& internal_comparator,
+    const FileMetaData& file_meta, const Slice& k, uint64_t location,
+    GetContext* get_context) {
+  if (file_meta.prop.is_map_sst()) {
+    return Status::NotSupported();
+  }
+  auto& fd = file_meta.fd;
+  Status s;
+  TableReader* t = fd.table_reader;
+  Cache::Handle* handle = nullptr;
+  if (t == nullptr) {
+    s = FindTable(env_options_, internal_comparator, fd, &handle, nullptr,
+                  options.read_tier == kBlockCacheTier /* no_io */,
+                  true /* record_read_stats */);
+    if (s.ok()) {
+      t = GetTableReaderFromHandle(handle);
+    }
+  }
+  if (s.ok()) {
+    s = t->GetByLocation(options, k, location, get_context);
+  } else if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
+    // Couldn't find Table in cache but treat as kFound if no_io set
+    get_context->MarkKeyMayExist();
+    s = Status::OK();
+  }
+  if (handle != nullptr) {
+    ReleaseHandle(handle);
+  }
+  return s;
+}
+
 Status TableCache::GetTableProperties(
     const EnvOptions& env_options,
     const InternalKeyComparator& internal_comparator,
@@ -609,7 +694,8 @@ size_t TableCache::GetMemoryUsageByTableReader(
   auto table_reader = fd.table_reader;
   // table already been pre-loaded?
   if (table_reader) {
-    return table_reader->ApproximateMemoryUsage();
+    return table_reader->ApproximateMemoryUsage() +
+           table_reader->MapSstElementIndexMemoryUsage();
   }
 
   Cache::Handle* table_handle = nullptr;
@@ -620,7 +706,8 @@ size_t TableCache::GetMemoryUsageByTableReader(
   }
   assert(table_handle);
   auto table = GetTableReaderFromHandle(table_handle);
-  auto ret = table->ApproximateMemoryUsage();
+  auto ret = table->ApproximateMemoryUsage() +
+             table->MapSstElementIndexMemoryUsage();
   ReleaseHandle(table_handle);
   return ret;
 }
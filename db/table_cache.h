@@ -77,6 +77,26 @@ class TableCache {
              HistogramImpl* file_read_hist = nullptr, bool skip_filters = false,
              int level = -1);
 
+  // Get() of each of keys[0, num_keys) with get_contexts[i] from one file,
+  // results go to statuses[i]. keys must be sorted by internal key. The table
+  // is looked up once and plain ssts get a batched TableReader::MultiGet().
+  void MultiGet(const ReadOptions& options,
+                const InternalKeyComparator& internal_comparator,
+                const FileMetaData& file_meta,
+                const DependenceMap& dependence_map, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                const SliceTransform* prefix_extractor = nullptr,
+                HistogramImpl* file_read_hist = nullptr,
+                bool skip_filters = false, int level = -1);
+
+  // Point lookup of "k" in a plain sst by a location recorded at build time,
+  // see TableReader::GetByLocation(). Returns NotSupported if the table can't
+  // do it, then caller should fall back to Get().
+  Status GetByLocation(const ReadOptions& options,
+                       const InternalKeyComparator& internal_comparator,
+                       const FileMetaData& file_meta, const Slice& k,
+                       uint64_t location, GetContext* get_context);
+
   // Evict any entry for the specified file number
   static void Evict(Cache* cache, uint64_t file_number);
 
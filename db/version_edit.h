@@ -74,15 +74,18 @@ struct FileDescriptor {
 };
 
 struct FileSampledStats {
-  FileSampledStats() : num_reads_sampled(0) {}
+  FileSampledStats() : num_reads_sampled(0), num_reads_decayed(0) {}
   FileSampledStats(const FileSampledStats& other) { *this = other; }
   FileSampledStats& operator=(const FileSampledStats& other) {
     num_reads_sampled = other.num_reads_sampled.load();
+    num_reads_decayed = other.num_reads_decayed.load();
     return *this;
   }
 
   // number of user reads to this file.
   mutable std::atomic<uint64_t> num_reads_sampled;
+  // part of num_reads_sampled no longer counted when ranking compactions.
+  mutable std::atomic<uint64_t> num_reads_decayed;
 };
 
 struct TablePropertyCache {
@@ -1228,10 +1228,13 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
       mutable_cf_options_(mutable_cf_options),
       version_number_(version_number) {}
 
+// context->data[1] packs user key size (low 32 bits) and value location + 1
+// (high 32 bits, 0 for none), see TransToCombined
 Status Version::fetch_buffer(LazyBuffer* buffer) const {
   auto context = get_context(buffer);
   Slice user_key(reinterpret_cast<const char*>(context->data[0]),
-                 context->data[1]);
+                 uint32_t(context->data[1]));
+  uint64_t location_plus_1 = context->data[1] >> 32;
   uint64_t sequence = context->data[2];
   auto pair = *reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
   bool value_found = false;
@@ -1242,10 +1245,19 @@ Status Version::fetch_buffer(LazyBuffer* buffer) const {
                          nullptr, nullptr, nullptr, env_, &context_seq);
   IterKey iter_key;
   iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
-  auto s = table_cache_->Get(
-      ReadOptions(), cfd_->internal_comparator(), *pair.second,
-      storage_info_.dependence_map(), iter_key.GetInternalKey(), &get_context,
-      mutable_cf_options_.prefix_extractor.get(), nullptr, true);
+  Status s = Status::NotSupported();
+  if (location_plus_1 != 0) {
+    s = table_cache_->GetByLocation(
+        ReadOptions(), cfd_->internal_comparator(), *pair.second,
+        iter_key.GetInternalKey(), location_plus_1 - 1, &get_context);
+  }
+  if (s.IsNotSupported()) {
+    s = table_cache_->Get(
+        ReadOptions(), cfd_->internal_comparator(), *pair.second,
+        storage_info_.dependence_map(), iter_key.GetInternalKey(),
+        &get_context, mutable_cf_options_.prefix_extractor.get(), nullptr,
+        true);
+  }
   if (!s.ok()) {
     return s;
   }
@@ -1276,13 +1288,21 @@ LazyBuffer Version::TransToCombined(const Slice& user_key, uint64_t sequence,
   auto find = dependence_map.find(file_number);
   if (find == dependence_map.end()) {
     return LazyBuffer(Status::Corruption("Separate value dependence missing"));
-  } else {
-    return LazyBuffer(
-        this,
-        {reinterpret_cast<uint64_t>(user_key.data()), user_key.size(), sequence,
-         reinterpret_cast<uint64_t>(&*find)},
-        Slice::Invalid(), find->second->fd.GetNumber());
   }
+  assert(user_key.size() <= port::kMaxUint32);
+  uint64_t key_size_and_location = user_key.size();
+  // Location is bound to the file it was recorded in, useless after GC
+  if (find->second->fd.GetNumber() == file_number) {
+    uint64_t location = SeparateHelper::DecodeLocation(value.slice());
+    if (location < port::kMaxUint32) {
+      key_size_and_location |= (location + 1) << 32;
+    }
+  }
+  return LazyBuffer(
+      this,
+      {reinterpret_cast<uint64_t>(user_key.data()), key_size_and_location,
+       sequence, reinterpret_cast<uint64_t>(&*find)},
+      Slice::Invalid(), find->second->fd.GetNumber());
 }
 
 void Version::Get(const ReadOptions& read_options, const Slice& user_key,
@@ -1403,6 +1423,217 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
   }
 }
 
+void Version::MultiGet(const ReadOptions& read_options, size_t num_keys,
+                       MultiGetKey* keys) {
+  enum KeyState { kSearching, kStopped, kDone };
+  std::deque<GetContext> get_contexts;
+  std::vector<KeyState> key_state(num_keys, kSearching);
+  // Keys still being searched, sorted by user key
+  std::vector<size_t> active(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    auto& key = keys[i];
+    assert(key.status->ok() || key.status->IsMergeInProgress());
+    get_contexts.emplace_back(
+        user_comparator(), merge_operator_, info_log_, db_statistics_,
+        key.status->ok() ? GetContext::kNotFound : GetContext::kMerge,
+        key.user_key, key.value, nullptr, key.merge_context, this,
+        key.max_covering_tombstone_seq, this->env_);
+    active[i] = i;
+  }
+  auto ucmp = user_comparator();
+  std::stable_sort(active.begin(), active.end(), [&](size_t a, size_t b) {
+    return ucmp->Compare(keys[a].user_key, keys[b].user_key) < 0;
+  });
+
+  auto searching = [&](size_t i) {
+    if (key_state[i] != kSearching) {
+      return false;
+    }
+    if (get_contexts[i].is_finished()) {
+      // The remaining files will only contain covered keys
+      key_state[i] = kStopped;
+      return false;
+    }
+    return true;
+  };
+
+  std::vector<size_t> batch;
+  std::vector<Slice> batch_keys;
+  std::vector<GetContext*> batch_contexts;
+  std::vector<Status> batch_status;
+  auto probe = [&](FdWithKeyRange* f, int level, bool is_last_in_level) {
+    if (batch.empty()) {
+      return;
+    }
+    batch_keys.clear();
+    batch_contexts.clear();
+    for (auto i : batch) {
+      batch_keys.emplace_back(keys[i].lkey->internal_key());
+      batch_contexts.emplace_back(&get_contexts[i]);
+      if (get_contexts[i].sample()) {
+        sample_file_read_inc(f->file_metadata);
+      }
+    }
+    batch_status.assign(batch.size(), Status());
+
+    bool timer_enabled =
+        GetPerfLevel() >= PerfLevel::kEnableTimeExceptForMutex &&
+        get_perf_context()->per_level_perf_context_enabled;
+    StopWatchNano timer(env_, timer_enabled /* auto_start */);
+    table_cache_->MultiGet(
+        read_options, *internal_comparator(), *f->file_metadata,
+        storage_info_.dependence_map(), batch.size(), batch_keys.data(),
+        batch_contexts.data(), batch_status.data(),
+        mutable_cf_options_.prefix_extractor.get(),
+        cfd_->internal_stats()->GetFileReadHist(level),
+        IsFilterSkipped(level, is_last_in_level), level);
+    if (timer_enabled) {
+      PERF_COUNTER_BY_LEVEL_ADD(get_from_table_nanos, timer.ElapsedNanos(),
+                                level);
+    }
+
+    for (size_t b = 0; b < batch.size(); ++b) {
+      size_t i = batch[b];
+      auto& get_context = get_contexts[i];
+      if (!batch_status[b].ok()) {
+        *keys[i].status = std::move(batch_status[b]);
+        key_state[i] = kDone;
+        continue;
+      }
+      if (get_context.State() != GetContext::kNotFound &&
+          get_context.State() != GetContext::kMerge &&
+          db_statistics_ != nullptr) {
+        get_context.ReportCounters();
+      }
+      switch (get_context.State()) {
+        case GetContext::kNotFound:
+        case GetContext::kMerge:
+          // Keep searching in other files
+          break;
+        case GetContext::kFound:
+          if (level == 0) {
+            RecordTick(db_statistics_, GET_HIT_L0);
+          } else if (level == 1) {
+            RecordTick(db_statistics_, GET_HIT_L1);
+          } else {
+            RecordTick(db_statistics_, GET_HIT_L2_AND_UP);
+          }
+          PERF_COUNTER_BY_LEVEL_ADD(user_key_return_count, 1, level);
+          key_state[i] = kDone;
+          break;
+        case GetContext::kDeleted:
+          *keys[i].status = Status::NotFound();
+          key_state[i] = kDone;
+          break;
+        case GetContext::kCorrupt:
+          *keys[i].status = std::move(get_context).CorruptReason();
+          key_state[i] = kDone;
+          break;
+      }
+    }
+    batch.clear();
+  };
+
+  auto key_less = [&](size_t i, const Slice& user_key) {
+    return ucmp->Compare(keys[i].user_key, user_key) < 0;
+  };
+  auto& level_files_brief = storage_info_.level_files_brief_;
+  for (int level = 0;
+       level < storage_info_.num_non_empty_levels_ && !active.empty();
+       ++level) {
+    auto& files = level_files_brief[level];
+    if (level == 0) {
+      // Files overlap, newest first. Probe each with the keys in its range
+      for (size_t j = 0; j < files.num_files; ++j) {
+        FdWithKeyRange* f = &files.files[j];
+        Slice largest = ExtractUserKey(f->largest_key);
+        for (auto it = std::lower_bound(active.begin(), active.end(),
+                                        ExtractUserKey(f->smallest_key),
+                                        key_less);
+             it != active.end() &&
+             ucmp->Compare(keys[*it].user_key, largest) <= 0;
+             ++it) {
+          if (searching(*it)) {
+            batch.push_back(*it);
+          }
+        }
+        probe(f, level, j + 1 == files.num_files);
+      }
+    } else {
+      // Files are sorted and disjoint, walk them along with the keys
+      auto it = active.begin();
+      size_t j = 0;
+      while (it != active.end()) {
+        const Slice& user_key = keys[*it].user_key;
+        j = std::lower_bound(files.files + j, files.files + files.num_files,
+                             user_key,
+                             [&](const FdWithKeyRange& file, const Slice& k) {
+                               return ucmp->Compare(
+                                          ExtractUserKey(file.largest_key),
+                                          k) < 0;
+                             }) -
+            files.files;
+        if (j == files.num_files) {
+          break;
+        }
+        FdWithKeyRange* f = &files.files[j];
+        Slice smallest = ExtractUserKey(f->smallest_key);
+        Slice largest = ExtractUserKey(f->largest_key);
+        while (it != active.end() && key_less(*it, smallest)) {
+          ++it;
+        }
+        auto first = it;
+        for (; it != active.end() &&
+               ucmp->Compare(keys[*it].user_key, largest) <= 0;
+             ++it) {
+          if (searching(*it)) {
+            batch.push_back(*it);
+          }
+        }
+        probe(f, level, j + 1 == files.num_files);
+        // A user key equal to the largest one may continue in the next file
+        while (it != first &&
+               ucmp->Compare(keys[*(it - 1)].user_key, largest) == 0) {
+          --it;
+        }
+        ++j;
+      }
+    }
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [&](size_t i) {
+                                  return key_state[i] != kSearching;
+                                }),
+                 active.end());
+  }
+
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (key_state[i] == kDone) {
+      continue;
+    }
+    auto& key = keys[i];
+    auto& get_context = get_contexts[i];
+    if (db_statistics_ != nullptr) {
+      get_context.ReportCounters();
+    }
+    if (GetContext::kMerge == get_context.State()) {
+      if (!merge_operator_) {
+        *key.status = Status::InvalidArgument(
+            "merge_operator is not properly initialized.");
+        continue;
+      }
+      *key.status = MergeHelper::TimedFullMerge(
+          merge_operator_, key.user_key, nullptr,
+          key.merge_context->GetOperands(), key.value, info_log_,
+          db_statistics_, env_, true);
+      if (key.status->ok()) {
+        key.value->pin(LazyBufferPinLevel::Internal);
+      }
+    } else {
+      *key.status = Status::NotFound();
+    }
+  }
+}
+
 void Version::GetKey(const Slice& user_key, const Slice& ikey, Status* status,
                      ValueType* type, SequenceNumber* seq, LazyBuffer* value) {
   bool value_found;
@@ -1448,6 +1679,236 @@ void Version::GetKey(const Slice& user_key, const Slice& ikey, Status* status,
   *status = Status::NotFound();
 }
 
+SortedKeyGetter::SortedKeyGetter(Version* version,
+                                 const EnvOptions& env_options,
+                                 uint64_t max_sequential_skip)
+    : SortedKeyGetter(
+          version->cfd()->internal_comparator(),
+          [version, &env_options](Arena* arena) {
+            ReadOptions read_options;
+            read_options.verify_checksums = true;
+            read_options.fill_cache = false;
+            read_options.total_order_seek = true;
+            MergeIteratorBuilder builder(
+                &version->cfd()->internal_comparator(), arena);
+            auto vstorage = version->storage_info();
+            for (int level = 0; level < vstorage->num_non_empty_levels();
+                 ++level) {
+              version->AddIteratorsForLevel(read_options, env_options,
+                                            &builder, level,
+                                            nullptr /* range_del_agg */);
+            }
+            return builder.Finish();
+          },
+          max_sequential_skip) {}
+
+SortedKeyGetter::SortedKeyGetter(const InternalKeyComparator& icmp,
+                                 CreateIterCallback create_iter,
+                                 uint64_t max_sequential_skip)
+    : icmp_(icmp),
+      create_iter_(std::move(create_iter)),
+      max_sequential_skip_(max_sequential_skip),
+      num_next_(0),
+      num_seek_(0) {}
+
+void SortedKeyGetter::Init() { iter_.set(create_iter_(&arena_)); }
+
+void SortedKeyGetter::GetKey(const Slice& user_key, const Slice& ikey,
+                             Status* status, ValueType* type,
+                             SequenceNumber* seq, LazyBuffer* value) {
+  if (iter_.get() == nullptr) {
+    Init();
+    iter_->Seek(ikey);
+    ++num_seek_;
+  } else if (icmp_.Compare(ikey, last_ikey_) < 0) {
+    iter_->Seek(ikey);
+    ++num_seek_;
+  } else {
+    // The scan stays on the first entry >= last key, if it's already beyond
+    // the target, it is the first entry >= target as well
+    uint64_t skip = 0;
+    while (iter_->Valid() && icmp_.Compare(iter_->key(), ikey) < 0) {
+      if (skip++ >= max_sequential_skip_) {
+        iter_->Seek(ikey);
+        ++num_seek_;
+        break;
+      }
+      iter_->Next();
+      ++num_next_;
+    }
+  }
+  last_ikey_.assign(ikey.data(), ikey.size());
+
+  if (!iter_->Valid()) {
+    *status = iter_->status();
+    if (status->ok()) {
+      *status = Status::NotFound();
+    }
+    return;
+  }
+  ParsedInternalKey found;
+  if (!ParseInternalKey(iter_->key(), &found)) {
+    *status = Status::Corruption("Invalid InternalKey");
+    return;
+  }
+  if (icmp_.user_comparator()->Compare(found.user_key, user_key) != 0) {
+    *status = Status::NotFound();
+    return;
+  }
+  switch (found.type) {
+    case kTypeValue:
+    case kTypeValueIndex:
+    case kTypeMerge:
+    case kTypeMergeIndex:
+      *status = Status::OK();
+      *type = found.type;
+      *seq = found.sequence;
+      *value = iter_->value();
+      return;
+    default:
+      *status = Status::NotFound();
+      return;
+  }
+}
+
+std::unique_ptr<SeparateHelper> Version::NewSequentialHelper(
+    const ReadOptions& read_options) const {
+  if (read_options.blob_readahead_files == 0) {
+    return nullptr;
+  }
+  return std::unique_ptr<SeparateHelper>(new BlobSequentialReader(
+      cfd_, storage_info_.dependence_map(), env_options_, read_options,
+      read_options.blob_readahead_files,
+      mutable_cf_options_.max_sequential_skip_in_iterations));
+}
+
+BlobSequentialReader::BlobSequentialReader(ColumnFamilyData* cfd,
+                                           const DependenceMap& dependence_map,
+                                           const EnvOptions& env_options,
+                                           const ReadOptions& read_options,
+                                           size_t max_files,
+                                           uint64_t max_sequential_skip)
+    : cfd_(cfd),
+      dependence_map_(dependence_map),
+      env_options_(env_options),
+      icmp_(cfd->internal_comparator()),
+      read_options_(read_options),
+      max_files_(max_files),
+      max_sequential_skip_(max_sequential_skip),
+      use_count_(0),
+      num_next_(0),
+      num_seek_(0) {
+  assert(max_files_ > 0);
+  read_options_.total_order_seek = true;
+  read_options_.iterate_lower_bound = nullptr;
+  read_options_.iterate_upper_bound = nullptr;
+  scans_.reserve(max_files_);
+}
+
+BlobSequentialReader::~BlobSequentialReader() {
+  for (auto& scan : scans_) {
+    delete scan.iter;
+  }
+}
+
+LazyBuffer BlobSequentialReader::TransToCombined(
+    const Slice& user_key, uint64_t sequence, const LazyBuffer& value) const {
+  auto s = value.fetch();
+  if (!s.ok()) {
+    return LazyBuffer(std::move(s));
+  }
+  uint64_t file_number = SeparateHelper::DecodeFileNumber(value.slice());
+  auto find = dependence_map_.find(file_number);
+  if (find == dependence_map_.end()) {
+    return LazyBuffer(Status::Corruption("Separate value dependence missing"));
+  }
+  return LazyBuffer(
+      this,
+      {reinterpret_cast<uint64_t>(user_key.data()), user_key.size(), sequence,
+       reinterpret_cast<uint64_t>(find->second)},
+      Slice::Invalid(), find->second->fd.GetNumber());
+}
+
+BlobSequentialReader::Scan* BlobSequentialReader::GetScan(
+    const FileMetaData& f) const {
+  Scan* lru = nullptr;
+  for (auto& scan : scans_) {
+    if (scan.file_number == f.fd.GetNumber()) {
+      scan.last_use = ++use_count_;
+      return &scan;
+    }
+    if (lru == nullptr || scan.last_use < lru->last_use) {
+      lru = &scan;
+    }
+  }
+  if (scans_.size() < max_files_) {
+    scans_.emplace_back();
+    lru = &scans_.back();
+  } else {
+    delete lru->iter;
+  }
+  lru->file_number = f.fd.GetNumber();
+  lru->iter = cfd_->table_cache()->NewIterator(
+      read_options_, env_options_, icmp_, f, dependence_map_,
+      nullptr /* range_del_agg */, nullptr /* prefix_extractor */);
+  lru->last_ikey.clear();
+  lru->last_use = ++use_count_;
+  return lru;
+}
+
+Status BlobSequentialReader::fetch_buffer(LazyBuffer* buffer) const {
+  auto context = get_context(buffer);
+  Slice user_key(reinterpret_cast<const char*>(context->data[0]),
+                 context->data[1]);
+  uint64_t sequence = context->data[2];
+  auto f = reinterpret_cast<const FileMetaData*>(context->data[3]);
+  Scan* scan = GetScan(*f);
+  InternalIterator* iter = scan->iter;
+
+  IterKey iter_key;
+  iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
+  Slice ikey = iter_key.GetInternalKey();
+  if (scan->last_ikey.empty() || icmp_.Compare(ikey, scan->last_ikey) < 0) {
+    iter->Seek(ikey);
+    ++num_seek_;
+  } else {
+    // Same as SortedKeyGetter, the scan stays on the first entry >= last key
+    uint64_t skip = 0;
+    while (iter->Valid() && icmp_.Compare(iter->key(), ikey) < 0) {
+      if (skip++ >= max_sequential_skip_) {
+        iter->Seek(ikey);
+        ++num_seek_;
+        break;
+      }
+      iter->Next();
+      ++num_next_;
+    }
+  }
+  scan->last_ikey.assign(ikey.data(), ikey.size());
+
+  ParsedInternalKey found;
+  if (!iter->Valid() || !ParseInternalKey(iter->key(), &found) ||
+      found.sequence != sequence ||
+      icmp_.user_comparator()->Compare(found.user_key, user_key) != 0) {
+    auto s = iter->status();
+    if (!s.ok()) {
+      return s;
+    }
+    char buf[128];
+    snprintf(buf, sizeof buf,
+             "file number = %" PRIu64 ", sequence = %" PRIu64,
+             f->fd.GetNumber(), sequence);
+    return Status::Corruption("Separate value missing", buf);
+  }
+  LazyBuffer value = iter->value();
+  auto s = value.fetch();
+  if (!s.ok()) {
+    return s;
+  }
+  buffer->reset(value.slice(), true, f->fd.GetNumber());
+  return Status::OK();
+}
+
 bool Version::IsFilterSkipped(int level, bool is_file_last_in_level) {
   // Reaching the bottom level implies misses at all upper levels, so we'll
   // skip checking the filters when we predict a hit.
@@ -1961,6 +2422,7 @@ uint64_t VersionStorageInfo::FileSizeWithBlob(const FileMetaData* f,
 // 7. GenerateBottommostFiles();
 void VersionStorageInfo::SetFinalized() {
   finalized_ = true;
+  dependence_map_.Finalize();
 #ifndef NDEBUG
   if (compaction_style_ != kCompactionStyleLevel) {
     // Not level based compaction.
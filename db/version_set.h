@@ -20,6 +20,7 @@
 #pragma once
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
@@ -45,6 +46,8 @@
 #include "options/db_options.h"
 #include "port/port.h"
 #include "rocksdb/env.h"
+#include "table/scoped_arena_iterator.h"
+#include "util/arena.h"
 
 namespace rocksdb {
 
@@ -653,6 +656,23 @@ class Version : public SeparateHelper, private LazyBufferState {
            bool* value_found = nullptr, bool* key_exists = nullptr,
            SequenceNumber* seq = nullptr, ReadCallback* callback = nullptr);
 
+  // One key of MultiGet(), fields are the same as the arguments of Get()
+  struct MultiGetKey {
+    Slice user_key;
+    const LookupKey* lkey;
+    LazyBuffer* value;
+    Status* status;
+    MergeContext* merge_context;
+    SequenceNumber* max_covering_tombstone_seq;
+  };
+
+  // Same as Get() on each key, but keys are sorted once and walked through
+  // the levels together, so each file is looked up once and gets all keys
+  // that may be in it in one TableCache::MultiGet().
+  //
+  // REQUIRES: lock is not held
+  void MultiGet(const ReadOptions&, size_t num_keys, MultiGetKey* keys);
+
   void GetKey(const Slice& user_key, const Slice& ikey, Status* status,
               ValueType* type, SequenceNumber* seq, LazyBuffer* value);
 
@@ -800,11 +820,109 @@ class Version : public SeparateHelper, private LazyBufferState {
   LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                              const LazyBuffer& value) const override;
 
+  std::unique_ptr<SeparateHelper> NewSequentialHelper(
+      const ReadOptions& read_options) const override;
+
   // No copying allowed
   Version(const Version&);
   void operator=(const Version&);
 };
 
+// Resolves a stream of point lookups with the same semantics as
+// Version::GetKey. Keys are expected in ascending internal key order, e.g. the
+// records of blob SSTs under garbage collection, so that they can share one
+// merged forward scan over all levels instead of a FilePicker walk per key.
+// Close keys are reached with Next(), distant keys with Seek(). Keys out of
+// order are still answered correctly, they just cost a Seek().
+class SortedKeyGetter {
+ public:
+  SortedKeyGetter(Version* version, const EnvOptions& env_options,
+                  uint64_t max_sequential_skip);
+
+  // Scans the merged iterator returned by create_iter instead of the levels of
+  // a Version, e.g. the read-only LSM view shipped to a compaction worker
+  typedef std::function<InternalIterator*(Arena*)> CreateIterCallback;
+  SortedKeyGetter(const InternalKeyComparator& icmp,
+                  CreateIterCallback create_iter,
+                  uint64_t max_sequential_skip);
+
+  // REQUIRES: the previous returned value is no longer used, it's pinned by
+  // the scan position
+  void GetKey(const Slice& user_key, const Slice& ikey, Status* status,
+              ValueType* type, SequenceNumber* seq, LazyBuffer* value);
+
+  uint64_t num_next() const { return num_next_; }
+  uint64_t num_seek() const { return num_seek_; }
+
+ private:
+  void Init();
+
+  const InternalKeyComparator& icmp_;
+  CreateIterCallback create_iter_;
+  uint64_t max_sequential_skip_;
+  Arena arena_;
+  ScopedArenaIterator iter_;
+  std::string last_ikey_;
+  uint64_t num_next_;
+  uint64_t num_seek_;
+
+  // No copying allowed
+  SortedKeyGetter(const SortedKeyGetter&) = delete;
+  void operator=(const SortedKeyGetter&) = delete;
+};
+
+// SeparateHelper of Version::NewSequentialHelper. Keeps a forward scan open
+// on each of the latest max_files blob SSTs it read from, values of close keys
+// come from the same data block, block reads are sequential and take the
+// readahead of the table iterator. Each fetched value is copied out of the
+// scan. Values out of order are still answered correctly, they just cost a
+// Seek().
+class BlobSequentialReader : public SeparateHelper, private LazyBufferState {
+ public:
+  BlobSequentialReader(ColumnFamilyData* cfd,
+                       const DependenceMap& dependence_map,
+                       const EnvOptions& env_options,
+                       const ReadOptions& read_options, size_t max_files,
+                       uint64_t max_sequential_skip);
+  ~BlobSequentialReader();
+
+  LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
+                             const LazyBuffer& value) const override;
+
+  uint64_t num_next() const { return num_next_; }
+  uint64_t num_seek() const { return num_seek_; }
+
+ private:
+  struct Scan {
+    uint64_t file_number;
+    InternalIterator* iter;
+    std::string last_ikey;
+    uint64_t last_use;
+  };
+
+  void destroy(LazyBuffer* /*buffer*/) const override {}
+
+  Status fetch_buffer(LazyBuffer* buffer) const override;
+
+  Scan* GetScan(const FileMetaData& f) const;
+
+  ColumnFamilyData* cfd_;
+  const DependenceMap& dependence_map_;
+  const EnvOptions& env_options_;
+  const InternalKeyComparator& icmp_;
+  ReadOptions read_options_;
+  size_t max_files_;
+  uint64_t max_sequential_skip_;
+  mutable std::vector<Scan> scans_;
+  mutable uint64_t use_count_;
+  mutable uint64_t num_next_;
+  mutable uint64_t num_seek_;
+
+  // No copying allowed
+  BlobSequentialReader(const BlobSequentialReader&) = delete;
+  void operator=(const BlobSequentialReader&) = delete;
+};
+
 struct ObsoleteFileInfo {
   FileMetaData* metadata;
   std::string path;
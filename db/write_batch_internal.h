@@ -182,6 +182,27 @@ class WriteBatchInternal {
                            bool seq_per_batch = false, size_t batch_cnt = 0,
                            bool batch_per_txn = true);
 
+  // Inserts the records of writer->batch in the byte range [begin, end)
+  // into the memtables, concurrently with other writers. The first record
+  // gets `sequence`, which the range must not share with other batches.
+  static Status InsertInto(WriteThread::Writer* writer, size_t begin,
+                           size_t end, SequenceNumber sequence,
+                           ColumnFamilyMemTables* memtables,
+                           FlushScheduler* flush_scheduler, DB* db);
+
+  // Iterates the records of the byte range [begin, end) of `wb`, which must
+  // start and end at record boundaries. The record count is only checked
+  // if the range covers the whole batch.
+  static Status Iterate(const WriteBatch* wb, WriteBatch::Handler* handler,
+                        size_t begin, size_t end);
+
+  // Splits `b` into ranges of at most `count` keys, each consuming one
+  // sequence number. Appends the byte offset where each range starts to
+  // `offsets`, followed by the end of the batch. Returns false if the
+  // batch holds transaction markers, whose records depend on each other.
+  static bool Split(const WriteBatch* b, size_t count,
+                    std::vector<size_t>* offsets);
+
   static Status Append(WriteBatch* dst, const WriteBatch* src,
                        const bool WAL_only = false);
 
@@ -426,6 +426,40 @@ TEST_F(WriteBatchTest, PrepareCommit) {
       handler.seen);
 }
 
+TEST_F(WriteBatchTest, Split) {
+  WriteBatch batch;
+  batch.Put(Slice("k1"), Slice("v1"));
+  batch.PutLogData(Slice("blob"));
+  batch.Delete(Slice("k2"));
+  batch.Put(Slice("k3"), Slice("v3"));
+  batch.Merge(Slice("k4"), Slice("v4"));
+  batch.SingleDelete(Slice("k5"));
+
+  std::vector<size_t> offsets;
+  ASSERT_TRUE(WriteBatchInternal::Split(&batch, 2, &offsets));
+  ASSERT_EQ(4, offsets.size());
+  ASSERT_EQ(size_t{WriteBatchInternal::kHeader}, offsets.front());
+  ASSERT_EQ(WriteBatchInternal::ByteSize(&batch), offsets.back());
+
+  std::string seen;
+  for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+    TestHandler handler;
+    ASSERT_OK(WriteBatchInternal::Iterate(&batch, &handler, offsets[i],
+                                          offsets[i + 1]));
+    seen += handler.seen + "|";
+  }
+  ASSERT_EQ(
+      "Put(k1, v1)LogData(blob)Delete(k2)|"
+      "Put(k3, v3)Merge(k4, v4)|"
+      "SingleDelete(k5)|",
+      seen);
+
+  // Transaction markers keep the batch whole
+  WriteBatchInternal::MarkCommit(&batch, Slice("xid1"));
+  offsets.clear();
+  ASSERT_FALSE(WriteBatchInternal::Split(&batch, 2, &offsets));
+}
+
 // It requires more than 30GB of memory to run the test. With single memory
 // allocation of more than 30GB.
 // Not all platform can run it. Also it runs a long time. So disable it.
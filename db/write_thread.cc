@@ -587,6 +587,14 @@ bool WriteThread::CompleteParallelMemTableWriter(Writer* w) {
     return false;
   }
   // else we're the last parallel worker and should perform exit duties.
+  for (auto& range : write_group->ranges) {
+    if (!range.status.ok()) {
+      range.writer->status = range.status;
+      if (write_group->status.ok()) {
+        write_group->status = range.status;
+      }
+    }
+  }
   w->status = write_group->status;
   return true;
 }
@@ -595,9 +603,8 @@ void WriteThread::ExitAsBatchGroupFollower(Writer* w) {
   auto* write_group = w->write_group;
 
   assert(w->state == STATE_PARALLEL_MEMTABLE_WRITER);
-  assert(write_group->status.ok());
+  // write_group->status holds memtable insert errors, e.g. of split ranges
   ExitAsBatchGroupLeader(*write_group, write_group->status);
-  assert(w->status.ok());
   assert(w->state == STATE_COMPLETED);
   SetState(write_group->leader, STATE_COMPLETED);
 }
@@ -83,6 +83,24 @@ class WriteThread {
     std::atomic<size_t> running;
     size_t size = 0;
 
+    // Records of the batches of a parallel memtable write group, set by the
+    // leader when some batch is larger than
+    // DBOptions::memtable_insert_split_size. The parallel memtable writers
+    // claim them through next_range instead of inserting their own batch.
+    struct BatchRange {
+      Writer* writer;
+      // byte offsets of the records in writer->batch
+      size_t begin;
+      size_t end;
+      // the sequence number of the first record
+      SequenceNumber sequence;
+      // set by the writer which inserted the range, passed to the owner
+      // writer and the group by the last parallel writer
+      Status status;
+    };
+    std::vector<BatchRange> ranges;
+    std::atomic<size_t> next_range{0};
+
     struct Iterator {
       Writer* writer;
       Writer* last_writer;
@@ -118,6 +136,7 @@ class WriteThread {
     bool no_slowdown;
     bool disable_wal;
     bool disable_memtable;
+    bool ignore_missing_column_families;
     size_t batch_cnt;  // if non-zero, number of sub-batches in the write batch
     PreReleaseCallback* pre_release_callback;
     uint64_t log_used;  // log number that this batch was inserted into
@@ -141,6 +160,7 @@ class WriteThread {
           no_slowdown(false),
           disable_wal(false),
           disable_memtable(false),
+          ignore_missing_column_families(false),
           batch_cnt(0),
           pre_release_callback(nullptr),
           log_used(0),
@@ -162,6 +182,8 @@ class WriteThread {
           no_slowdown(write_options.no_slowdown),
           disable_wal(write_options.disableWAL),
           disable_memtable(_disable_memtable),
+          ignore_missing_column_families(
+              write_options.ignore_missing_column_families),
           batch_cnt(_batch_cnt),
           pre_release_callback(_pre_release_callback),
           log_used(0),
@@ -1179,6 +1179,112 @@ class TestLogger : public Logger {
   int char_0_count;
 };
 
+TEST_P(EnvPosixTestWithParam, MultiRead) {
+  EnvOptions soptions;
+  soptions.use_direct_reads = soptions.use_direct_writes = direct_io_;
+  std::string fname = test::PerThreadDBPath(env_, "testfile");
+
+  const size_t kSectorSize = 4096;
+  // More than the io_uring queue depth
+  const size_t kNumSectors = 300;
+
+  // Create file.
+  {
+    std::unique_ptr<WritableFile> wfile;
+#if !defined(OS_MACOSX) && !defined(OS_WIN) && !defined(OS_SOLARIS) && \
+    !defined(OS_AIX)
+    if (soptions.use_direct_writes) {
+      soptions.use_direct_writes = false;
+    }
+#endif
+    ASSERT_OK(env_->NewWritableFile(fname, &wfile, soptions));
+    for (size_t i = 0; i < kNumSectors; ++i) {
+      auto data = NewAligned(kSectorSize, static_cast<char>(i + 1));
+      ASSERT_OK(wfile->Append(Slice(data.get(), kSectorSize)));
+    }
+    ASSERT_OK(wfile->Close());
+  }
+
+#if !defined(OS_MACOSX) && !defined(OS_WIN) && !defined(OS_SOLARIS) && \
+    !defined(OS_AIX)
+  if (soptions.use_direct_reads) {
+    soptions.use_direct_reads = false;
+  }
+#endif
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname, &file, soptions));
+
+  // Every sector once in reverse order, the last request runs past the end of
+  // file
+  auto prepare = [&](std::vector<std::unique_ptr<char, Deleter>>* scratches,
+                     std::vector<ReadRequest>* reqs) {
+    reqs->resize(kNumSectors);
+    for (size_t i = 0; i < kNumSectors; ++i) {
+      size_t sector = kNumSectors - 1 - i;
+      size_t len = sector == kNumSectors - 1 ? kSectorSize * 2 : kSectorSize;
+      scratches->emplace_back(NewAligned(len, 0));
+      (*reqs)[i].offset = sector * kSectorSize;
+      (*reqs)[i].len = len;
+      (*reqs)[i].scratch = scratches->back().get();
+    }
+  };
+  auto multi_read = [&]() {
+    std::vector<std::unique_ptr<char, Deleter>> scratches;
+    std::vector<ReadRequest> reqs;
+    prepare(&scratches, &reqs);
+    ASSERT_OK(file->MultiRead(reqs.data(), reqs.size()));
+    for (size_t i = 0; i < kNumSectors; ++i) {
+      size_t sector = kNumSectors - 1 - i;
+      ASSERT_OK(reqs[i].status);
+      ASSERT_EQ(kSectorSize, reqs[i].result.size());
+      auto expect = NewAligned(kSectorSize, static_cast<char>(sector + 1));
+      ASSERT_EQ(0, memcmp(expect.get(), reqs[i].result.data(), kSectorSize));
+    }
+  };
+  multi_read();
+
+  // A failed submission waits for the reads already in flight, the next call
+  // on this thread doesn't see their completions
+  int num_submits = 0;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "PosixRandomAccessFile::MultiRead:Submit", [&](void* arg) {
+        if (++num_submits == 2) {
+          *static_cast<int*>(arg) = EBADF;
+        }
+      });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  {
+    std::vector<std::unique_ptr<char, Deleter>> scratches;
+    std::vector<ReadRequest> reqs;
+    prepare(&scratches, &reqs);
+    Status s = file->MultiRead(reqs.data(), reqs.size());
+    if (num_submits > 0) {
+      ASSERT_TRUE(s.IsIOError());
+    }
+  }
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+  multi_read();
+
+  // Same results when the ring can't be set up on a new thread, the setup is
+  // tried once per thread
+  int num_inits = 0;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "GetThreadLocalIOUring:Init", [&](void* arg) {
+        ++num_inits;
+        *static_cast<int*>(arg) = ENOMEM;
+      });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  std::thread fallback([&] {
+    multi_read();
+    multi_read();
+  });
+  fallback.join();
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_LE(num_inits, 1);
+}
+
 TEST_P(EnvPosixTestWithParam, LogBufferTest) {
   TestLogger test_logger;
   test_logger.SetInfoLogLevel(InfoLogLevel::INFO_LEVEL);
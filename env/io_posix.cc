@@ -14,6 +14,8 @@
 #include <fcntl.h>
 
 #include <algorithm>
+#include <atomic>
+#include <vector>
 #if defined(OS_LINUX)
 #include <linux/fs.h>
 #endif
@@ -30,6 +32,10 @@
 #include <sys/syscall.h>
 #include <sys/sysmacros.h>
 #endif
+#ifdef ROCKSDB_IOURING_PRESENT
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#endif
 #ifdef WITH_TERARK_ZIP
 #include <terark/thread/fiber_aio.hpp>
 #endif
@@ -41,6 +47,7 @@
 #include "util/coding.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
+#include "util/thread_local.h"
 
 #if defined(OS_LINUX) && !defined(F_SET_RW_HINT)
 #define F_LINUX_SPECIFIC_BASE 1024
@@ -372,6 +379,233 @@ static Status PosixFsRead(uint64_t offset, size_t n, Slice* result,
   return s;
 }  // namespace rocksdb
 
+#ifdef ROCKSDB_IOURING_PRESENT
+namespace {
+
+// A minimal io_uring driven through the raw syscalls, so liburing is not
+// needed. Every thread owns its ring, so none of this is synchronized.
+class IOUring {
+ public:
+  static const unsigned kQueueDepth = 256;
+
+  IOUring() = default;
+  ~IOUring();
+
+  // Returns 0 on success, otherwise the errno of the failed setup
+  int Init();
+
+  // False if Init() failed, the ring is kept so the thread doesn't retry
+  bool ok() const { return sqes_ != nullptr; }
+
+  unsigned queue_depth() const { return sq_entries_; }
+
+  // Queue a readv of iov at offset, the caller keeps at most queue_depth()
+  // reads in flight
+  void PrepareRead(int fd, struct iovec* iov, uint64_t offset,
+                   uint64_t user_data);
+
+  // Submit queued reads and wait for at least one completion
+  int SubmitAndWait();
+
+  // Drop queued reads the kernel hasn't taken yet, returns how many
+  unsigned DiscardUnsubmitted();
+
+  // Wait for at least one completion without submitting
+  int Wait();
+
+  // Returns false if no completion is ready
+  bool PopCompletion(uint64_t* user_data, int32_t* res);
+
+ private:
+  int ring_fd_ = -1;
+  void* sq_ptr_ = MAP_FAILED;
+  size_t sq_size_ = 0;
+  void* cq_ptr_ = MAP_FAILED;
+  size_t cq_size_ = 0;
+  void* sqes_ptr_ = MAP_FAILED;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  struct io_uring_sqe* sqes_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  struct io_uring_cqe* cqes_ = nullptr;
+  unsigned sq_entries_ = 0;
+  unsigned to_submit_ = 0;
+};
+
+IOUring::~IOUring() {
+  if (sqes_ptr_ != MAP_FAILED) {
+    munmap(sqes_ptr_, sqes_size_);
+  }
+  if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+    munmap(cq_ptr_, cq_size_);
+  }
+  if (sq_ptr_ != MAP_FAILED) {
+    munmap(sq_ptr_, sq_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+int IOUring::Init() {
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, kQueueDepth, &p));
+  if (fd < 0) {
+    return errno;
+  }
+  ring_fd_ = fd;
+  sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+  }
+  sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    return errno;
+  }
+  if (single_mmap) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      return errno;
+    }
+  }
+  sqes_size_ = p.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ptr_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes_ptr_ == MAP_FAILED) {
+    return errno;
+  }
+  char* sq = static_cast<char*>(sq_ptr_);
+  char* cq = static_cast<char*>(cq_ptr_);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes_ptr_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + p.cq_off.cqes);
+  sq_entries_ = p.sq_entries;
+  return 0;
+}
+
+void IOUring::PrepareRead(int fd, struct iovec* iov, uint64_t offset,
+                          uint64_t user_data) {
+  // Only this thread writes the tail, the kernel consumes every queued
+  // entry in io_uring_enter()
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(iov);
+  sqe->len = 1;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  ++to_submit_;
+}
+
+int IOUring::SubmitAndWait() {
+  int r;
+  do {
+    r = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit_, 1,
+                                 IORING_ENTER_GETEVENTS, nullptr, 0));
+  } while (r < 0 && (errno == EINTR || errno == EAGAIN));
+  if (r > 0) {
+    to_submit_ -= std::min(to_submit_, static_cast<unsigned>(r));
+  }
+  return r < 0 ? errno : 0;
+}
+
+unsigned IOUring::DiscardUnsubmitted() {
+  // A failed io_uring_enter() submitted nothing, the kernel never read the
+  // entries past its head, so the tail can be moved back
+  unsigned n = to_submit_;
+  __atomic_store_n(sq_tail_, *sq_tail_ - n, __ATOMIC_RELEASE);
+  to_submit_ = 0;
+  return n;
+}
+
+int IOUring::Wait() {
+  int r;
+  do {
+    r = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                                 IORING_ENTER_GETEVENTS, nullptr, 0));
+  } while (r < 0 && (errno == EINTR || errno == EAGAIN));
+  return r < 0 ? errno : 0;
+}
+
+bool IOUring::PopCompletion(uint64_t* user_data, int32_t* res) {
+  unsigned head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  struct io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+  *user_data = cqe->user_data;
+  *res = cqe->res;
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+void DeleteIOUring(void* ptr) { delete static_cast<IOUring*>(ptr); }
+
+// Set once the kernel refused io_uring, later threads don't try again
+std::atomic<bool> io_uring_unsupported{false};
+
+ThreadLocalPtr* ThreadLocalIOUrings() {
+  static ThreadLocalPtr* rings = new ThreadLocalPtr(&DeleteIOUring);
+  return rings;
+}
+
+IOUring* GetThreadLocalIOUring() {
+  if (io_uring_unsupported.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  ThreadLocalPtr* rings = ThreadLocalIOUrings();
+  IOUring* ring = static_cast<IOUring*>(rings->Get());
+  if (ring == nullptr) {
+    // A failed ring is kept as well, so the setup isn't retried by every
+    // read of this thread
+    ring = new IOUring;
+    int err = ring->Init();
+    TEST_SYNC_POINT_CALLBACK("GetThreadLocalIOUring:Init", &err);
+    if (err != 0) {
+      delete ring;
+      ring = new IOUring;
+      if (err == ENOSYS || err == EPERM || err == EINVAL) {
+        io_uring_unsupported.store(true, std::memory_order_relaxed);
+      }
+    }
+    rings->Reset(ring);
+  }
+  return ring->ok() ? ring : nullptr;
+}
+
+// The next read of this thread sets up a new ring
+void ResetThreadLocalIOUring(IOUring* ring) {
+  ThreadLocalPtr* rings = ThreadLocalIOUrings();
+  assert(rings->Get() == ring);
+  rings->Reset(nullptr);
+  delete ring;
+}
+
+}  // anonymous namespace
+#endif  // ROCKSDB_IOURING_PRESENT
+
 Status PosixRandomAccessFile::Read(uint64_t offset, size_t n, Slice* result,
                                    char* scratch) const {
 #if !defined(NDEBUG)
@@ -385,6 +619,86 @@ Status PosixRandomAccessFile::Read(uint64_t offset, size_t n, Slice* result,
                      use_direct_io_, GetRequiredBufferAlignment());
 }
 
+Status PosixRandomAccessFile::MultiRead(ReadRequest* reqs,
+                                        size_t num_reqs) const {
+#ifdef ROCKSDB_IOURING_PRESENT
+  // Fiber aio reads keep going through Read()
+  IOUring* ring =
+      use_aio_reads_ || num_reqs < 2 ? nullptr : GetThreadLocalIOUring();
+  if (ring != nullptr) {
+    const size_t alignment = GetRequiredBufferAlignment();
+    std::vector<struct iovec> iovs(num_reqs);
+    size_t next = 0;
+    size_t inflight = 0;
+    while (next < num_reqs || inflight > 0) {
+      for (; next < num_reqs && inflight < ring->queue_depth(); ++next) {
+        ReadRequest& req = reqs[next];
+#if !defined(NDEBUG)
+        if (use_direct_io_) {
+          assert(IsSectorAligned(req.offset, alignment));
+          assert(IsSectorAligned(req.len, alignment));
+          assert(IsSectorAligned(req.scratch, alignment));
+        }
+#endif
+        iovs[next].iov_base = req.scratch;
+        iovs[next].iov_len = req.len;
+        ring->PrepareRead(fd_, &iovs[next], req.offset, next);
+        ++inflight;
+      }
+      int err = ring->SubmitAndWait();
+      TEST_SYNC_POINT_CALLBACK("PosixRandomAccessFile::MultiRead:Submit",
+                               &err);
+      uint64_t id;
+      int32_t res;
+      if (err != 0) {
+        // Reads in flight still write into the callers' buffers, and their
+        // completions must not be seen by the next call on this thread
+        inflight -= ring->DiscardUnsubmitted();
+        while (inflight > 0) {
+          while (inflight > 0 && ring->PopCompletion(&id, &res)) {
+            --inflight;
+          }
+          if (inflight > 0 && ring->Wait() != 0) {
+            // Closing the ring cancels what is left
+            ResetThreadLocalIOUring(ring);
+            break;
+          }
+        }
+        return IOError("While io_uring_enter", filename_, err);
+      }
+      while (ring->PopCompletion(&id, &res)) {
+        assert(id < num_reqs && inflight > 0);
+        --inflight;
+        ReadRequest& req = reqs[id];
+        if (res == -EINTR || res == -EAGAIN) {
+          req.status = PosixFsRead(req.offset, req.len, &req.result,
+                                   req.scratch, fd_, filename_, false,
+                                   use_direct_io_, alignment);
+        } else if (res < 0) {
+          req.status = IOError("While pread offset " + ToString(req.offset) +
+                                   " len " + ToString(req.len),
+                               filename_, -res);
+          req.result = Slice(req.scratch, 0);
+        } else if (res > 0 && static_cast<size_t>(res) < req.len &&
+                   (!use_direct_io_ || res % alignment == 0)) {
+          // Short read before end of file, finish it synchronously
+          Slice rest;
+          req.status = PosixFsRead(req.offset + res, req.len - res, &rest,
+                                   req.scratch + res, fd_, filename_, false,
+                                   use_direct_io_, alignment);
+          req.result = Slice(req.scratch, res + rest.size());
+        } else {
+          req.status = Status::OK();
+          req.result = Slice(req.scratch, res);
+        }
+      }
+    }
+    return Status::OK();
+  }
+#endif  // ROCKSDB_IOURING_PRESENT
+  return RandomAccessFile::MultiRead(reqs, num_reqs);
+}
+
 Status PosixRandomAccessFile::Prefetch(uint64_t offset, size_t n) {
   Status s;
   if (!use_direct_io_) {
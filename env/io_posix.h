@@ -94,6 +94,10 @@ class PosixRandomAccessFile : public RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const final;
 
+  // Submits all requests through a per thread io_uring when the kernel
+  // supports it, otherwise reads them one by one.
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs) const final;
+
   virtual Status Prefetch(uint64_t offset, size_t n) override;
 
 #if defined(OS_LINUX) || defined(OS_MACOSX) || defined(OS_AIX)
@@ -44,6 +44,16 @@ class RemoteCompactionDispatcher : public CompactionDispatcher {
     virtual ~Worker();
     virtual std::string GenerateOutputFileName(size_t file_index) = 0;
     std::string DoCompaction(Slice data);
+
+    // Called with an encoded FileInfo as soon as an output file is finished
+    typedef std::function<void(const std::string&)> FileFinishedCallback;
+    std::string DoCompaction(Slice data,
+                             const FileFinishedCallback& on_file_finished);
+
+    // Serve framed requests from in_fd until it is closed, writing each
+    // finished file and the result to out_fd. Used by the process pool of
+    // NewLocalWorkerPoolCompactionDispatcher(). Returns the exit code.
+    int Serve(int in_fd, int out_fd);
     static void DebugSerializeCheckResult(Slice data);
 
    protected:
@@ -55,4 +65,16 @@ class RemoteCompactionDispatcher : public CompactionDispatcher {
 extern std::shared_ptr<CompactionDispatcher> NewCommandLineCompactionDispatcher(
     std::string cmd);
 
+// Called on the thread of a job each time its worker finished an output file,
+// partial.files holds the files finished so far, the other fields are unset.
+typedef std::function<void(const CompactionWorkerResult& partial)>
+    CompactionProgressCallback;
+
+// Keeps num_workers processes running "cmd", which must call
+// Worker::Serve(0, 1), and hands jobs to them instead of forking per job.
+extern std::shared_ptr<CompactionDispatcher>
+NewLocalWorkerPoolCompactionDispatcher(
+    std::string cmd, size_t num_workers,
+    CompactionProgressCallback on_progress = nullptr);
+
 }  // namespace rocksdb
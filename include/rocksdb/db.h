@@ -697,6 +697,15 @@ class DB {
     //      entries being pinned.
     static const std::string kBlockCachePinnedUsage;
 
+    //  "rocksdb.memory-arbiter-stats" - returns a multi-line string, or a map
+    //      with GetMapProperty(), of the usage of each consumer, waiting and
+    //      granted reservations of options.memory_arbiter.
+    static const std::string kMemoryArbiterStats;
+
+    //  "rocksdb.memory-arbiter-usage" - returns the memory accounted by
+    //      options.memory_arbiter over all of its consumers.
+    static const std::string kMemoryArbiterUsage;
+
     // "rocksdb.options-statistics" - returns multi-line string
     //      of options.statistics
     static const std::string kOptionsStatistics;
@@ -756,6 +765,7 @@ class DB {
   //  "rocksdb.block-cache-capacity"
   //  "rocksdb.block-cache-usage"
   //  "rocksdb.block-cache-pinned-usage"
+  //  "rocksdb.memory-arbiter-usage"
   virtual bool GetIntProperty(ColumnFamilyHandle* column_family,
                               const Slice& property, uint64_t* value) = 0;
   virtual bool GetIntProperty(const Slice& property, uint64_t* value) {
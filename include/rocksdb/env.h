@@ -578,6 +578,25 @@ class SequentialFileWrapper : public SequentialFile {
   }
 };
 
+// A read request for RandomAccessFile::MultiRead()
+struct ReadRequest {
+  // File offset in bytes
+  uint64_t offset;
+
+  // Length to read in bytes
+  size_t len;
+
+  // A buffer that MultiRead() can read data into, at least len bytes
+  char* scratch;
+
+  // Output parameter set by MultiRead() to point to the data read, may be
+  // shorter than len at end of file
+  Slice result;
+
+  // Output parameter set by MultiRead(), status of this request
+  Status status;
+};
+
 // A file abstraction for randomly reading the contents of a file.
 class RandomAccessFile {
  public:
@@ -597,6 +616,23 @@ class RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const = 0;
 
+  // Read the ranges described by reqs[0..num_reqs-1], setting result and
+  // status of each request as Read() would. Implementations may issue the
+  // reads in parallel, but all of them have completed when MultiRead()
+  // returns. Ranges must not overlap. A non-OK return applies to all
+  // requests and the individual statuses should be ignored.
+  //
+  // Safe for concurrent use by multiple threads.
+  // If Direct I/O enabled, offset, len, and scratch of every request should
+  // be aligned properly.
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs) const {
+    for (size_t i = 0; i < num_reqs; ++i) {
+      ReadRequest& req = reqs[i];
+      req.status = Read(req.offset, req.len, &req.result, req.scratch);
+    }
+    return Status::OK();
+  }
+
   // Readahead the file starting from offset by n bytes for caching.
   virtual Status Prefetch(uint64_t /*offset*/, size_t /*n*/) {
     return Status::OK();
@@ -672,6 +708,10 @@ class RandomAccessFileWrapper : public RandomAccessFile {
     return t_->Read(offset, n, result, scratch);
   };
 
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) const override {
+    return t_->MultiRead(reqs, num_reqs);
+  }
+
   Status Prefetch(uint64_t offset, size_t n) override {
     return t_->Prefetch(offset, n);
   }
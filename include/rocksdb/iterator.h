@@ -103,6 +103,9 @@ class Iterator : public Cleanable {
   // Property "rocksdb.iterator.internal-key":
   //   Get the user-key portion of the internal key at which the iteration
   //   stopped.
+  // Property "rocksdb.iterator.value":
+  //   Only for iterators created with ReadOptions::value_meta_only, fetch the
+  //   real value of the current entry.
   virtual Status GetProperty(std::string prop_name, std::string* prop);
 
  private:
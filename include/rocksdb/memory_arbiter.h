@@ -0,0 +1,158 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// MemoryArbiter is one memory budget shared by the memory consumers of one or
+// more DBs: memtables (through WriteBufferManager), the working memory of
+// table builders, table readers and, if given, a block cache.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "rocksdb/cache.h"
+
+namespace rocksdb {
+
+class MemoryArbiter {
+ public:
+  enum Consumer : int {
+    kMemTable = 0,
+    kTableBuilder,
+    kTableReader,
+    kCache,
+    kNumConsumers,
+  };
+
+  // Order in which waiting reservations are granted
+  enum Priority : int {
+    kHigh = 0,  // flush, frees memtable memory
+    kLow,       // compaction
+    kBottom,    // bottommost level compaction
+    kNumPriorities,
+  };
+
+  // Granted memory, given back to the arbiter on destruction
+  class Reservation {
+   public:
+    Reservation() : arbiter_(nullptr), consumer_(kTableBuilder), size_(0) {}
+    Reservation(Reservation&& other) noexcept;
+    Reservation& operator=(Reservation&& other) noexcept;
+    ~Reservation() { Release(); }
+
+    size_t size() const { return size_; }
+
+    // Give back `size` bytes, 0 for all of them
+    void Release(size_t size = 0);
+
+   private:
+    friend class MemoryArbiter;
+    Reservation(MemoryArbiter* arbiter, Consumer consumer, size_t size)
+        : arbiter_(arbiter), consumer_(consumer), size_(size) {}
+
+    MemoryArbiter* arbiter_;
+    Consumer consumer_;
+    size_t size_;
+  };
+
+  struct Stats {
+    size_t limit = 0;
+    size_t usage[kNumConsumers] = {};
+    size_t peak_usage = 0;
+    // Reservations waiting right now and the bytes they ask for
+    size_t num_waiting = 0;
+    size_t waiting_bytes = 0;
+    uint64_t num_reservations = 0;
+    uint64_t num_waits = 0;
+    uint64_t wait_micros = 0;
+    // Reservations granted over the limit after max_wait_micros
+    uint64_t num_timeouts = 0;
+  };
+
+  // limit == 0 means no limit, reservations are only accounted. If `cache` is
+  // given, its usage counts against the limit as consumer kCache.
+  explicit MemoryArbiter(size_t limit, std::shared_ptr<Cache> cache = {});
+  ~MemoryArbiter();
+
+  // Cache usage is read at most every kCacheUsageRefreshMicros by the
+  // approximate checks, the cache takes the mutex of every shard for it
+  static const uint64_t kCacheUsageRefreshMicros = 10 * 1000;
+
+  size_t limit() const { return limit_; }
+  size_t usage(Consumer consumer) const;
+  size_t usage() const;
+  // usage() with a cache usage up to kCacheUsageRefreshMicros old, cheap
+  // enough for every write group
+  size_t approximate_usage() const;
+  bool exceeds_limit() const {
+    return limit_ != 0 && approximate_usage() >= limit_;
+  }
+
+  // Blocks until `size` bytes fit into the limit. Waiters are woken when
+  // memory is given back, higher priority first and in arrival order within
+  // one priority. A reservation is always granted when no other reservation
+  // is outstanding, so a request above the limit can't wait forever.
+  // If `max_wait_micros` is not 0, a reservation still waiting after that
+  // long is granted over the limit.
+  Reservation Reserve(Consumer consumer, size_t size, Priority priority,
+                      uint64_t max_wait_micros = 0);
+
+  // Same as Reserve() without waiting, false if `size` doesn't fit now
+  bool TryReserve(Consumer consumer, size_t size, Priority priority,
+                  Reservation* reservation);
+
+  // Account memory the consumer allocates regardless of the limit, e.g. the
+  // arena blocks of memtables. Giving it back wakes waiters.
+  void Charge(Consumer consumer, size_t size);
+  void Discharge(Consumer consumer, size_t size);
+
+  void GetStats(Stats* stats) const;
+  std::string ToString() const;
+
+  static const char* ConsumerName(Consumer consumer);
+
+ private:
+  struct Waiter {
+    Consumer consumer;
+    size_t size;
+    bool granted;
+    std::condition_variable cv;
+  };
+
+  bool FitsLocked(size_t size) const;
+  // Grant waiters in order as long as the head fits
+  void GrantLocked();
+  void Return(Consumer consumer, size_t size);
+
+  const size_t limit_;
+  std::shared_ptr<Cache> cache_;
+  std::atomic<size_t> usage_[kNumConsumers];
+  // Last cache usage read and when, in steady clock micros
+  mutable std::atomic<size_t> cache_usage_;
+  mutable std::atomic<uint64_t> cache_usage_micros_;
+  std::atomic<size_t> peak_usage_;
+  // Bytes held by Reservation objects
+  size_t reserved_;
+  size_t num_waiting_;
+  mutable std::mutex mutex_;
+  std::deque<Waiter*> waiters_[kNumPriorities];
+  size_t waiting_bytes_;
+  uint64_t num_reservations_;
+  uint64_t num_waits_;
+  uint64_t wait_micros_;
+  uint64_t num_timeouts_;
+
+  // No copying allowed
+  MemoryArbiter(const MemoryArbiter&) = delete;
+  MemoryArbiter& operator=(const MemoryArbiter&) = delete;
+};
+
+}  // namespace rocksdb
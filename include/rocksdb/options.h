@@ -26,6 +26,7 @@
 #include "rocksdb/universal_compaction.h"
 #include "rocksdb/value_extractor.h"
 #include "rocksdb/version.h"
+#include "rocksdb/memory_arbiter.h"
 #include "rocksdb/write_buffer_manager.h"
 
 #ifdef max
@@ -306,6 +307,13 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // valid [0 , 1]
   double blob_large_key_ratio = 0.25;
 
+  // Record the location of each separated value in its value index, so that
+  // reading it back skips the index search of the blob sst. Value indexes
+  // written with this option can't be read by older versions.
+  //
+  // Dynamically changeable through SetOptions() API
+  bool blob_value_location = false;
+
   // Key Value separation gc ratio
   // Startup GC when garbage ratio larger than blob_gc_ratio
   // valid [0 , 0.5]
@@ -633,6 +641,19 @@ struct DBOptions {
   //
   size_t prepare_log_writer_num = 1;
 
+  // If non-zero, the WAL records are read, checksummed and uncompressed on a
+  // background thread during recovery, up to this many bytes of them ahead
+  // of the memtable inserts.
+  // Default: 0
+  size_t wal_recovery_readahead_size = 0;
+
+  // If non-zero, the recovered WAL batches are inserted into the memtables
+  // on up to this many background threads. Each column family is inserted
+  // by one thread, in log order, so this helps when the WAL holds writes to
+  // several column families. Not used with allow_2pc or seq_per_batch.
+  // Default: 0
+  size_t wal_recovery_insert_threads = 0;
+
   // manifest file is rolled over on reaching this limit.
   // The older manifest file be deleted.
   // The default value is 1GB so that the manifest file can grow, but not
@@ -752,6 +773,15 @@ struct DBOptions {
   // Default: null
   std::shared_ptr<WriteBufferManager> write_buffer_manager = nullptr;
 
+  // One memory budget for memtables, table builders, table readers and the
+  // block cache given to it, see memory_arbiter.h. The same object can be
+  // shared by multiple DBs. Memtables are charged through the default
+  // WriteBufferManager; a write_buffer_manager set above must be created with
+  // the arbiter itself.
+  //
+  // Default: null
+  std::shared_ptr<MemoryArbiter> memory_arbiter = nullptr;
+
   // Specify the file access pattern once a compaction is started.
   // It will be applied to all input files of a compaction.
   // Default: NORMAL
@@ -928,6 +958,16 @@ struct DBOptions {
   // Default: 3
   uint64_t write_thread_slow_yield_usec = 3;
 
+  // If allow_concurrent_memtable_write is set and a write batch of a write
+  // group has more than this many keys, the leader splits the batches of
+  // the group into ranges of at most this many keys. All writer threads of
+  // the group insert the ranges into the memtables in parallel, so a large
+  // batch doesn't hold up the small batches written with it. Batches with
+  // transaction markers are not split. 0 disables splitting.
+  //
+  // Default: 0
+  size_t memtable_insert_split_size = 0;
+
   // Deprecated
   bool skip_stats_update_on_db_open = false;
 
@@ -1021,6 +1061,15 @@ struct DBOptions {
   // file.
   bool manual_wal_flush = false;
 
+  // If not kNoCompression, every record written to the WAL is compressed
+  // with one streaming context per log file, so records also refer to the
+  // data of the ones before them. Only kZSTD and kZlibCompression are
+  // supported, other types and recycle_log_file_num > 0 turn it off.
+  // Logs written without compression can always be recovered.
+  //
+  // Default: kNoCompression
+  CompressionType wal_compression = kNoCompression;
+
   // If true, RocksDB supports flushing multiple column families and committing
   // their results atomically to MANIFEST. Note that it is not
   // necessary to set atomic_flush to true if WAL is always enabled since WAL
@@ -1199,6 +1248,22 @@ struct ReadOptions {
   // now only used by MultiGet
   int aio_concurrency;
 
+  // If non-zero, iterators read separated values (KV separation) through
+  // forward scans kept open on up to this many blob SSTs, instead of one
+  // point lookup per value. Speeds up long forward scans, values of close
+  // keys share data blocks and block reads become sequential.
+  // Default: 0
+  size_t blob_readahead_files;
+
+  // If true, iterators return the value meta instead of the value, and never
+  // read blob SSTs for it. For separated values (KV separation) it is the
+  // meta stored in the LSM, for other values it is computed by
+  // value_meta_extractor_factory, empty if there is none. The real value is
+  // available through property "rocksdb.iterator.value". Merged entries
+  // still read their operands and return the merged value.
+  // Default: false
+  bool value_meta_only;
+
   // A callback to determine whether relevant keys for this scan exist in a
   // given table based on the table's properties. The callback is passed the
   // properties of each table during iteration. If the callback returns false,
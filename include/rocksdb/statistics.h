@@ -251,6 +251,17 @@ enum Tickers : uint32_t {
 
   NO_ITERATOR_CREATED,  // number of iterators created
   NO_ITERATOR_DELETED,  // number of iterators deleted
+
+  // Hot record cache of TerarkZipTable readers
+  TERARK_RECORD_CACHE_HIT,
+  TERARK_RECORD_CACHE_MISS,
+
+  // Data blocks evicted from block cache and kept compressed in the
+  // compressed block cache, see block_cache_demotion_compression.
+  // Promotions back count as BLOCK_CACHE_COMPRESSED_HIT.
+  BLOCK_CACHE_COMPRESSED_DEMOTE,
+  // # of bytes of the compressed blocks demoted
+  BLOCK_CACHE_COMPRESSED_DEMOTE_BYTES,
   TICKER_ENUM_MAX
 };
 
@@ -258,6 +258,17 @@ struct BlockBasedTableOptions {
 
   // Align data blocks on lesser of page size and block size
   bool block_align = false;
+
+  // If not kNoCompression and block_cache_compressed is set, the compressed
+  // block cache becomes a second tier of block_cache: data blocks evicted
+  // from block_cache are compressed with this type and kept in
+  // block_cache_compressed, and a later miss in block_cache uncompresses
+  // and promotes them back. Raw blocks read from the file are no longer
+  // inserted into block_cache_compressed.
+  // Blocks which don't compress well are dropped on eviction.
+  // Demotion costs CPU on the eviction path: the block is compressed by the
+  // thread whose insert into block_cache evicted it, usually a reader.
+  CompressionType block_cache_demotion_compression = kNoCompression;
 };
 
 // Table Properties that are specific to block-based table properties.
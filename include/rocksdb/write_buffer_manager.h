@@ -15,6 +15,7 @@
 #include <atomic>
 #include <cstddef>
 #include "rocksdb/cache.h"
+#include "rocksdb/memory_arbiter.h"
 
 namespace rocksdb {
 
@@ -24,14 +25,19 @@ class WriteBufferManager {
   // memory_usage() won't be valid and ShouldFlush() will always return true.
   // if `cache` is provided, we'll put dummy entries in the cache and cost
   // the memory allocated to the cache. It can be used even if _buffer_size = 0.
+  // if `arbiter` is provided, memtable memory is charged to it and a flush is
+  // triggered when the arbiter runs over its limit.
   explicit WriteBufferManager(size_t _buffer_size,
-                              std::shared_ptr<Cache> cache = {});
+                              std::shared_ptr<Cache> cache = {},
+                              std::shared_ptr<MemoryArbiter> arbiter = {});
   ~WriteBufferManager();
 
   bool enabled() const { return buffer_size_ != 0; }
 
   bool cost_to_cache() const { return cache_rep_ != nullptr; }
 
+  MemoryArbiter* arbiter() const { return arbiter_.get(); }
+
   // Only valid if enabled()
   size_t memory_usage() const {
     return memory_used_.load(std::memory_order_relaxed);
@@ -55,6 +61,16 @@ class WriteBufferManager {
         return true;
       }
     }
+    if (arbiter_ != nullptr && arbiter_->exceeds_limit()) {
+      // Over the shared budget, memtables holding a fair share of it give
+      // memory back, unless half of them is being flushed already. The
+      // check sees the block cache usage of the last refresh only.
+      size_t memtable_usage = arbiter_->usage(MemoryArbiter::kMemTable);
+      if (memtable_usage >= arbiter_->limit() / 4 &&
+          mutable_memtable_memory_usage() >= memtable_usage / 2) {
+        return true;
+      }
+    }
     return false;
   }
 
@@ -64,14 +80,17 @@ class WriteBufferManager {
     } else if (enabled()) {
       memory_used_.fetch_add(mem, std::memory_order_relaxed);
     }
-    if (enabled()) {
+    if (enabled() || arbiter_ != nullptr) {
       memory_active_.fetch_add(mem, std::memory_order_relaxed);
     }
+    if (arbiter_ != nullptr) {
+      arbiter_->Charge(MemoryArbiter::kMemTable, mem);
+    }
   }
   // We are in the process of freeing `mem` bytes, so it is not considered
   // when checking the soft limit.
   void ScheduleFreeMem(size_t mem) {
-    if (enabled()) {
+    if (enabled() || arbiter_ != nullptr) {
       memory_active_.fetch_sub(mem, std::memory_order_relaxed);
     }
   }
@@ -81,6 +100,9 @@ class WriteBufferManager {
     } else if (enabled()) {
       memory_used_.fetch_sub(mem, std::memory_order_relaxed);
     }
+    if (arbiter_ != nullptr) {
+      arbiter_->Discharge(MemoryArbiter::kMemTable, mem);
+    }
   }
 
  private:
@@ -91,6 +113,7 @@ class WriteBufferManager {
   std::atomic<size_t> memory_active_;
   struct CacheRep;
   std::unique_ptr<CacheRep> cache_rep_;
+  std::shared_ptr<MemoryArbiter> arbiter_;
 
   void ReserveMemWithCache(size_t mem);
   void FreeMemWithCache(size_t mem);
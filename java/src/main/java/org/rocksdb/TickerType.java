@@ -484,7 +484,28 @@ public enum TickerType {
      */
     NO_ITERATOR_DELETED((byte) 0x60),
 
-    TICKER_ENUM_MAX((byte) 0x61);
+    /**
+     * Number of point lookups served by the hot record cache of TerarkZipTable.
+     */
+    TERARK_RECORD_CACHE_HIT((byte) 0x61),
+
+    /**
+     * Number of point lookups which decompressed their TerarkZipTable record.
+     */
+    TERARK_RECORD_CACHE_MISS((byte) 0x62),
+
+    /**
+     * Number of data blocks evicted from the block cache and kept compressed
+     * in the compressed block cache.
+     */
+    BLOCK_CACHE_COMPRESSED_DEMOTE((byte) 0x63),
+
+    /**
+     * Number of bytes of the data blocks demoted to the compressed block cache.
+     */
+    BLOCK_CACHE_COMPRESSED_DEMOTE_BYTES((byte) 0x64),
+
+    TICKER_ENUM_MAX((byte) 0x65);
 
 
     private final byte value;
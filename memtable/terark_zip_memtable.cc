@@ -6,6 +6,8 @@
 #include <sys/mman.h>
 #endif
 
+#include "util/sync_point.h"
+
 using terark::MainPatricia;
 
 namespace {
@@ -88,6 +90,7 @@ PatriciaTrieRep::PatriciaTrieRep(details::ConcurrentType concurrent_type,
                                  Allocator* allocator)
     : MemTableRep(allocator) {
   immutable_ = false;
+  num_entries_ = 0;
   patricia_key_type_ = patricia_key_type;
   handle_duplicate_ = handle_duplicate;
   write_buffer_size_ = write_buffer_size;
@@ -274,20 +277,93 @@ void PatriciaTrieRep::Get(const LookupKey& k, void* callback_args,
 
 MemTableRep::Iterator* PatriciaTrieRep::GetIterator(Arena* arena) {
   MemTableRep::Iterator* iter;
+  bool immutable = immutable_;
   if (trie_vec_size_ == 1) {
     typedef PatriciaRepIterator<false> iter_t;
     iter = arena ? new (arena->AllocateAligned(sizeof(iter_t)))
-                       iter_t(trie_vec_, 1)
-                 : new iter_t(trie_vec_, 1);
+                       iter_t(trie_vec_, 1, immutable)
+                 : new iter_t(trie_vec_, 1, immutable);
   } else {
     typedef PatriciaRepIterator<true> iter_t;
     iter = arena ? new (arena->AllocateAligned(sizeof(iter_t)))
-                       iter_t(trie_vec_, trie_vec_size_)
-                 : new iter_t(trie_vec_, trie_vec_size_);
+                       iter_t(trie_vec_, trie_vec_size_, immutable)
+                 : new iter_t(trie_vec_, trie_vec_size_, immutable);
   }
   return iter;
 }
 
+namespace {
+
+// Big endian value of the 8 bytes of `key` after `prefix_len`, a position in
+// the key space for interpolation
+double KeyPosition(terark::fstring key, size_t prefix_len) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    size_t pos = prefix_len + i;
+    value = value << 8 | (pos < size_t(key.size()) ? byte_t(key[pos]) : 0);
+  }
+  return double(value);
+}
+
+}  // namespace
+
+uint64_t PatriciaTrieRep::ApproximateNumEntries(const Slice& start_ikey,
+                                                const Slice& end_ikey) {
+  // Ranges with up to this many keys in a trie are counted exactly
+  static const size_t kMaxCountedKeys = 64;
+  terark::fstring start(start_ikey.data(), start_ikey.size() - 8);
+  terark::fstring end(end_ikey.data(), end_ikey.size() - 8);
+  if (start >= end) {
+    return 0;
+  }
+  size_t num_tries = trie_vec_size_;
+  double num_keys = 0;
+  size_t total_keys = 0;
+  for (size_t i = 0; i < num_tries; ++i) {
+    auto* trie = trie_vec_[i];
+    total_keys += trie->num_words();
+    terark::Patricia::IteratorPtr iter(trie->new_iter());
+    size_t counted = 0;
+    for (bool ok = iter->seek_lower_bound(start);
+         ok && counted < kMaxCountedKeys && iter->word() < end;
+         ok = iter->incr()) {
+      ++counted;
+    }
+    if (counted < kMaxCountedKeys) {
+      num_keys += counted;
+      continue;
+    }
+    // Interpolate [start, end) within [first, last] of this trie. The bounds
+    // are clamped first, KeyPosition() is only meaningful for keys sharing
+    // the prefix of first and last
+    if (!iter->seek_begin()) {
+      continue;
+    }
+    std::string first = iter->word().str();
+    iter->seek_end();
+    std::string last = iter->word().str();
+    terark::fstring range_start = std::max(start, terark::fstring(first));
+    terark::fstring range_end = std::min(end, terark::fstring(last));
+    size_t prefix_len = terark::fstring(first).commonPrefixLen(last);
+    double lo = KeyPosition(first, prefix_len);
+    double hi = KeyPosition(last, prefix_len);
+    double range_lo = KeyPosition(range_start, prefix_len);
+    double range_hi = KeyPosition(range_end, prefix_len);
+    double fraction =
+        hi > lo ? std::max(0.0, range_hi - range_lo) / (hi - lo) : 1;
+    num_keys += std::max<double>(kMaxCountedKeys,
+                                 fraction * trie->num_words());
+  }
+  if (total_keys == 0) {
+    return 0;
+  }
+  // Every user key holds one or more entries with different tags
+  double entries_per_key =
+      std::max(1.0, double(num_entries_.load(std::memory_order_relaxed)) /
+                        total_keys);
+  return uint64_t(num_keys * entries_per_key);
+}
+
 bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
                                      const Slice& value) {
   TERARK_VERIFY(!immutable_);
@@ -381,6 +457,7 @@ bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
     trie_vec_[trie_vec_size_] = new MainPatricia(
         sizeof(uint32_t), write_buffer_size_, concurrent_level_);
     trie_vec_size_++;
+    TEST_SYNC_POINT("PatriciaTrieRep::InsertKeyValue:NewTrie");
   };
   // tool lambda fn end
   // function start
@@ -421,6 +498,7 @@ bool PatriciaTrieRep::InsertKeyValue(const Slice& internal_key,
     }
   }
   assert(insert_result == details::InsertResult::Success);
+  num_entries_.fetch_add(1, std::memory_order_relaxed);
   return true;
 }
 
@@ -555,46 +633,45 @@ template <int direction, class func_t>
 void PatriciaRepIterator<heap_mode>::Rebuild(func_t&& callback_func) {
   static_assert(direction == 1 || direction == -1, "direction must be 1 or -1");
   direction_ = direction;
-  multi_.size = multi_.count;
-  if (direction == 1) {
-    for (size_t i = 0; i < multi_.size;) {
-      if (callback_func(multi_.heap[i])) {
-        ++i;
-      } else {
-        --multi_.size;
-        std::swap(multi_.heap[i], multi_.heap[multi_.size]);
-      }
-    }
-    std::make_heap(multi_.heap, multi_.heap + multi_.size, ForwardComp());
-  } else {
-    for (size_t i = 0; i < multi_.size;) {
-      if (callback_func(multi_.heap[i])) {
-        ++i;
+  HeapItem* inputs[std::tuple_size<details::tries_t>::value];
+  for (size_t i = 0; i < multi_.count; ++i) {
+    HeapItem* item = &multi_.array[i];
+    inputs[i] = callback_func(item) ? item : nullptr;
+  }
+  tree_.Init(inputs, multi_.count, MergeComp{direction});
+}
+
+template <bool heap_mode>
+template <int direction>
+void PatriciaRepIterator<heap_mode>::Reverse() {
+  // Tries don't change any more, every other heap item is next to the current
+  // key on the other side, or exhausted
+  HeapItem* current = tree_.top();
+  Rebuild<direction>([&](HeapItem* item) {
+    if (item != current) {
+      if (item->index == size_t(-1)) {
+        direction == 1 ? item->SeekToFirst() : item->SeekToLast();
       } else {
-        --multi_.size;
-        std::swap(multi_.heap[i], multi_.heap[multi_.size]);
+        direction == 1 ? item->Next() : item->Prev();
       }
     }
-    std::make_heap(multi_.heap, multi_.heap + multi_.size, BackwardComp());
-  }
+    return item->index != size_t(-1);
+  });
 }
 
 template <bool heap_mode>
 PatriciaRepIterator<heap_mode>::PatriciaRepIterator(details::tries_t& tries,
-                                                    size_t tries_size)
-    : direction_(0) {
+                                                    size_t tries_size,
+                                                    bool immutable)
+    : direction_(0), immutable_(immutable) {
   assert(tries.size() > 0);
   if (heap_mode) {
     valvec<HeapItem> hitem(tries.size(), terark::valvec_reserve());
-    valvec<HeapItem*> hptrs(tries.size(), terark::valvec_reserve());
     for (size_t i = 0; i < tries_size; ++i) {
-      hptrs.push_back(new (hitem.grow_no_init(1)) HeapItem(tries[i]));
+      new (hitem.grow_no_init(1)) HeapItem(tries[i]);
     }
-    assert(hitem.size() == hptrs.size());
     multi_.count = hitem.size();
     multi_.array = hitem.risk_release_ownership();
-    multi_.heap = hptrs.risk_release_ownership();
-    multi_.size = 0;
   } else {
     new (&single_) HeapItem(tries.front());
   }
@@ -602,7 +679,6 @@ PatriciaRepIterator<heap_mode>::PatriciaRepIterator(details::tries_t& tries,
 template <bool heap_mode>
 PatriciaRepIterator<heap_mode>::~PatriciaRepIterator() {
   if (heap_mode) {
-    free(multi_.heap);
     for (size_t i = 0; i < multi_.count; ++i) {
       multi_.array[i].~HeapItem();
     }
@@ -625,26 +701,27 @@ template <bool heap_mode>
 void PatriciaRepIterator<heap_mode>::Next() {
   if (heap_mode) {
     if (direction_ != 1) {
-      terark::fstring find_key(buffer_.data(), buffer_.size() - 8);
-      uint64_t tag = DecodeFixed64(find_key.end());
-      Rebuild<1>([&](HeapItem* item) {
-        item->Seek(find_key, tag);
-        return item->index != size_t(-1);
-      });
-      if (multi_.size == 0) {
-        direction_ = 0;
-        return;
+      if (immutable_) {
+        Reverse<1>();
+      } else {
+        terark::fstring find_key(buffer_.data(), buffer_.size() - 8);
+        uint64_t tag = DecodeFixed64(find_key.end());
+        Rebuild<1>([&](HeapItem* item) {
+          item->Seek(find_key, tag);
+          return item->index != size_t(-1);
+        });
       }
-    }
-    multi_.heap[0]->Next();
-    if (multi_.heap[0]->index == size_t(-1)) {
-      std::pop_heap(multi_.heap, multi_.heap + multi_.size, ForwardComp());
-      if (--multi_.size == 0) {
+      if (tree_.top() == nullptr) {
         direction_ = 0;
         return;
       }
-    } else {
-      terark::adjust_heap_top(multi_.heap, multi_.size, ForwardComp());
+    }
+    HeapItem* top = tree_.top();
+    top->Next();
+    tree_.ReplaceTop(top->index == size_t(-1) ? nullptr : top);
+    if (tree_.top() == nullptr) {
+      direction_ = 0;
+      return;
     }
   } else {
     single_.Next();
@@ -660,26 +737,27 @@ template <bool heap_mode>
 void PatriciaRepIterator<heap_mode>::Prev() {
   if (heap_mode) {
     if (direction_ != -1) {
-      terark::fstring find_key(buffer_.data(), buffer_.size() - 8);
-      uint64_t tag = DecodeFixed64(find_key.end());
-      Rebuild<-1>([&](HeapItem* item) {
-        item->SeekForPrev(find_key, tag);
-        return item->index != size_t(-1);
-      });
-      if (multi_.size == 0) {
-        direction_ = 0;
-        return;
+      if (immutable_) {
+        Reverse<-1>();
+      } else {
+        terark::fstring find_key(buffer_.data(), buffer_.size() - 8);
+        uint64_t tag = DecodeFixed64(find_key.end());
+        Rebuild<-1>([&](HeapItem* item) {
+          item->SeekForPrev(find_key, tag);
+          return item->index != size_t(-1);
+        });
       }
-    }
-    multi_.heap[0]->Prev();
-    if (multi_.heap[0]->index == size_t(-1)) {
-      std::pop_heap(multi_.heap, multi_.heap + multi_.size, BackwardComp());
-      if (--multi_.size == 0) {
+      if (tree_.top() == nullptr) {
         direction_ = 0;
         return;
       }
-    } else {
-      terark::adjust_heap_top(multi_.heap, multi_.size, BackwardComp());
+    }
+    HeapItem* top = tree_.top();
+    top->Prev();
+    tree_.ReplaceTop(top->index == size_t(-1) ? nullptr : top);
+    if (tree_.top() == nullptr) {
+      direction_ = 0;
+      return;
     }
   } else {
     single_.Prev();
@@ -708,7 +786,7 @@ void PatriciaRepIterator<heap_mode>::Seek(const Slice& user_key,
       item->Seek(find_key, tag);
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
+    if (tree_.top() == nullptr) {
       direction_ = 0;
       return;
     }
@@ -740,7 +818,7 @@ void PatriciaRepIterator<heap_mode>::SeekForPrev(const Slice& user_key,
       item->SeekForPrev(find_key, tag);
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
+    if (tree_.top() == nullptr) {
       direction_ = 0;
       return;
     }
@@ -762,7 +840,7 @@ void PatriciaRepIterator<heap_mode>::SeekToFirst() {
       item->SeekToFirst();
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
+    if (tree_.top() == nullptr) {
       direction_ = 0;
       return;
     }
@@ -784,7 +862,7 @@ void PatriciaRepIterator<heap_mode>::SeekToLast() {
       item->SeekToLast();
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
+    if (tree_.top() == nullptr) {
       direction_ = 0;
       return;
     }
@@ -22,6 +22,7 @@
 #include "terark/io/byte_swap.hpp"
 #include "terark/thread/instance_tls_owner.hpp"
 #include "util/arena.h"
+#include "util/loser_tree.h"
 
 namespace rocksdb {
 
@@ -74,6 +75,7 @@ class PatriciaTrieRep : public MemTableRep {
   terark_memtable_details::PatriciaKeyType patricia_key_type_;
   bool handle_duplicate_;
   std::atomic_bool immutable_;
+  std::atomic<uint64_t> num_entries_;
   terark_memtable_details::tries_t trie_vec_;
   size_t trie_vec_size_;
   size_t overhead_;  // this overhead is for new memtable size check
@@ -94,11 +96,10 @@ class PatriciaTrieRep : public MemTableRep {
   // all patricia trie handled by this rep.
   virtual size_t ApproximateMemoryUsage() override;
 
-  // This approximition is not supported, return 0 instead.
-  virtual uint64_t ApproximateNumEntries(const Slice& /*start_ikey*/,
-                                         const Slice& /*end_ikey*/) override {
-    return 0;
-  }
+  // Count the keys of small ranges, interpolate the key position within
+  // each trie for large ones.
+  virtual uint64_t ApproximateNumEntries(const Slice& start_ikey,
+                                         const Slice& end_ikey) override;
 
   // Return true if this rep contains querying key.
   virtual bool Contains(const Slice& internal_key) const override;
@@ -127,8 +128,10 @@ class PatriciaTrieRep : public MemTableRep {
   virtual void MarkReadOnly() override;
 };
 
-// Heap iterator for traversing multi tries simultaneously.
-// Create a heap to merge iterators from all tries.
+// Merging iterator for traversing multi tries simultaneously.
+// Iterators of all tries are merged by a loser tree, once the rep is
+// immutable a change of direction steps every trie iterator by one instead
+// of seeking all of them again.
 template <bool heap_mode>
 class PatriciaRepIterator : public MemTableRep::Iterator,
                             boost::noncopyable {
@@ -160,27 +163,39 @@ class PatriciaRepIterator : public MemTableRep::Iterator,
     void Prev();
   };
 
+  // Lexicographical order for direction 1, reverse order for -1
+  struct MergeComp {
+    int direction;
+    bool operator()(const HeapItem* l, const HeapItem* r) const {
+      int c = terark::fstring_func::compare3()(l->handle->word(),
+                                               r->handle->word());
+      if (direction == 1) {
+        return c == 0 ? l->tag > r->tag : c < 0;
+      } else {
+        return c == 0 ? l->tag < r->tag : c > 0;
+      }
+    }
+  };
+
   // union definition as unify interface for iterator polymorphism
   union {
     struct {
       HeapItem* array;
       size_t count;
-      HeapItem** heap;
-      size_t size;
     } multi_;
     HeapItem single_;
   };
 
+  LoserTree<HeapItem, MergeComp> tree_;
   std::string buffer_;
   int direction_;
+  bool immutable_;
 
   // Return pointer of current heap item.
-  const HeapItem* Current() const {
-    return heap_mode ? *multi_.heap : &single_;
-  }
+  const HeapItem* Current() const { return heap_mode ? tree_.top() : &single_; }
 
   // Return pointer of current heap item.
-  HeapItem* Current() { return heap_mode ? *multi_.heap : &single_; }
+  HeapItem* Current() { return heap_mode ? tree_.top() : &single_; }
 
   // Return current key.
   terark::fstring CurrentKey() { return Current()->handle->word(); }
@@ -188,31 +203,17 @@ class PatriciaRepIterator : public MemTableRep::Iterator,
   // Return current tag.
   uint64_t CurrentTag() { return Current()->tag; }
 
-  // Lexicographical order 3 way compartor
-  struct ForwardComp {
-    bool operator()(HeapItem* l, HeapItem* r) const {
-      int c = terark::fstring_func::compare3()(l->handle->word(),
-                                               r->handle->word());
-      return c == 0 ? l->tag < r->tag : c > 0;
-    }
-  };
-
-  // Reverse lexicographical order 3 way compartor
-  struct BackwardComp {
-    bool operator()(HeapItem* l, HeapItem* r) const {
-      int c = terark::fstring_func::compare3()(l->handle->word(),
-                                               r->handle->word());
-      return c == 0 ? l->tag > r->tag : c < 0;
-    }
-  };
-
-  // Rebuild heap for orderness
+  // Position every heap item by callback_func and rebuild the loser tree
   template <int direction, class func_t>
   void Rebuild(func_t&& callback_func);
 
+  // Turn around all heap items from the current position, without seeking
+  template <int direction>
+  void Reverse();
+
  public:
   PatriciaRepIterator(terark_memtable_details::tries_t& tries,
-                      size_t tries_size);
+                      size_t tries_size, bool immutable);
 
   virtual ~PatriciaRepIterator();
 
@@ -142,6 +142,34 @@ TEST_F(WriteBufferManagerTest, NoCapCacheCost) {
   ASSERT_GE(cache->GetPinnedUsage(), 1024 * 1024);
   ASSERT_LT(cache->GetPinnedUsage(), 1024 * 1024 + 10000);
 }
+
+TEST_F(WriteBufferManagerTest, MemoryArbiter) {
+  std::shared_ptr<MemoryArbiter> arbiter =
+      std::make_shared<MemoryArbiter>(16 * 1024 * 1024);
+  // No buffer size of its own, memtables are limited by the arbiter only
+  std::unique_ptr<WriteBufferManager> wbf(
+      new WriteBufferManager(0, {} /* cache */, arbiter));
+
+  wbf->ReserveMem(6 * 1024 * 1024);
+  ASSERT_EQ(6 * 1024 * 1024, arbiter->usage(MemoryArbiter::kMemTable));
+  ASSERT_FALSE(wbf->ShouldFlush());
+
+  // Table builders push the arbiter over its limit
+  auto reservation = arbiter->Reserve(MemoryArbiter::kTableBuilder,
+                                      10 * 1024 * 1024, MemoryArbiter::kLow);
+  ASSERT_TRUE(wbf->ShouldFlush());
+
+  // More than half of the memtable memory is being flushed already
+  wbf->ScheduleFreeMem(4 * 1024 * 1024);
+  ASSERT_FALSE(wbf->ShouldFlush());
+
+  wbf->FreeMem(4 * 1024 * 1024);
+  ASSERT_EQ(2 * 1024 * 1024, arbiter->usage(MemoryArbiter::kMemTable));
+  ASSERT_FALSE(wbf->ShouldFlush());
+  reservation.Release();
+  wbf->FreeMem(2 * 1024 * 1024);
+  ASSERT_EQ(0, arbiter->usage());
+}
 #endif  // ROCKSDB_LITE
 }  // namespace rocksdb
 
@@ -4,6 +4,8 @@
 //  (found in the LICENSE.Apache file in the root directory).
 //
 #pragma once
+#include <algorithm>
+
 #include "db/version_edit.h"
 #include "util/random.h"
 
@@ -20,4 +22,21 @@ inline void sample_file_read_inc(FileMetaData* meta) {
   meta->stats.num_reads_sampled.fetch_add(kFileReadSampleRate,
                                           std::memory_order_relaxed);
 }
+
+// Sampled reads left after decay, compactions are ranked on them rather than
+// on num_reads_sampled, which users see through the file metadata
+inline uint64_t sample_file_read_recent(const FileMetaData* meta) {
+  uint64_t decayed =
+      meta->stats.num_reads_decayed.load(std::memory_order_relaxed);
+  uint64_t reads =
+      meta->stats.num_reads_sampled.load(std::memory_order_relaxed);
+  return reads - std::min(reads, decayed);
+}
+
+// Halves the recent reads, so rankings built on them follow recent lookups.
+// Only called with the db mutex held.
+inline void sample_file_read_decay(FileMetaData* meta) {
+  meta->stats.num_reads_decayed.fetch_add(sample_file_read_recent(meta) / 2,
+                                          std::memory_order_relaxed);
+}
 }
@@ -134,6 +134,11 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {NUMBER_MULTIGET_KEYS_FOUND, "rocksdb.number.multiget.keys.found"},
     {NO_ITERATOR_CREATED, "rocksdb.num.iterator.created"},
     {NO_ITERATOR_DELETED, "rocksdb.num.iterator.deleted"},
+    {TERARK_RECORD_CACHE_HIT, "rocksdb.terark.record.cache.hit"},
+    {TERARK_RECORD_CACHE_MISS, "rocksdb.terark.record.cache.miss"},
+    {BLOCK_CACHE_COMPRESSED_DEMOTE, "rocksdb.block.cachecompressed.demote"},
+    {BLOCK_CACHE_COMPRESSED_DEMOTE_BYTES,
+     "rocksdb.block.cachecompressed.demote.bytes"},
 };
 
 const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
@@ -125,6 +125,8 @@ struct ImmutableCFOptions {
 
   std::shared_ptr<Cache> row_cache;
 
+  MemoryArbiter* memory_arbiter;
+
   const SliceTransform* memtable_insert_with_hint_prefix_extractor;
 
   std::vector<DbPath> cf_paths;
@@ -133,6 +135,7 @@ struct ImmutableCFOptions {
 struct BlobConfig {
   size_t blob_size;
   double large_key_ratio;
+  bool value_location;
 };
 
 struct MutableCFOptions {
@@ -151,6 +154,7 @@ struct MutableCFOptions {
         max_subcompactions(options.max_subcompactions),
         blob_size(options.blob_size),
         blob_large_key_ratio(options.blob_large_key_ratio),
+        blob_value_location(options.blob_value_location),
         blob_gc_ratio(options.blob_gc_ratio),
         soft_pending_compaction_bytes_limit(
             options.soft_pending_compaction_bytes_limit),
@@ -191,6 +195,7 @@ struct MutableCFOptions {
         max_subcompactions(0),
         blob_size(0),
         blob_large_key_ratio(0),
+        blob_value_location(false),
         blob_gc_ratio(0),
         soft_pending_compaction_bytes_limit(0),
         hard_pending_compaction_bytes_limit(0),
@@ -212,7 +217,7 @@ struct MutableCFOptions {
   explicit MutableCFOptions(const Options& options);
 
   BlobConfig get_blob_config() const {
-    return BlobConfig{ blob_size, blob_large_key_ratio };
+    return BlobConfig{ blob_size, blob_large_key_ratio, blob_value_location };
   }
 
   // Must be called after any change to MutableCFOptions
@@ -248,6 +253,7 @@ struct MutableCFOptions {
   uint32_t max_subcompactions;
   size_t blob_size;
   double blob_large_key_ratio;
+  bool blob_value_location;
   double blob_gc_ratio;
   uint64_t soft_pending_compaction_bytes_limit;
   uint64_t hard_pending_compaction_bytes_limit;
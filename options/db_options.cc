@@ -17,6 +17,7 @@
 #include "rocksdb/env.h"
 #include "rocksdb/sst_file_manager.h"
 #include "rocksdb/wal_filter.h"
+#include "util/compression.h"
 #include "util/logging.h"
 
 namespace rocksdb {
@@ -45,6 +46,8 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       keep_log_file_num(options.keep_log_file_num),
       recycle_log_file_num(options.recycle_log_file_num),
       prepare_log_writer_num(options.prepare_log_writer_num),
+      wal_recovery_readahead_size(options.wal_recovery_readahead_size),
+      wal_recovery_insert_threads(options.wal_recovery_insert_threads),
       max_manifest_file_size(options.max_manifest_file_size),
       max_manifest_edit_count(options.max_manifest_edit_count),
       table_cache_numshardbits(options.table_cache_numshardbits),
@@ -64,6 +67,7 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       write_buffer_flush_pri(options.write_buffer_flush_pri),
       db_write_buffer_size(options.db_write_buffer_size),
       write_buffer_manager(options.write_buffer_manager),
+      memory_arbiter(options.memory_arbiter),
       access_hint_on_compaction_start(options.access_hint_on_compaction_start),
       new_table_reader_for_compaction_inputs(
           options.new_table_reader_for_compaction_inputs),
@@ -77,6 +81,7 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
           options.enable_write_thread_adaptive_yield),
       write_thread_max_yield_usec(options.write_thread_max_yield_usec),
       write_thread_slow_yield_usec(options.write_thread_slow_yield_usec),
+      memtable_insert_split_size(options.memtable_insert_split_size),
       skip_stats_update_on_db_open(options.skip_stats_update_on_db_open),
       wal_recovery_mode(options.wal_recovery_mode),
       allow_2pc(options.allow_2pc),
@@ -91,6 +96,7 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       preserve_deletes(options.preserve_deletes),
       two_write_queues(options.two_write_queues),
       manual_wal_flush(options.manual_wal_flush),
+      wal_compression(options.wal_compression),
       atomic_flush(options.atomic_flush),
       avoid_unnecessary_blocking_io(options.avoid_unnecessary_blocking_io) {
 }
@@ -133,6 +139,12 @@ void ImmutableDBOptions::Dump(Logger* log) const {
   ROCKS_LOG_HEADER(
       log, "                 Options.prepare_log_writer_num: %" ROCKSDB_PRIszt,
       prepare_log_writer_num);
+  ROCKS_LOG_HEADER(
+      log, "            Options.wal_recovery_readahead_size: %" ROCKSDB_PRIszt,
+      wal_recovery_readahead_size);
+  ROCKS_LOG_HEADER(
+      log, "            Options.wal_recovery_insert_threads: %" ROCKSDB_PRIszt,
+      wal_recovery_insert_threads);
   ROCKS_LOG_HEADER(log, "                        Options.allow_fallocate: %d",
                    allow_fallocate);
   ROCKS_LOG_HEADER(log, "                       Options.allow_mmap_reads: %d",
@@ -189,6 +201,8 @@ void ImmutableDBOptions::Dump(Logger* log) const {
       db_write_buffer_size);
   ROCKS_LOG_HEADER(log, "                   Options.write_buffer_manager: %p",
                    write_buffer_manager.get());
+  ROCKS_LOG_HEADER(log, "                         Options.memory_arbiter: %p",
+                   memory_arbiter.get());
   ROCKS_LOG_HEADER(log, "        Options.access_hint_on_compaction_start: %d",
                    static_cast<int>(access_hint_on_compaction_start));
   ROCKS_LOG_HEADER(log, " Options.new_table_reader_for_compaction_inputs: %d",
@@ -219,6 +233,9 @@ void ImmutableDBOptions::Dump(Logger* log) const {
   ROCKS_LOG_HEADER(log,
                    "           Options.write_thread_slow_yield_usec: %" PRIu64,
                    write_thread_slow_yield_usec);
+  ROCKS_LOG_HEADER(
+      log, "             Options.memtable_insert_split_size: %" ROCKSDB_PRIszt,
+      memtable_insert_split_size);
   if (row_cache) {
     ROCKS_LOG_HEADER(
         log, "                              Options.row_cache: %" PRIu64,
@@ -242,6 +259,8 @@ void ImmutableDBOptions::Dump(Logger* log) const {
                    two_write_queues);
   ROCKS_LOG_HEADER(log, "                       Options.manual_wal_flush: %d",
                    manual_wal_flush);
+  ROCKS_LOG_HEADER(log, "                        Options.wal_compression: %s",
+                   CompressionTypeToString(wal_compression).c_str());
   ROCKS_LOG_HEADER(log, "                           Options.atomic_flush: %d",
                    atomic_flush);
   ROCKS_LOG_HEADER(log, "          Options.avoid_unnecessary_blocking_io: %d",
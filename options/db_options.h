@@ -41,6 +41,8 @@ struct ImmutableDBOptions {
   size_t keep_log_file_num;
   size_t recycle_log_file_num;
   size_t prepare_log_writer_num;
+  size_t wal_recovery_readahead_size;
+  size_t wal_recovery_insert_threads;
   uint64_t max_manifest_file_size;
   uint64_t max_manifest_edit_count;
   int table_cache_numshardbits;
@@ -59,6 +61,7 @@ struct ImmutableDBOptions {
   WriteBufferFlushPri write_buffer_flush_pri;
   size_t db_write_buffer_size;
   std::shared_ptr<WriteBufferManager> write_buffer_manager;
+  std::shared_ptr<MemoryArbiter> memory_arbiter;
   DBOptions::AccessHint access_hint_on_compaction_start;
   bool new_table_reader_for_compaction_inputs;
   size_t random_access_max_buffer_size;
@@ -70,6 +73,7 @@ struct ImmutableDBOptions {
   bool enable_write_thread_adaptive_yield;
   uint64_t write_thread_max_yield_usec;
   uint64_t write_thread_slow_yield_usec;
+  size_t memtable_insert_split_size;
   bool skip_stats_update_on_db_open;
   WALRecoveryMode wal_recovery_mode;
   bool allow_2pc;
@@ -84,6 +88,7 @@ struct ImmutableDBOptions {
   bool preserve_deletes;
   bool two_write_queues;
   bool manual_wal_flush;
+  CompressionType wal_compression;
   bool atomic_flush;
   bool avoid_unnecessary_blocking_io;
 };
@@ -255,6 +255,8 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                    blob_size);
   ROCKS_LOG_HEADER(log, "                   Options.blob_large_key_ratio: %f",
                    blob_large_key_ratio);
+  ROCKS_LOG_HEADER(log, "                    Options.blob_value_location: %d",
+                   blob_value_location);
   ROCKS_LOG_HEADER(log, "                          Options.blob_gc_ratio: %f",
                    blob_gc_ratio);
 
@@ -565,6 +567,8 @@ ReadOptions::ReadOptions()
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
+      blob_readahead_files(0),
+      value_meta_only(false),
       iter_start_seqnum(0) {}
 
 ReadOptions::ReadOptions(bool cksum, bool cache)
@@ -583,6 +587,8 @@ ReadOptions::ReadOptions(bool cksum, bool cache)
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
+      blob_readahead_files(0),
+      value_meta_only(false),
       iter_start_seqnum(0) {}
 
 }  // namespace rocksdb
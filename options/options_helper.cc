@@ -69,6 +69,10 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.keep_log_file_num = immutable_db_options.keep_log_file_num;
   options.recycle_log_file_num = immutable_db_options.recycle_log_file_num;
   options.prepare_log_writer_num = immutable_db_options.prepare_log_writer_num;
+  options.wal_recovery_readahead_size =
+      immutable_db_options.wal_recovery_readahead_size;
+  options.wal_recovery_insert_threads =
+      immutable_db_options.wal_recovery_insert_threads;
   options.max_manifest_file_size = immutable_db_options.max_manifest_file_size;
   options.max_manifest_edit_count =
       immutable_db_options.max_manifest_edit_count;
@@ -92,6 +96,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.write_buffer_flush_pri = immutable_db_options.write_buffer_flush_pri;
   options.db_write_buffer_size = immutable_db_options.db_write_buffer_size;
   options.write_buffer_manager = immutable_db_options.write_buffer_manager;
+  options.memory_arbiter = immutable_db_options.memory_arbiter;
   options.access_hint_on_compaction_start =
       immutable_db_options.access_hint_on_compaction_start;
   options.new_table_reader_for_compaction_inputs =
@@ -115,6 +120,8 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
       immutable_db_options.write_thread_max_yield_usec;
   options.write_thread_slow_yield_usec =
       immutable_db_options.write_thread_slow_yield_usec;
+  options.memtable_insert_split_size =
+      immutable_db_options.memtable_insert_split_size;
   options.skip_stats_update_on_db_open =
       immutable_db_options.skip_stats_update_on_db_open;
   options.wal_recovery_mode = immutable_db_options.wal_recovery_mode;
@@ -134,6 +141,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.preserve_deletes = immutable_db_options.preserve_deletes;
   options.two_write_queues = immutable_db_options.two_write_queues;
   options.manual_wal_flush = immutable_db_options.manual_wal_flush;
+  options.wal_compression = immutable_db_options.wal_compression;
   options.atomic_flush = immutable_db_options.atomic_flush;
   options.avoid_unnecessary_blocking_io =
       immutable_db_options.avoid_unnecessary_blocking_io;
@@ -163,6 +171,7 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.disable_auto_compactions;
   cf_opts.blob_size = mutable_cf_options.blob_size;
   cf_opts.blob_large_key_ratio = mutable_cf_options.blob_large_key_ratio;
+  cf_opts.blob_value_location = mutable_cf_options.blob_value_location;
   cf_opts.blob_gc_ratio = mutable_cf_options.blob_gc_ratio;
   cf_opts.soft_pending_compaction_bytes_limit =
       mutable_cf_options.soft_pending_compaction_bytes_limit;
@@ -480,12 +489,21 @@ bool ParseOptionHelper(char* opt_address, const OptionType& opt_type,
     case OptionType::kInt:
       *reinterpret_cast<int*>(opt_address) = ParseInt(value);
       break;
+    case OptionType::kInt8T:
+      *reinterpret_cast<int8_t*>(opt_address) = ParseInt8(value);
+      break;
     case OptionType::kVectorInt:
       *reinterpret_cast<std::vector<int>*>(opt_address) = ParseVectorInt(value);
       break;
     case OptionType::kUInt:
       *reinterpret_cast<unsigned int*>(opt_address) = ParseUint32(value);
       break;
+    case OptionType::kUInt8T:
+      *reinterpret_cast<uint8_t*>(opt_address) = ParseUint8(value);
+      break;
+    case OptionType::kUInt16T:
+      *reinterpret_cast<uint16_t*>(opt_address) = ParseUint16(value);
+      break;
     case OptionType::kUInt32T:
       *reinterpret_cast<uint32_t*>(opt_address) = ParseUint32(value);
       break;
@@ -602,12 +620,23 @@ bool SerializeSingleOptionHelper(const char* opt_address,
     case OptionType::kInt:
       *value = ToString(*(reinterpret_cast<const int*>(opt_address)));
       break;
+    case OptionType::kInt8T:
+      *value = ToString(
+          static_cast<int>(*reinterpret_cast<const int8_t*>(opt_address)));
+      break;
     case OptionType::kVectorInt:
       return SerializeIntVector(
           *reinterpret_cast<const std::vector<int>*>(opt_address), value);
     case OptionType::kUInt:
       *value = ToString(*(reinterpret_cast<const unsigned int*>(opt_address)));
       break;
+    case OptionType::kUInt8T:
+      *value = ToString(
+          static_cast<uint32_t>(*reinterpret_cast<const uint8_t*>(opt_address)));
+      break;
+    case OptionType::kUInt16T:
+      *value = ToString(*(reinterpret_cast<const uint16_t*>(opt_address)));
+      break;
     case OptionType::kUInt32T:
       *value = ToString(*(reinterpret_cast<const uint32_t*>(opt_address)));
       break;
@@ -1541,6 +1570,12 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"prepare_log_writer_num",
          {offsetof(struct DBOptions, prepare_log_writer_num),
           OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}},
+        {"wal_recovery_readahead_size",
+         {offsetof(struct DBOptions, wal_recovery_readahead_size),
+          OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}},
+        {"wal_recovery_insert_threads",
+         {offsetof(struct DBOptions, wal_recovery_insert_threads),
+          OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}},
         {"log_file_time_to_roll",
          {offsetof(struct DBOptions, log_file_time_to_roll), OptionType::kSizeT,
           OptionVerificationType::kNormal, false, 0}},
@@ -1619,6 +1654,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"write_thread_max_yield_usec",
          {offsetof(struct DBOptions, write_thread_max_yield_usec),
           OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"memtable_insert_split_size",
+         {offsetof(struct DBOptions, memtable_insert_split_size),
+          OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}},
         {"access_hint_on_compaction_start",
          {offsetof(struct DBOptions, access_hint_on_compaction_start),
           OptionType::kAccessHint, OptionVerificationType::kNormal, false, 0}},
@@ -1658,6 +1696,10 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct DBOptions, manual_wal_flush), OptionType::kBoolean,
           OptionVerificationType::kNormal, false,
           offsetof(struct ImmutableDBOptions, manual_wal_flush)}},
+        {"wal_compression",
+         {offsetof(struct DBOptions, wal_compression),
+          OptionType::kCompressionType, OptionVerificationType::kNormal, false,
+          offsetof(struct ImmutableDBOptions, wal_compression)}},
         {"seq_per_batch",
          {0, OptionType::kBoolean, OptionVerificationType::kDeprecated, false,
           0}},
@@ -1807,6 +1849,10 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::blob_large_key_ratio),
           OptionType::kDouble, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, blob_large_key_ratio)}},
+        {"blob_value_location",
+         {offset_of(&ColumnFamilyOptions::blob_value_location),
+          OptionType::kBoolean, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, blob_value_location)}},
         {"blob_gc_ratio",
          {offset_of(&ColumnFamilyOptions::blob_gc_ratio), OptionType::kDouble,
           OptionVerificationType::kNormal, true,
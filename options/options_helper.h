@@ -48,8 +48,11 @@ Status GetTableFactoryFromMap(
 enum class OptionType {
   kBoolean,
   kInt,
+  kInt8T,
   kVectorInt,
   kUInt,
+  kUInt8T,
+  kUInt16T,
   kUInt32T,
   kUInt64T,
   kSizeT,
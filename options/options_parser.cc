@@ -500,12 +500,21 @@ bool AreEqualOptions(
     case OptionType::kInt:
       return (*reinterpret_cast<const int*>(offset1) ==
               *reinterpret_cast<const int*>(offset2));
+    case OptionType::kInt8T:
+      return (*reinterpret_cast<const int8_t*>(offset1) ==
+              *reinterpret_cast<const int8_t*>(offset2));
     case OptionType::kVectorInt:
       return (*reinterpret_cast<const std::vector<int>*>(offset1) ==
               *reinterpret_cast<const std::vector<int>*>(offset2));
     case OptionType::kUInt:
       return (*reinterpret_cast<const unsigned int*>(offset1) ==
               *reinterpret_cast<const unsigned int*>(offset2));
+    case OptionType::kUInt8T:
+      return (*reinterpret_cast<const uint8_t*>(offset1) ==
+              *reinterpret_cast<const uint8_t*>(offset2));
+    case OptionType::kUInt16T:
+      return (*reinterpret_cast<const uint16_t*>(offset1) ==
+              *reinterpret_cast<const uint16_t*>(offset2));
     case OptionType::kUInt32T:
       return (*reinterpret_cast<const uint32_t*>(offset1) ==
               *reinterpret_cast<const uint32_t*>(offset2));
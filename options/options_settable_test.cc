@@ -155,7 +155,8 @@ TEST_F(OptionsSettableTest, BlockBasedTableOptionsAllFieldsSettable) {
       "hash_index_allow_collision=false;"
       "verify_compression=true;read_amp_bytes_per_bit=0;"
       "enable_index_compression=false;"
-      "block_align=true",
+      "block_align=true;"
+      "block_cache_demotion_compression=kLZ4Compression",
       new_bbto));
 
   ASSERT_EQ(unset_bytes_base,
@@ -196,6 +197,8 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
       {offsetof(struct DBOptions, wal_dir), sizeof(std::string)},
       {offsetof(struct DBOptions, write_buffer_manager),
        sizeof(std::shared_ptr<WriteBufferManager>)},
+      {offsetof(struct DBOptions, memory_arbiter),
+       sizeof(std::shared_ptr<MemoryArbiter>)},
       {offsetof(struct DBOptions, listeners),
        sizeof(std::vector<std::shared_ptr<EventListener>>)},
       {offsetof(struct DBOptions, row_cache), sizeof(std::shared_ptr<Cache>)},
@@ -263,6 +266,8 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "enable_thread_tracking=false;"
                              "recycle_log_file_num=0;"
                              "prepare_log_writer_num=0;"
+                             "wal_recovery_readahead_size=1048576;"
+                             "wal_recovery_insert_threads=4;"
                              "create_missing_column_families=true;"
                              "log_file_time_to_roll=3097;"
                              "max_background_flushes=35;"
@@ -288,6 +293,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "enable_write_thread_adaptive_yield=true;"
                              "write_thread_slow_yield_usec=5;"
                              "write_thread_max_yield_usec=1000;"
+                             "memtable_insert_split_size=1000;"
                              "access_hint_on_compaction_start=NONE;"
                              "info_log_level=DEBUG_LEVEL;"
                              "dump_malloc_stats=false;"
@@ -299,6 +305,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "concurrent_prepare=false;"
                              "two_write_queues=false;"
                              "manual_wal_flush=false;"
+                             "wal_compression=kZSTD;"
                              "seq_per_batch=false;"
                              "atomic_flush=false;"
                              "avoid_unnecessary_blocking_io=false",
@@ -460,6 +467,7 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "disable_auto_compactions=false;"
       "blob_size=1028;"
       "blob_large_key_ratio=0.5;"
+      "blob_value_location=true;"
       "blob_size=1024;"
       "blob_gc_ratio=0.05;"
       "report_bg_io_stats=true;"
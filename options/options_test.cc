@@ -26,6 +26,9 @@
 #include "rocksdb/convenience.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/utilities/leveldb_options.h"
+#ifdef WITH_TERARK_ZIP
+#include "table/terark_zip_table.h"
+#endif
 #include "util/random.h"
 #include "util/stderr_logger.h"
 #include "util/string_util.h"
@@ -719,6 +722,55 @@ TEST_F(OptionsTest, GetPlainTableOptionsFromString) {
 }
 #endif  // !ROCKSDB_LITE
 
+#if !defined(ROCKSDB_LITE) && defined(WITH_TERARK_ZIP)
+TEST_F(OptionsTest, TerarkZipTableOptionsStringRoundTrip) {
+  TerarkZipTableOptions table_opt;
+  // narrow fields next to each other, a too wide store clobbers neighbours
+  table_opt.debugLevel = 0;
+  table_opt.indexNestScale = 5;
+  table_opt.indexTempLevel = -1;
+  table_opt.enableCompressionProbe = false;
+  table_opt.enableEntropyStore = false;
+  table_opt.cbtHashBits = 7;
+  table_opt.buildParallelism = 3;
+  table_opt.offsetArrayBlockUnits = 64;
+  table_opt.localTempDir = test::TmpDir();
+  std::shared_ptr<TableFactory> factory(
+      NewTerarkZipTableFactory(table_opt, nullptr));
+  std::string opt_str;
+  ASSERT_OK(factory->GetOptionString(&opt_str, ";"));
+
+  TerarkZipTableOptions new_opt;
+  ASSERT_OK(GetTerarkZipTableOptionsFromString(TerarkZipTableOptions(),
+                                               opt_str, &new_opt));
+  ASSERT_EQ(new_opt.debugLevel, 0);
+  ASSERT_EQ(new_opt.indexNestScale, 5);
+  ASSERT_EQ(new_opt.indexTempLevel, -1);
+  ASSERT_FALSE(new_opt.enableCompressionProbe);
+  ASSERT_TRUE(new_opt.useSuffixArrayLocalMatch ==
+              table_opt.useSuffixArrayLocalMatch);
+  ASSERT_FALSE(new_opt.enableEntropyStore);
+  ASSERT_EQ(new_opt.cbtHashBits, 7);
+  ASSERT_EQ(new_opt.buildParallelism, 3);
+  ASSERT_EQ(new_opt.offsetArrayBlockUnits, 64);
+  ASSERT_EQ(new_opt.localTempDir, table_opt.localTempDir);
+
+  std::shared_ptr<TableFactory> new_factory(
+      NewTerarkZipTableFactory(new_opt, nullptr));
+  std::string new_opt_str;
+  ASSERT_OK(new_factory->GetOptionString(&new_opt_str, ";"));
+  ASSERT_EQ(opt_str, new_opt_str);
+
+  // out of range for the field width
+  ASSERT_NOK(GetTerarkZipTableOptionsFromString(
+      TerarkZipTableOptions(), "buildParallelism=256", &new_opt));
+  ASSERT_NOK(GetTerarkZipTableOptionsFromString(
+      TerarkZipTableOptions(), "offsetArrayBlockUnits=65536", &new_opt));
+  ASSERT_NOK(GetTerarkZipTableOptionsFromString(
+      TerarkZipTableOptions(), "indexTempLevel=128", &new_opt));
+}
+#endif  // !ROCKSDB_LITE && WITH_TERARK_ZIP
+
 #ifndef ROCKSDB_LITE  // GetMemTableRepFactoryFromString is not supported
 TEST_F(OptionsTest, GetMemTableRepFactoryFromString) {
   std::unique_ptr<MemTableRepFactory> new_mem_factory = nullptr;
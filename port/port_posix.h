@@ -114,6 +114,8 @@ class Mutex {
   ~Mutex();
 
   void Lock();
+  // false if the mutex is held by another thread
+  bool TryLock();
   void Unlock();
   // this will assert if the mutex is not locked
   // it does NOT verify that mutex is held by a calling thread
@@ -138,6 +138,17 @@ class Mutex {
 #endif
   }
 
+  // false if the mutex is held by another thread
+  bool TryLock() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+#ifndef NDEBUG
+    locked_ = true;
+#endif
+    return true;
+  }
+
   void Unlock() {
 #ifndef NDEBUG
     locked_ = false;
@@ -15,6 +15,7 @@ LIB_SOURCES =                                                   \
   db/compaction_picker_fifo.cc                                  \
   db/compaction_picker_universal.cc                             \
   db/compaction_dispatcher.cc                                   \
+  db/compaction_worker_codec.cc                                 \
   db/convenience.cc                                             \
   db/db_filesnapshot.cc                                         \
   db/db_impl.cc                                                 \
@@ -120,6 +121,7 @@ LIB_SOURCES =                                                   \
   table/get_context.cc                                          \
   table/index_builder.cc                                        \
   table/iterator.cc                                             \
+  table/map_sst_element_index.cc                                \
   table/merging_iterator.cc                                     \
   table/meta_blocks.cc                                          \
   table/partitioned_filter_block.cc                             \
@@ -133,6 +135,7 @@ LIB_SOURCES =                                                   \
   table/sst_file_writer.cc                                      \
   table/table_properties.cc                                     \
   table/table_reader.cc                                         \
+  table/terark_zip_adaptive_builder.cc                          \
   table/terark_zip_common.cc                                    \
   table/terark_zip_config.cc                                    \
   table/terark_zip_table_builder.cc                             \
@@ -151,6 +154,7 @@ LIB_SOURCES =                                                   \
   util/concurrent_arena.cc                                      \
   util/crc32c.cc                                                \
   util/delete_scheduler.cc                                      \
+  util/dependence_map.cc                                        \
   util/dynamic_bloom.cc                                         \
   util/event_logger.cc                                          \
   util/file_reader_writer.cc                                    \
@@ -162,6 +166,7 @@ LIB_SOURCES =                                                   \
   util/jemalloc_nodump_allocator.cc                             \
   util/lazy_buffer.cc                                           \
   util/log_buffer.cc                                            \
+  util/memory_arbiter.cc                                        \
   util/murmurhash.cc                                            \
   util/random.cc                                                \
   util/rate_limiter.cc                                          \
@@ -173,6 +178,7 @@ LIB_SOURCES =                                                   \
   util/sync_point_impl.cc                                       \
   util/thread_local.cc                                          \
   util/threadpool_imp.cc                                        \
+  util/tiny_lfu.cc                                              \
   util/trace_replay.cc                                          \
   util/transaction_test_util.cc                                 \
   util/xxhash.cc                                                \
@@ -276,12 +282,15 @@ TEST_LIB_SOURCES = \
 MAIN_SOURCES =                                                          \
   cache/cache_bench.cc                                                  \
   cache/cache_test.cc                                                   \
+  cache/lirs_cache_test.cc                                              \
   db/column_family_test.cc                                              \
   db/compact_files_test.cc                                              \
+  db/compaction_dispatcher_test.cc                                      \
   db/compaction_iterator_test.cc                                        \
   db/compaction_job_stats_test.cc                                       \
   db/compaction_job_test.cc                                             \
   db/compaction_picker_test.cc                                          \
+  db/compaction_worker_codec_test.cc                                    \
   db/comparator_db_test.cc                                              \
   db/corruption_test.cc                                                 \
   db/cuckoo_table_db_test.cc                                            \
@@ -380,6 +389,7 @@ MAIN_SOURCES =                                                          \
   table/sst_file_reader_test.cc                                         \
   table/table_reader_bench.cc                                           \
   table/table_test.cc                                                   \
+  table/terark_zip_adaptive_builder.cc                                  \
   table/terark_zip_config.cc                                            \
   table/terark_zip_table_builder.cc                                     \
   table/terark_zip_table_reader.cc                                      \
@@ -398,9 +408,12 @@ MAIN_SOURCES =                                                          \
   util/bloom_test.cc                                                    \
   util/coding_test.cc                                                   \
   util/crc32c_test.cc                                                   \
+  util/dependence_map_bench.cc                                          \
+  util/dependence_map_test.cc                                           \
   util/dynamic_bloom_test.cc                                            \
   util/event_logger_test.cc                                             \
   util/filelock_test.cc                                                 \
+  util/memory_arbiter_test.cc                                           \
   util/log_write_bench.cc                                               \
   util/rate_limiter_test.cc                                             \
   util/repeatable_thread_test.cc                                        \
@@ -408,6 +421,8 @@ MAIN_SOURCES =                                                          \
   util/timer_queue_test.cc                                              \
   util/thread_list_test.cc                                              \
   util/thread_local_test.cc                                             \
+  util/tiny_lfu_test.cc                                                 \
+  util/loser_tree_test.cc                                               \
   utilities/backupable/backupable_db_test.cc                            \
   utilities/cassandra/cassandra_format_test.cc                          \
   utilities/cassandra/cassandra_functional_test.cc                      \
@@ -964,6 +964,12 @@ uint64_t BlockBasedTableBuilder::FileSize() const {
   return rep_->offset;
 }
 
+uint64_t BlockBasedTableBuilder::LastEntryLocation() const {
+  // The pending data block gets the next ordinal when flushed
+  assert(!rep_->data_block.empty());
+  return rep_->props.num_data_blocks;
+}
+
 bool BlockBasedTableBuilder::NeedCompact() const {
   for (const auto& collector : rep_->table_properties_collectors) {
     if (collector->NeedCompact()) {
@@ -77,6 +77,9 @@ class BlockBasedTableBuilder : public TableBuilder {
   // Finish() call, returns the size of the final generated file.
   uint64_t FileSize() const override;
 
+  // Ordinal of the data block holding the last added entry
+  uint64_t LastEntryLocation() const override;
+
   bool NeedCompact() const override;
 
   // Get table properties
@@ -27,6 +27,7 @@
 #include "table/block_based_table_builder.h"
 #include "table/block_based_table_reader.h"
 #include "table/format.h"
+#include "util/compression.h"
 #include "util/mutexlock.h"
 #include "util/string_util.h"
 
@@ -375,6 +376,11 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  block_align: %d\n",
            table_options_.block_align);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  block_cache_demotion_compression: %s\n",
+           CompressionTypeToString(
+               table_options_.block_cache_demotion_compression)
+               .c_str());
+  ret.append(buffer);
   return ret;
 }
 
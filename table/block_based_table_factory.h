@@ -187,6 +187,11 @@ static std::unordered_map<std::string, OptionTypeInfo>
         {"pin_top_level_index_and_filter",
          {offsetof(struct BlockBasedTableOptions,
                    pin_top_level_index_and_filter),
-          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}}};
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"block_cache_demotion_compression",
+         {offsetof(struct BlockBasedTableOptions,
+                   block_cache_demotion_compression),
+          OptionType::kCompressionType, OptionVerificationType::kNormal, false,
+          0}}};
 #endif  // !ROCKSDB_LITE
 }  // namespace rocksdb
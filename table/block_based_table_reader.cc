@@ -28,6 +28,7 @@
 #include "rocksdb/table_properties.h"
 #include "table/block.h"
 #include "table/block_based_filter_block.h"
+#include "table/block_based_table_builder.h"
 #include "table/block_based_table_factory.h"
 #include "table/block_fetcher.h"
 #include "table/block_prefix_index.h"
@@ -42,7 +43,10 @@
 #include "table/sst_file_writer_collectors.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/file_reader_writer.h"
+#include "util/memory_allocator.h"
+#include "util/mutexlock.h"
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
@@ -204,6 +208,123 @@ bool PrefixExtractorChanged(const TablePropertiesBase* table_properties_base,
 
 }  // namespace
 
+// Data blocks evicted from the block cache of a table are compressed into
+// block_cache_compressed, see block_cache_demotion_compression. Shared by
+// the table and its cached blocks, which may be evicted after the table is
+// closed.
+struct BlockCacheDemotion {
+  std::shared_ptr<Cache> block_cache_compressed;
+  CompressionType compression_type;
+  uint32_t format_version;
+  Statistics* statistics;
+  std::string cache_key_prefix;
+  std::string compressed_cache_key_prefix;
+  // Cleared by the table when it is closed, blocks evicted after that are
+  // dropped. Demotions hold the read lock.
+  port::RWMutex mutex;
+  bool active = true;
+
+  void Demote(const Slice& key, const Block* block);
+};
+
+void BlockCacheDemotion::Demote(const Slice& key, const Block* block) {
+  ReadLock l(&mutex);
+  if (!active || block->size() == 0 || !key.starts_with(cache_key_prefix)) {
+    return;
+  }
+  // The thread whose insert evicted the block compresses it, with a context
+  // kept per core
+  CompressionContextCache* ctx_cache = CompressionContextCache::Instance();
+  int64_t ctx_idx;
+  std::unique_ptr<CompressionContext> compression_ctx =
+      ctx_cache->GetCachedCompressionContext(compression_type, &ctx_idx);
+  CompressionType type;
+  std::string compressed;
+  Slice data = CompressBlock(Slice(block->data(), block->size()),
+                             *compression_ctx, &type, format_version,
+                             &compressed);
+  ctx_cache->ReturnCachedCompressionContext(std::move(compression_ctx),
+                                            ctx_idx);
+  if (type == kNoCompression) {
+    return;
+  }
+
+  // Same layout as a raw block read from the file: the compressed data
+  // followed by the compression type
+  CacheAllocationPtr allocation = AllocateBlock(
+      data.size() + 1, block_cache_compressed->memory_allocator());
+  memcpy(allocation.get(), data.data(), data.size());
+  allocation.get()[data.size()] = static_cast<char>(type);
+  BlockContents* contents = new BlockContents(std::move(allocation),
+                                              data.size());
+#ifndef NDEBUG
+  contents->is_raw_block = true;
+#endif  // NDEBUG
+
+  std::string compressed_key = compressed_cache_key_prefix;
+  compressed_key.append(key.data() + cache_key_prefix.size(),
+                        key.size() - cache_key_prefix.size());
+  Status s = block_cache_compressed->Insert(compressed_key, contents,
+                                            contents->ApproximateMemoryUsage(),
+                                            &DeleteCachedEntry<BlockContents>);
+  if (s.ok()) {
+    RecordTick(statistics, BLOCK_CACHE_COMPRESSED_DEMOTE);
+    RecordTick(statistics, BLOCK_CACHE_COMPRESSED_DEMOTE_BYTES, data.size());
+  } else {
+    RecordTick(statistics, BLOCK_CACHE_COMPRESSED_ADD_FAILURES);
+    delete contents;
+  }
+}
+
+namespace {
+
+// A data block in the block cache which is demoted when it leaves the cache
+class DemotableBlock : public Block {
+ public:
+  DemotableBlock(BlockContents&& contents, SequenceNumber _global_seqno,
+                 size_t read_amp_bytes_per_bit, Statistics* statistics,
+                 std::shared_ptr<BlockCacheDemotion> demotion)
+      : Block(std::move(contents), _global_seqno, read_amp_bytes_per_bit,
+              statistics),
+        demotion_(std::move(demotion)) {}
+
+  void Demote(const Slice& key) const { demotion_->Demote(key, this); }
+
+ private:
+  std::shared_ptr<BlockCacheDemotion> demotion_;
+};
+
+void DeleteDemotableBlock(const Slice& key, void* value) {
+  auto block = static_cast<DemotableBlock*>(reinterpret_cast<Block*>(value));
+  block->Demote(key);
+  delete block;
+}
+
+// Create a block to be inserted into the block cache, a DemotableBlock if
+// `demotion` is set. Block has no virtual destructor, so the block must be
+// freed by DeleteDemotableBlock() as the cache deleter or by
+// DeleteCachedBlock().
+Block* NewCachedBlock(BlockContents&& contents, SequenceNumber global_seqno,
+                      size_t read_amp_bytes_per_bit, Statistics* statistics,
+                      const std::shared_ptr<BlockCacheDemotion>& demotion) {
+  if (demotion != nullptr) {
+    return new DemotableBlock(std::move(contents), global_seqno,
+                              read_amp_bytes_per_bit, statistics, demotion);
+  }
+  return new Block(std::move(contents), global_seqno, read_amp_bytes_per_bit,
+                   statistics);
+}
+
+void DeleteCachedBlock(Block* block, bool demotable) {
+  if (demotable) {
+    delete static_cast<DemotableBlock*>(block);
+  } else {
+    delete block;
+  }
+}
+
+}  // namespace
+
 // Index that allows binary search lookup in a two-level index structure.
 class PartitionIndexReader : public IndexReader, public Cleanable {
  public:
@@ -625,6 +746,24 @@ void BlockBasedTable::SetupCacheKeyPrefix(Rep* rep, uint64_t file_size) {
                         rep->file->file(), &rep->compressed_cache_key_prefix[0],
                         &rep->compressed_cache_key_prefix_size);
   }
+  if (rep->table_options.block_cache != nullptr &&
+      rep->table_options.block_cache_compressed != nullptr &&
+      rep->table_options.block_cache_demotion_compression != kNoCompression &&
+      !rep->immortal_table) {
+    auto demotion = std::make_shared<BlockCacheDemotion>();
+    demotion->block_cache_compressed =
+        rep->table_options.block_cache_compressed;
+    demotion->compression_type =
+        rep->table_options.block_cache_demotion_compression;
+    demotion->format_version = rep->table_options.format_version;
+    demotion->statistics = rep->ioptions.statistics;
+    demotion->cache_key_prefix.assign(rep->cache_key_prefix,
+                                      rep->cache_key_prefix_size);
+    demotion->compressed_cache_key_prefix.assign(
+        rep->compressed_cache_key_prefix,
+        rep->compressed_cache_key_prefix_size);
+    rep->cache_demotion = std::move(demotion);
+  }
 }
 
 void BlockBasedTable::GenerateCachePrefix(Cache* cc, RandomAccessFile* file,
@@ -1283,30 +1422,38 @@ Status BlockBasedTable::GetDataBlockFromCache(
   CompressionType compression_type = compressed_block->get_compression_type();
   assert(compression_type != kNoCompression);
 
-  // Retrieve the uncompressed contents into a new buffer
+  // Retrieve the uncompressed contents into a new buffer. Demoted blocks
+  // are compressed without dictionary.
   BlockContents contents;
-  UncompressionContext uncompresssion_ctx(compression_type, compression_dict);
+  UncompressionContext uncompresssion_ctx(
+      compression_type,
+      rep->cache_demotion != nullptr ? Slice() : compression_dict);
   s = UncompressBlockContents(uncompresssion_ctx, compressed_block->data.data(),
                               compressed_block->data.size(), &contents,
                               rep->table_options.format_version, rep->ioptions,
                               GetMemoryAllocator(rep->table_options));
 
   // Insert uncompressed block into block cache
+  bool promoted = false;
   if (s.ok()) {
-    block->value =
-        new Block(std::move(contents), rep->get_global_seqno(is_index),
-                  read_amp_bytes_per_bit,
-                  statistics);  // uncompressed block
+    bool demotable = rep->cache_demotion != nullptr && !is_index &&
+                     block_cache != nullptr && read_options.fill_cache;
+    block->value = NewCachedBlock(
+        std::move(contents), rep->get_global_seqno(is_index),
+        read_amp_bytes_per_bit, statistics,
+        demotable ? rep->cache_demotion : nullptr);  // uncompressed block
     if (block_cache != nullptr && block->value->own_bytes() &&
         read_options.fill_cache) {
       size_t charge = block->value->ApproximateMemoryUsage();
-      s = block_cache->Insert(block_cache_key, block->value, charge,
-                              &DeleteCachedEntry<Block>,
-                              &(block->cache_handle));
+      s = block_cache->Insert(
+          block_cache_key, block->value, charge,
+          demotable ? &DeleteDemotableBlock : &DeleteCachedEntry<Block>,
+          &(block->cache_handle));
 #ifndef NDEBUG
       block_cache->TEST_mark_as_data_block(block_cache_key, charge);
 #endif  // NDEBUG
       if (s.ok()) {
+        promoted = demotable;
         if (get_context != nullptr) {
           get_context->get_context_stats_.num_cache_add++;
           get_context->get_context_stats_.num_cache_bytes_write += charge;
@@ -1335,14 +1482,17 @@ Status BlockBasedTable::GetDataBlockFromCache(
         }
       } else {
         RecordTick(statistics, BLOCK_CACHE_ADD_FAILURES);
-        delete block->value;
+        DeleteCachedBlock(block->value, demotable);
         block->value = nullptr;
       }
     }
   }
 
-  // Release hold on compressed cache entry
-  block_cache_compressed->Release(block_cache_compressed_handle);
+  // Release hold on compressed cache entry. A block promoted back to the
+  // block cache is demoted again when evicted, so the compressed copy is
+  // dropped.
+  block_cache_compressed->Release(block_cache_compressed_handle,
+                                  promoted /* force_erase */);
   return s;
 }
 
@@ -1354,7 +1504,8 @@ Status BlockBasedTable::PutDataBlockToCache(
     CompressionType raw_block_comp_type, uint32_t format_version,
     const Slice& compression_dict, SequenceNumber seq_no,
     size_t read_amp_bytes_per_bit, MemoryAllocator* memory_allocator,
-    bool is_index, Cache::Priority priority, GetContext* get_context) {
+    const std::shared_ptr<BlockCacheDemotion>& demotion, bool is_index,
+    Cache::Priority priority, GetContext* get_context) {
   assert(raw_block_comp_type == kNoCompression ||
          block_cache_compressed != nullptr);
 
@@ -1374,19 +1525,19 @@ Status BlockBasedTable::PutDataBlockToCache(
     return s;
   }
 
-  if (raw_block_comp_type != kNoCompression) {
-    cached_block->value = new Block(std::move(uncompressed_block_contents),
-                                    seq_no, read_amp_bytes_per_bit,
-                                    statistics);  // uncompressed block
-  } else {
-    cached_block->value =
-        new Block(std::move(*raw_block_contents), seq_no,
-                  read_amp_bytes_per_bit, ioptions.statistics);
-  }
+  BlockContents& block_contents = raw_block_comp_type != kNoCompression
+                                      ? uncompressed_block_contents
+                                      : *raw_block_contents;
+  bool demotable = demotion != nullptr && !is_index &&
+                   block_cache != nullptr && block_contents.own_bytes();
+  cached_block->value = NewCachedBlock(
+      std::move(block_contents), seq_no, read_amp_bytes_per_bit, statistics,
+      demotable ? demotion : nullptr);  // uncompressed block
 
-  // Insert compressed block into compressed block cache.
+  // Insert compressed block into compressed block cache, unless it is filled
+  // by demotion.
   // Release the hold on the compressed cache entry immediately.
-  if (block_cache_compressed != nullptr &&
+  if (block_cache_compressed != nullptr && demotion == nullptr &&
       raw_block_comp_type != kNoCompression && raw_block_contents != nullptr &&
       raw_block_contents->own_bytes()) {
 #ifndef NDEBUG
@@ -1413,9 +1564,10 @@ Status BlockBasedTable::PutDataBlockToCache(
   // insert into uncompressed block cache
   if (block_cache != nullptr && cached_block->value->own_bytes()) {
     size_t charge = cached_block->value->ApproximateMemoryUsage();
-    s = block_cache->Insert(block_cache_key, cached_block->value, charge,
-                            &DeleteCachedEntry<Block>,
-                            &(cached_block->cache_handle), priority);
+    s = block_cache->Insert(
+        block_cache_key, cached_block->value, charge,
+        demotable ? &DeleteDemotableBlock : &DeleteCachedEntry<Block>,
+        &(cached_block->cache_handle), priority);
 #ifndef NDEBUG
     block_cache->TEST_mark_as_data_block(block_cache_key, charge);
 #endif  // NDEBUG
@@ -1450,7 +1602,7 @@ Status BlockBasedTable::PutDataBlockToCache(
                  cached_block->cache_handle)) == cached_block->value);
     } else {
       RecordTick(statistics, BLOCK_CACHE_ADD_FAILURES);
-      delete cached_block->value;
+      DeleteCachedBlock(cached_block->value, demotable);
       cached_block->value = nullptr;
     }
   }
@@ -1891,8 +2043,9 @@ Status BlockBasedTable::MaybeReadBlockAndLoadToCache(
     // file.
     if (block_entry->value == nullptr && !no_io && ro.fill_cache) {
       Statistics* statistics = rep->ioptions.statistics;
-      bool do_decompress =
-          block_cache_compressed == nullptr && rep->blocks_maybe_compressed;
+      bool do_decompress = (block_cache_compressed == nullptr ||
+                            rep->cache_demotion != nullptr) &&
+                           rep->blocks_maybe_compressed;
       CompressionType raw_block_comp_type;
       BlockContents raw_block_contents;
       {
@@ -1917,7 +2070,8 @@ Status BlockBasedTable::MaybeReadBlockAndLoadToCache(
             block_entry, &raw_block_contents, raw_block_comp_type,
             rep->table_options.format_version, compression_dict, seq_no,
             rep->table_options.read_amp_bytes_per_bit,
-            GetMemoryAllocator(rep->table_options), is_index,
+            GetMemoryAllocator(rep->table_options), rep->cache_demotion,
+            is_index,
             is_index && rep->table_options
                             .cache_index_and_filter_blocks_with_high_priority
                 ? Cache::Priority::HIGH
@@ -2400,6 +2554,36 @@ bool BlockBasedTable::FullFilterKeyMayMatch(
   return may_match;
 }
 
+namespace {
+// Values of DataBlockIter, pinned by referencing the cached block
+class DataBlockValueState : public LazyBufferState {
+ public:
+  virtual void destroy(LazyBuffer* /*buffer*/) const override {}
+
+  virtual Status pin_buffer(LazyBuffer* buffer) const override {
+    if (buffer->size() <= sizeof(LazyBufferContext)) {
+      buffer->reset(buffer->slice(), true, buffer->file_number());
+      return Status::OK();
+    }
+    auto context = get_context(buffer);
+    DataBlockIter* iter = reinterpret_cast<DataBlockIter*>(context->data[0]);
+    assert(iter != nullptr);
+    Cleanable release_cached_entry = iter->RefCache();
+    if (release_cached_entry.Empty()) {
+      return Status::NotSupported();
+    }
+    buffer->reset(buffer->slice(), std::move(release_cached_entry),
+                  buffer->file_number());
+    return Status::OK();
+  }
+
+  Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
+    return Status::OK();
+  }
+};
+const DataBlockValueState data_block_value_state;
+}  // namespace
+
 Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
                             GetContext* get_context,
                             const SliceTransform* prefix_extractor,
@@ -2483,34 +2667,6 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
           break;
         }
 
-        class LazyBufferStateImpl : public LazyBufferState {
-         public:
-          virtual void destroy(LazyBuffer* /*buffer*/) const override {}
-
-          virtual Status pin_buffer(LazyBuffer* buffer) const override {
-            if (buffer->size() <= sizeof(LazyBufferContext)) {
-              buffer->reset(buffer->slice(), true, buffer->file_number());
-              return Status::OK();
-            }
-            auto context = get_context(buffer);
-            DataBlockIter* iter =
-                reinterpret_cast<DataBlockIter*>(context->data[0]);
-            assert(iter != nullptr);
-            Cleanable release_cached_entry = iter->RefCache();
-            if (release_cached_entry.Empty()) {
-              return Status::NotSupported();
-            }
-            buffer->reset(buffer->slice(), std::move(release_cached_entry),
-                          buffer->file_number());
-            return Status::OK();
-          }
-
-          Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
-            return Status::OK();
-          }
-        };
-        static LazyBufferStateImpl static_state;
-
         // Call the *saver function on each entry/block until it returns false
         for (; biter.Valid(); biter.Next()) {
           ParsedInternalKey parsed_key;
@@ -2520,7 +2676,7 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
 
           if (!get_context->SaveValue(
                   parsed_key,
-                  LazyBuffer(&static_state,
+                  LazyBuffer(&data_block_value_state,
                              {reinterpret_cast<uint64_t>(&biter)},
                              biter.value(), rep_->file_number),
                   &matched)) {
@@ -2554,6 +2710,286 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
   return s;
 }
 
+void BlockBasedTable::MultiGet(const ReadOptions& read_options,
+                               size_t num_keys, const Slice* keys,
+                               GetContext** get_contexts, Status* statuses,
+                               const SliceTransform* prefix_extractor,
+                               bool skip_filters) {
+  if (num_keys == 0) {
+    return;
+  }
+  const bool no_io = read_options.read_tier == kBlockCacheTier;
+  CachableEntry<FilterBlockReader> filter_entry;
+  if (!skip_filters) {
+    filter_entry = GetFilter(prefix_extractor, /*prefetch_buffer*/ nullptr,
+                             no_io, get_contexts[0]);
+  }
+  FilterBlockReader* filter = filter_entry.value;
+
+  IndexBlockIter iiter_on_stack;
+  bool need_upper_bound_check = false;
+  if (rep_->index_type == BlockBasedTableOptions::kHashSearch) {
+    need_upper_bound_check = PrefixExtractorChanged(
+        &rep_->table_properties_base, prefix_extractor);
+  }
+  InternalIteratorBase<BlockHandle>* iiter = nullptr;
+  std::unique_ptr<InternalIteratorBase<BlockHandle>> iiter_unique_ptr;
+
+  std::vector<char> key_may_match(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    assert(keys[i].size() >= 8);  // key must be internal key
+    assert(i == 0 ||
+           rep_->internal_comparator.Compare(keys[i - 1], keys[i]) <= 0);
+    key_may_match[i] = FullFilterKeyMayMatch(read_options, filter, keys[i],
+                                             no_io, prefix_extractor);
+    if (!key_may_match[i]) {
+      RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+      PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_useful, 1, rep_->level);
+      statuses[i] = Status::OK();
+    } else if (iiter == nullptr) {
+      iiter = NewIndexIterator(read_options, need_upper_bound_check,
+                               &iiter_on_stack, /* index_entry */ nullptr,
+                               get_contexts[i]);
+      if (iiter != &iiter_on_stack) {
+        iiter_unique_ptr.reset(iiter);
+      }
+    }
+  }
+
+  // Data blocks missing from the block cache are read by one MultiRead
+  // instead of one Read per block
+  std::vector<uint64_t> prefetch_offsets;
+  std::unique_ptr<FilePrefetchBuffer[]> prefetch_buffers;
+  if (!no_io && iiter != nullptr && num_keys > 1) {
+    Cache* block_cache = rep_->table_options.block_cache.get();
+    Cache* block_cache_compressed =
+        rep_->immortal_table
+            ? nullptr
+            : rep_->table_options.block_cache_compressed.get();
+    char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+    std::vector<size_t> prefetch_lens;
+    uint64_t last_offset = port::kMaxUint64;
+    for (size_t i = 0; i < num_keys; ++i) {
+      if (!key_may_match[i]) {
+        continue;
+      }
+      iiter->Seek(keys[i]);
+      if (!iiter->Valid()) {
+        continue;
+      }
+      BlockHandle handle = iiter->value();
+      if (handle.offset() == last_offset) {
+        continue;
+      }
+      last_offset = handle.offset();
+      bool cached = false;
+      for (auto cache : {block_cache, block_cache_compressed}) {
+        if (cache == nullptr || cached) {
+          continue;
+        }
+        Slice key = cache == block_cache
+                        ? GetCacheKey(rep_->cache_key_prefix,
+                                      rep_->cache_key_prefix_size, handle,
+                                      cache_key)
+                        : GetCacheKey(rep_->compressed_cache_key_prefix,
+                                      rep_->compressed_cache_key_prefix_size,
+                                      handle, cache_key);
+        Cache::Handle* cache_handle = cache->Lookup(key);
+        if (cache_handle != nullptr) {
+          cache->Release(cache_handle);
+          cached = true;
+        }
+      }
+      if (!cached) {
+        prefetch_offsets.push_back(handle.offset());
+        prefetch_lens.push_back(static_cast<size_t>(handle.size()) +
+                                kBlockTrailerSize);
+      }
+    }
+    if (prefetch_offsets.size() > 1) {
+      prefetch_buffers.reset(new FilePrefetchBuffer[prefetch_offsets.size()]);
+      Status s = FilePrefetchBuffer::MultiPrefetch(
+          rep_->file.get(), prefetch_offsets.size(), prefetch_buffers.get(),
+          prefetch_offsets.data(), prefetch_lens.data());
+      if (!s.ok()) {
+        // Blocks are read one by one below
+        prefetch_buffers.reset();
+      }
+    }
+  }
+
+  // Data block of the previous key, reused while keys stay in it
+  std::unique_ptr<DataBlockIter> biter;
+  BlockHandle biter_handle;
+
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (!key_may_match[i]) {
+      continue;
+    }
+    const Slice& key = keys[i];
+    GetContext* get_context = get_contexts[i];
+    Status s;
+
+    bool matched = false;  // if such user key mathced a key in SST
+    bool done = false;
+    for (iiter->Seek(key); iiter->Valid() && !done; iiter->Next()) {
+      BlockHandle handle = iiter->value();
+
+      bool not_exist_in_filter =
+          filter != nullptr && filter->IsBlockBased() == true &&
+          !filter->KeyMayMatch(ExtractUserKey(key), prefix_extractor,
+                               handle.offset(), no_io);
+
+      if (not_exist_in_filter) {
+        RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+        PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_useful, 1, rep_->level);
+        break;
+      }
+      if (biter == nullptr || biter_handle.offset() != handle.offset() ||
+          !biter->status().ok()) {
+        biter.reset(new DataBlockIter);
+        biter_handle = handle;
+        FilePrefetchBuffer* prefetch_buffer = nullptr;
+        if (prefetch_buffers) {
+          auto find = std::lower_bound(prefetch_offsets.begin(),
+                                       prefetch_offsets.end(), handle.offset());
+          if (find != prefetch_offsets.end() && *find == handle.offset()) {
+            prefetch_buffer =
+                &prefetch_buffers[find - prefetch_offsets.begin()];
+          }
+        }
+        NewDataBlockIterator<DataBlockIter>(
+            rep_, read_options, handle, biter.get(), false,
+            true /* key_includes_seq */, true /* index_key_is_full */,
+            get_context, Status(), prefetch_buffer);
+      }
+
+      if (no_io && biter->status().IsIncomplete()) {
+        // couldn't get block from block_cache
+        get_context->MarkKeyMayExist();
+        break;
+      }
+      if (!biter->status().ok()) {
+        s = biter->status();
+        break;
+      }
+
+      bool may_exist = biter->SeekForGet(key);
+      if (!may_exist) {
+        break;
+      }
+
+      for (; biter->Valid(); biter->Next()) {
+        ParsedInternalKey parsed_key;
+        if (!ParseInternalKey(biter->key(), &parsed_key)) {
+          s = Status::Corruption(Slice());
+        }
+
+        if (!get_context->SaveValue(
+                parsed_key,
+                LazyBuffer(&data_block_value_state,
+                           {reinterpret_cast<uint64_t>(biter.get())},
+                           biter->value(), rep_->file_number),
+                &matched)) {
+          done = true;
+          break;
+        }
+      }
+      s = biter->status();
+      if (done) {
+        break;
+      }
+    }
+    if (matched && filter != nullptr && !filter->IsBlockBased()) {
+      RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_FULL_TRUE_POSITIVE);
+      PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_full_true_positive, 1,
+                                rep_->level);
+    }
+    if (s.ok()) {
+      s = iiter->status();
+    }
+    statuses[i] = s;
+  }
+
+  if (!rep_->filter_entry.IsSet()) {
+    filter_entry.Release(rep_->table_options.block_cache.get());
+  }
+}
+
+Status BlockBasedTable::LoadDataBlockHandles(const ReadOptions& read_options) {
+  if (rep_->data_block_handles_ready.load(std::memory_order_acquire)) {
+    return Status::OK();
+  }
+  std::lock_guard<std::mutex> lock(rep_->data_block_handles_mutex);
+  if (rep_->data_block_handles_ready.load(std::memory_order_relaxed)) {
+    return Status::OK();
+  }
+  IndexBlockIter iiter_on_stack;
+  auto iiter = NewIndexIterator(read_options, false, &iiter_on_stack);
+  std::unique_ptr<InternalIteratorBase<BlockHandle>> iiter_unique_ptr;
+  if (iiter != &iiter_on_stack) {
+    iiter_unique_ptr.reset(iiter);
+  }
+  std::vector<BlockHandle> handles;
+  if (rep_->table_properties) {
+    handles.reserve(rep_->table_properties->num_data_blocks);
+  }
+  for (iiter->SeekToFirst(); iiter->Valid(); iiter->Next()) {
+    handles.emplace_back(iiter->value());
+  }
+  Status s = iiter->status();
+  if (s.ok()) {
+    rep_->data_block_handles = std::move(handles);
+    rep_->data_block_handles_ready.store(true, std::memory_order_release);
+  }
+  return s;
+}
+
+Status BlockBasedTable::GetByLocation(const ReadOptions& read_options,
+                                      const Slice& key, uint64_t location,
+                                      GetContext* get_context) {
+  assert(key.size() >= 8);  // key must be internal key
+  Status s = LoadDataBlockHandles(read_options);
+  if (!s.ok()) {
+    return s;
+  }
+  if (location >= rep_->data_block_handles.size()) {
+    return Status::Corruption("BlockBasedTable::GetByLocation",
+                              "location out of range");
+  }
+  TEST_SYNC_POINT("BlockBasedTable::GetByLocation");
+  DataBlockIter biter;
+  NewDataBlockIterator<DataBlockIter>(
+      rep_, read_options, rep_->data_block_handles[location], &biter, false,
+      true /* key_includes_seq */, true /* index_key_is_full */, get_context);
+  if (read_options.read_tier == kBlockCacheTier &&
+      biter.status().IsIncomplete()) {
+    get_context->MarkKeyMayExist();
+    return Status::OK();
+  }
+  if (!biter.status().ok()) {
+    return biter.status();
+  }
+  bool matched = false;
+  if (biter.SeekForGet(key)) {
+    for (; biter.Valid(); biter.Next()) {
+      ParsedInternalKey parsed_key;
+      if (!ParseInternalKey(biter.key(), &parsed_key)) {
+        return Status::Corruption(Slice());
+      }
+      if (!get_context->SaveValue(
+              parsed_key,
+              LazyBuffer(&data_block_value_state,
+                         {reinterpret_cast<uint64_t>(&biter)}, biter.value(),
+                         rep_->file_number),
+              &matched)) {
+        break;
+      }
+    }
+  }
+  return biter.status();
+}
+
 Status BlockBasedTable::Prefetch(const Slice* const begin,
                                  const Slice* const end) {
   auto& comparator = rep_->internal_comparator;
@@ -3073,6 +3509,11 @@ void BlockBasedTable::Close() {
                                 rep_->dummy_index_reader_offset, cache_key);
     rep_->table_options.block_cache.get()->Erase(key);
   }
+  // The data blocks left in the block cache may outlive the statistics
+  if (rep_->cache_demotion != nullptr) {
+    WriteLock l(&rep_->cache_demotion->mutex);
+    rep_->cache_demotion->active = false;
+  }
   rep_->closed = true;
 }
 
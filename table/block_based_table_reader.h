@@ -10,7 +10,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -37,6 +39,7 @@
 namespace rocksdb {
 
 class BlockHandle;
+struct BlockCacheDemotion;
 class Cache;
 class FilterBlockReader;
 class BlockBasedFilterBlockReader;
@@ -122,6 +125,17 @@ class BlockBasedTable : public TableReader {
              GetContext* get_context, const SliceTransform* prefix_extractor,
              bool skip_filters = false) override;
 
+  // Filter and index are fetched once, keys falling in the same data block
+  // share one block read
+  void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                const SliceTransform* prefix_extractor,
+                bool skip_filters = false) override;
+
+  // location is the data block ordinal recorded by BlockBasedTableBuilder
+  Status GetByLocation(const ReadOptions& readOptions, const Slice& key,
+                       uint64_t location, GetContext* get_context) override;
+
   // Pre-fetch the disk blocks that correspond to the key range specified by
   // (kbegin, kend). The call will return error status in the event of
   // IO or iteration error.
@@ -293,6 +307,9 @@ class BlockBasedTable : public TableReader {
       CachableEntry<IndexReader>* index_entry = nullptr,
       GetContext* get_context = nullptr);
 
+  // Fill rep_->data_block_handles once, for GetByLocation()
+  Status LoadDataBlockHandles(const ReadOptions& read_options);
+
   // Read block cache from block caches (if set): block_cache and
   // block_cache_compressed.
   // On success, Status::OK with be returned and @block will be populated with
@@ -317,6 +334,8 @@ class BlockBasedTable : public TableReader {
   // PutDataBlockToCache(). After the call, the object will be invalid.
   // @param compression_dict Data for presetting the compression library's
   //    dictionary.
+  // @param demotion If not null, data blocks are demoted to the compressed
+  //    block cache when evicted, instead of inserting the raw block there.
   static Status PutDataBlockToCache(
       const Slice& block_cache_key, const Slice& compressed_block_cache_key,
       Cache* block_cache, Cache* block_cache_compressed,
@@ -325,6 +344,7 @@ class BlockBasedTable : public TableReader {
       CompressionType raw_block_comp_type, uint32_t format_version,
       const Slice& compression_dict, SequenceNumber seq_no,
       size_t read_amp_bytes_per_bit, MemoryAllocator* memory_allocator,
+      const std::shared_ptr<BlockCacheDemotion>& demotion,
       bool is_index = false, Cache::Priority pri = Cache::Priority::LOW,
       GetContext* get_context = nullptr);
 
@@ -466,6 +486,8 @@ struct BlockBasedTable::Rep {
   size_t persistent_cache_key_prefix_size = 0;
   char compressed_cache_key_prefix[kMaxCacheKeyPrefixSize];
   size_t compressed_cache_key_prefix_size = 0;
+  // Set if evicted data blocks are demoted to block_cache_compressed
+  std::shared_ptr<BlockCacheDemotion> cache_demotion;
   uint64_t dummy_index_reader_offset =
       0;  // ID that is unique for the block cache.
   PersistentCacheOptions persistent_cache_options;
@@ -536,6 +558,11 @@ struct BlockBasedTable::Rep {
   bool closed = false;
   const bool immortal_table;
 
+  // Data block handles in file order, loaded by the first GetByLocation()
+  std::mutex data_block_handles_mutex;
+  std::atomic<bool> data_block_handles_ready{false};
+  std::vector<BlockHandle> data_block_handles;
+
   SequenceNumber get_global_seqno(bool is_index) const {
     return is_index ? kDisableGlobalSequenceNumber : global_seqno;
   }
@@ -124,10 +124,14 @@ LazyBuffer CombinedInternalIterator::value() const {
 }
 
 LazyBuffer CombinedInternalIterator::value(const Slice& user_key,
-                                           std::string* meta) const {
+                                           std::string* meta,
+                                           uint64_t* location) const {
   if (meta != nullptr) {
     meta->clear();
   }
+  if (location != nullptr) {
+    *location = SeparateHelper::kNoLocation;
+  }
   if (separate_helper_ == nullptr) {
     return iter_->value();
   }
@@ -145,6 +149,13 @@ LazyBuffer CombinedInternalIterator::value(const Slice& user_key,
     auto meta_slice = SeparateHelper::DecodeValueMeta(value_index.slice());
     meta->assign(meta_slice.data(), meta_slice.size());
   }
+  // GC moves values into other files, the location only holds in the file
+  // it was recorded for
+  if (location != nullptr && value_index.valid() &&
+      v.file_number() ==
+          SeparateHelper::DecodeFileNumber(value_index.slice())) {
+    *location = SeparateHelper::DecodeLocation(value_index.slice());
+  }
   return v;
 }
 
@@ -103,7 +103,10 @@ class CombinedInternalIterator : public InternalIterator {
   bool Valid() const override { return iter_->Valid(); }
   Slice key() const override { return iter_->key(); }
   LazyBuffer value() const override;
-  LazyBuffer value(const Slice& user_key, std::string* meta) const;
+  // location receives the value location carried by the value index, or
+  // SeparateHelper::kNoLocation if absent or no longer valid
+  LazyBuffer value(const Slice& user_key, std::string* meta,
+                   uint64_t* location = nullptr) const;
   Status status() const override { return iter_->status(); }
   void Next() override { iter_->Next(); }
   void Prev() override { iter_->Prev(); }
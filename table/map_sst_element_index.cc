@@ -0,0 +1,78 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "table/map_sst_element_index.h"
+
+#include <algorithm>
+
+#include "db/dbformat.h"
+
+namespace rocksdb {
+
+Status MapSstElementIndex::Build(InternalIterator* iter) {
+  keys_.clear();
+  elements_.clear();
+  links_.clear();
+  // Key slices are fixed up once keys_ stops growing
+  struct KeyOffset {
+    size_t smallest, smallest_size, largest, largest_size;
+  };
+  std::vector<KeyOffset> offsets;
+  MapSstElement map_element;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    LazyBuffer value = iter->value();
+    Status s = value.fetch();
+    if (!s.ok()) {
+      return s;
+    }
+    if (!map_element.Decode(iter->key(), value.slice())) {
+      return Status::Corruption("Map sst invalid link_value");
+    }
+    Element e;
+    e.flags = (map_element.include_smallest ? MapSstElement::kIncludeSmallest
+                                            : MapSstElement::kEmpty) |
+              (map_element.include_largest ? MapSstElement::kIncludeLargest
+                                           : MapSstElement::kEmpty) |
+              (map_element.has_delete_range ? MapSstElement::kHasDeleteRange
+                                            : MapSstElement::kEmpty);
+    e.link_begin = static_cast<uint32_t>(links_.size());
+    e.link_count = static_cast<uint32_t>(map_element.link.size());
+    for (auto& link : map_element.link) {
+      links_.push_back(link.file_number);
+    }
+    KeyOffset offset;
+    offset.smallest = keys_.size();
+    offset.smallest_size = map_element.smallest_key.size();
+    keys_.append(map_element.smallest_key.data(),
+                 map_element.smallest_key.size());
+    offset.largest = keys_.size();
+    offset.largest_size = map_element.largest_key.size();
+    keys_.append(map_element.largest_key.data(),
+                 map_element.largest_key.size());
+    offsets.push_back(offset);
+    elements_.push_back(e);
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+  for (size_t i = 0; i < elements_.size(); ++i) {
+    elements_[i].smallest_key =
+        Slice(keys_.data() + offsets[i].smallest, offsets[i].smallest_size);
+    elements_[i].largest_key =
+        Slice(keys_.data() + offsets[i].largest, offsets[i].largest_size);
+  }
+  return Status::OK();
+}
+
+size_t MapSstElementIndex::LowerBound(const InternalKeyComparator& icomp,
+                                      const Slice& k) const {
+  return std::lower_bound(elements_.begin(), elements_.end(), k,
+                          [&icomp](const Element& e, const Slice& key) {
+                            return icomp.Compare(e.largest_key, key) < 0;
+                          }) -
+         elements_.begin();
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,59 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "table/internal_iterator.h"
+
+namespace rocksdb {
+
+class InternalKeyComparator;
+
+// All MapSstElement of a map sst, decoded once. Point lookups binary search
+// the elements by largest key instead of seeking the table and re-parsing
+// the varint encoded element for every query.
+class MapSstElementIndex {
+ public:
+  struct Element {
+    Slice smallest_key;
+    Slice largest_key;
+    // MapSstElement::Flags
+    uint64_t flags;
+    // Link file numbers are links_[link_begin, link_begin + link_count)
+    uint32_t link_begin;
+    uint32_t link_count;
+  };
+
+  // Decode all elements from iter, which must be positioned before the
+  // first element or at it.
+  Status Build(InternalIterator* iter);
+
+  size_t size() const { return elements_.size(); }
+  const Element& element(size_t i) const { return elements_[i]; }
+  const uint64_t* links(const Element& e) const {
+    return links_.data() + e.link_begin;
+  }
+
+  // Index of the first element whose largest key is not less than k, same as
+  // where Seek(k) on the map sst would land. Returns size() if none.
+  size_t LowerBound(const InternalKeyComparator& icomp, const Slice& k) const;
+
+  size_t ApproximateMemoryUsage() const {
+    return keys_.capacity() + elements_.capacity() * sizeof(Element) +
+           links_.capacity() * sizeof(uint64_t);
+  }
+
+ private:
+  std::string keys_;
+  std::vector<Element> elements_;
+  std::vector<uint64_t> links_;
+};
+
+}  // namespace rocksdb
@@ -181,6 +181,11 @@ class TableBuilder {
   // Finish() call, returns the size of the final generated file.
   virtual uint64_t FileSize() const = 0;
 
+  // Location of the entry passed to the last Add() call, which the reader of
+  // this table resolves by TableReader::GetByLocation() without an index
+  // search. uint64_t(-1) if not supported.
+  virtual uint64_t LastEntryLocation() const { return uint64_t(-1); }
+
   // If the user defined table properties collector suggest the file to
   // be further compacted.
   virtual bool NeedCompact() const { return false; }
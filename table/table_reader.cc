@@ -10,11 +10,17 @@
 #include "table_reader.h"
 #include "rocksdb/statistics.h"
 #include "table/get_context.h"
+#include "table/map_sst_element_index.h"
 #include "table/scoped_arena_iterator.h"
 #include "util/arena.h"
+#include "util/sync_point.h"
 
 namespace rocksdb {
 
+TableReader::~TableReader() {
+  delete map_sst_element_index_.load(std::memory_order_relaxed);
+}
+
 void TableReader::RangeScan(const Slice* begin,
                             const SliceTransform* prefix_extractor, void* arg,
                             bool (*callback_func)(void* arg, const Slice& key,
@@ -28,6 +34,17 @@ void TableReader::RangeScan(const Slice* begin,
   }
 }
 
+void TableReader::MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                           const Slice* keys, GetContext** get_contexts,
+                           Status* statuses,
+                           const SliceTransform* prefix_extractor,
+                           bool skip_filters) {
+  for (size_t i = 0; i < num_keys; ++i) {
+    statuses[i] = Get(readOptions, keys[i], get_contexts[i], prefix_extractor,
+                      skip_filters);
+  }
+}
+
 void TableReader::UpdateMaxCoveringTombstoneSeq(
     const rocksdb::ReadOptions& readOptions, const rocksdb::Slice& user_key,
     rocksdb::SequenceNumber* max_covering_tombstone_seq) {
@@ -43,4 +60,33 @@ void TableReader::UpdateMaxCoveringTombstoneSeq(
   }
 }
 
+Status TableReader::GetMapSstElementIndex(const MapSstElementIndex** index) {
+  MapSstElementIndex* ptr =
+      map_sst_element_index_.load(std::memory_order_acquire);
+  if (ptr == nullptr) {
+    std::unique_ptr<MapSstElementIndex> new_index(new MapSstElementIndex);
+    Arena arena;
+    ScopedArenaIterator iter(NewIterator(ReadOptions(), nullptr, &arena));
+    Status s = new_index->Build(iter.get());
+    if (!s.ok()) {
+      return s;
+    }
+    TEST_SYNC_POINT("TableReader::GetMapSstElementIndex:Build");
+    // Concurrent builders may race, the loser drops its copy
+    if (map_sst_element_index_.compare_exchange_strong(
+            ptr, new_index.get(), std::memory_order_acq_rel,
+            std::memory_order_acquire)) {
+      ptr = new_index.release();
+    }
+  }
+  *index = ptr;
+  return Status::OK();
+}
+
+size_t TableReader::MapSstElementIndexMemoryUsage() const {
+  MapSstElementIndex* ptr =
+      map_sst_element_index_.load(std::memory_order_acquire);
+  return ptr == nullptr ? 0 : ptr->ApproximateMemoryUsage();
+}
+
 }  // namespace rocksdb
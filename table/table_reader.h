@@ -8,6 +8,7 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #pragma once
+#include <atomic>
 #include <memory>
 #include "db/range_tombstone_fragmenter.h"
 #include "rocksdb/cache.h"
@@ -24,13 +25,15 @@ class Statistics;
 struct ReadOptions;
 struct TableProperties;
 class GetContext;
+class MapSstElementIndex;
 
 // A Table is a sorted map from strings to strings.  Tables are
 // immutable and persistent.  A Table may be safely accessed from
 // multiple threads without external synchronization.
 class TableReader {
  public:
-  virtual ~TableReader() {}
+  TableReader() : map_sst_element_index_(nullptr) {}
+  virtual ~TableReader();
 
   // Returns a new iterator over the table contents.
   // The result of NewIterator() is initially invalid (caller must
@@ -90,6 +93,26 @@ class TableReader {
                      const SliceTransform* prefix_extractor,
                      bool skip_filters = false) = 0;
 
+  // Batched Get(): statuses[i] is the result of Get() of keys[i] with
+  // get_contexts[i]. keys must be sorted by internal key. The default
+  // implementation calls Get() for each key, tables may override it to probe
+  // the filter and index once and read a data block once for all keys in it.
+  virtual void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                        const Slice* keys, GetContext** get_contexts,
+                        Status* statuses,
+                        const SliceTransform* prefix_extractor,
+                        bool skip_filters = false);
+
+  // Same as Get(), but starts from the entry at location, which is the
+  // TableBuilder::LastEntryLocation() of key when this table was built, to
+  // skip the index search. Returns NotSupported if the table can't address
+  // entries by location, then caller should fall back to Get().
+  virtual Status GetByLocation(const ReadOptions& /*readOptions*/,
+                               const Slice& /*key*/, uint64_t /*location*/,
+                               GetContext* /*get_context*/) {
+    return Status::NotSupported();
+  }
+
   // Logic same as for(it->Seek(begin); it->Valid() && callback(*it); ++it) {}
   // Specialization for performance
   virtual void RangeScan(const Slice* begin,
@@ -128,6 +151,17 @@ class TableReader {
       SequenceNumber* max_covering_tombstone_seq);
 
   virtual void Close() {}
+
+  // Decoded elements of a map sst, built on first call and kept until the
+  // reader is destroyed.
+  Status GetMapSstElementIndex(const MapSstElementIndex** index);
+
+  // Memory held by the decoded map sst elements, 0 before they are built.
+  // Not part of ApproximateMemoryUsage(), which each reader implements.
+  size_t MapSstElementIndexMemoryUsage() const;
+
+ private:
+  std::atomic<MapSstElementIndex*> map_sst_element_index_;
 };
 
 }  // namespace rocksdb
@@ -0,0 +1,337 @@
+/*
+ * terark_zip_adaptive_builder.cc
+ *
+ * Chooses between terarkZip and the fallback TableFactory for every output
+ * file by compressing a sample of its head both ways.
+ */
+
+// project headers
+#include "terark_zip_common.h"
+#include "terark_zip_internal.h"
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+// rocksdb headers
+#include <db/dbformat.h>
+#include <db/table_properties_collector.h>
+#include <rocksdb/table.h>
+#include <table/table_builder.h>
+// third party
+#include <zstd/zstd.h>
+
+namespace rocksdb {
+
+// defined in terark_zip_table_builder.cc
+extern TableBuilder* createTerarkZipTableBuilder(
+    const TerarkZipTableFactory* table_factory,
+    const TerarkZipTableOptions& tzo, const TableBuilderOptions& tbo,
+    uint32_t column_family_id, WritableFileWriter* file,
+    uint32_t key_prefixLen);
+
+const std::string kTerarkZipAdaptiveFormat = "terark.adaptive.format";
+const std::string kTerarkZipAdaptiveReason = "terark.adaptive.reason";
+
+namespace {
+
+// Hands out the collectors of the column family to the chosen builder, the
+// factories are owned by the column family
+class ForwardingCollectorFactory : public IntTblPropCollectorFactory {
+ public:
+  explicit ForwardingCollectorFactory(IntTblPropCollectorFactory* base)
+      : base_(base) {}
+
+  IntTblPropCollector* CreateIntTblPropCollector(
+      const TablePropertiesCollectorFactory::Context& context) override {
+    return base_->CreateIntTblPropCollector(context);
+  }
+  const char* Name() const override { return base_->Name(); }
+
+ private:
+  IntTblPropCollectorFactory* base_;
+};
+
+class AdaptiveDecisionCollector : public IntTblPropCollector {
+ public:
+  AdaptiveDecisionCollector(const std::string& format,
+                            const std::string& reason)
+      : format_(format), reason_(reason) {}
+
+  Status Finish(UserCollectedProperties* properties) override {
+    properties->emplace(kTerarkZipAdaptiveFormat, format_);
+    properties->emplace(kTerarkZipAdaptiveReason, reason_);
+    return Status::OK();
+  }
+  const char* Name() const override { return "TerarkZipAdaptiveDecision"; }
+  Status InternalAdd(const Slice&, const Slice&, uint64_t) override {
+    return Status::OK();
+  }
+  UserCollectedProperties GetReadableProperties() const override {
+    return UserCollectedProperties{{kTerarkZipAdaptiveFormat, format_},
+                                   {kTerarkZipAdaptiveReason, reason_}};
+  }
+
+ private:
+  std::string format_;
+  std::string reason_;
+};
+
+class AdaptiveDecisionCollectorFactory : public IntTblPropCollectorFactory {
+ public:
+  AdaptiveDecisionCollectorFactory(const std::string& format,
+                                   const std::string& reason)
+      : format_(format), reason_(reason) {}
+
+  IntTblPropCollector* CreateIntTblPropCollector(
+      const TablePropertiesCollectorFactory::Context&) override {
+    return new AdaptiveDecisionCollector(format_, reason_);
+  }
+  const char* Name() const override {
+    return "TerarkZipAdaptiveDecisionFactory";
+  }
+
+ private:
+  std::string format_;
+  std::string reason_;
+};
+
+// Buffers the first adaptiveSampleBytes of an output, then creates the table
+// builder the sample favors, replays the buffered entries into it and
+// forwards everything else
+class TerarkZipAdaptiveBuilder : public TableBuilder {
+ public:
+  TerarkZipAdaptiveBuilder(const TerarkZipTableFactory* table_factory,
+                           TableFactory* fallback_factory,
+                           const TerarkZipTableOptions& tzo,
+                           const TableBuilderOptions& tbo,
+                           uint32_t column_family_id, WritableFileWriter* file,
+                           uint32_t key_prefixLen)
+      : table_factory_(table_factory),
+        fallback_factory_(fallback_factory),
+        table_options_(tzo),
+        column_family_id_(column_family_id),
+        file_(file),
+        key_prefixLen_(key_prefixLen),
+        smallest_user_key_(tbo.smallest_user_key.ToString()),
+        largest_user_key_(tbo.largest_user_key.ToString()),
+        second_pass_iter_(nullptr),
+        sample_size_(0) {
+    tbo_.reset(new TableBuilderOptions(
+        tbo.ioptions, tbo.moptions, tbo.internal_comparator,
+        &collector_factories_, tbo.compression_type, tbo.compression_opts,
+        tbo.compression_dict, tbo.skip_filters, tbo.column_family_name,
+        tbo.level, tbo.compaction_load, tbo.creation_time,
+        tbo.oldest_key_time, tbo.sst_purpose));
+    tbo_->smallest_user_key = smallest_user_key_;
+    tbo_->largest_user_key = largest_user_key_;
+    if (tbo.int_tbl_prop_collector_factories) {
+      for (auto& factory : *tbo.int_tbl_prop_collector_factories) {
+        collector_factories_.emplace_back(
+            new ForwardingCollectorFactory(factory.get()));
+      }
+    }
+  }
+
+  void SetSecondPassIterator(InternalIterator* iter) override {
+    second_pass_iter_ = iter;
+    if (builder_) {
+      builder_->SetSecondPassIterator(iter);
+    }
+  }
+
+  Status Add(const Slice& key, const LazyBuffer& value) override {
+    if (builder_) {
+      return builder_->Add(key, value);
+    }
+    return Buffer(key, value, false);
+  }
+
+  Status AddTombstone(const Slice& key, const LazyBuffer& value) override {
+    if (builder_) {
+      return builder_->AddTombstone(key, value);
+    }
+    return Buffer(key, value, true);
+  }
+
+  Status Finish(const TablePropertyCache* prop,
+                const std::vector<uint64_t>* snapshots) override {
+    if (!builder_) {
+      Status s = Decide();
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    return builder_->Finish(prop, snapshots);
+  }
+
+  void Abandon() override {
+    if (builder_) {
+      builder_->Abandon();
+    }
+  }
+
+  uint64_t NumEntries() const override {
+    return builder_ ? builder_->NumEntries() : entries_.size();
+  }
+
+  uint64_t FileSize() const override {
+    return builder_ ? builder_->FileSize() : 0;
+  }
+
+  uint64_t LastEntryLocation() const override {
+    return builder_ ? builder_->LastEntryLocation() : uint64_t(-1);
+  }
+
+  bool NeedCompact() const override {
+    return builder_ ? builder_->NeedCompact() : false;
+  }
+
+  TableProperties GetTableProperties() const override {
+    return builder_ ? builder_->GetTableProperties() : TableProperties();
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    std::string value;
+    bool tombstone;
+  };
+
+  Status Buffer(const Slice& key, const LazyBuffer& value, bool tombstone) {
+    auto s = value.fetch();
+    if (!s.ok()) {
+      return s;
+    }
+    entries_.push_back(
+        Entry{key.ToString(), value.slice().ToString(), tombstone});
+    sample_size_ += key.size() + value.size();
+    if (sample_size_ >= table_options_.adaptiveSampleBytes) {
+      return Decide();
+    }
+    return Status::OK();
+  }
+
+  size_t BlockSize() const {
+    if (strcmp(fallback_factory_->Name(), "BlockBasedTable") == 0) {
+      auto bbto =
+          static_cast<BlockBasedTableOptions*>(fallback_factory_->GetOptions());
+      return std::max<size_t>(bbto->block_size, 1);
+    }
+    return 4096;
+  }
+
+  static size_t ZstdSize(const std::string& data, int level,
+                         std::string* buf) {
+    buf->resize(ZSTD_compressBound(data.size()));
+    size_t size =
+        ZSTD_compress(&(*buf)[0], buf->size(), data.data(), data.size(), level);
+    return ZSTD_isError(size) ? data.size() : size;
+  }
+
+  // dictZip compresses all values of a file against one dictionary and
+  // the index shares the common prefixes of all keys, so the sample is
+  // compressed as one frame of keys and one of values. Block based tables
+  // compress every block on its own.
+  Status Decide() {
+    int level = tbo_->compression_opts.level;
+    if (level == CompressionOptions::kDefaultCompressionLevel) {
+      level = 3;
+    }
+    const size_t block_size = BlockSize();
+    std::string keys, values, block, buf;
+    size_t block_estimate = 0;
+    auto t0 = g_pf.now();
+    for (auto& e : entries_) {
+      block.append(e.key).append(e.value);
+      if (block.size() >= block_size) {
+        block_estimate += ZstdSize(block, level, &buf);
+        block.clear();
+      }
+    }
+    if (!block.empty()) {
+      block_estimate += ZstdSize(block, level, &buf);
+    }
+    auto t1 = g_pf.now();
+    for (auto& e : entries_) {
+      keys.append(e.key);
+      values.append(e.value);
+    }
+    size_t zip_estimate =
+        ZstdSize(keys, level, &buf) + ZstdSize(values, level, &buf);
+    auto t2 = g_pf.now();
+
+    double gain =
+        block_estimate ? 1.0 - double(zip_estimate) / block_estimate : 0;
+    bool use_zip = gain >= table_options_.adaptiveMinZipGain;
+    char reason[256];
+    snprintf(reason, sizeof reason,
+             "sample=%zd entries=%zd dictzip=%zd block=%zd gain=%.3f "
+             "min_gain=%.3f dictzip_us=%.0f block_us=%.0f",
+             sample_size_, entries_.size(), zip_estimate, block_estimate,
+             gain, table_options_.adaptiveMinZipGain, g_pf.uf(t1, t2),
+             g_pf.uf(t0, t1));
+    const char* format = use_zip ? "TerarkZipTable" : fallback_factory_->Name();
+    collector_factories_.emplace_back(
+        new AdaptiveDecisionCollectorFactory(format, reason));
+    INFO(tbo_->ioptions.info_log,
+         "TerarkZipAdaptiveBuilder: level = %d, use %s, %s\n", tbo_->level,
+         format, reason);
+
+    if (use_zip) {
+      builder_.reset(createTerarkZipTableBuilder(table_factory_,
+                                                 table_options_, *tbo_,
+                                                 column_family_id_, file_,
+                                                 key_prefixLen_));
+    } else {
+      builder_.reset(fallback_factory_->NewTableBuilder(
+          *tbo_, column_family_id_, file_));
+    }
+    if (second_pass_iter_) {
+      builder_->SetSecondPassIterator(second_pass_iter_);
+    }
+    Status s;
+    for (auto& e : entries_) {
+      LazyBuffer value(e.value);
+      s = e.tombstone ? builder_->AddTombstone(e.key, value)
+                      : builder_->Add(e.key, value);
+      if (!s.ok()) {
+        break;
+      }
+    }
+    entries_.clear();
+    entries_.shrink_to_fit();
+    return s;
+  }
+
+  const TerarkZipTableFactory* table_factory_;
+  TableFactory* fallback_factory_;
+  const TerarkZipTableOptions& table_options_;
+  uint32_t column_family_id_;
+  WritableFileWriter* file_;
+  uint32_t key_prefixLen_;
+  std::string smallest_user_key_;
+  std::string largest_user_key_;
+  std::vector<std::unique_ptr<IntTblPropCollectorFactory>>
+      collector_factories_;
+  std::unique_ptr<TableBuilderOptions> tbo_;
+  InternalIterator* second_pass_iter_;
+  std::vector<Entry> entries_;
+  size_t sample_size_;
+  std::unique_ptr<TableBuilder> builder_;
+};
+
+}  // namespace
+
+TableBuilder* createTerarkZipAdaptiveBuilder(
+    const TerarkZipTableFactory* table_factory, TableFactory* fallback_factory,
+    const TerarkZipTableOptions& tzo, const TableBuilderOptions& tbo,
+    uint32_t column_family_id, WritableFileWriter* file,
+    uint32_t key_prefixLen) {
+  return new TerarkZipAdaptiveBuilder(table_factory, fallback_factory, tzo,
+                                      tbo, column_family_id, file,
+                                      key_prefixLen);
+}
+
+}  // namespace rocksdb
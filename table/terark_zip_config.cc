@@ -298,6 +298,9 @@ bool TerarkZipCFOptionsFromEnv(ColumnFamilyOptions& cfo,
   if (const char* env = getenv("TerarkZipTable_indexType")) {
     tzo.indexType = env;
   }
+  if (const char* env = getenv("TerarkZipTable_memTempDir")) {
+    tzo.memTempDir = env;
+  }
 
   MyOverrideInt(tzo, checksumLevel);
   MyOverrideInt(tzo, checksumSmallValSize);
@@ -307,6 +310,7 @@ bool TerarkZipCFOptionsFromEnv(ColumnFamilyOptions& cfo,
   MyOverrideInt(tzo, keyPrefixLen);
   MyOverrideInt(tzo, offsetArrayBlockUnits);
   MyOverrideInt(tzo, indexNestScale);
+  MyOverrideInt(tzo, buildParallelism);
 
   if (0 != tzo.offsetArrayBlockUnits && 64 != tzo.offsetArrayBlockUnits &&
       128 != tzo.offsetArrayBlockUnits) {
@@ -338,6 +342,7 @@ bool TerarkZipCFOptionsFromEnv(ColumnFamilyOptions& cfo,
   MyOverrideDouble(tzo, sampleRatio);
   MyOverrideDouble(tzo, indexCacheRatio);
   MyOverrideDouble(tzo, cbtMinKeyRatio);
+  MyOverrideDouble(tzo, adaptiveMinZipGain);
 
   MyOverrideInt(tzo, minDictZipValueSize);
   MyOverrideInt(tzo, minPreadLen);
@@ -350,6 +355,9 @@ bool TerarkZipCFOptionsFromEnv(ColumnFamilyOptions& cfo,
   MyOverrideXiB(tzo, singleIndexMinSize);
   MyOverrideXiB(tzo, singleIndexMaxSize);
   MyOverrideXiB(tzo, cacheCapacityBytes);
+  MyOverrideXiB(tzo, memTempMaxBytes);
+  MyOverrideXiB(tzo, adaptiveSampleBytes);
+  MyOverrideXiB(tzo, hotRecordCacheBytes);
   MyOverrideInt(tzo, cbtEntryPerTrie);
   MyOverrideInt(tzo, cbtMinKeySize);
   MyOverrideInt(tzo, cacheShards);
@@ -433,6 +441,10 @@ void TerarkZipConfigCompactionWorkerFromEnv(TerarkZipTableOptions& tzo) {
   } else {
     tzo.localTempDir = "/tmp";
   }
+  if (const char* env = getenv("TerarkZipTable_memTempDir")) {
+    tzo.memTempDir = env;
+  }
+  MyOverrideXiB(tzo, memTempMaxBytes);
   size_t sys_mem = TerarkGetSysMemSize();
   tzo.softZipWorkingMemLimit = sys_mem / 2;
   tzo.hardZipWorkingMemLimit = sys_mem / 2;
@@ -17,10 +17,13 @@
 #include <boost/noncopyable.hpp>
 // rocksdb headers
 #include <options/options_helper.h>
+#include <rocksdb/cache.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/env.h>
 #include <rocksdb/slice.h>
+#include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
+#include <util/tiny_lfu.h>
 // terark headers
 #include <terark/fstring.hpp>
 #include <terark/stdtypes.hpp>
@@ -165,6 +168,36 @@ struct TerarkZipMultiOffsetInfo {
   void risk_release_ownership();
 };
 
+/// decompressed records of point lookups shared by all readers of a factory,
+/// a missed record is only cached while the cache has room or when TinyLFU
+/// has seen it kMinAdmitFrequency times recently, so one-off reads of cold
+/// records don't evict hot ones
+class TerarkZipRecordCache : boost::noncopyable {
+ public:
+  struct Key {
+    char data[24];
+    uint64_t hash;
+
+    Key(uint64_t cache_id, size_t sub_index, size_t rec_id);
+    Slice slice() const { return Slice(data, sizeof data); }
+  };
+  static const uint32_t kMinAdmitFrequency = 2;
+
+  explicit TerarkZipRecordCache(size_t capacity);
+
+  /// append the cached record to buf, false if it is not cached
+  bool Lookup(const Key& key, valvec<byte_t>* buf, Statistics* stats);
+  void Insert(const Key& key, fstring record);
+
+  /// unique key prefix of a table reader, like BlockBasedTable's cache keys
+  uint64_t NewId() { return cache_->NewId(); }
+  Cache* cache() const { return cache_.get(); }
+
+ private:
+  std::shared_ptr<Cache> cache_;
+  TinyLFU admission_;
+};
+
 class TerarkZipTableFactory : public TableFactory, boost::noncopyable {
  public:
   explicit TerarkZipTableFactory(const TerarkZipTableOptions& tzto,
@@ -195,6 +228,7 @@ class TerarkZipTableFactory : public TableFactory, boost::noncopyable {
   bool IsBuilderNeedSecondPass() const override { return true; }
 
   LruReadonlyCache* cache() const { return cache_.get(); }
+  TerarkZipRecordCache* record_cache() const { return record_cache_.get(); }
 
   Status GetOptionString(std::string* opt_string,
                          const std::string& delimiter) const
@@ -206,6 +240,7 @@ class TerarkZipTableFactory : public TableFactory, boost::noncopyable {
   TableFactory* adaptive_factory_;  // just for open table
   mutable std::mutex cache_create_mutex_;
   mutable boost::intrusive_ptr<LruReadonlyCache> cache_;
+  std::unique_ptr<TerarkZipRecordCache> record_cache_;
   mutable size_t nth_new_terark_table_ = 0;
   mutable size_t nth_new_fallback_table_ = 0;
 
@@ -231,6 +231,9 @@ TerarkZipTableFactory::TerarkZipTableFactory(
     // turn off warmUpIndexOnOpen if forceMetaInMemory
     table_options_.warmUpIndexOnOpen = !tzto.forceMetaInMemory;
   }
+  if (tzto.hotRecordCacheBytes) {
+    record_cache_.reset(new TerarkZipRecordCache(tzto.hotRecordCacheBytes));
+  }
 }
 
 TerarkZipTableFactory::~TerarkZipTableFactory() { delete adaptive_factory_; }
@@ -341,6 +344,12 @@ extern TableBuilder* createTerarkZipTableBuilder(
     const TerarkZipTableOptions& tzo, const TableBuilderOptions& tbo,
     uint32_t column_family_id, WritableFileWriter* file,
     uint32_t key_prefixLen);
+// defined in terark_zip_adaptive_builder.cc
+extern TableBuilder* createTerarkZipAdaptiveBuilder(
+    const TerarkZipTableFactory* table_factory, TableFactory* fallback_factory,
+    const TerarkZipTableOptions& tzo, const TableBuilderOptions& tbo,
+    uint32_t column_family_id, WritableFileWriter* file,
+    uint32_t key_prefixLen);
 extern long long g_lastTime;
 
 TableBuilder* TerarkZipTableFactory::NewTableBuilder(
@@ -401,6 +410,13 @@ TableBuilder* TerarkZipTableFactory::NewTableBuilder(
   }
   nth_new_terark_table_++;
 
+  if (fallback_factory_ && curlevel >= 0 &&
+      table_options_.adaptiveSampleBytes > 0 &&
+      table_builder_options.sst_purpose == kEssenceSst) {
+    return createTerarkZipAdaptiveBuilder(
+        this, fallback_factory_.get(), table_options_, table_builder_options,
+        column_family_id, file, keyPrefixLen);
+  }
   return createTerarkZipTableBuilder(this, table_options_,
                                      table_builder_options, column_family_id,
                                      file, keyPrefixLen);
@@ -518,14 +534,14 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct TerarkZipTableOptions, terarkZipMinLevel),
           OptionType::kInt, OptionVerificationType::kNormal, false, 0}},
         {"debugLevel",
-         {offsetof(struct TerarkZipTableOptions, debugLevel), OptionType::kUInt,
-          OptionVerificationType::kNormal, false, 0}},
+         {offsetof(struct TerarkZipTableOptions, debugLevel),
+          OptionType::kUInt8T, OptionVerificationType::kNormal, false, 0}},
         {"indexNestScale",
          {offsetof(struct TerarkZipTableOptions, indexNestScale),
-          OptionType::kUInt, OptionVerificationType::kNormal, false, 0}},
+          OptionType::kUInt8T, OptionVerificationType::kNormal, false, 0}},
         {"indexTempLevel",
          {offsetof(struct TerarkZipTableOptions, indexTempLevel),
-          OptionType::kInt, OptionVerificationType::kNormal, false, 0}},
+          OptionType::kInt8T, OptionVerificationType::kNormal, false, 0}},
         {"enableCompressionProbe",
          {offsetof(struct TerarkZipTableOptions, enableCompressionProbe),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
@@ -555,10 +571,13 @@ std::unordered_map<std::string, OptionTypeInfo>
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
         {"cbtHashBits",
          {offsetof(struct TerarkZipTableOptions, cbtHashBits),
-          OptionType::kUInt, OptionVerificationType::kNormal, false, 0}},
+          OptionType::kUInt8T, OptionVerificationType::kNormal, false, 0}},
+        {"buildParallelism",
+         {offsetof(struct TerarkZipTableOptions, buildParallelism),
+          OptionType::kUInt8T, OptionVerificationType::kNormal, false, 0}},
         {"offsetArrayBlockUnits",
          {offsetof(struct TerarkZipTableOptions, offsetArrayBlockUnits),
-          OptionType::kUInt, OptionVerificationType::kNormal, false, 0}},
+          OptionType::kUInt16T, OptionVerificationType::kNormal, false, 0}},
         {"sampleRatio",
          {offsetof(struct TerarkZipTableOptions, sampleRatio),
           OptionType::kDouble, OptionVerificationType::kNormal, false, 0}},
@@ -568,6 +587,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"localTempDir",
          {offsetof(struct TerarkZipTableOptions, localTempDir),
           OptionType::kString, OptionVerificationType::kNormal, false, 0}},
+        {"memTempDir",
+         {offsetof(struct TerarkZipTableOptions, memTempDir),
+          OptionType::kString, OptionVerificationType::kNormal, false, 0}},
         {"indexType",
          {offsetof(struct TerarkZipTableOptions, indexType),
           OptionType::kString, OptionVerificationType::kNormal, false, 0}},
@@ -592,6 +614,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"singleIndexMaxSize",
          {offsetof(struct TerarkZipTableOptions, singleIndexMaxSize),
           OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"memTempMaxBytes",
+         {offsetof(struct TerarkZipTableOptions, memTempMaxBytes),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
         {"minPreadLen",
          {offsetof(struct TerarkZipTableOptions, minPreadLen), OptionType::kInt,
           OptionVerificationType::kNormal, false, 0}},
@@ -610,6 +635,15 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"cbtMinKeyRatio",
          {offsetof(struct TerarkZipTableOptions, cbtMinKeyRatio),
           OptionType::kDouble, OptionVerificationType::kNormal, false, 0}},
+        {"adaptiveSampleBytes",
+         {offsetof(struct TerarkZipTableOptions, adaptiveSampleBytes),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"adaptiveMinZipGain",
+         {offsetof(struct TerarkZipTableOptions, adaptiveMinZipGain),
+          OptionType::kDouble, OptionVerificationType::kNormal, false, 0}},
+        {"hotRecordCacheBytes",
+         {offsetof(struct TerarkZipTableOptions, hotRecordCacheBytes),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
 };
 
 // delimiter must be "\n"
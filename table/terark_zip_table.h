@@ -74,7 +74,11 @@ struct TerarkZipTableOptions {
   bool forceMetaInMemory = false;
   bool enableEntropyStore = true;
   uint8_t cbtHashBits = 0;
-  uint8_t reserveBytes0[5] = {};
+  /// split large outputs into about this many parts (more for compaction
+  /// outputs, target sizes are compressed sizes), their index and
+  /// uncompressed value store are built in parallel on the LOW pool
+  uint8_t buildParallelism = 1;
+  uint8_t reserveBytes0[4] = {};
   uint16_t offsetArrayBlockUnits = 0;
 
   double sampleRatio = 0.03;
@@ -83,6 +87,13 @@ struct TerarkZipTableOptions {
   // is about only 10% when set to 0.001
   double indexCacheRatio = 0;  // 0.001;
   std::string localTempDir = "/tmp";
+  /// memory backed dir (tmpfs) used instead of localTempDir to stage outputs,
+  /// so they are built without extra disk writes. The expected temp file
+  /// sizes of all builds of the process staging there at once stay within
+  /// memTempMaxBytes and the space of memTempDir. Staging memory is charged
+  /// to DBOptions::memory_arbiter if it is set. Outputs which don't fit fall
+  /// back to localTempDir
+  std::string memTempDir = "/dev/shm";
   std::string indexType = "Mixed_XL_256_32_FL";
 
   uint64_t softZipWorkingMemLimit = 16ull << 30;
@@ -95,6 +106,7 @@ struct TerarkZipTableOptions {
 
   uint64_t singleIndexMinSize = 8ULL << 20;   // 8M
   uint64_t singleIndexMaxSize = 0x1E0000000;  // 7.5G
+  uint64_t memTempMaxBytes = 0;  // 0 : always use localTempDir
 
   ///  < 0: do not use pread
   /// == 0: always use pread
@@ -107,6 +119,19 @@ struct TerarkZipTableOptions {
   double cbtMinKeyRatio = 0.5;
   uint8_t reserveBytes1[8] = {};
 
+  /// when fallback TableFactory is set, the first adaptiveSampleBytes of
+  /// every output are compressed both as one dict (dictZip estimate) and as
+  /// independent blocks (block based estimate), terarkZip is used only if it
+  /// saves at least adaptiveMinZipGain of the block based size.
+  /// 0 : always use terarkZip for levels >= terarkZipMinLevel
+  uint64_t adaptiveSampleBytes = 0;
+  double adaptiveMinZipGain = 0.1;
+
+  /// capacity of the cache of decompressed records shared by all readers,
+  /// only point lookups use it and a record is only admitted after it was
+  /// read a few times recently (TinyLFU). 0 : disable
+  uint64_t hotRecordCacheBytes = 0;
+
   class Status Parse(class Slice);
 };
 
@@ -3,9 +3,17 @@
 
 #include "terark_zip_common.h"
 // std headers
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
 #include <cfloat>
 #include <exception>
 #include <future>
+#include <unordered_map>
 // boost headers
 #include <boost/range/algorithm.hpp>
 // rocksdb headers
@@ -56,6 +64,89 @@ static valvec<PendingTask> waitQueue;
 static size_t sumWaitingMem = 0;
 static size_t sumWorkingMem = 0;
 
+static std::mutex memTempMutex;
+// Staging bytes of the builders using each memTempDir, guarded by
+// memTempMutex
+static std::unordered_map<std::string, size_t> memTempInFlight;
+
+// Per process staging dir under `memTempDir`, empty if it can't be created.
+// Each dir holds a flock'd LOCK file for the life of its process. Dirs whose
+// lock can be taken were left behind by dead processes and are removed here,
+// so a crash doesn't leak memory backed temp files. Locks rather than pids
+// are checked because /dev/shm may be shared across pid namespaces.
+static std::string TerarkZipMemTempDir(const std::string& memTempDir) {
+  static std::unordered_map<std::string, std::string> dirs;
+  auto ib = dirs.emplace(memTempDir, std::string());
+  if (!ib.second) {
+    return ib.first->second;
+  }
+  Env* env = Env::Default();
+  std::vector<std::string> children;
+  env->GetChildren(memTempDir, &children);
+  for (const std::string& child : children) {
+    if (!Slice(child).starts_with("terark-")) {
+      continue;
+    }
+    std::string dir = memTempDir + "/" + child;
+    int fd = ::open((dir + "/LOCK").c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+      // Not a staging dir, or one whose owner is still creating it
+      continue;
+    }
+    if (::flock(fd, LOCK_EX | LOCK_NB) == 0) {
+      std::vector<std::string> files;
+      env->GetChildren(dir, &files);
+      for (const std::string& f : files) {
+        if (f != "." && f != "..") {
+          env->DeleteFile(dir + "/" + f);
+        }
+      }
+      env->DeleteDir(dir);
+    }
+    ::close(fd);
+  }
+  // A sweeper of another process may remove a new dir before it is locked,
+  // the lock file is only trusted if it is still linked once locked
+  for (int retry = 0; retry < 3; ++retry) {
+    std::string dir = memTempDir + "/terark-XXXXXX";
+    if (::mkdtemp(&dir[0]) == nullptr) {
+      break;
+    }
+    std::string lock = dir + "/LOCK";
+    int fd = ::open(lock.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      continue;
+    }
+    struct stat locked, linked;
+    if (::flock(fd, LOCK_EX | LOCK_NB) == 0 && ::fstat(fd, &locked) == 0 &&
+        ::stat(lock.c_str(), &linked) == 0 && locked.st_ino == linked.st_ino) {
+      // Held until the process exits
+      ib.first->second = dir;
+      break;
+    }
+    ::close(fd);
+  }
+  return ib.first->second;
+}
+
+// Space the files in `dir` take
+static uint64_t MemTempDirUsage(const std::string& dir) {
+  uint64_t usage = 0;
+  DIR* d = ::opendir(dir.c_str());
+  if (d == nullptr) {
+    return 0;
+  }
+  while (struct dirent* e = ::readdir(d)) {
+    std::string path = dir + "/" + e->d_name;
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+      usage += uint64_t(st.st_blocks) * 512;
+    }
+  }
+  ::closedir(d);
+  return usage;
+}
+
 template <class ByteArray>
 static Status WriteBlock(const ByteArray& blockData, WritableFileWriter* file,
                          uint64_t* offset, BlockHandle* block_handle) {
@@ -194,6 +285,10 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
     }
 
     estimateRatio_ = table_factory_->GetCollect().estimate();
+    targetFileSize_ = level_ <= 0 ? tbo.moptions.write_buffer_size
+                                  : MaxFileSizeForLevel(
+                                        tbo.moptions, level_,
+                                        ioptions_.compaction_style);
 
     properties_.fixed_key_len = 0;
     properties_.num_data_blocks = 1;
@@ -235,7 +330,8 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
     file_ = file;
     sampleUpperBound_ =
         uint64_t(randomGenerator_.max() * table_options_.sampleRatio);
-    tmpSentryFile_.path = table_options_.localTempDir + "/Terark-XXXXXX";
+    tiopt_.localTempDir = ChooseTempDir();
+    tmpSentryFile_.path = tiopt_.localTempDir + "/Terark-XXXXXX";
     tmpSentryFile_.open_temp();
     tmpSampleFile_.path = tmpSentryFile_.path + ".sample";
     tmpSampleFile_.open();
@@ -248,6 +344,8 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
   } catch (const std::exception& ex) {
     WARN_EXCEPT(tbo.ioptions.info_log, "%s: Exception: %s",
                 BOOST_CURRENT_FUNCTION, ex.what());
+    // The destructor won't run
+    ReleaseMemTemp();
     throw;
   }
 }
@@ -265,10 +363,82 @@ DictZipBlobStore::ZipBuilder* TerarkZipTableBuilder::createZipBuilder() const {
 }
 
 TerarkZipTableBuilder::~TerarkZipTableBuilder() {
+  ReleaseMemTemp();
   std::unique_lock<std::mutex> zipLock(zipMutex);
   waitQueue.trim(boost::remove_if(waitQueue, TERARK_GET(.tztb) == this));
 }
 
+std::string TerarkZipTableBuilder::ChooseTempDir() {
+  const std::string& memTempDir = table_options_.memTempDir;
+  if (table_options_.memTempMaxBytes == 0 || memTempDir.empty()) {
+    return table_options_.localTempDir;
+  }
+  // Keys and values are staged uncompressed, the zipped store next to them.
+  // Flush outputs hold at most one write buffer of raw data.
+  double rawSize = targetFileSize_;
+  if (level_ > 0) {
+    rawSize /= estimateRatio_;
+  }
+  size_t stagingSize = size_t(rawSize * (1 + estimateRatio_));
+  MemoryArbiter* arbiter = ioptions_.memory_arbiter;
+  // Staging memory is charged rather than reserved: it must not hold back the
+  // working memory reservation of this very builder
+  if (arbiter != nullptr && arbiter->limit() != 0 &&
+      arbiter->usage() + stagingSize > arbiter->limit()) {
+    return table_options_.localTempDir;
+  }
+  std::string dir;
+  {
+    std::lock_guard<std::mutex> lock(memTempMutex);
+    dir = TerarkZipMemTempDir(memTempDir);
+    if (dir.empty()) {
+      return table_options_.localTempDir;
+    }
+    // Builders staging in `dir` still write to their files, the free space
+    // and what they wrote so far must hold all of them and this output.
+    // Other users of the tmpfs may still take space meanwhile.
+    size_t& inFlight = memTempInFlight[memTempDir];
+    struct statvfs vfs;
+    if (inFlight + stagingSize > table_options_.memTempMaxBytes ||
+        ::statvfs(dir.c_str(), &vfs) != 0 ||
+        uint64_t(vfs.f_bavail) * vfs.f_frsize + MemTempDirUsage(dir) <
+            inFlight + stagingSize) {
+      return table_options_.localTempDir;
+    }
+    inFlight += stagingSize;
+    memTempBytes_ = stagingSize;
+  }
+  if (arbiter != nullptr) {
+    arbiter->Charge(MemoryArbiter::kTableBuilder, stagingSize);
+  }
+  return dir;
+}
+
+void TerarkZipTableBuilder::ReleaseMemTemp() {
+  if (memTempBytes_ == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(memTempMutex);
+    memTempInFlight[table_options_.memTempDir] -= memTempBytes_;
+  }
+  if (ioptions_.memory_arbiter != nullptr) {
+    ioptions_.memory_arbiter->Discharge(MemoryArbiter::kTableBuilder,
+                                        memTempBytes_);
+  }
+  memTempBytes_ = 0;
+}
+
+MemoryArbiter::Priority TerarkZipTableBuilder::ArbiterPriority() const {
+  // Flush outputs go first, they give memtable memory back
+  if (level_ <= 0) {
+    return MemoryArbiter::kHigh;
+  } else if (level_ == ioptions_.num_levels - 1) {
+    return MemoryArbiter::kBottom;
+  }
+  return MemoryArbiter::kLow;
+}
+
 uint64_t TerarkZipTableBuilder::FileSize() const {
   if (offset_ == 0) {
     // for compaction caller to split file by increasing size
@@ -420,6 +590,20 @@ Status TerarkZipTableBuilder::Add(const Slice& key,
     if (terark_unlikely(indexBuildMemSize > singleIndexMaxSize_)) {
       return true;
     }
+    if (table_options_.buildParallelism > 1) {
+      // Split the keys of a target size output into buildParallelism parts,
+      // whose index and store are built in parallel. Bounds only depend on
+      // the data, so the output stays deterministic.
+      double keyShare =
+          double(properties_.raw_key_size) /
+          (properties_.raw_key_size + properties_.raw_value_size);
+      size_t partKeySize = std::max<size_t>(
+          table_options_.singleIndexMinSize,
+          size_t(targetFileSize_ * keyShare / table_options_.buildParallelism));
+      if (r22_->stat.sumKeyLen > partKeySize) {
+        return true;
+      }
+    }
     return !MergeRangeStatus(
         r22_.get(), r11_.get(), r21_.get(),
         freq_hist_o1::estimate_size_unfinish(freq_[2]->k, freq_[1]->k));
@@ -584,8 +768,11 @@ Status TerarkZipTableBuilder::AddTombstone(const Slice& key,
 TerarkZipTableBuilder::WaitHandle::WaitHandle() : myWorkMem(0) {}
 TerarkZipTableBuilder::WaitHandle::WaitHandle(size_t workMem)
     : myWorkMem(workMem) {}
+TerarkZipTableBuilder::WaitHandle::WaitHandle(
+    MemoryArbiter::Reservation&& r)
+    : myWorkMem(0), reservation(std::move(r)) {}
 TerarkZipTableBuilder::WaitHandle::WaitHandle(WaitHandle&& other) noexcept
-    : myWorkMem(other.myWorkMem) {
+    : myWorkMem(other.myWorkMem), reservation(std::move(other.reservation)) {
   other.myWorkMem = 0;
 }
 TerarkZipTableBuilder::WaitHandle& TerarkZipTableBuilder::WaitHandle::operator=(
@@ -593,9 +780,14 @@ TerarkZipTableBuilder::WaitHandle& TerarkZipTableBuilder::WaitHandle::operator=(
   Release();
   myWorkMem = other.myWorkMem;
   other.myWorkMem = 0;
+  reservation = std::move(other.reservation);
   return *this;
 }
 void TerarkZipTableBuilder::WaitHandle::Release(size_t size) {
+  if (reservation.size() > 0) {
+    reservation.Release(std::min(size, reservation.size()));
+    return;
+  }
   assert(size <= myWorkMem);
   if (myWorkMem > 0) {
     if (size == 0) {
@@ -612,6 +804,20 @@ TerarkZipTableBuilder::WaitHandle::~WaitHandle() { Release(myWorkMem); }
 
 TerarkZipTableBuilder::WaitHandle TerarkZipTableBuilder::WaitForMemory(
     const char* who, size_t myWorkMem) {
+  if (MemoryArbiter* arbiter = ioptions_.memory_arbiter) {
+    long long t0 = g_pf.now();
+    // Index and store of a parallel Finish reserve one after another, two
+    // builders each holding one part must not wait on each other forever
+    const uint64_t kMaxWaitMicros = 60 * 1000000;
+    WaitHandle handle(arbiter->Reserve(MemoryArbiter::kTableBuilder, myWorkMem,
+                                       ArbiterPriority(), kMaxWaitMicros));
+    INFO(ioptions_.info_log,
+         "TerarkZipTableBuilder::Finish():this=%12p:\n %-10s workingMem "
+         "=%8.4f GB, waited %9.3f sec, arbiter usage =%8.3f GB\n",
+         this, who, myWorkMem / 1e9, g_pf.sf(t0, g_pf.now()),
+         arbiter->usage() / 1e9);
+    return handle;
+  }
   const size_t softMemLimit = table_options_.softZipWorkingMemLimit;
   const size_t hardMemLimit =
       std::max<size_t>(table_options_.hardZipWorkingMemLimit, softMemLimit);
@@ -939,13 +1145,25 @@ Status TerarkZipTableBuilder::BuildStore(KeyValueStatus& kvs,
                                          DictZipBlobStore::ZipBuilder* zbuilder,
                                          uint64_t flag) {
   auto buildUncompressedStore = [this, &kvs]() {
-    std::unique_lock<std::mutex> l(storeBuildMutex_);
-    assert(tmpStoreFileSize_ == 0 ||
-           tmpStoreFileSize_ == FileStream(tmpStoreFile_.fpath, "rb").fsize());
+    // Parts of a parallel build write their own file instead of waiting for
+    // tmpStoreFile_, MergePartStores() appends them in part order
+    const bool usePartFile = table_options_.buildParallelism > 1;
+    std::unique_lock<std::mutex> l(storeBuildMutex_, std::defer_lock);
+    if (usePartFile) {
+      kvs.partStoreFile.fpath =
+          tmpSentryFile_.path + ".bs." + std::to_string(storePartSeed_++);
+    } else {
+      l.lock();
+    }
+    AutoDeleteFile& storeFile = usePartFile ? kvs.partStoreFile : tmpStoreFile_;
+    uint64_t& storeFileSize =
+        usePartFile ? kvs.partStoreFileSize : tmpStoreFileSize_;
+    assert(storeFileSize == 0 ||
+           storeFileSize == FileStream(storeFile.fpath, "rb").fsize());
     auto& stat = kvs.status.stat;
     size_t fixedNum = kvs.status.valueHist.m_cnt_of_max_cnt_key;
     size_t variaNum = stat.keyCount - fixedNum;
-    BuildStoreParams params = {kvs, 0, tmpStoreFile_, tmpStoreFileSize_};
+    BuildStoreParams params = {kvs, 0, storeFile, storeFileSize};
     Status s;
     try {
       if (kvs.status.valueHist.m_total_key_len == 0) {
@@ -962,16 +1180,15 @@ Status TerarkZipTableBuilder::BuildStore(KeyValueStatus& kvs,
       } else {
         s = buildMixedLenBlobStore(params);
       }
-      size_t newTmpStoreFileSize =
-          FileStream(tmpStoreFile_.fpath, "rb").fsize();
+      size_t newStoreFileSize = FileStream(storeFile.fpath, "rb").fsize();
       if (s.ok()) {
-        kvs.valueFileBegin = tmpStoreFileSize_;
-        kvs.valueFileEnd = newTmpStoreFileSize;
+        kvs.valueFileBegin = storeFileSize;
+        kvs.valueFileEnd = newStoreFileSize;
         assert((kvs.valueFileEnd - kvs.valueFileBegin) % 8 == 0);
       }
-      tmpStoreFileSize_ = newTmpStoreFileSize;
+      storeFileSize = newStoreFileSize;
     } catch (...) {
-      tmpStoreFileSize_ = FileStream(tmpStoreFile_.fpath, "rb").fsize();
+      storeFileSize = FileStream(storeFile.fpath, "rb").fsize();
       throw;
     }
     return s;
@@ -1082,6 +1299,34 @@ TerarkZipTableBuilder::CompressDict(fstring tmpDictFile, fstring dict,
       &dictTag);
 }
 
+Status TerarkZipTableBuilder::MergePartStores() {
+  std::unique_lock<std::mutex> l(storeBuildMutex_);
+  FileStream writer;
+  for (auto& kvs : prefixBuildInfos_) {
+    if (kvs->partStoreFile.fpath.empty()) {
+      continue;
+    }
+    if (!writer.isOpen()) {
+      writer.open(tmpStoreFile_.fpath, "ab+");
+    }
+    assert(tmpStoreFileSize_ % 8 == 0);
+    uint64_t begin = tmpStoreFileSize_;
+    {
+      MmapWholeFile part(kvs->partStoreFile.fpath);
+      writer.ensureWrite(part.base, part.size);
+      tmpStoreFileSize_ += part.size;
+    }
+    kvs->valueFileBegin += begin;
+    kvs->valueFileEnd += begin;
+    kvs->partStoreFile.Delete();
+  }
+  if (writer.isOpen()) {
+    writer.flush();
+    assert(tmpStoreFileSize_ == writer.fsize());
+  }
+  return Status::OK();
+}
+
 Status TerarkZipTableBuilder::WaitBuildIndex() {
   ioptions_.env->UnSchedule(&indexTag, rocksdb::Env::Priority::LOW);
   Status result = Status::OK();
@@ -1414,6 +1659,10 @@ Status TerarkZipTableBuilder::ZipValueToFinish() {
   if (tmpDumpFile_.isOpen()) {
     tmpDumpFile_.close();
   }
+  s = MergePartStores();
+  if (!s.ok()) {
+    return s;
+  }
   return WriteSSTFile(t3, t4, td, tmpDictFile, dictInfo, dictHash, dzstat);
 }
 
@@ -1501,6 +1750,10 @@ Status TerarkZipTableBuilder::ZipValueToFinishMulti() {
   if (tmpDumpFile_.isOpen()) {
     tmpDumpFile_.close();
   }
+  s = MergePartStores();
+  if (!s.ok()) {
+    return s;
+  }
   return WriteSSTFileMulti(t3, t4, td, tmpDictFile, dictInfo, dictHash, dzstat);
 }
 
@@ -2512,10 +2765,16 @@ std::string ParseTerarkZipTableOption(const std::string& name,
     }
   }
   const auto& opt_info = iter->second;
-  if (opt_info.verification != OptionVerificationType::kDeprecated &&
-      !ParseOptionHelper(reinterpret_cast<char*>(new_options) + opt_info.offset,
-                         opt_info.type, value)) {
-    return "Invalid value";
+  try {
+    if (opt_info.verification != OptionVerificationType::kDeprecated &&
+        !ParseOptionHelper(
+            reinterpret_cast<char*>(new_options) + opt_info.offset,
+            opt_info.type, value)) {
+      return "Invalid value";
+    }
+  } catch (const std::exception& e) {
+    // out of range for the width of the field
+    return std::string("Invalid value: ") + e.what();
   }
   return "";
 }
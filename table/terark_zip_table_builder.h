@@ -120,6 +120,10 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
     uint64_t indexFileEnd = 0;
     uint64_t valueFileBegin = 0;
     uint64_t valueFileEnd = 0;
+    // Uncompressed store of this part when TerarkZipTableOptions::
+    // buildParallelism > 1, until MergePartStores()
+    AutoDeleteFile partStoreFile;
+    uint64_t partStoreFileSize = 0;
     bool isValueBuild = false;
     bool isUseDictZip = false;
     bool isFullValue = false;
@@ -138,13 +142,20 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   struct WaitHandle : boost::noncopyable {
     WaitHandle();
     WaitHandle(size_t);
+    WaitHandle(MemoryArbiter::Reservation&&);
     WaitHandle(WaitHandle&&) noexcept;
     WaitHandle& operator=(WaitHandle&&) noexcept;
     size_t myWorkMem;
+    // Used instead of myWorkMem when ImmutableCFOptions::memory_arbiter is set
+    MemoryArbiter::Reservation reservation;
     void Release(size_t size = 0);
     ~WaitHandle();
   };
   WaitHandle WaitForMemory(const char* who, size_t memorySize);
+  MemoryArbiter::Priority ArbiterPriority() const;
+  std::string ChooseTempDir();
+  // Give back the staging bytes ChooseTempDir() counted
+  void ReleaseMemTemp();
   Status EmptyTableFinish();
   std::unique_ptr<AsyncTask<Status>> Async(std::function<Status()> func,
                                            void* tag);
@@ -161,6 +172,7 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
                                                   long long* td);
   Status WaitBuildIndex();
   Status WaitBuildStore();
+  Status MergePartStores();
   struct BuildReorderParams {
     AutoDeleteFile tmpReorderFile;
     bitfield_array<2> type;
@@ -231,6 +243,10 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   valvec<std::unique_ptr<KeyValueStatus>> prefixBuildInfos_;
   std::shared_ptr<FilePair> filePair_;
   InternalKey prevKey_;
+  // Staging bytes counted in flight for TerarkZipTableOptions::memTempDir,
+  // and charged to ImmutableCFOptions::memory_arbiter if set, when the temp
+  // files live there
+  size_t memTempBytes_ = 0;
   TempFileDeleteOnClose tmpSentryFile_;
   TempFileDeleteOnClose tmpSampleFile_;
   AutoDeleteFile tmpIndexFile_;
@@ -252,6 +268,8 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   uint64_t estimateOffset_ = 0;
   size_t dictSize_ = 0;
   float estimateRatio_ = 0;
+  uint64_t targetFileSize_ = 0;
+  std::atomic<size_t> storePartSeed_{0};
   size_t seqExpandSize_ = 0;
   size_t multiValueExpandSize_ = 0;
   TableProperties properties_;
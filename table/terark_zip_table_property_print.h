@@ -1,6 +1,7 @@
   const double GiB = 1ull << 30;
 
   M_String(localTempDir);
+  M_String(memTempDir);
   M_String(indexType);
   M_NumFmt(checksumLevel            , "%d");
   M_NumFmt(checksumSmallValSize     , "%d");
@@ -22,6 +23,7 @@
   M_Boolea(forceMetaInMemory);
   M_Boolea(enableEntropyStore);
   M_NumFmt(cbtHashBits              , "%d");
+  M_NumFmt(buildParallelism         , "%d");
   M_NumFmt(minPreadLen              , "%d");
   M_NumFmt(offsetArrayBlockUnits    , "%d");
   M_NumFmt(sampleRatio              , "%lf");
@@ -31,11 +33,15 @@
   M_NumGiB(smallTaskMemory);
   M_NumGiB(singleIndexMinSize);
   M_NumGiB(singleIndexMaxSize);
+  M_NumGiB(memTempMaxBytes);
   M_NumGiB(cacheCapacityBytes);
   M_NumFmt(cacheShards              , "%d");
   M_NumFmt(cbtEntryPerTrie          , "%u");
   M_NumFmt(cbtMinKeySize            , "%u");
   M_NumFmt(cbtMinKeyRatio           , "%lf");
+  M_NumGiB(adaptiveSampleBytes);
+  M_NumFmt(adaptiveMinZipGain       , "%lf");
+  M_NumGiB(hotRecordCacheBytes);
 
 #undef M_NumFmt
 #undef M_NumGiB
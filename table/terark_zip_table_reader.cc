@@ -2,11 +2,15 @@
 #include "terark_zip_table_reader.h"
 
 #include "terark_zip_common.h"
+// std headers
+#include <algorithm>
 // rocksdb headers
+#include <monitoring/statistics.h>
 #include <table/get_context.h>
 #include <table/internal_iterator.h>
 #include <table/meta_blocks.h>
 #include <table/sst_file_writer_collectors.h>
+#include <util/coding.h>
 #include <util/util.h>
 // terark headers
 #include <terark/lcast.hpp>
@@ -888,8 +892,71 @@ static const byte_t* FsPread(void* vself, size_t offset, size_t len,
   return buf->data();
 }
 
+TerarkZipRecordCache::Key::Key(uint64_t cache_id, size_t sub_index,
+                               size_t rec_id) {
+  EncodeFixed64(data + 0, cache_id);
+  EncodeFixed64(data + 8, sub_index);
+  EncodeFixed64(data + 16, rec_id);
+  // murmur3 finalizer over the three fields
+  uint64_t h = (cache_id * 0x9e3779b97f4a7c15ull) ^
+               (uint64_t(sub_index) << 32) ^ rec_id;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  hash = h;
+}
+
+TerarkZipRecordCache::TerarkZipRecordCache(size_t capacity)
+    // about one counter per 64 cached bytes
+    : cache_(NewLRUCache(capacity)), admission_(capacity / 64) {}
+
+bool TerarkZipRecordCache::Lookup(const Key& key, valvec<byte_t>* buf,
+                                  Statistics* stats) {
+  admission_.Increment(key.hash);
+  Cache::Handle* handle = cache_->Lookup(key.slice());
+  if (handle == nullptr) {
+    RecordTick(stats, TERARK_RECORD_CACHE_MISS);
+    return false;
+  }
+  auto record = static_cast<const std::string*>(cache_->Value(handle));
+  buf->append((const byte_t*)record->data(), record->size());
+  cache_->Release(handle);
+  RecordTick(stats, TERARK_RECORD_CACHE_HIT);
+  return true;
+}
+
+void TerarkZipRecordCache::Insert(const Key& key, fstring record) {
+  size_t charge = record.size() + sizeof(std::string) + sizeof key.data;
+  if (cache_->GetUsage() + charge > cache_->GetCapacity() &&
+      admission_.Frequency(key.hash) < kMinAdmitFrequency) {
+    return;
+  }
+  cache_->Insert(key.slice(), new std::string(record.data(), record.size()),
+                 charge, [](const Slice&, void* value) {
+                   delete static_cast<std::string*>(value);
+                 });
+}
+
 void TerarkZipSubReader::GetRecordAppend(size_t recId,
                                          valvec<byte_t>* tbuf) const {
+  if (record_cache_) {
+    TerarkZipRecordCache::Key key(record_cache_id_, subIndex_, recId);
+    if (record_cache_->Lookup(key, tbuf, statistics_)) {
+      return;
+    }
+    size_t oldsize = tbuf->size();
+    GetRecordAppendUncached(recId, tbuf);
+    record_cache_->Insert(
+        key, fstring(tbuf->data() + oldsize, tbuf->size() - oldsize));
+  } else {
+    GetRecordAppendUncached(recId, tbuf);
+  }
+}
+
+void TerarkZipSubReader::GetRecordAppendUncached(size_t recId,
+                                                 valvec<byte_t>* tbuf) const {
   if (storeUsePread_) {
     auto cache = cache_;
     if (cache)
@@ -925,13 +992,51 @@ Status TerarkZipSubReader::Get(SequenceNumber global_seqno,
         "TerarkZipTableReader::Get()",
         "bad internal key causing ParseInternalKey() failed");
   }
-  Slice user_key = ExtractUserKey(ikey);
-  uint64_t ikey_tag = ExtractInternalKeyFooter(ikey);
   auto g_tctx = terark::GetTlsTerarkContext();
-  size_t recId = index_->Find(fstringOf(user_key), g_tctx);
+  size_t recId = index_->Find(fstringOf(ExtractUserKey(ikey)), g_tctx);
   if (size_t(-1) == recId) {
     return Status::OK();
   }
+  return GetRecord(global_seqno, ikey, recId, get_context);
+}
+
+void TerarkZipSubReader::MultiGet(SequenceNumber global_seqno,
+                                  const ReadOptions& /*ro*/, size_t num_keys,
+                                  const Slice* ikeys, GetContext** get_contexts,
+                                  Status* statuses, int flag) const {
+  TERARK_UNUSED_VAR(flag);
+  // Resolve all keys against the index first, then read records in record
+  // id order: the store is read front to back, preads of neighbouring
+  // records hit the same cached pages and the read ahead of the file
+  auto g_tctx = terark::GetTlsTerarkContext();
+  std::vector<std::pair<size_t, size_t>> records;  // record id, key index
+  records.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (ikeys[i].size() < 8) {
+      statuses[i] = Status::InvalidArgument(
+          "TerarkZipTableReader::MultiGet()",
+          "bad internal key causing ParseInternalKey() failed");
+      continue;
+    }
+    statuses[i] = Status::OK();
+    size_t recId = index_->Find(fstringOf(ExtractUserKey(ikeys[i])), g_tctx);
+    if (size_t(-1) != recId) {
+      records.emplace_back(recId, i);
+    }
+  }
+  std::sort(records.begin(), records.end());
+  for (auto& r : records) {
+    statuses[r.second] = GetRecord(global_seqno, ikeys[r.second], r.first,
+                                   get_contexts[r.second]);
+  }
+}
+
+Status TerarkZipSubReader::GetRecord(SequenceNumber global_seqno,
+                                     const Slice& ikey, size_t recId,
+                                     GetContext* get_context) const {
+  Slice user_key = ExtractUserKey(ikey);
+  uint64_t ikey_tag = ExtractInternalKeyFooter(ikey);
+  auto g_tctx = terark::GetTlsTerarkContext();
   auto zvType =
       type_.size() ? ZipValueType(type_[recId]) : ZipValueType::kZeroSeq;
   bool matched;
@@ -1274,6 +1379,11 @@ Status TerarkZipTableReader::Open(RandomAccessFileReader* file,
     }
   }
   subReader_.file_number_ = table_reader_options_.file_number;
+  subReader_.record_cache_ = table_factory_->record_cache();
+  if (subReader_.record_cache_) {
+    subReader_.record_cache_id_ = subReader_.record_cache_->NewId();
+  }
+  subReader_.statistics_ = ioptions.statistics;
   long long t1 = g_pf.now();
   subReader_.index_->BuildCache(tzto_.indexCacheRatio);
   long long t2 = g_pf.now();
@@ -1373,6 +1483,18 @@ Status TerarkZipTableReader::Get(const ReadOptions& ro, const Slice& ikey,
   return subReader_.Get(global_seqno_, ro, ikey, get_context, flag);
 }
 
+void TerarkZipTableReader::MultiGet(const ReadOptions& ro, size_t num_keys,
+                                    const Slice* ikeys,
+                                    GetContext** get_contexts,
+                                    Status* statuses,
+                                    const SliceTransform* /*prefix_extractor*/,
+                                    bool skip_filters) {
+  int flag = skip_filters ? TerarkZipSubReader::FlagSkipFilter
+                          : TerarkZipSubReader::FlagNone;
+  subReader_.MultiGet(global_seqno_, ro, num_keys, ikeys, get_contexts,
+                      statuses, flag);
+}
+
 void TerarkZipTableReader::RangeScan(
     const Slice* begin, const SliceTransform* /*prefix_extractor*/, void* arg,
     bool (*callback_func)(void* arg, const Slice& key, LazyBuffer&& value)) {
@@ -1547,6 +1669,17 @@ Status TerarkZipTableMultiReader::SubIndex::Init(
   return Status::OK();
 }
 
+void TerarkZipTableMultiReader::SubIndex::SetRecordCache(
+    TerarkZipRecordCache* record_cache, Statistics* statistics) {
+  // parts share the id, their sub index tells them apart
+  uint64_t record_cache_id = record_cache ? record_cache->NewId() : 0;
+  for (auto& part : subReader_) {
+    part.record_cache_ = record_cache;
+    part.record_cache_id_ = record_cache_id;
+    part.statistics_ = statistics;
+  }
+}
+
 size_t TerarkZipTableMultiReader::SubIndex::GetSubCount() const {
   return partCount_;
 }
@@ -1608,6 +1741,45 @@ Status TerarkZipTableMultiReader::Get(
   return subReader->Get(global_seqno_, ro, ikey, get_context, flag);
 }
 
+void TerarkZipTableMultiReader::MultiGet(
+    const ReadOptions& ro, size_t num_keys, const Slice* ikeys,
+    GetContext** get_contexts, Status* statuses,
+    const SliceTransform* /*prefix_extractor*/, bool skip_filters) {
+  int flag = skip_filters ? TerarkZipSubReader::FlagSkipFilter
+                          : TerarkZipSubReader::FlagNone;
+  // Keys are sorted, so the keys of one sub reader are adjacent
+  size_t begin = 0;
+  const TerarkZipSubReader* current = nullptr;
+  auto flush = [&](size_t end) {
+    if (current != nullptr && begin < end) {
+      current->MultiGet(global_seqno_, ro, end - begin, ikeys + begin,
+                        get_contexts + begin, statuses + begin, flag);
+    }
+  };
+  for (size_t i = 0; i < num_keys; ++i) {
+    const TerarkZipSubReader* subReader = nullptr;
+    if (ikeys[i].size() < 8) {
+      statuses[i] =
+          Status::InvalidArgument("TerarkZipTableMultiReader::MultiGet()",
+                                  "param target.size() < 8 + PrefixLen");
+    } else {
+      fstring user_key = fstringOf(ikeys[i]).substr(0, ikeys[i].size() - 8);
+      subReader = isReverseBytewiseOrder_
+                      ? subIndex_.LowerBoundSubReaderReverse(user_key)
+                      : subIndex_.LowerBoundSubReader(user_key);
+      if (subReader == nullptr) {
+        statuses[i] = Status::OK();
+      }
+    }
+    if (subReader != current) {
+      flush(i);
+      current = subReader;
+      begin = i;
+    }
+  }
+  flush(num_keys);
+}
+
 void TerarkZipTableMultiReader::RangeScan(
     const Slice* begin, const SliceTransform* /*prefix_extractor*/, void* arg,
     bool (*callback_func)(void* arg, const Slice& key, LazyBuffer&& value)) {
@@ -1738,6 +1910,8 @@ Status TerarkZipTableMultiReader::Open(RandomAccessFileReader* file,
   if (!s.ok()) {
     return s;
   }
+  subIndex_.SetRecordCache(table_factory_->record_cache(),
+                           table_reader_options_.ioptions.statistics);
   valvec<fstring> meta_data_in_mmap;
   if (tzto_.forceMetaInMemory) {
     valvec<std::pair<valvec<fstring>, valvec<fstring>>> meta_data;
@@ -133,6 +133,10 @@ class TerarkEmptyTableReader : public TerarkZipTableReaderBase {
 
 struct TerarkZipSubReader {
   LruReadonlyCache* cache_ = nullptr;
+  TerarkZipRecordCache* record_cache_ = nullptr;
+  // from Cache::NewId(), file numbers are unknown or reused across DBs
+  uint64_t record_cache_id_ = 0;
+  Statistics* statistics_ = nullptr;
   size_t subIndex_;
   size_t rawReaderOffset_;
   size_t rawReaderSize_;
@@ -153,11 +157,20 @@ struct TerarkZipSubReader {
 
   void InitUsePread(int minPreadLen);
 
+  // Point lookups go through the record cache of the factory if any
   void GetRecordAppend(size_t recId, valvec<byte_t>* tbuf) const;
+  void GetRecordAppendUncached(size_t recId, valvec<byte_t>* tbuf) const;
   void GetRecordAppend(size_t recId, terark::BlobStore::CacheOffsets*) const;
 
   Status Get(SequenceNumber, const ReadOptions&, const Slice& key, GetContext*,
              int flag) const;
+  // Looks up all keys in the index before reading any record, then reads the
+  // records in store order
+  void MultiGet(SequenceNumber, const ReadOptions&, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                int flag) const;
+  Status GetRecord(SequenceNumber, const Slice& key, size_t recId,
+                   GetContext*) const;
   size_t DictRank(fstring key) const;
 
   ~TerarkZipSubReader();
@@ -185,6 +198,11 @@ class TerarkZipTableReader : public TerarkZipTableReaderBase {
              GetContext* get_context, const SliceTransform* prefix_extractor,
              bool skip_filters) override;
 
+  void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                const SliceTransform* prefix_extractor,
+                bool skip_filters) override;
+
   void RangeScan(const Slice* begin, const SliceTransform* prefix_extractor,
                  void* arg,
                  bool (*callback_func)(void* arg, const Slice& key,
@@ -233,6 +251,11 @@ class TerarkZipTableMultiReader : public TerarkZipTableReaderBase {
              GetContext* get_context, const SliceTransform* prefix_extractor,
              bool skip_filters) override;
 
+  void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                const SliceTransform* prefix_extractor,
+                bool skip_filters) override;
+
   void RangeScan(const Slice* begin, const SliceTransform* prefix_extractor,
                  void* arg,
                  bool (*callback_func)(void* arg, const Slice& key,
@@ -272,6 +295,8 @@ class TerarkZipTableMultiReader : public TerarkZipTableReaderBase {
                 RandomAccessFile* fileObj, LruReadonlyCache* cache,
                 uint64_t file_number, bool warmUpIndexOnOpen, bool reverse);
 
+    void SetRecordCache(TerarkZipRecordCache* record_cache,
+                        Statistics* statistics);
     size_t GetSubCount() const;
     const TerarkZipSubReader* GetSubReader(size_t i) const;
     const TerarkZipSubReader* LowerBoundSubReader(fstring key) const;
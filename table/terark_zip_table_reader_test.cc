@@ -498,6 +498,17 @@ class TerarkZipReaderTest : public DBTestBase {
       ASSERT_EQ(value, *it + "-3");
       ASSERT_TRUE(db->Get(ro4, *it, &value).IsNotFound());
     }
+    std::vector<Slice> keys(key_set.begin(), key_set.end());
+    std::vector<std::string> values;
+    auto statuses = db->MultiGet(ro3, keys, &values);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      ASSERT_OK(statuses[i]);
+      ASSERT_EQ(values[i], keys[i].ToString() + "-3");
+    }
+    statuses = db->MultiGet(ro2, keys, &values);
+    for (auto& s : statuses) {
+      ASSERT_TRUE(s.IsNotFound());
+    }
 
     auto basic_test = [&](Iterator* i, std::string s) {
       i->SeekToFirst();
@@ -1012,6 +1023,103 @@ TEST_F(TerarkZipReaderTest, IndexBuildTest) {
   IterTest(data_list, test_list, true , 4, 64, 1024, 1);
 }
 
+TEST_F(TerarkZipReaderTest, AdaptiveTableFormat) {
+  auto test = [&](double minZipGain, const std::string& format) {
+    Options options = CurrentOptions();
+    TerarkZipTableOptions tzto;
+    tzto.localTempDir = dbname_;
+    tzto.adaptiveSampleBytes = 4096;
+    tzto.adaptiveMinZipGain = minZipGain;
+    options.allow_mmap_reads = true;
+    options.table_factory.reset(NewTerarkZipTableFactory(
+        tzto, std::shared_ptr<TableFactory>(NewBlockBasedTableFactory())));
+    DestroyAndReopen(options);
+    ReadOptions ro;
+    WriteOptions wo;
+    for (size_t i = 0; i < 1000; ++i) {
+      ASSERT_OK(db_->Put(wo, get_key(i), get_value(i)));
+    }
+    ASSERT_OK(db_->Flush(FlushOptions()));
+    TablePropertiesCollection props;
+    ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+    ASSERT_EQ(1, props.size());
+    auto& user_props = props.begin()->second->user_collected_properties;
+    ASSERT_EQ(format, user_props.at("terark.adaptive.format"));
+    ASSERT_NE(std::string::npos,
+              user_props.at("terark.adaptive.reason").find("gain="));
+    std::string value;
+    for (size_t i = 0; i < 1000; ++i) {
+      ASSERT_OK(db_->Get(ro, get_key(i), &value));
+      ASSERT_EQ(get_value(i), value);
+    }
+  };
+  // Any sample favors dictZip with a negative gain and none with gain 1
+  test(-1, "TerarkZipTable");
+  test(1, "BlockBasedTable");
+}
+
+TEST_F(TerarkZipReaderTest, HotRecordCache) {
+  Options options = CurrentOptions();
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.hotRecordCacheBytes = 1 << 20;
+  options.allow_mmap_reads = true;
+  options.statistics = CreateDBStatistics();
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  ReadOptions ro;
+  WriteOptions wo;
+  for (size_t i = 0; i < 100; ++i) {
+    ASSERT_OK(db_->Put(wo, get_key(i), get_value(i)));
+  }
+  ASSERT_OK(db_->Flush(FlushOptions()));
+  std::string value;
+  for (int round = 0; round < 3; ++round) {
+    for (size_t i = 0; i < 100; ++i) {
+      ASSERT_OK(db_->Get(ro, get_key(i), &value));
+      ASSERT_EQ(get_value(i), value);
+    }
+  }
+  // The cache has room, every record is cached on its first miss
+  ASSERT_EQ(100, TestGetTickerCount(options, TERARK_RECORD_CACHE_MISS));
+  ASSERT_EQ(200, TestGetTickerCount(options, TERARK_RECORD_CACHE_HIT));
+}
+
+TEST_F(TerarkZipReaderTest, HotRecordCacheSharedByDBs) {
+  Options options = CurrentOptions();
+  TerarkZipTableOptions tzto;
+  tzto.localTempDir = dbname_;
+  tzto.hotRecordCacheBytes = 1 << 20;
+  options.allow_mmap_reads = true;
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+  // Both DBs get the same file numbers, their records must not collide in
+  // the cache of the shared factory
+  std::string other_dbname = dbname_ + "_other";
+  ASSERT_OK(DestroyDB(other_dbname, options));
+  DB* other_db = nullptr;
+  ASSERT_OK(DB::Open(options, other_dbname, &other_db));
+  ReadOptions ro;
+  WriteOptions wo;
+  for (size_t i = 0; i < 100; ++i) {
+    ASSERT_OK(db_->Put(wo, get_key(i), get_value(i)));
+    ASSERT_OK(other_db->Put(wo, get_key(i), get_value(i) + "_other"));
+  }
+  ASSERT_OK(db_->Flush(FlushOptions()));
+  ASSERT_OK(other_db->Flush(FlushOptions()));
+  std::string value;
+  for (int round = 0; round < 2; ++round) {
+    for (size_t i = 0; i < 100; ++i) {
+      ASSERT_OK(db_->Get(ro, get_key(i), &value));
+      ASSERT_EQ(get_value(i), value);
+      ASSERT_OK(other_db->Get(ro, get_key(i), &value));
+      ASSERT_EQ(get_value(i) + "_other", value);
+    }
+  }
+  delete other_db;
+  ASSERT_OK(DestroyDB(other_dbname, options));
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -191,6 +191,7 @@ DEFINE_string(
     "Meta operations:\n"
     "\tcompact     -- Compact the entire DB; If multiple, randomly choose one\n"
     "\tcompactall  -- Compact the entire DB\n"
+    "\trecover     -- Reopen the DB and report the time to replay its WAL\n"
     "\tstats       -- Print DB stats\n"
     "\tresetstats  -- Reset DB stats\n"
     "\tlevelstats  -- Print the number of files and bytes per level\n"
@@ -780,6 +781,11 @@ DEFINE_string(compression_type, "snappy",
 static enum rocksdb::CompressionType FLAGS_compression_type_e =
     rocksdb::kSnappyCompression;
 
+DEFINE_string(wal_compression, "none",
+              "Algorithm to use to compress the WAL, zstd or zlib");
+static enum rocksdb::CompressionType FLAGS_wal_compression_e =
+    rocksdb::kNoCompression;
+
 DEFINE_int32(compression_level, rocksdb::CompressionOptions().level,
              "Compression level. The meaning of this value is library-"
              "dependent. If unset, we try to use the default for the library "
@@ -814,6 +820,17 @@ DEFINE_int32(table_cache_numshardbits, 4, "");
 
 DEFINE_uint64(prepare_log_writer_num, 1, "");
 
+DEFINE_uint64(wal_recovery_readahead_size,
+              rocksdb::Options().wal_recovery_readahead_size,
+              "Bytes of WAL records read on a background thread ahead of the "
+              "memtable inserts during recovery, 0 disables the read ahead.");
+
+DEFINE_uint64(wal_recovery_insert_threads,
+              rocksdb::Options().wal_recovery_insert_threads,
+              "Threads inserting the recovered WAL batches into the memtables, "
+              "one per group of column families, 0 inserts on the recovery "
+              "thread.");
+
 #ifndef ROCKSDB_LITE
 DEFINE_string(env_uri, "",
               "URI for registry Env lookup. Mutually exclusive"
@@ -898,6 +915,11 @@ DEFINE_uint64(write_thread_slow_yield_usec, 3,
               "The threshold at which a slow yield is considered a signal that "
               "other processes or threads want the core.");
 
+DEFINE_uint64(memtable_insert_split_size,
+              rocksdb::Options().memtable_insert_split_size,
+              "Split write groups with larger batches into ranges of this many "
+              "keys for parallel memtable inserts, 0 disables splitting.");
+
 DEFINE_int32(rate_limit_delay_max_milliseconds, 1000,
              "When hard_rate_limit is set then this is the max time a put will"
              " be stalled.");
@@ -2718,6 +2740,8 @@ class Benchmark {
         method = &Benchmark::Compact;
       } else if (name == "compactall") {
         CompactAll();
+      } else if (name == "recover") {
+        Recover();
       } else if (name == "crc32c") {
         method = &Benchmark::Crc32c;
       } else if (name == "xxhash") {
@@ -3485,9 +3509,13 @@ class Benchmark {
     options.enable_pipelined_write = FLAGS_enable_pipelined_write;
     options.write_thread_max_yield_usec = FLAGS_write_thread_max_yield_usec;
     options.write_thread_slow_yield_usec = FLAGS_write_thread_slow_yield_usec;
+    options.memtable_insert_split_size = FLAGS_memtable_insert_split_size;
     options.rate_limit_delay_max_milliseconds =
         FLAGS_rate_limit_delay_max_milliseconds;
     options.prepare_log_writer_num = FLAGS_prepare_log_writer_num;
+    options.wal_recovery_readahead_size = FLAGS_wal_recovery_readahead_size;
+    options.wal_recovery_insert_threads = FLAGS_wal_recovery_insert_threads;
+    options.wal_compression = FLAGS_wal_compression_e;
     options.table_cache_numshardbits = FLAGS_table_cache_numshardbits;
     options.max_compaction_bytes = FLAGS_max_compaction_bytes;
     options.disable_auto_compactions = FLAGS_disable_auto_compactions;
@@ -5704,6 +5732,25 @@ class Benchmark {
     }
   }
 
+  // Closing a DB with the WAL enabled doesn't flush its memtables, so the
+  // reopen replays every WAL written since the last flush
+  void Recover() {
+    if (db_.db != nullptr) {
+      db_.DeleteDBs();
+    }
+    for (auto& db_with_cfh : multi_dbs_) {
+      db_with_cfh.DeleteDBs();
+    }
+    uint64_t start = FLAGS_env->NowMicros();
+    Open(&open_options_);
+    fprintf(stdout,
+            "%-12s : %11.3f seconds (wal_recovery_readahead_size %" PRIu64
+            ", wal_recovery_insert_threads %" PRIu64 ")\n",
+            "recover", (FLAGS_env->NowMicros() - start) * 1e-6,
+            FLAGS_wal_recovery_readahead_size,
+            FLAGS_wal_recovery_insert_threads);
+  }
+
   void ResetStats() {
     if (db_.db != nullptr) {
       db_.db->ResetStats();
@@ -5811,6 +5858,8 @@ int db_bench_tool(int argc, char** argv) {
 
   FLAGS_compression_type_e =
       StringToCompressionType(FLAGS_compression_type.c_str());
+  FLAGS_wal_compression_e =
+      StringToCompressionType(FLAGS_wal_compression.c_str());
 
 #ifndef ROCKSDB_LITE
   std::unique_ptr<Env> custom_env_guard;
@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <string>
 #include <terark/util/linebuf.hpp>
 #include <thread>
 
@@ -21,7 +22,7 @@ class MyWorker : public rocksdb::RemoteCompactionDispatcher::Worker {
   using rocksdb::RemoteCompactionDispatcher::Worker::Worker;
 };
 
-int main() {
+int main(int argc, char** argv) {
   rocksdb::EnvOptions env_options;
   MyWorker worker(env_options, rocksdb::Env::Default());
 
@@ -35,6 +36,10 @@ int main() {
   // worker.RegistTablePropertiesCollectorFactory(
   //    std::shared_ptr<TablePropertiesCollectorFactory>);
 
+  if (argc > 1 && std::string(argv[1]) == "--serve") {
+    // persistent worker of NewLocalWorkerPoolCompactionDispatcher
+    return worker.Serve(0, 1);
+  }
   terark::LineBuf buf;
   buf.read_all(stdin);
   std::cout << worker.DoCompaction(rocksdb::Slice(buf.p, buf.n));
@@ -44,4 +49,6 @@ int main() {
 // a shell script calling this program:
 // ----------------------------------------------
 // env TerarkZipTable_localTempDir=/tmp remote_compaction_worker_101
+// or, for NewLocalWorkerPoolCompactionDispatcher:
+// env TerarkZipTable_localTempDir=/tmp remote_compaction_worker_101 --serve
 // ----------------------------------------------
@@ -1112,4 +1112,274 @@ inline std::string ZSTD_TrainDictionary(const std::string& samples,
 #endif  // ZSTD_VERSION_NUMBER >= 10103
 }
 
+inline bool StreamingCompressionTypeSupported(CompressionType type) {
+  switch (type) {
+    case kZlibCompression:
+      return Zlib_Supported();
+    case kZSTD:
+    case kZSTDNotFinalCompression:
+#if defined(ZSTD) && ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return false;
+  }
+}
+
+// Compresses a stream of records with one persistent context, so a record
+// refers to the data of the records before it. Every record is flushed, it
+// can be decoded without the records after it.
+class StreamingCompress {
+ public:
+  // Returns nullptr if `type` can't be compressed as a stream. Supports
+  // kZlibCompression and kZSTD.
+  static StreamingCompress* Create(
+      CompressionType type,
+      int level = CompressionOptions::kDefaultCompressionLevel);
+
+  virtual ~StreamingCompress() {}
+
+  // Appends the compressed `input` to `output`
+  virtual bool Compress(const Slice& input, std::string* output) = 0;
+
+ protected:
+  static const size_t kBufferSize = 16384;
+};
+
+// Decodes the records of a StreamingCompress, in the same order
+class StreamingUncompress {
+ public:
+  // Returns nullptr if `type` can't be uncompressed as a stream
+  static StreamingUncompress* Create(CompressionType type);
+
+  virtual ~StreamingUncompress() {}
+
+  // Appends the data of one compressed record to `output`
+  virtual bool Uncompress(const Slice& input, std::string* output) = 0;
+
+ protected:
+  static const size_t kBufferSize = 16384;
+};
+
+namespace compression {
+
+#ifdef ZLIB
+class ZlibStreamingCompress : public StreamingCompress {
+ public:
+  ZlibStreamingCompress() : initialized_(false) {
+    memset(&stream_, 0, sizeof(z_stream));
+  }
+  ~ZlibStreamingCompress() {
+    if (initialized_) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  bool Init(int level) {
+    if (level == CompressionOptions::kDefaultCompressionLevel) {
+      level = Z_DEFAULT_COMPRESSION;
+    }
+    // Raw deflate, the records carry their own checksums
+    initialized_ = deflateInit2(&stream_, level, Z_DEFLATED, -15, 8,
+                                Z_DEFAULT_STRATEGY) == Z_OK;
+    return initialized_;
+  }
+
+  virtual bool Compress(const Slice& input, std::string* output) override {
+    if (input.size() > std::numeric_limits<uInt>::max()) {
+      return false;
+    }
+    char buffer[kBufferSize];
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream_.avail_in = static_cast<uInt>(input.size());
+    do {
+      stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+      stream_.avail_out = static_cast<uInt>(kBufferSize);
+      // Z_BUF_ERROR only means no progress was possible
+      int st = deflate(&stream_, Z_SYNC_FLUSH);
+      if (st != Z_OK && st != Z_BUF_ERROR) {
+        return false;
+      }
+      output->append(buffer, kBufferSize - stream_.avail_out);
+    } while (stream_.avail_out == 0);
+    return true;
+  }
+
+ private:
+  z_stream stream_;
+  bool initialized_;
+};
+
+class ZlibStreamingUncompress : public StreamingUncompress {
+ public:
+  ZlibStreamingUncompress() : initialized_(false) {
+    memset(&stream_, 0, sizeof(z_stream));
+  }
+  ~ZlibStreamingUncompress() {
+    if (initialized_) {
+      inflateEnd(&stream_);
+    }
+  }
+
+  bool Init() {
+    initialized_ = inflateInit2(&stream_, -15) == Z_OK;
+    return initialized_;
+  }
+
+  virtual bool Uncompress(const Slice& input, std::string* output) override {
+    if (input.size() > std::numeric_limits<uInt>::max()) {
+      return false;
+    }
+    char buffer[kBufferSize];
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream_.avail_in = static_cast<uInt>(input.size());
+    do {
+      stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+      stream_.avail_out = static_cast<uInt>(kBufferSize);
+      int st = inflate(&stream_, Z_SYNC_FLUSH);
+      if (st != Z_OK && st != Z_BUF_ERROR) {
+        return false;
+      }
+      output->append(buffer, kBufferSize - stream_.avail_out);
+    } while (stream_.avail_out == 0);
+    return stream_.avail_in == 0;
+  }
+
+ private:
+  z_stream stream_;
+  bool initialized_;
+};
+#endif  // ZLIB
+
+#if defined(ZSTD) && ZSTD_VERSION_NUMBER >= 10000  // v1.0.0+
+class ZSTDStreamingCompress : public StreamingCompress {
+ public:
+  ZSTDStreamingCompress() : stream_(ZSTD_createCStream()) {}
+  ~ZSTDStreamingCompress() { ZSTD_freeCStream(stream_); }
+
+  bool Init(int level) {
+    if (level == CompressionOptions::kDefaultCompressionLevel) {
+      // ZSTD_CLEVEL_DEFAULT
+      level = 3;
+    }
+    return stream_ != nullptr &&
+           !ZSTD_isError(ZSTD_initCStream(stream_, level));
+  }
+
+  virtual bool Compress(const Slice& input, std::string* output) override {
+    char buffer[kBufferSize];
+    ZSTD_inBuffer in = {input.data(), input.size(), 0};
+    while (in.pos < in.size) {
+      ZSTD_outBuffer out = {buffer, kBufferSize, 0};
+      if (ZSTD_isError(ZSTD_compressStream(stream_, &out, &in))) {
+        return false;
+      }
+      output->append(buffer, out.pos);
+    }
+    size_t remaining;
+    do {
+      ZSTD_outBuffer out = {buffer, kBufferSize, 0};
+      remaining = ZSTD_flushStream(stream_, &out);
+      if (ZSTD_isError(remaining)) {
+        return false;
+      }
+      output->append(buffer, out.pos);
+    } while (remaining != 0);
+    return true;
+  }
+
+ private:
+  ZSTD_CStream* stream_;
+};
+
+class ZSTDStreamingUncompress : public StreamingUncompress {
+ public:
+  ZSTDStreamingUncompress() : stream_(ZSTD_createDStream()) {}
+  ~ZSTDStreamingUncompress() { ZSTD_freeDStream(stream_); }
+
+  bool Init() {
+    return stream_ != nullptr && !ZSTD_isError(ZSTD_initDStream(stream_));
+  }
+
+  virtual bool Uncompress(const Slice& input, std::string* output) override {
+    char buffer[kBufferSize];
+    ZSTD_inBuffer in = {input.data(), input.size(), 0};
+    ZSTD_outBuffer out;
+    do {
+      out = {buffer, kBufferSize, 0};
+      if (ZSTD_isError(ZSTD_decompressStream(stream_, &out, &in))) {
+        return false;
+      }
+      output->append(buffer, out.pos);
+    } while (in.pos < in.size || out.pos == out.size);
+    return true;
+  }
+
+ private:
+  ZSTD_DStream* stream_;
+};
+#endif  // ZSTD && ZSTD_VERSION_NUMBER >= 10000
+
+}  // namespace compression
+
+inline StreamingCompress* StreamingCompress::Create(CompressionType type,
+                                                    int level) {
+  switch (type) {
+#ifdef ZLIB
+    case kZlibCompression: {
+      auto* compress = new compression::ZlibStreamingCompress();
+      if (compress->Init(level)) {
+        return compress;
+      }
+      delete compress;
+      return nullptr;
+    }
+#endif  // ZLIB
+#if defined(ZSTD) && ZSTD_VERSION_NUMBER >= 10000
+    case kZSTD:
+    case kZSTDNotFinalCompression: {
+      auto* compress = new compression::ZSTDStreamingCompress();
+      if (compress->Init(level)) {
+        return compress;
+      }
+      delete compress;
+      return nullptr;
+    }
+#endif  // ZSTD && ZSTD_VERSION_NUMBER >= 10000
+    default:
+      (void)level;
+      return nullptr;
+  }
+}
+
+inline StreamingUncompress* StreamingUncompress::Create(CompressionType type) {
+  switch (type) {
+#ifdef ZLIB
+    case kZlibCompression: {
+      auto* uncompress = new compression::ZlibStreamingUncompress();
+      if (uncompress->Init()) {
+        return uncompress;
+      }
+      delete uncompress;
+      return nullptr;
+    }
+#endif  // ZLIB
+#if defined(ZSTD) && ZSTD_VERSION_NUMBER >= 10000
+    case kZSTD:
+    case kZSTDNotFinalCompression: {
+      auto* uncompress = new compression::ZSTDStreamingUncompress();
+      if (uncompress->Init()) {
+        return uncompress;
+      }
+      delete uncompress;
+      return nullptr;
+    }
+#endif  // ZSTD && ZSTD_VERSION_NUMBER >= 10000
+    default:
+      return nullptr;
+  }
+}
+
 }  // namespace rocksdb
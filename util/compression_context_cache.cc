@@ -19,9 +19,9 @@ namespace compression_cache {
 
 void* const SentinelValue = nullptr;
 // Cache ZSTD uncompression contexts for reads
-// if needed we can add ZSTD compression context caching
-// which is currently is not done since BlockBasedTableBuilder
-// simply creates one compression context per new SST file.
+// BlockBasedTableBuilder creates one compression context per new SST file,
+// only block cache demotion compresses on the read path, see
+// CompressionCachedData.
 struct ZSTDCachedData {
   // We choose to cache the below structure instead of a ptr
   // because we want to avoid a) native types leak b) make
@@ -63,6 +63,38 @@ struct ZSTDCachedData {
 };
 static_assert(sizeof(ZSTDCachedData) % CACHE_LINE_SIZE == 0,
               "Expected CACHE_LINE_SIZE alignment");
+
+// A compression context taken out while in use, the next thread on the core
+// creates its own. ZSTD allocates its context on creation, which costs more
+// than compressing a single block.
+struct CompressionCachedData {
+  std::atomic<CompressionContext*> ctx_;
+
+  char padding[(CACHE_LINE_SIZE -
+                sizeof(std::atomic<CompressionContext*>) % CACHE_LINE_SIZE)];
+
+  CompressionCachedData() : ctx_(nullptr) {}
+  ~CompressionCachedData() { delete ctx_.load(std::memory_order_relaxed); }
+  CompressionCachedData(const CompressionCachedData&) = delete;
+  CompressionCachedData& operator=(const CompressionCachedData&) = delete;
+
+  std::unique_ptr<CompressionContext> Get(CompressionType type) {
+    std::unique_ptr<CompressionContext> ctx(ctx_.exchange(nullptr));
+    if (ctx == nullptr || ctx->type() != type) {
+      ctx.reset(new CompressionContext(type));
+    }
+    return ctx;
+  }
+  void Return(std::unique_ptr<CompressionContext> ctx) {
+    CompressionContext* expected = nullptr;
+    // Another thread may have returned one meanwhile, `ctx` is then freed
+    if (ctx_.compare_exchange_strong(expected, ctx.get())) {
+      ctx.release();
+    }
+  }
+};
+static_assert(sizeof(CompressionCachedData) % CACHE_LINE_SIZE == 0,
+              "Expected CACHE_LINE_SIZE alignment");
 }  // namespace compression_cache
 
 using namespace compression_cache;
@@ -80,9 +112,22 @@ class CompressionContextCache::Rep {
     auto* cn = per_core_uncompr_.AccessAtCore(static_cast<size_t>(idx));
     cn->ReturnUncompressData();
   }
+  std::unique_ptr<CompressionContext> GetCompressionContext(
+      CompressionType type, int64_t* idx) {
+    auto p = per_core_compr_.AccessElementAndIndex();
+    *idx = static_cast<int64_t>(p.second);
+    return p.first->Get(type);
+  }
+  void ReturnCompressionContext(std::unique_ptr<CompressionContext> ctx,
+                                int64_t idx) {
+    assert(idx >= 0);
+    per_core_compr_.AccessAtCore(static_cast<size_t>(idx))
+        ->Return(std::move(ctx));
+  }
 
  private:
   CoreLocalArray<ZSTDCachedData> per_core_uncompr_;
+  CoreLocalArray<CompressionCachedData> per_core_compr_;
 };
 
 CompressionContextCache::CompressionContextCache() : rep_(new Rep()) {}
@@ -103,6 +148,17 @@ void CompressionContextCache::ReturnCachedZSTDUncompressData(int64_t idx) {
   rep_->ReturnZSTDUncompressData(idx);
 }
 
+std::unique_ptr<CompressionContext>
+CompressionContextCache::GetCachedCompressionContext(CompressionType type,
+                                                     int64_t* idx) {
+  return rep_->GetCompressionContext(type, idx);
+}
+
+void CompressionContextCache::ReturnCachedCompressionContext(
+    std::unique_ptr<CompressionContext> ctx, int64_t idx) {
+  rep_->ReturnCompressionContext(std::move(ctx), idx);
+}
+
 CompressionContextCache::~CompressionContextCache() { delete rep_; }
 
 }  // namespace rocksdb
@@ -19,7 +19,11 @@
 
 #include <stdint.h>
 
+#include <memory>
+
 namespace rocksdb {
+enum CompressionType : unsigned char;
+class CompressionContext;
 class ZSTDUncompressCachedData;
 
 class CompressionContextCache {
@@ -33,6 +37,14 @@ class CompressionContextCache {
   ZSTDUncompressCachedData GetCachedZSTDUncompressData();
   void ReturnCachedZSTDUncompressData(int64_t idx);
 
+  // Compression context of `type` for compressing single blocks off the
+  // table builders, e.g. on block cache eviction. One context per core is
+  // kept, of the type last returned. Give it back with the `idx` set here.
+  std::unique_ptr<CompressionContext> GetCachedCompressionContext(
+      CompressionType type, int64_t* idx);
+  void ReturnCachedCompressionContext(std::unique_ptr<CompressionContext> ctx,
+                                      int64_t idx);
+
  private:
   // Singleton
   CompressionContextCache();
@@ -0,0 +1,87 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/dependence_map.h"
+
+#include <cassert>
+
+namespace rocksdb {
+
+namespace {
+// Keep at least half of the slots empty so probe chains stay short
+size_t SlotCountFor(size_t n) {
+  size_t slot_count = 8;
+  while (slot_count < n * 2) {
+    slot_count <<= 1;
+  }
+  return slot_count;
+}
+}  // namespace
+
+std::pair<DependenceMap::iterator, bool> DependenceMap::emplace(
+    uint64_t file_number, FileMetaData* f) {
+  if (slots_.size() < (items_.size() + 1) * 2) {
+    Rehash(SlotCountFor(items_.size() + 1));
+  }
+  size_t i = Bucket(file_number);
+  for (; slots_[i].index != 0; i = (i + 1) & mask_) {
+    if (slots_[i].key == file_number) {
+      return {items_.data() + slots_[i].index - 1, false};
+    }
+  }
+  items_.emplace_back(file_number, f);
+  slots_[i].key = file_number;
+  slots_[i].index = items_.size();
+  return {items_.data() + items_.size() - 1, true};
+}
+
+void DependenceMap::reserve(size_t n) {
+  items_.reserve(n);
+  if (slots_.size() < n * 2) {
+    Rehash(SlotCountFor(n));
+  }
+}
+
+void DependenceMap::clear() {
+  items_.clear();
+  slots_.clear();
+  mask_ = 0;
+  shift_ = 64;
+}
+
+void DependenceMap::Finalize() {
+  if (items_.empty()) {
+    clear();
+    items_.shrink_to_fit();
+    slots_.shrink_to_fit();
+    return;
+  }
+  items_.shrink_to_fit();
+  size_t slot_count = SlotCountFor(items_.size());
+  if (slot_count != slots_.size()) {
+    Rehash(slot_count);
+  }
+}
+
+void DependenceMap::Rehash(size_t slot_count) {
+  assert(slot_count >= 8 && (slot_count & (slot_count - 1)) == 0);
+  assert(slot_count >= items_.size() * 2);
+  std::vector<Slot>(slot_count, Slot{0, 0}).swap(slots_);
+  mask_ = slot_count - 1;
+  shift_ = 64;
+  for (size_t n = slot_count; n > 1; n >>= 1) {
+    --shift_;
+  }
+  for (size_t index = 0; index < items_.size(); ++index) {
+    size_t i = Bucket(items_[index].first);
+    while (slots_[i].index != 0) {
+      i = (i + 1) & mask_;
+    }
+    slots_[i].key = items_[index].first;
+    slots_[i].index = index + 1;
+  }
+}
+
+}  // namespace rocksdb
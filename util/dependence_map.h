@@ -0,0 +1,91 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace rocksdb {
+
+struct FileMetaData;
+
+// Maps file numbers to FileMetaData for map SST and blob SST resolution.
+//
+// Entries live in one contiguous array in insertion order, and an open
+// addressing table of (file number, entry index) slots sits in front of it.
+// Probing touches only the slot array, which holds keys inline, so a lookup
+// is usually a single cache line. Entries are never erased: the map is built
+// once per Version and then only read.
+//
+// REQUIRES: Pointers and iterators are invalidated by emplace().
+class DependenceMap {
+ public:
+  typedef uint64_t key_type;
+  typedef FileMetaData* mapped_type;
+  typedef std::pair<uint64_t, FileMetaData*> value_type;
+  typedef const value_type* const_iterator;
+  typedef const_iterator iterator;
+
+  DependenceMap() : mask_(0), shift_(64) {}
+
+  // Insert (file_number, f) unless file_number is already present. Returns
+  // the element for file_number and whether it was inserted.
+  std::pair<iterator, bool> emplace(uint64_t file_number, FileMetaData* f);
+
+  const_iterator find(uint64_t file_number) const {
+    if (slots_.empty()) {
+      return end();
+    }
+    for (size_t i = Bucket(file_number);; i = (i + 1) & mask_) {
+      const Slot& slot = slots_[i];
+      if (slot.index == 0) {
+        return end();
+      }
+      if (slot.key == file_number) {
+        return items_.data() + slot.index - 1;
+      }
+    }
+  }
+
+  size_t count(uint64_t file_number) const {
+    return find(file_number) == end() ? 0 : 1;
+  }
+
+  const_iterator begin() const { return items_.data(); }
+  const_iterator end() const { return items_.data() + items_.size(); }
+
+  size_t size() const { return items_.size(); }
+  bool empty() const { return items_.empty(); }
+
+  void reserve(size_t n);
+  void clear();
+
+  // Release spare capacity once no more entries will be added.
+  void Finalize();
+
+ private:
+  struct Slot {
+    uint64_t key;
+    // Entry index + 1, 0 for an empty slot
+    uint64_t index;
+  };
+
+  size_t Bucket(uint64_t file_number) const {
+    // Fibonacci hashing, file numbers are mostly dense and increasing
+    return static_cast<size_t>((file_number * 0x9E3779B97F4A7C15ull) >>
+                               shift_);
+  }
+
+  void Rehash(size_t slot_count);
+
+  std::vector<value_type> items_;
+  std::vector<Slot> slots_;
+  size_t mask_;
+  unsigned shift_;
+};
+
+}  // namespace rocksdb
@@ -0,0 +1,121 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef GFLAGS
+#include <cstdio>
+int main() {
+  fprintf(stderr, "Please install gflags to run rocksdb tools\n");
+  return 1;
+}
+#else
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "util/dependence_map.h"
+#include "util/random.h"
+#include "util/stop_watch.h"
+
+#include "util/gflags_compat.h"
+
+using GFLAGS_NAMESPACE::ParseCommandLineFlags;
+
+DEFINE_int32(num_files, 10000, "number of entries in the dependence map");
+
+DEFINE_int32(num_lookups, 10000000, "number of lookups per run");
+
+DEFINE_int32(num_runs, 5, "number of test runs");
+
+DEFINE_double(miss_ratio, 0.1, "ratio of lookups for absent file numbers");
+
+DEFINE_bool(sparse, false,
+            "use random file numbers instead of dense increasing ones");
+
+DEFINE_int32(seed, 301, "random number generator seed");
+
+namespace {
+
+struct Stats {
+  uint64_t time_build = 0;
+  uint64_t time_lookup = 0;
+  uint64_t hits = 0;
+};
+
+template <class Map>
+Stats RunBench(const std::vector<uint64_t>& files,
+               const std::vector<uint64_t>& lookups) {
+  Stats stats;
+  for (int run = 0; run < FLAGS_num_runs; ++run) {
+    rocksdb::StopWatchNano stop_watch_build(rocksdb::Env::Default(),
+                                            true /* auto_start */);
+    Map map;
+    for (auto file_number : files) {
+      map.emplace(file_number, reinterpret_cast<rocksdb::FileMetaData*>(
+                                   static_cast<uintptr_t>(file_number | 1)));
+    }
+    stats.time_build += stop_watch_build.ElapsedNanos();
+
+    rocksdb::StopWatchNano stop_watch_lookup(rocksdb::Env::Default(),
+                                             true /* auto_start */);
+    uint64_t hits = 0;
+    for (auto file_number : lookups) {
+      auto find = map.find(file_number);
+      if (find != map.end()) {
+        hits += reinterpret_cast<uintptr_t>(find->second) & 1;
+      }
+    }
+    stats.time_lookup += stop_watch_lookup.ElapsedNanos();
+    stats.hits += hits;
+  }
+  return stats;
+}
+
+void Report(const char* name, const Stats& s) {
+  std::cout << std::left << std::setw(20) << name << "build: " << std::setw(10)
+            << s.time_build / (FLAGS_num_runs * 1.0e3) << " us  lookup: "
+            << s.time_lookup / (FLAGS_num_runs * 1.0 * FLAGS_num_lookups)
+            << " ns/op  hits: " << s.hits / FLAGS_num_runs << "\n";
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  ParseCommandLineFlags(&argc, &argv, true);
+
+  rocksdb::Random64 rnd(FLAGS_seed);
+  std::vector<uint64_t> files(FLAGS_num_files);
+  for (size_t i = 0; i < files.size(); ++i) {
+    files[i] = FLAGS_sparse ? rnd.Next() & ~uint64_t(1) : (i + 1) * 2;
+  }
+  std::vector<uint64_t> lookups(FLAGS_num_lookups);
+  for (auto& file_number : lookups) {
+    if (rnd.Uniform(1000000) < FLAGS_miss_ratio * 1000000) {
+      // File numbers in the map are all even
+      file_number = rnd.Next() | 1;
+    } else {
+      file_number = files[rnd.Uniform(files.size())];
+    }
+  }
+
+  Stats flat = RunBench<rocksdb::DependenceMap>(files, lookups);
+  Stats unordered =
+      RunBench<std::unordered_map<uint64_t, rocksdb::FileMetaData*>>(files,
+                                                                    lookups);
+
+  std::cout << "=========================\n"
+            << "Results (" << FLAGS_num_files << " files, "
+            << (FLAGS_sparse ? "sparse" : "dense") << "):\n"
+            << "=========================\n";
+  Report("DependenceMap", flat);
+  Report("std::unordered_map", unordered);
+
+  return 0;
+}
+
+#endif  // GFLAGS
@@ -0,0 +1,89 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/dependence_map.h"
+
+#include <random>
+#include <unordered_map>
+
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class DependenceMapTest : public testing::Test {};
+
+namespace {
+FileMetaData* FakeMeta(uint64_t n) {
+  return reinterpret_cast<FileMetaData*>(static_cast<uintptr_t>(n * 16 + 8));
+}
+}  // namespace
+
+TEST_F(DependenceMapTest, Empty) {
+  DependenceMap map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(0, map.size());
+  ASSERT_TRUE(map.find(1) == map.end());
+  ASSERT_EQ(0, map.count(0));
+  ASSERT_TRUE(map.begin() == map.end());
+  map.Finalize();
+  ASSERT_TRUE(map.find(1) == map.end());
+}
+
+TEST_F(DependenceMapTest, EmplaceFind) {
+  DependenceMap map;
+  auto ib = map.emplace(7, FakeMeta(7));
+  ASSERT_TRUE(ib.second);
+  ASSERT_EQ(7, ib.first->first);
+  ib = map.emplace(7, FakeMeta(8));
+  ASSERT_FALSE(ib.second);
+  ASSERT_EQ(FakeMeta(7), ib.first->second);
+  ASSERT_EQ(1, map.size());
+  ASSERT_EQ(1, map.count(7));
+  ASSERT_EQ(0, map.count(8));
+  // File number 0 is a valid key
+  ASSERT_TRUE(map.emplace(0, FakeMeta(0)).second);
+  ASSERT_EQ(FakeMeta(0), map.find(0)->second);
+}
+
+TEST_F(DependenceMapTest, RandomAgainstUnorderedMap) {
+  std::mt19937_64 rnd(301);
+  for (size_t round = 0; round < 8; ++round) {
+    DependenceMap map;
+    std::unordered_map<uint64_t, FileMetaData*> expect;
+    size_t n = size_t(1) << (round * 2);
+    if (round % 2 == 0) {
+      map.reserve(n);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      // Mix dense and sparse file numbers
+      uint64_t file_number = i % 3 == 0 ? rnd() : rnd() % (n * 2);
+      bool inserted = expect.emplace(file_number, FakeMeta(i)).second;
+      ASSERT_EQ(inserted, map.emplace(file_number, FakeMeta(i)).second);
+    }
+    for (int finalized = 0; finalized < 2; ++finalized) {
+      ASSERT_EQ(expect.size(), map.size());
+      for (auto& pair : expect) {
+        auto find = map.find(pair.first);
+        ASSERT_TRUE(find != map.end());
+        ASSERT_EQ(pair.second, find->second);
+      }
+      for (auto& pair : map) {
+        ASSERT_EQ(1, expect.count(pair.first));
+      }
+      for (size_t i = 0; i < 1000; ++i) {
+        uint64_t file_number = rnd();
+        ASSERT_EQ(expect.count(file_number), map.count(file_number));
+      }
+      map.Finalize();
+    }
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
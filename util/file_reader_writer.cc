@@ -221,6 +221,63 @@ Status RandomAccessFileReader::Read(uint64_t offset, size_t n, Slice* result,
   return s;
 }
 
+Status RandomAccessFileReader::MultiRead(ReadRequest* reqs,
+                                         size_t num_reqs) const {
+  bool per_request = use_fsread_ || (for_compaction_ && rate_limiter_);
+  if (!per_request && use_direct_io()) {
+    size_t alignment = file_->GetRequiredBufferAlignment();
+    for (size_t i = 0; i < num_reqs && !per_request; ++i) {
+      per_request =
+          reqs[i].offset % alignment != 0 || reqs[i].len % alignment != 0 ||
+          reinterpret_cast<uintptr_t>(reqs[i].scratch) % alignment != 0;
+    }
+  }
+  if (per_request) {
+    for (size_t i = 0; i < num_reqs; ++i) {
+      ReadRequest& req = reqs[i];
+      req.status = Read(req.offset, req.len, &req.result, req.scratch);
+    }
+    return Status::OK();
+  }
+  TEST_SYNC_POINT_CALLBACK("RandomAccessFileReader::MultiRead", &num_reqs);
+  Status s;
+  uint64_t elapsed = 0;
+  {
+    StopWatch sw(env_, stats_, hist_type_,
+                 (stats_ != nullptr) ? &elapsed : nullptr, true /*overwrite*/,
+                 true /*delay_enabled*/);
+    IOSTATS_TIMER_GUARD(read_nanos);
+#ifndef ROCKSDB_LITE
+    FileOperationInfo::TimePoint start_ts;
+    if (ShouldNotifyListeners()) {
+      start_ts = std::chrono::system_clock::now();
+    }
+#endif
+    s = file_->MultiRead(reqs, num_reqs);
+    for (size_t i = 0; i < num_reqs; ++i) {
+      ReadRequest& req = reqs[i];
+      if (!s.ok()) {
+        req.status = s;
+        req.result = Slice(req.scratch, 0);
+      } else if (!req.status.ok()) {
+        req.result = Slice(req.scratch, 0);
+      }
+#ifndef ROCKSDB_LITE
+      if (ShouldNotifyListeners()) {
+        auto finish_ts = std::chrono::system_clock::now();
+        NotifyOnFileReadFinish(req.offset, req.result.size(), start_ts,
+                               finish_ts, req.status);
+      }
+#endif
+      IOSTATS_ADD_IF_POSITIVE(bytes_read, req.result.size());
+    }
+  }
+  if (stats_ != nullptr && file_read_hist_ != nullptr) {
+    file_read_hist_->Add(elapsed);
+  }
+  return s;
+}
+
 Status WritableFileWriter::Append(const Slice& data) {
   const char* src = data.data();
   size_t left = data.size();
@@ -901,6 +958,47 @@ Status FilePrefetchBuffer::Prefetch(RandomAccessFileReader* reader,
   return s;
 }
 
+Status FilePrefetchBuffer::MultiPrefetch(RandomAccessFileReader* reader,
+                                         size_t num,
+                                         FilePrefetchBuffer* buffers,
+                                         const uint64_t* offsets,
+                                         const size_t* lens) {
+  size_t alignment = reader->file()->GetRequiredBufferAlignment();
+  std::vector<ReadRequest> reqs(num);
+  for (size_t i = 0; i < num; ++i) {
+    size_t offset_ = static_cast<size_t>(offsets[i]);
+    uint64_t rounddown_offset = Rounddown(offset_, alignment);
+    uint64_t roundup_end = Roundup(offset_ + lens[i], alignment);
+    size_t roundup_len = static_cast<size_t>(roundup_end - rounddown_offset);
+    AlignedBuffer& buffer = buffers[i].buffer_;
+    if (buffer.Capacity() < roundup_len) {
+      buffer.Alignment(alignment);
+      buffer.AllocateNewBuffer(roundup_len);
+    }
+    buffer.Size(0);
+    buffers[i].buffer_offset_ = rounddown_offset;
+    reqs[i].offset = rounddown_offset;
+    reqs[i].len = roundup_len;
+    reqs[i].scratch = buffer.BufferStart();
+  }
+  Status s = reader->MultiRead(reqs.data(), num);
+  if (!s.ok()) {
+    return s;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    ReadRequest& req = reqs[i];
+    if (!req.status.ok()) {
+      continue;
+    }
+    if (req.result.data() != req.scratch) {
+      // mmap reads don't land in scratch
+      memcpy(req.scratch, req.result.data(), req.result.size());
+    }
+    buffers[i].buffer_.Size(req.result.size());
+  }
+  return Status::OK();
+}
+
 bool FilePrefetchBuffer::TryReadFromCache(uint64_t offset, size_t n,
                                           Slice* result) {
   if (track_min_offset_ && offset < min_offset_read_) {
@@ -111,6 +111,10 @@ class RandomAccessFileReader {
 
   Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const;
 
+  // Read several ranges at once through RandomAccessFile::MultiRead(), falls
+  // back to one Read() per request when the file can't take them as is
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) const;
+
   Status Prefetch(uint64_t offset, size_t n) const {
     return file_->Prefetch(offset, n);
   }
@@ -268,6 +272,13 @@ class FilePrefetchBuffer {
   Status Prefetch(RandomAccessFileReader* reader, uint64_t offset, size_t n);
   bool TryReadFromCache(uint64_t offset, size_t n, Slice* result);
 
+  // Prefetch [offsets[i], offsets[i] + lens[i]) into buffers[i] for all i
+  // with one RandomAccessFileReader::MultiRead(). A buffer whose read failed
+  // is left empty, so its later reads simply miss.
+  static Status MultiPrefetch(RandomAccessFileReader* reader, size_t num,
+                              FilePrefetchBuffer* buffers,
+                              const uint64_t* offsets, const size_t* lens);
+
   // The minimum `offset` ever passed to TryReadFromCache(). Only be tracked
   // if track_min_offset = true.
   size_t min_offset_read() const { return min_offset_read_; }
@@ -112,12 +112,13 @@ void IteratorCache::PutFileMetaData(FileMetaData* f) {
 
 const FileMetaData* IteratorCache::GetFileMetaData(uint64_t file_number) {
   auto find = dependence_map_.find(file_number);
-  if (find == dependence_map_.end()) {
-    find = dependence_map_ext_.find(file_number);
-  }
   if (find != dependence_map_.end()) {
     return find->second;
   }
+  find = dependence_map_ext_.find(file_number);
+  if (find != dependence_map_ext_.end()) {
+    return find->second;
+  }
   return nullptr;
 }
 
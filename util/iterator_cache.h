@@ -9,6 +9,7 @@
 
 #include "table/internal_iterator.h"
 #include "util/arena.h"
+#include "util/dependence_map.h"
 
 namespace rocksdb {
 
@@ -16,8 +17,6 @@ struct FileMetaData;
 class RangeDelAggregator;
 class TableReader;
 
-typedef std::unordered_map<uint64_t, FileMetaData*> DependenceMap;
-
 class IteratorCache {
  public:
   using CreateIterCallback = InternalIterator* (*)(void* arg,
@@ -0,0 +1,94 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// LoserTree merges n sorted inputs. Every internal node keeps the loser of
+// the match played there, so replaying the winner after it advanced takes
+// exactly log2(n) comparisons along one leaf-to-root path, where a binary
+// heap needs up to twice as many.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace rocksdb {
+
+// `Compare(a, b)` returns true if `a` goes out before `b`
+template <class T, class Compare>
+class LoserTree {
+ public:
+  LoserTree() = default;
+
+  // Play all matches from scratch, a nullptr input is exhausted
+  void Init(T* const* inputs, size_t n, const Compare& comp) {
+    comp_ = comp;
+    inputs_.assign(inputs, inputs + n);
+    tree_.resize(n);
+    if (n == 0) {
+      return;
+    }
+    // Reused across calls, Init runs on every Seek of the owner iterator
+    std::vector<uint32_t>& winners = winners_;
+    winners.resize(2 * n);
+    for (size_t i = 0; i < n; ++i) {
+      winners[n + i] = uint32_t(i);
+    }
+    for (size_t j = n - 1; j > 0; --j) {
+      uint32_t a = winners[2 * j], b = winners[2 * j + 1];
+      bool a_wins = Beats(a, b);
+      winners[j] = a_wins ? a : b;
+      tree_[j] = a_wins ? b : a;
+    }
+    tree_[0] = n == 1 ? 0 : winners[1];
+  }
+
+  size_t size() const { return inputs_.size(); }
+
+  // The input holding the first element, nullptr if all are exhausted
+  T* top() const { return inputs_.empty() ? nullptr : inputs_[tree_[0]]; }
+  size_t top_index() const { return tree_[0]; }
+
+  T* input(size_t i) const { return inputs_[i]; }
+
+  // Replay the winner after its input advanced, `top` is nullptr if it is
+  // exhausted
+  void ReplaceTop(T* top) {
+    assert(!inputs_.empty());
+    uint32_t winner = tree_[0];
+    inputs_[winner] = top;
+    size_t n = inputs_.size();
+    for (size_t j = (winner + n) / 2; j > 0; j /= 2) {
+      if (Beats(tree_[j], winner)) {
+        std::swap(tree_[j], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+ private:
+  bool Beats(uint32_t a, uint32_t b) const {
+    if (inputs_[a] == nullptr) {
+      return false;
+    }
+    if (inputs_[b] == nullptr) {
+      return true;
+    }
+    // Ties go to the smaller input index
+    return comp_(inputs_[a], inputs_[b]) ||
+           (a < b && !comp_(inputs_[b], inputs_[a]));
+  }
+
+  Compare comp_;
+  std::vector<T*> inputs_;
+  // tree_[0] is the winner, tree_[j] the loser of the match at node j
+  std::vector<uint32_t> tree_;
+  // Scratch for Init, the winner of the match at every node and leaf
+  std::vector<uint32_t> winners_;
+};
+
+}  // namespace rocksdb
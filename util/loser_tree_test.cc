@@ -0,0 +1,83 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/loser_tree.h"
+
+#include <algorithm>
+
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class LoserTreeTest : public testing::Test {};
+
+namespace {
+
+struct Input {
+  std::vector<int> values;
+  size_t pos = 0;
+  int value() const { return values[pos]; }
+};
+
+struct InputLess {
+  bool greater = false;
+  bool operator()(const Input* a, const Input* b) const {
+    return greater ? a->value() > b->value() : a->value() < b->value();
+  }
+};
+
+}  // namespace
+
+TEST_F(LoserTreeTest, Merge) {
+  Random rnd(301);
+  // One tree is re-initialized for every input set, its scratch is reused
+  LoserTree<Input, InputLess> tree;
+  for (size_t n = 1; n < 10; ++n) {
+    for (bool greater : {false, true}) {
+      std::vector<Input> inputs(n);
+      std::vector<int> expected;
+      for (auto& input : inputs) {
+        // Some inputs are empty, values repeat across inputs
+        size_t count = rnd.Uniform(3) == 0 ? 0 : rnd.Uniform(50);
+        for (size_t i = 0; i < count; ++i) {
+          input.values.push_back(int(rnd.Uniform(100)));
+        }
+        std::sort(input.values.begin(), input.values.end());
+        if (greater) {
+          std::reverse(input.values.begin(), input.values.end());
+        }
+        expected.insert(expected.end(), input.values.begin(),
+                        input.values.end());
+      }
+      std::sort(expected.begin(), expected.end());
+      if (greater) {
+        std::reverse(expected.begin(), expected.end());
+      }
+      std::vector<Input*> ptrs;
+      for (auto& input : inputs) {
+        ptrs.push_back(input.values.empty() ? nullptr : &input);
+      }
+      InputLess less;
+      less.greater = greater;
+      tree.Init(ptrs.data(), ptrs.size(), less);
+      ASSERT_EQ(n, tree.size());
+      std::vector<int> merged;
+      while (Input* top = tree.top()) {
+        ASSERT_EQ(top, tree.input(tree.top_index()));
+        merged.push_back(top->value());
+        tree.ReplaceTop(++top->pos < top->values.size() ? top : nullptr);
+      }
+      ASSERT_EQ(expected, merged);
+    }
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,302 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rocksdb/memory_arbiter.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+
+#include "port/port.h"
+
+namespace rocksdb {
+
+namespace {
+uint64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+const uint64_t MemoryArbiter::kCacheUsageRefreshMicros;
+
+MemoryArbiter::Reservation::Reservation(Reservation&& other) noexcept
+    : arbiter_(other.arbiter_),
+      consumer_(other.consumer_),
+      size_(other.size_) {
+  other.size_ = 0;
+}
+
+MemoryArbiter::Reservation& MemoryArbiter::Reservation::operator=(
+    Reservation&& other) noexcept {
+  Release();
+  arbiter_ = other.arbiter_;
+  consumer_ = other.consumer_;
+  size_ = other.size_;
+  other.size_ = 0;
+  return *this;
+}
+
+void MemoryArbiter::Reservation::Release(size_t size) {
+  assert(size <= size_);
+  if (size == 0) {
+    size = size_;
+  }
+  if (size > 0) {
+    size_ -= size;
+    arbiter_->Return(consumer_, size);
+  }
+}
+
+MemoryArbiter::MemoryArbiter(size_t limit, std::shared_ptr<Cache> cache)
+    : limit_(limit),
+      cache_(std::move(cache)),
+      cache_usage_(0),
+      cache_usage_micros_(0),
+      peak_usage_(0),
+      reserved_(0),
+      num_waiting_(0),
+      waiting_bytes_(0),
+      num_reservations_(0),
+      num_waits_(0),
+      wait_micros_(0),
+      num_timeouts_(0) {
+  for (auto& u : usage_) {
+    u.store(0, std::memory_order_relaxed);
+  }
+}
+
+MemoryArbiter::~MemoryArbiter() {
+  assert(reserved_ == 0);
+  assert(num_waiting_ == 0);
+}
+
+size_t MemoryArbiter::usage(Consumer consumer) const {
+  if (consumer == kCache && cache_ != nullptr) {
+    return cache_->GetUsage();
+  }
+  return usage_[consumer].load(std::memory_order_relaxed);
+}
+
+size_t MemoryArbiter::usage() const {
+  size_t sum = 0;
+  for (int i = 0; i < kNumConsumers; ++i) {
+    sum += usage(static_cast<Consumer>(i));
+  }
+  return sum;
+}
+
+size_t MemoryArbiter::approximate_usage() const {
+  size_t sum = 0;
+  for (int i = 0; i < kNumConsumers; ++i) {
+    if (i != kCache || cache_ == nullptr) {
+      sum += usage_[i].load(std::memory_order_relaxed);
+    }
+  }
+  if (cache_ != nullptr) {
+    uint64_t now = NowMicros();
+    uint64_t last = cache_usage_micros_.load(std::memory_order_relaxed);
+    // One caller refreshes, the others take the last value
+    if ((last == 0 || now - last >= kCacheUsageRefreshMicros) &&
+        cache_usage_micros_.compare_exchange_strong(
+            last, now, std::memory_order_relaxed)) {
+      cache_usage_.store(cache_->GetUsage(), std::memory_order_relaxed);
+    }
+    sum += cache_usage_.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+bool MemoryArbiter::FitsLocked(size_t size) const {
+  return limit_ == 0 || reserved_ == 0 || usage() + size <= limit_;
+}
+
+void MemoryArbiter::GrantLocked() {
+  for (auto& queue : waiters_) {
+    while (!queue.empty()) {
+      Waiter* w = queue.front();
+      if (!FitsLocked(w->size)) {
+        // Lower priorities must not pass a waiting higher priority
+        return;
+      }
+      queue.pop_front();
+      w->granted = true;
+      reserved_ += w->size;
+      Charge(w->consumer, w->size);
+      waiting_bytes_ -= w->size;
+      --num_waiting_;
+      w->cv.notify_one();
+    }
+  }
+}
+
+MemoryArbiter::Reservation MemoryArbiter::Reserve(Consumer consumer,
+                                                  size_t size,
+                                                  Priority priority,
+                                                  uint64_t max_wait_micros) {
+  Reservation reservation;
+  if (TryReserve(consumer, size, priority, &reservation)) {
+    return reservation;
+  }
+  // Cache usage shrinks without telling the arbiter, waiters look again
+  // every so often
+  const std::chrono::milliseconds kRecheckInterval(100);
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::microseconds(max_wait_micros);
+  Waiter w;
+  w.consumer = consumer;
+  w.size = size;
+  w.granted = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++num_waits_;
+    waiting_bytes_ += size;
+    ++num_waiting_;
+    auto& queue = waiters_[priority];
+    queue.push_back(&w);
+    // Memory may have been given back since TryReserve()
+    GrantLocked();
+    while (!w.granted) {
+      auto now = std::chrono::steady_clock::now();
+      if (max_wait_micros != 0 && now >= deadline) {
+        queue.erase(std::find(queue.begin(), queue.end(), &w));
+        w.granted = true;
+        reserved_ += size;
+        Charge(consumer, size);
+        waiting_bytes_ -= size;
+        --num_waiting_;
+        ++num_timeouts_;
+        // Waiters behind this one may fit now
+        GrantLocked();
+        break;
+      }
+      auto until = now + kRecheckInterval;
+      if (max_wait_micros != 0) {
+        until = std::min(until, deadline);
+      }
+      if (w.cv.wait_until(lock, until) == std::cv_status::timeout) {
+        GrantLocked();
+      }
+    }
+    ++num_reservations_;
+    wait_micros_ += std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  }
+  return Reservation(this, consumer, size);
+}
+
+bool MemoryArbiter::TryReserve(Consumer consumer, size_t size,
+                               Priority priority, Reservation* reservation) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Queued waiters of the same or a higher priority go first
+    for (int i = 0; i <= priority; ++i) {
+      if (!waiters_[i].empty()) {
+        return false;
+      }
+    }
+    if (!FitsLocked(size)) {
+      return false;
+    }
+    reserved_ += size;
+    ++num_reservations_;
+    Charge(consumer, size);
+  }
+  *reservation = Reservation(this, consumer, size);
+  return true;
+}
+
+void MemoryArbiter::Charge(Consumer consumer, size_t size) {
+  usage_[consumer].fetch_add(size, std::memory_order_relaxed);
+  // Memtables charge every arena block, don't read the cache each time
+  size_t current = approximate_usage();
+  size_t peak = peak_usage_.load(std::memory_order_relaxed);
+  while (current > peak &&
+         !peak_usage_.compare_exchange_weak(peak, current,
+                                            std::memory_order_relaxed)) {
+  }
+}
+
+void MemoryArbiter::Discharge(Consumer consumer, size_t size) {
+  assert(usage_[consumer].load(std::memory_order_relaxed) >= size);
+  usage_[consumer].fetch_sub(size, std::memory_order_relaxed);
+  // Checking for waiters without mutex_ could miss a Reserve() that queues
+  // right now and has already looked at the old usage
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_waiting_ > 0) {
+    GrantLocked();
+  }
+}
+
+void MemoryArbiter::Return(Consumer consumer, size_t size) {
+  assert(usage_[consumer].load(std::memory_order_relaxed) >= size);
+  usage_[consumer].fetch_sub(size, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  assert(reserved_ >= size);
+  reserved_ -= size;
+  GrantLocked();
+}
+
+void MemoryArbiter::GetStats(Stats* stats) const {
+  stats->limit = limit_;
+  for (int i = 0; i < kNumConsumers; ++i) {
+    stats->usage[i] = usage(static_cast<Consumer>(i));
+  }
+  stats->peak_usage = peak_usage_.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats->num_waiting = num_waiting_;
+  stats->waiting_bytes = waiting_bytes_;
+  stats->num_reservations = num_reservations_;
+  stats->num_waits = num_waits_;
+  stats->wait_micros = wait_micros_;
+  stats->num_timeouts = num_timeouts_;
+}
+
+std::string MemoryArbiter::ToString() const {
+  Stats stats;
+  GetStats(&stats);
+  std::string result;
+  char buf[512];
+  size_t total = 0;
+  for (int i = 0; i < kNumConsumers; ++i) {
+    snprintf(buf, sizeof buf, "%-13s: %10.3f MB\n",
+             ConsumerName(static_cast<Consumer>(i)), stats.usage[i] / 1048576.);
+    result.append(buf);
+    total += stats.usage[i];
+  }
+  snprintf(buf, sizeof buf,
+           "total        : %10.3f MB, limit %.3f MB, peak %.3f MB\n"
+           "waiting      : %" ROCKSDB_PRIszt " reservations, %.3f MB\n"
+           "reservations : %" PRIu64 ", waited %" PRIu64 " times, %.3f sec, "
+           "%" PRIu64 " timed out\n",
+           total / 1048576., stats.limit / 1048576.,
+           stats.peak_usage / 1048576., stats.num_waiting,
+           stats.waiting_bytes / 1048576., stats.num_reservations,
+           stats.num_waits, stats.wait_micros / 1e6, stats.num_timeouts);
+  result.append(buf);
+  return result;
+}
+
+const char* MemoryArbiter::ConsumerName(Consumer consumer) {
+  switch (consumer) {
+    case kMemTable:
+      return "memtable";
+    case kTableBuilder:
+      return "table_builder";
+    case kTableReader:
+      return "table_reader";
+    case kCache:
+      return "cache";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,160 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rocksdb/memory_arbiter.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class MemoryArbiterTest : public testing::Test {
+ public:
+  static void WaitForWaiters(const MemoryArbiter& arbiter, size_t n) {
+    MemoryArbiter::Stats stats;
+    do {
+      std::this_thread::yield();
+      arbiter.GetStats(&stats);
+    } while (stats.num_waiting < n);
+  }
+};
+
+const size_t kMB = 1 << 20;
+
+TEST_F(MemoryArbiterTest, ReserveAndRelease) {
+  MemoryArbiter arbiter(10 * kMB);
+  {
+    auto r1 = arbiter.Reserve(MemoryArbiter::kTableBuilder, 4 * kMB,
+                              MemoryArbiter::kLow);
+    ASSERT_EQ(4 * kMB, r1.size());
+    ASSERT_EQ(4 * kMB, arbiter.usage(MemoryArbiter::kTableBuilder));
+    MemoryArbiter::Reservation r2;
+    ASSERT_TRUE(arbiter.TryReserve(MemoryArbiter::kTableReader, 6 * kMB,
+                                   MemoryArbiter::kLow, &r2));
+    ASSERT_TRUE(arbiter.exceeds_limit());
+    MemoryArbiter::Reservation r3;
+    ASSERT_FALSE(arbiter.TryReserve(MemoryArbiter::kTableBuilder, 1,
+                                    MemoryArbiter::kHigh, &r3));
+    r2.Release(2 * kMB);
+    ASSERT_EQ(4 * kMB, arbiter.usage(MemoryArbiter::kTableReader));
+    ASSERT_TRUE(arbiter.TryReserve(MemoryArbiter::kTableBuilder, 2 * kMB,
+                                   MemoryArbiter::kHigh, &r3));
+    ASSERT_EQ(6 * kMB, arbiter.usage(MemoryArbiter::kTableBuilder));
+  }
+  ASSERT_EQ(0, arbiter.usage());
+  MemoryArbiter::Stats stats;
+  arbiter.GetStats(&stats);
+  ASSERT_EQ(3, stats.num_reservations);
+  ASSERT_EQ(0, stats.num_waits);
+  ASSERT_EQ(10 * kMB, stats.peak_usage);
+
+  // A reservation above the limit still runs alone
+  auto big = arbiter.Reserve(MemoryArbiter::kTableBuilder, 20 * kMB,
+                             MemoryArbiter::kBottom);
+  ASSERT_EQ(20 * kMB, big.size());
+}
+
+TEST_F(MemoryArbiterTest, WakeInPriorityOrder) {
+  MemoryArbiter arbiter(10 * kMB);
+  auto held = arbiter.Reserve(MemoryArbiter::kTableBuilder, 8 * kMB,
+                              MemoryArbiter::kLow);
+  std::mutex mutex;
+  std::vector<int> order;
+  auto reserve = [&](int id, MemoryArbiter::Priority priority) {
+    auto r = arbiter.Reserve(MemoryArbiter::kTableBuilder, 6 * kMB, priority);
+    std::lock_guard<std::mutex> lock(mutex);
+    order.push_back(id);
+  };
+  std::thread bottom(reserve, 0, MemoryArbiter::kBottom);
+  WaitForWaiters(arbiter, 1);
+  std::thread low(reserve, 1, MemoryArbiter::kLow);
+  WaitForWaiters(arbiter, 2);
+  std::thread high(reserve, 2, MemoryArbiter::kHigh);
+  WaitForWaiters(arbiter, 3);
+  // A small request of a lower priority must not pass the queue
+  MemoryArbiter::Reservation small;
+  ASSERT_FALSE(arbiter.TryReserve(MemoryArbiter::kTableBuilder, 1 * kMB,
+                                  MemoryArbiter::kBottom, &small));
+
+  held.Release();
+  bottom.join();
+  low.join();
+  high.join();
+  ASSERT_EQ((std::vector<int>{2, 1, 0}), order);
+  MemoryArbiter::Stats stats;
+  arbiter.GetStats(&stats);
+  ASSERT_EQ(3, stats.num_waits);
+  ASSERT_EQ(0, stats.num_waiting);
+  ASSERT_EQ(0, arbiter.usage());
+}
+
+TEST_F(MemoryArbiterTest, ChargeAndCache) {
+  std::shared_ptr<Cache> cache = NewLRUCache(8 * kMB, 0);
+  MemoryArbiter arbiter(10 * kMB, cache);
+  ASSERT_OK(cache->Insert("block", nullptr, 4 * kMB, nullptr));
+  ASSERT_EQ(4 * kMB, arbiter.usage(MemoryArbiter::kCache));
+  arbiter.Charge(MemoryArbiter::kMemTable, 4 * kMB);
+  ASSERT_EQ(8 * kMB, arbiter.usage());
+
+  auto held = arbiter.Reserve(MemoryArbiter::kTableBuilder, 1 * kMB,
+                              MemoryArbiter::kLow);
+  std::thread waiter([&] {
+    auto r = arbiter.Reserve(MemoryArbiter::kTableBuilder, 3 * kMB,
+                             MemoryArbiter::kHigh);
+  });
+  WaitForWaiters(arbiter, 1);
+  // Memtable memory given back wakes the waiter without a release
+  arbiter.Discharge(MemoryArbiter::kMemTable, 4 * kMB);
+  waiter.join();
+  ASSERT_EQ(5 * kMB, arbiter.usage());
+  ASSERT_NE(std::string::npos, arbiter.ToString().find("table_builder"));
+}
+
+TEST_F(MemoryArbiterTest, ApproximateCacheUsage) {
+  std::shared_ptr<Cache> cache = NewLRUCache(8 * kMB, 0);
+  MemoryArbiter arbiter(10 * kMB, cache);
+  ASSERT_FALSE(arbiter.exceeds_limit());
+  ASSERT_OK(cache->Insert("block", nullptr, 8 * kMB, nullptr));
+  arbiter.Charge(MemoryArbiter::kMemTable, 4 * kMB);
+  // The cache usage is read again once it is old enough
+  ASSERT_EQ(12 * kMB, arbiter.usage());
+  std::this_thread::sleep_for(std::chrono::microseconds(
+      2 * MemoryArbiter::kCacheUsageRefreshMicros));
+  ASSERT_TRUE(arbiter.exceeds_limit());
+  ASSERT_EQ(12 * kMB, arbiter.approximate_usage());
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(4 * kMB, arbiter.usage());
+  std::this_thread::sleep_for(std::chrono::microseconds(
+      2 * MemoryArbiter::kCacheUsageRefreshMicros));
+  ASSERT_FALSE(arbiter.exceeds_limit());
+}
+
+TEST_F(MemoryArbiterTest, MaxWait) {
+  MemoryArbiter arbiter(10 * kMB);
+  auto held = arbiter.Reserve(MemoryArbiter::kTableBuilder, 8 * kMB,
+                              MemoryArbiter::kLow);
+  // Nothing is given back, the waiter runs over the limit after its wait
+  auto r = arbiter.Reserve(MemoryArbiter::kTableBuilder, 6 * kMB,
+                           MemoryArbiter::kLow, 50 * 1000 /* 50ms */);
+  ASSERT_EQ(6 * kMB, r.size());
+  ASSERT_EQ(14 * kMB, arbiter.usage());
+  MemoryArbiter::Stats stats;
+  arbiter.GetStats(&stats);
+  ASSERT_EQ(1, stats.num_waits);
+  ASSERT_EQ(1, stats.num_timeouts);
+  ASSERT_EQ(0, stats.num_waiting);
+  ASSERT_EQ(0, stats.waiting_bytes);
+  ASSERT_GE(stats.wait_micros, 50 * 1000);
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
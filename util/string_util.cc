@@ -281,6 +281,24 @@ bool ParseBoolean(const std::string& type, const std::string& value) {
   throw std::invalid_argument(type);
 }
 
+uint8_t ParseUint8(const std::string& value) {
+  uint64_t num = ParseUint64(value);
+  if ((num >> 8LL) == 0) {
+    return static_cast<uint8_t>(num);
+  } else {
+    throw std::out_of_range(value);
+  }
+}
+
+uint16_t ParseUint16(const std::string& value) {
+  uint64_t num = ParseUint64(value);
+  if ((num >> 16LL) == 0) {
+    return static_cast<uint16_t>(num);
+  } else {
+    throw std::out_of_range(value);
+  }
+}
+
 uint32_t ParseUint32(const std::string& value) {
   uint64_t num = ParseUint64(value);
   if ((num >> 32LL) == 0) {
@@ -340,6 +358,15 @@ int ParseInt(const std::string& value) {
   return num;
 }
 
+int8_t ParseInt8(const std::string& value) {
+  int num = ParseInt(value);
+  if (num >= INT8_MIN && num <= INT8_MAX) {
+    return static_cast<int8_t>(num);
+  } else {
+    throw std::out_of_range(value);
+  }
+}
+
 double ParseDouble(const std::string& value) {
 #ifndef CYGWIN
   return std::stod(value);
@@ -108,6 +108,10 @@ std::string trim(const std::string& str);
 #ifndef ROCKSDB_LITE
 bool ParseBoolean(const std::string& type, const std::string& value);
 
+uint8_t ParseUint8(const std::string& value);
+
+uint16_t ParseUint16(const std::string& value);
+
 uint32_t ParseUint32(const std::string& value);
 #endif
 
@@ -115,6 +119,8 @@ uint64_t ParseUint64(const std::string& value);
 
 int ParseInt(const std::string& value);
 
+int8_t ParseInt8(const std::string& value);
+
 double ParseDouble(const std::string& value);
 
 size_t ParseSizeT(const std::string& value);
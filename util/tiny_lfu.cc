@@ -0,0 +1,97 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/tiny_lfu.h"
+
+#include <algorithm>
+
+namespace rocksdb {
+
+namespace {
+const uint64_t kSeeds[TinyLFU::kDepth] = {
+    0xc3a5c85c97cb3127ull, 0xb492b66fbe98f273ull, 0x9ae16a3b2f90404full,
+    0xcbf29ce484222325ull};
+const uint64_t kResetMask = 0x7777777777777777ull;
+}  // namespace
+
+const int TinyLFU::kDepth;
+const uint32_t TinyLFU::kMaxFrequency;
+
+TinyLFU::TinyLFU(size_t num_counters, size_t sample_size) : additions_(0) {
+  bits_ = 4;
+  while ((size_t(1) << bits_) < num_counters) {
+    ++bits_;
+  }
+  sample_size_ = sample_size ? sample_size : 10 * this->num_counters();
+  size_t num_words = this->num_counters() / 16;
+  table_.reset(new std::atomic<uint64_t>[num_words]);
+  for (size_t i = 0; i < num_words; ++i) {
+    table_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void TinyLFU::Locate(uint64_t hash, int i, size_t* word, int* shift) const {
+  uint64_t h = (hash ^ (hash >> 29)) * kSeeds[i];
+  h += h >> 32;
+  size_t index = size_t(h) & (num_counters() - 1);
+  *word = index >> 4;
+  *shift = int(index & 15) * 4;
+}
+
+void TinyLFU::Increment(uint64_t hash) {
+  size_t word[kDepth];
+  int shift[kDepth];
+  uint32_t count[kDepth];
+  uint32_t min_count = kMaxFrequency;
+  for (int i = 0; i < kDepth; ++i) {
+    Locate(hash, i, &word[i], &shift[i]);
+    count[i] = uint32_t(
+        table_[word[i]].load(std::memory_order_relaxed) >> shift[i] & 15);
+    min_count = std::min(min_count, count[i]);
+  }
+  if (min_count < kMaxFrequency) {
+    // Conservative update, only the smallest counters are raised
+    for (int i = 0; i < kDepth; ++i) {
+      if (count[i] != min_count) {
+        continue;
+      }
+      uint64_t w = table_[word[i]].load(std::memory_order_relaxed);
+      while ((w >> shift[i] & 15) < kMaxFrequency &&
+             !table_[word[i]].compare_exchange_weak(
+                 w, w + (uint64_t(1) << shift[i]),
+                 std::memory_order_relaxed)) {
+      }
+    }
+  }
+  if (additions_.fetch_add(1, std::memory_order_relaxed) + 1 == sample_size_) {
+    Reset();
+  }
+}
+
+uint32_t TinyLFU::Frequency(uint64_t hash) const {
+  uint32_t min_count = kMaxFrequency;
+  for (int i = 0; i < kDepth; ++i) {
+    size_t word;
+    int shift;
+    Locate(hash, i, &word, &shift);
+    uint32_t count =
+        uint32_t(table_[word].load(std::memory_order_relaxed) >> shift & 15);
+    min_count = std::min(min_count, count);
+  }
+  return min_count;
+}
+
+void TinyLFU::Reset() {
+  // Increments racing with the halving may be lost, which is fine for an
+  // estimate
+  size_t num_words = num_counters() / 16;
+  for (size_t i = 0; i < num_words; ++i) {
+    uint64_t w = table_[i].load(std::memory_order_relaxed);
+    table_[i].store((w >> 1) & kResetMask, std::memory_order_relaxed);
+  }
+  additions_.fetch_sub(sample_size_ / 2, std::memory_order_relaxed);
+}
+
+}  // namespace rocksdb
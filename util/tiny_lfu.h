@@ -0,0 +1,48 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// TinyLFU keeps approximate access frequencies of a large key space in a
+// count-min sketch of 4-bit counters, which are halved after every
+// `sample_size` accesses so the frequencies follow the recent history. Caches
+// use it to admit only entries which are accessed often enough.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace rocksdb {
+
+class TinyLFU {
+ public:
+  // `num_counters` is rounded up to a power of two, the sketch takes half a
+  // byte per counter. sample_size == 0 means 10 * num_counters.
+  explicit TinyLFU(size_t num_counters, size_t sample_size = 0);
+
+  // Record one access of the key with hash `hash`, thread safe
+  void Increment(uint64_t hash);
+
+  // Estimated number of accesses in [0, 15]
+  uint32_t Frequency(uint64_t hash) const;
+
+  size_t num_counters() const { return size_t(1) << bits_; }
+
+  // Counters one key maps to, 16 counters share one 64 bit word
+  static const int kDepth = 4;
+  static const uint32_t kMaxFrequency = 15;
+
+ private:
+  // Position of the counter of row `i`, as word index and nibble shift
+  void Locate(uint64_t hash, int i, size_t* word, int* shift) const;
+  void Reset();
+
+  int bits_;
+  size_t sample_size_;
+  std::unique_ptr<std::atomic<uint64_t>[]> table_;
+  std::atomic<size_t> additions_;
+};
+
+}  // namespace rocksdb
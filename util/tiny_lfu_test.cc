@@ -0,0 +1,49 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/tiny_lfu.h"
+
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class TinyLFUTest : public testing::Test {};
+
+TEST_F(TinyLFUTest, Frequency) {
+  TinyLFU lfu(1000, 1 << 20);
+  ASSERT_EQ(1024, lfu.num_counters());
+  for (int i = 0; i < 5; ++i) {
+    lfu.Increment(42);
+  }
+  lfu.Increment(43);
+  ASSERT_EQ(5, lfu.Frequency(42));
+  ASSERT_GE(lfu.Frequency(43), 1);
+  ASSERT_LE(lfu.Frequency(44), 1);
+  for (int i = 0; i < 100; ++i) {
+    lfu.Increment(42);
+  }
+  ASSERT_EQ(TinyLFU::kMaxFrequency, lfu.Frequency(42));
+}
+
+TEST_F(TinyLFUTest, Aging) {
+  TinyLFU lfu(1 << 12, 100);
+  for (int i = 0; i < 12; ++i) {
+    lfu.Increment(7);
+  }
+  ASSERT_EQ(12, lfu.Frequency(7));
+  // The 100th access halves all counters
+  for (uint64_t i = 0; i < 88; ++i) {
+    lfu.Increment(1000 + i);
+  }
+  ASSERT_EQ(6, lfu.Frequency(7));
+  ASSERT_LE(lfu.Frequency(1000), 1);
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}